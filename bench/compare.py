@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Compare two OrangeEngineBenchMath JSON results and fail on regressions.
+
+Usage: compare.py <baseline.json> <current.json> [--threshold 0.05] [--metric median_ns]
+
+Benchmarks are matched by name and size. A benchmark regresses when its time grows by more than the
+threshold relative to the baseline. Exits with 1 if any benchmark regressed, 0 otherwise.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path, encoding="utf-8") as file:
+        data = json.load(file)
+    return {(entry["name"], entry["size"]): entry for entry in data["benchmarks"]}, data.get("context", {})
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.05, help="allowed relative slowdown (default 0.05)")
+    parser.add_argument("--metric", default="median_ns", choices=["median_ns", "min_ns"])
+    args = parser.parse_args()
+
+    baseline, baseline_context = load(args.baseline)
+    current, current_context = load(args.current)
+    for key in ("compiler", "simd_backend", "stream_isa"):
+        if baseline_context.get(key) != current_context.get(key):
+            print(f"warning: {key} differs: {baseline_context.get(key)} vs {current_context.get(key)}")
+
+    regressions = []
+    print(f"{'benchmark':<44} {'size':>8} {'baseline':>12} {'current':>12} {'change':>9}")
+    for key in sorted(baseline.keys() & current.keys()):
+        before = baseline[key][args.metric]
+        after = current[key][args.metric]
+        change = (after - before) / before if before > 0 else 0.0
+        marker = ""
+        if change > args.threshold:
+            marker = "  REGRESSION"
+            regressions.append(key)
+        print(f"{key[0]:<44} {key[1]:>8} {before:>12.3f} {after:>12.3f} {change:>+8.1%}{marker}")
+
+    for key in sorted(baseline.keys() - current.keys()):
+        print(f"missing from current run: {key[0]} ({key[1]})")
+    for key in sorted(current.keys() - baseline.keys()):
+        print(f"new benchmark: {key[0]} ({key[1]})")
+
+    if regressions:
+        print(f"\n{len(regressions)} benchmark(s) regressed by more than {args.threshold:.0%}")
+        return 1
+    print(f"\nNo regressions above {args.threshold:.0%}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,461 @@
+// Microbenchmarks for orange_math
+//
+// Every benchmark runs an operation over arrays of `size` elements and reports the time per element.
+// Size 1 measures the cost of a single call, the larger sizes show throughput once the compiler and
+// the SIMD paths can pipeline many elements.
+//
+// Usage: OrangeEngineBenchMath [--json <path>] [--filter <substring>] [--samples <count>] [--min-time <ms>]
+// Compare two JSON runs with bench/compare.py.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "math/matrix.h"
+#include "math/quat.h"
+#include "math/transform.h"
+#include "math/vec_stream.h"
+#include "math/vector.h"
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+// Keeps the compiler from discarding results which are otherwise unused
+template <typename T> inline void do_not_optimize(T const& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile char sink;
+    sink = *reinterpret_cast<char const volatile*>(&value);
+#endif
+}
+
+// Runs the operation `iterations` times over all `size` elements
+using runner = std::function<void(size_t iterations)>;
+
+struct benchmark
+{
+    std::string name;
+    size_t size;
+    // Allocates and fills the inputs outside of the timed region
+    std::function<runner()> prepare;
+};
+
+struct result
+{
+    std::string name;
+    size_t size;
+    size_t iterations;
+    double median_ns;
+    double min_ns;
+    double max_ns;
+};
+
+struct options
+{
+    std::string json_path;
+    std::string filter;
+    size_t samples = 15;
+    double min_sample_ms = 2.0;
+};
+
+constexpr size_t sizes[] = { 1, 256, 16384 };
+
+// Deterministic inputs that avoid zeros, denormals and values which would overflow
+float make_float(size_t i) { return 0.5f + static_cast<float>((i * 7919) % 1000) / 250.f; }
+
+template <typename T> T make_value(size_t i);
+template <> math::vec2 make_value<math::vec2>(size_t i) { return math::vec2{ make_float(i), make_float(i + 1) }; }
+template <> math::vec3 make_value<math::vec3>(size_t i)
+{
+    return math::vec3{ make_float(i), make_float(i + 1), make_float(i + 2) };
+}
+template <> math::vec4 make_value<math::vec4>(size_t i)
+{
+    return math::vec4{ make_float(i), make_float(i + 1), make_float(i + 2), make_float(i + 3) };
+}
+template <> math::vec4i make_value<math::vec4i>(size_t i)
+{
+    int32_t v = static_cast<int32_t>(i % 1000) + 1;
+    return math::vec4i{ v, v + 1, v + 2, v + 3 };
+}
+template <> math::matrix4 make_value<math::matrix4>(size_t i)
+{
+    // rotation, scale and translation keep the matrix well conditioned for the inverses
+    math::transform t{ make_value<math::vec3>(i),
+        math::from_axis_angle(math::vec3{ 0.f, 0.f, 1.f }, make_float(i + 5)),
+        make_value<math::vec3>(i + 7) };
+    return math::to_matrix(t);
+}
+template <> math::quat make_value<math::quat>(size_t i)
+{
+    return math::from_axis_angle(math::normalize(make_value<math::vec3>(i)), make_float(i + 3));
+}
+template <> math::transform make_value<math::transform>(size_t i)
+{
+    return math::transform{ make_value<math::vec3>(i), make_value<math::quat>(i + 1), make_value<math::vec3>(i + 2) };
+}
+
+template <typename T> std::vector<T> make_values(size_t size, size_t seed)
+{
+    std::vector<T> out;
+    out.reserve(size);
+    for (size_t i = 0; i < size; i++)
+        out.push_back(make_value<T>(i + seed));
+    return out;
+}
+
+template <size_t L> math::vec_stream<float, L> make_stream(size_t size, size_t seed)
+{
+    math::vec_stream<float, L> out;
+    for (size_t i = 0; i < size; i++)
+        out.push_back(make_value<math::vec<float, L>>(i + seed));
+    return out;
+}
+
+// std::vector<bool> is bit packed, store comparison results as bytes instead
+template <typename T> using storage_t = std::conditional_t<std::is_same_v<T, bool>, uint8_t, T>;
+
+class registry
+{
+    public:
+    // out[i] = op(a[i])
+    template <typename A, typename Op> void unary(std::string const& name, Op op)
+    {
+        for (size_t size : sizes)
+            benchmarks.push_back(benchmark{ name, size, [size, op]() -> runner {
+                                               auto a = std::make_shared<std::vector<A>>(make_values<A>(size, 0));
+                                               using R = storage_t<decltype(op((*a)[0]))>;
+                                               auto out = std::make_shared<std::vector<R>>(size);
+                                               return [a, out, op](size_t iterations) {
+                                                   for (size_t it = 0; it < iterations; it++)
+                                                   {
+                                                       for (size_t i = 0; i < a->size(); i++)
+                                                           (*out)[i] = op((*a)[i]);
+                                                       do_not_optimize(out->data());
+                                                   }
+                                               };
+                                           } });
+    }
+    // out[i] = op(a[i], b[i])
+    template <typename A, typename B, typename Op> void binary(std::string const& name, Op op)
+    {
+        for (size_t size : sizes)
+            benchmarks.push_back(benchmark{ name, size, [size, op]() -> runner {
+                                               auto a = std::make_shared<std::vector<A>>(make_values<A>(size, 0));
+                                               auto b = std::make_shared<std::vector<B>>(make_values<B>(size, 1));
+                                               using R = storage_t<decltype(op((*a)[0], (*b)[0]))>;
+                                               auto out = std::make_shared<std::vector<R>>(size);
+                                               return [a, b, out, op](size_t iterations) {
+                                                   for (size_t it = 0; it < iterations; it++)
+                                                   {
+                                                       for (size_t i = 0; i < a->size(); i++)
+                                                           (*out)[i] = op((*a)[i], (*b)[i]);
+                                                       do_not_optimize(out->data());
+                                                   }
+                                               };
+                                           } });
+    }
+    // setup(size) prepares the inputs and returns an operation over the whole arrays, for the batched
+    // span and stream functions
+    template <typename Setup> void batch(std::string const& name, Setup setup)
+    {
+        for (size_t size : sizes)
+            benchmarks.push_back(benchmark{ name, size, [size, setup]() -> runner {
+                                               auto op = setup(size);
+                                               return [op](size_t iterations) {
+                                                   for (size_t it = 0; it < iterations; it++)
+                                                       op();
+                                               };
+                                           } });
+    }
+
+    std::vector<benchmark> benchmarks;
+};
+
+// Memberwise operators and utilities shared by every vec type
+template <typename V> void register_vec(registry& r, std::string const& type)
+{
+    using T = typename std::remove_cvref_t<decltype(std::declval<V>()[0])>;
+    r.unary<V>(type + "/negate", [](V const& a) { return -a; });
+    r.binary<V, V>(type + "/add", [](V const& a, V const& b) { return a + b; });
+    r.binary<V, V>(type + "/sub", [](V const& a, V const& b) { return a - b; });
+    r.binary<V, V>(type + "/mul", [](V const& a, V const& b) { return a * b; });
+    r.unary<V>(type + "/add_scalar", [](V const& a) { return a + T{ 3 }; });
+    r.unary<V>(type + "/sub_scalar", [](V const& a) { return a - T{ 3 }; });
+    r.unary<V>(type + "/mul_scalar", [](V const& a) { return a * T{ 3 }; });
+    r.unary<V>(type + "/scalar_sub", [](V const& a) { return T{ 3 } - a; });
+    r.binary<V, V>(type + "/add_assign", [](V a, V const& b) { return a += b; });
+    r.binary<V, V>(type + "/sub_assign", [](V a, V const& b) { return a -= b; });
+    r.binary<V, V>(type + "/mul_assign", [](V a, V const& b) { return a *= b; });
+    r.binary<V, V>(type + "/dot", [](V const& a, V const& b) { return math::dot(a, b); });
+    r.binary<V, V>(type + "/min", [](V const& a, V const& b) { return math::min(a, b); });
+    r.binary<V, V>(type + "/max", [](V const& a, V const& b) { return math::max(a, b); });
+    r.unary<V>(type + "/abs", [](V const& a) { return math::abs(a); });
+    r.unary<V>(type + "/clamp", [](V const& a) { return math::clamp(a, T{ 1 }, T{ 3 }); });
+    r.binary<V, V>(type + "/clamp_vec", [](V const& a, V const& b) { return math::clamp(a, b, b + T{ 1 }); });
+    r.binary<V, V>(type + "/equal", [](V const& a, V const& b) { return a == b; });
+}
+
+template <typename V> void register_float_vec(registry& r, std::string const& type)
+{
+    register_vec<V>(r, type);
+    r.binary<V, V>(type + "/div", [](V const& a, V const& b) { return a / b; });
+    r.binary<V, V>(type + "/div_assign", [](V a, V const& b) { return a /= b; });
+    r.unary<V>(type + "/div_scalar", [](V const& a) { return a / 3.f; });
+    r.unary<V>(type + "/scalar_div", [](V const& a) { return 3.f / a; });
+    r.binary<V, V>(type + "/lerp", [](V const& a, V const& b) { return math::lerp(a, b, 0.25f); });
+    r.unary<V>(type + "/length", [](V const& a) { return math::length(a); });
+    r.unary<V>(type + "/normalize", [](V const& a) { return math::normalize(a); });
+}
+
+template <size_t L> void register_stream(registry& r, std::string const& type)
+{
+    using stream = math::vec_stream<float, L>;
+    auto binary = [&r, &type](std::string const& op_name, void (*op)(stream const&, stream const&, stream&)) {
+        r.batch(type + "_stream/" + op_name, [op](size_t size) {
+            auto a = std::make_shared<stream>(make_stream<L>(size, 0));
+            auto b = std::make_shared<stream>(make_stream<L>(size, 1));
+            auto out = std::make_shared<stream>(size);
+            return [a, b, out, op]() {
+                op(*a, *b, *out);
+                do_not_optimize(out->x().data());
+            };
+        });
+    };
+    binary("add", [](stream const& a, stream const& b, stream& out) { math::add(a, b, out); });
+    binary("sub", [](stream const& a, stream const& b, stream& out) { math::sub(a, b, out); });
+    binary("mul", [](stream const& a, stream const& b, stream& out) { math::mul(a, b, out); });
+    binary("min", [](stream const& a, stream const& b, stream& out) { math::min(a, b, out); });
+    binary("max", [](stream const& a, stream const& b, stream& out) { math::max(a, b, out); });
+    binary("lerp", [](stream const& a, stream const& b, stream& out) { math::lerp(a, b, 0.25f, out); });
+    binary("fma", [](stream const& a, stream const& b, stream& out) { math::fma(a, b, a, out); });
+    binary("clamp", [](stream const& a, stream const&, stream& out) { math::clamp(a, 1.f, 3.f, out); });
+    binary("normalize", [](stream const& a, stream const&, stream& out) { math::normalize(a, out); });
+    r.batch(type + "_stream/dot", [](size_t size) {
+        auto a = std::make_shared<stream>(make_stream<L>(size, 0));
+        auto b = std::make_shared<stream>(make_stream<L>(size, 1));
+        auto out = std::make_shared<math::float_stream>(size);
+        return [a, b, out]() {
+            math::dot(*a, *b, *out);
+            do_not_optimize(out->x().data());
+        };
+    });
+}
+
+void register_matrix(registry& r)
+{
+    using math::matrix4;
+    r.binary<matrix4, matrix4>("matrix4/mul", [](matrix4 const& a, matrix4 const& b) { return a * b; });
+    r.binary<matrix4, math::vec4>("matrix4/mul_vec4", [](matrix4 const& a, math::vec4 const& b) { return a * b; });
+    r.unary<matrix4>("matrix4/transpose", [](matrix4 const& a) { return math::transpose(a); });
+    r.unary<matrix4>("matrix4/inverse", [](matrix4 const& a) { return math::inverse(a); });
+    r.unary<matrix4>("matrix4/affine_inverse", [](matrix4 const& a) { return math::affine_inverse(a); });
+    r.unary<matrix4>("matrix4/determinant", [](matrix4 const& a) { return math::determinant(a); });
+    r.batch("matrix4/transform_points", [](size_t size) {
+        auto points = std::make_shared<std::vector<math::vec3>>(make_values<math::vec3>(size, 0));
+        auto out = std::make_shared<std::vector<math::vec3>>(size);
+        matrix4 m = make_value<matrix4>(3);
+        return [points, out, m]() {
+            math::transform_points(m, *points, *out);
+            do_not_optimize(out->data());
+        };
+    });
+    r.batch("matrix4/transform_vectors", [](size_t size) {
+        auto points = std::make_shared<std::vector<math::vec3>>(make_values<math::vec3>(size, 0));
+        auto out = std::make_shared<std::vector<math::vec3>>(size);
+        matrix4 m = make_value<matrix4>(3);
+        return [points, out, m]() {
+            math::transform_vectors(m, *points, *out);
+            do_not_optimize(out->data());
+        };
+    });
+}
+
+void register_quat(registry& r)
+{
+    using math::quat;
+    r.binary<quat, quat>("quat/mul", [](quat const& a, quat const& b) { return a * b; });
+    r.binary<quat, math::vec3>("quat/rotate", [](quat const& a, math::vec3 const& b) { return a * b; });
+    r.binary<quat, quat>("quat/nlerp", [](quat const& a, quat const& b) { return math::nlerp(a, b, 0.25f); });
+    r.binary<quat, quat>("quat/slerp", [](quat const& a, quat const& b) { return math::slerp(a, b, 0.25f); });
+    r.unary<quat>("quat/to_matrix", [](quat const& a) { return math::to_matrix(a); });
+    r.unary<math::transform>("transform/to_matrix", [](math::transform const& a) { return math::to_matrix(a); });
+    r.batch("transform/propagate_world_matrices", [](size_t size) {
+        // a forest of chains four levels deep, already depth sorted
+        auto local = std::make_shared<std::vector<math::transform>>(make_values<math::transform>(size, 0));
+        auto parents = std::make_shared<std::vector<uint32_t>>(size);
+        size_t roots = (size + 3) / 4;
+        for (size_t i = 0; i < size; i++)
+            (*parents)[i] = i < roots ? math::no_parent : static_cast<uint32_t>(i - roots);
+        auto world = std::make_shared<std::vector<math::matrix4>>(size);
+        return [local, parents, world]() {
+            math::propagate_world_matrices(*local, *parents, *world);
+            do_not_optimize(world->data());
+        };
+    });
+}
+
+registry make_registry()
+{
+    registry r;
+    register_float_vec<math::vec2>(r, "vec2");
+    register_float_vec<math::vec3>(r, "vec3");
+    register_float_vec<math::vec4>(r, "vec4");
+    register_vec<math::vec4i>(r, "vec4i");
+    r.binary<math::vec3, math::vec3>("vec3/cross", [](math::vec3 const& a, math::vec3 const& b) { return math::cross(a, b); });
+    register_stream<2>(r, "vec2");
+    register_stream<3>(r, "vec3");
+    register_stream<4>(r, "vec4");
+    register_matrix(r);
+    register_quat(r);
+    return r;
+}
+
+double elapsed_ns(runner const& run, size_t iterations)
+{
+    auto start = clock_type::now();
+    run(iterations);
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count());
+}
+
+result measure(benchmark const& bench, options const& opts)
+{
+    // Grow the iteration count until one sample takes long enough for the timer resolution and call
+    // overhead to vanish in the noise
+    runner run = bench.prepare();
+    double const min_sample_ns = opts.min_sample_ms * 1e6;
+    size_t iterations = 1;
+    double time = elapsed_ns(run, iterations);
+    while (time < min_sample_ns && iterations < (size_t{ 1 } << 40))
+    {
+        double scale = time > 0.0 ? min_sample_ns / time * 1.2 : 10.0;
+        iterations = std::max(iterations + 1, static_cast<size_t>(static_cast<double>(iterations) * std::min(scale, 10.0)));
+        time = elapsed_ns(run, iterations);
+    }
+
+    std::vector<double> per_element;
+    per_element.reserve(opts.samples);
+    double const element_count = static_cast<double>(iterations) * static_cast<double>(bench.size);
+    for (size_t s = 0; s < opts.samples; s++)
+        per_element.push_back(elapsed_ns(run, iterations) / element_count);
+    std::sort(per_element.begin(), per_element.end());
+    return result{ bench.name, bench.size, iterations, per_element[per_element.size() / 2], per_element.front(),
+        per_element.back() };
+}
+
+std::string compiler_name()
+{
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "unknown";
+#endif
+}
+
+char const* simd_backend()
+{
+#if defined(ORANGE_MATH_SIMD_SSE41)
+    return "sse4.1";
+#elif defined(ORANGE_MATH_SIMD_SSE)
+    return "sse2";
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+bool parse_options(int argc, char** argv, options& opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--json" && has_value)
+            opts.json_path = argv[++i];
+        else if (arg == "--filter" && has_value)
+            opts.filter = argv[++i];
+        else if (arg == "--samples" && has_value)
+            opts.samples = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (arg == "--min-time" && has_value)
+            opts.min_sample_ms = std::stod(argv[++i]);
+        else
+        {
+            std::fprintf(stderr,
+                "Usage: %s [--json <path>] [--filter <substring>] [--samples <count>] [--min-time <ms>]\n",
+                argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    options opts;
+    if (!parse_options(argc, argv, opts)) return 1;
+
+    registry r = make_registry();
+    std::vector<result> results;
+    std::printf("simd backend: %s, stream kernels: %s\n", simd_backend(), math::to_string(math::get_stream_isa()));
+    std::printf("%-44s %8s %14s %14s\n", "benchmark", "size", "median ns/op", "min ns/op");
+    for (auto const& bench : r.benchmarks)
+    {
+        if (!opts.filter.empty() && bench.name.find(opts.filter) == std::string::npos) continue;
+        results.push_back(measure(bench, opts));
+        auto const& res = results.back();
+        std::printf("%-44s %8zu %14.3f %14.3f\n", res.name.c_str(), res.size, res.median_ns, res.min_ns);
+    }
+
+    if (opts.json_path.empty()) return 0;
+
+    nlohmann::json out;
+    out["context"] = {
+        { "date", std::time(nullptr) },
+        { "compiler", compiler_name() },
+        { "simd_backend", simd_backend() },
+        { "stream_isa", math::to_string(math::get_stream_isa()) },
+        { "samples", opts.samples },
+        { "min_sample_ms", opts.min_sample_ms },
+    };
+    out["benchmarks"] = nlohmann::json::array();
+    for (auto const& res : results)
+    {
+        out["benchmarks"].push_back({
+            { "name", res.name },
+            { "size", res.size },
+            { "iterations", res.iterations },
+            { "median_ns", res.median_ns },
+            { "min_ns", res.min_ns },
+            { "max_ns", res.max_ns },
+        });
+    }
+    std::ofstream file(opts.json_path);
+    if (!file)
+    {
+        std::fprintf(stderr, "Failed to open %s for writing\n", opts.json_path.c_str());
+        return 1;
+    }
+    file << out.dump(4) << '\n';
+    return 0;
+}
@@ -0,0 +1,982 @@
+#include "gltf_loader.h"
+
+#include <cgltf.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "core/profiler.h"
+#include "mapped_file.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+struct CgltfDeleter
+{
+    void operator()(cgltf_data* data) const noexcept { cgltf_free(data); }
+};
+using CgltfData = std::unique_ptr<cgltf_data, CgltfDeleter>;
+
+const char* to_string(cgltf_result result) noexcept
+{
+    switch (result)
+    {
+        case cgltf_result_success: return "success";
+        case cgltf_result_data_too_short: return "data_too_short";
+        case cgltf_result_unknown_format: return "unknown_format";
+        case cgltf_result_invalid_json: return "invalid_json";
+        case cgltf_result_invalid_gltf: return "invalid_gltf";
+        case cgltf_result_invalid_options: return "invalid_options";
+        case cgltf_result_file_not_found: return "file_not_found";
+        case cgltf_result_io_error: return "io_error";
+        case cgltf_result_out_of_memory: return "out_of_memory";
+        case cgltf_result_legacy_gltf: return "legacy_gltf";
+        default: return "unknown";
+    }
+}
+
+std::runtime_error load_error(std::filesystem::path const& path, std::string const& what)
+{
+    return std::runtime_error("Failed to load glTF "s + path.string() + ": " + what);
+}
+
+std::string string_of(const char* name) { return name != nullptr ? std::string(name) : ""; }
+
+template <typename T> uint32_t index_of(const T* item, const T* first) noexcept
+{
+    return item != nullptr ? static_cast<uint32_t>(item - first) : no_index;
+}
+
+bool is_data_uri(const char* uri) noexcept { return std::strncmp(uri, "data:", 5) == 0; }
+
+// Relative URIs are percent encoded and relative to the glTF file
+std::filesystem::path resolve_uri(std::filesystem::path const& gltf_path, const char* uri)
+{
+    std::string decoded = uri;
+    cgltf_decode_uri(decoded.data());
+    decoded.resize(std::strlen(decoded.c_str()));
+    return gltf_path.parent_path() /
+           std::filesystem::path(std::u8string(decoded.begin(), decoded.end()));
+}
+
+std::vector<std::byte> decode_base64(std::string_view text)
+{
+    auto value_of = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    };
+    std::vector<std::byte> out;
+    out.reserve(text.size() / 4 * 3);
+    uint32_t bits = 0;
+    int bit_count = 0;
+    for (char c : text)
+    {
+        int value = value_of(c);
+        // padding ends the data
+        if (value < 0) break;
+        bits = bits << 6 | static_cast<uint32_t>(value);
+        bit_count += 6;
+        if (bit_count >= 8)
+        {
+            bit_count -= 8;
+            out.push_back(static_cast<std::byte>((bits >> bit_count) & 0xFFu));
+        }
+    }
+    return out;
+}
+
+// Maps every buffer stored in a file of its own and hands it to cgltf, which then neither reads
+// nor frees it. Embedded buffers are left to cgltf_load_buffers().
+std::vector<MappedFile> map_external_buffers(cgltf_data& data, std::filesystem::path const& path)
+{
+    std::vector<MappedFile> files;
+    for (cgltf_size i = 0; i < data.buffers_count; i++)
+    {
+        auto& buffer = data.buffers[i];
+        if (buffer.data != nullptr || buffer.uri == nullptr || is_data_uri(buffer.uri)) continue;
+        auto& file = files.emplace_back(resolve_uri(path, buffer.uri));
+        if (file.bytes().size() < buffer.size)
+            throw load_error(path, "buffer "s + buffer.uri + " is shorter than declared");
+        buffer.data = const_cast<std::byte*>(file.bytes().data());
+        buffer.data_free_method = cgltf_data_free_method_none;
+    }
+    return files;
+}
+
+const std::byte* data_of(cgltf_buffer_view const& buffer_view) noexcept
+{
+    // set when an extension decoded the view
+    if (buffer_view.data != nullptr) return static_cast<const std::byte*>(buffer_view.data);
+    if (buffer_view.buffer->data == nullptr) return nullptr;
+    return static_cast<const std::byte*>(buffer_view.buffer->data) + buffer_view.offset;
+}
+
+// Elements of an accessor in the mapped buffers
+struct AccessorView
+{
+    const std::byte* data = nullptr;
+    size_t stride = 0;
+    size_t count = 0;
+    size_t components = 0;
+    cgltf_component_type component_type = cgltf_component_type_r_32f;
+    bool normalized = false;
+};
+
+// An accessor's data. Sparse accessors and ones without a buffer view are the only ones unpacked
+// into memory of their own first, since their values aren't stored anywhere as a whole.
+struct AccessorSource
+{
+    AccessorView view;
+    std::vector<float> unpacked;
+};
+
+AccessorSource source_of(cgltf_accessor const& accessor)
+{
+    AccessorSource source;
+    source.view.count = accessor.count;
+    source.view.components = cgltf_num_components(accessor.type);
+    if (!accessor.is_sparse && accessor.buffer_view != nullptr &&
+        data_of(*accessor.buffer_view) != nullptr)
+    {
+        source.view.data = data_of(*accessor.buffer_view) + accessor.offset;
+        source.view.stride = accessor.stride;
+        source.view.component_type = accessor.component_type;
+        source.view.normalized = accessor.normalized != 0;
+        return source;
+    }
+    source.unpacked.resize(accessor.count * source.view.components);
+    cgltf_accessor_unpack_floats(&accessor, source.unpacked.data(), source.unpacked.size());
+    source.view.data = reinterpret_cast<const std::byte*>(source.unpacked.data());
+    source.view.stride = source.view.components * sizeof(float);
+    return source;
+}
+
+// Where one component of every element goes, element i at base + i * stride
+struct ComponentTarget
+{
+    std::byte* base;
+    size_t stride;
+};
+
+// Applies glTF's normalization for normalized integer components
+template <typename Source> float read_component(const std::byte* at, bool normalized) noexcept
+{
+    Source value;
+    std::memcpy(&value, at, sizeof(Source));
+    if constexpr (std::is_same_v<Source, float>)
+        return value;
+    else
+    {
+        auto as_float = static_cast<float>(value);
+        if (!normalized) return as_float;
+        constexpr auto max = static_cast<float>(std::numeric_limits<Source>::max());
+        if constexpr (std::is_signed_v<Source>)
+            return std::max(as_float / max, -1.f);
+        else
+            return as_float / max;
+    }
+}
+
+template <typename Target> void store(std::byte* at, Target value) noexcept
+{
+    std::memcpy(at, &value, sizeof(Target));
+}
+
+template <typename Target> Target quantize(float value, float low, float scale) noexcept
+{
+    return static_cast<Target>(std::lround(std::clamp(value, low, 1.f) * scale));
+}
+
+template <VertexComponent Component> void write_component(std::byte* at, float value) noexcept
+{
+    if constexpr (Component == VertexComponent::float32)
+        store(at, value);
+    else if constexpr (Component == VertexComponent::unorm8)
+        store(at, quantize<uint8_t>(value, 0.f, 255.f));
+    else if constexpr (Component == VertexComponent::snorm8)
+        store(at, quantize<int8_t>(value, -1.f, 127.f));
+    else if constexpr (Component == VertexComponent::uint8)
+        store(at, static_cast<uint8_t>(std::lround(std::clamp(value, 0.f, 255.f))));
+    else if constexpr (Component == VertexComponent::unorm16)
+        store(at, quantize<uint16_t>(value, 0.f, 65535.f));
+    else if constexpr (Component == VertexComponent::snorm16)
+        store(at, quantize<int16_t>(value, -1.f, 32767.f));
+    else
+        store(at, static_cast<uint16_t>(std::lround(std::clamp(value, 0.f, 65535.f))));
+}
+
+template <typename Source, VertexComponent Component>
+void convert(AccessorView const& view, std::span<const ComponentTarget> targets) noexcept
+{
+    size_t read_count = std::min(view.components, targets.size());
+    for (size_t i = 0; i < view.count; i++)
+    {
+        const std::byte* element = view.data + i * view.stride;
+        for (size_t c = 0; c < read_count; c++)
+            write_component<Component>(targets[c].base + i * targets[c].stride,
+                read_component<Source>(element + c * sizeof(Source), view.normalized));
+        // a missing alpha or w is 1, everything else missing stays 0
+        if (targets.size() == 4 && read_count < 4)
+            write_component<Component>(targets[3].base + i * targets[3].stride, 1.f);
+    }
+}
+
+template <typename Source>
+void convert_from(
+    AccessorView const& view, VertexComponent component, std::span<const ComponentTarget> targets)
+{
+    using enum VertexComponent;
+    switch (component)
+    {
+        case float32: convert<Source, float32>(view, targets); break;
+        case unorm8: convert<Source, unorm8>(view, targets); break;
+        case snorm8: convert<Source, snorm8>(view, targets); break;
+        case uint8: convert<Source, uint8>(view, targets); break;
+        case unorm16: convert<Source, unorm16>(view, targets); break;
+        case snorm16: convert<Source, snorm16>(view, targets); break;
+        case uint16: convert<Source, uint16>(view, targets); break;
+    }
+}
+
+// Converts every element of `view` in one pass, the source type is resolved once per accessor
+void convert(
+    AccessorView const& view, VertexComponent component, std::span<const ComponentTarget> targets)
+{
+    switch (view.component_type)
+    {
+        case cgltf_component_type_r_8: convert_from<int8_t>(view, component, targets); break;
+        case cgltf_component_type_r_8u: convert_from<uint8_t>(view, component, targets); break;
+        case cgltf_component_type_r_16: convert_from<int16_t>(view, component, targets); break;
+        case cgltf_component_type_r_16u: convert_from<uint16_t>(view, component, targets); break;
+        case cgltf_component_type_r_32u: convert_from<uint32_t>(view, component, targets); break;
+        case cgltf_component_type_r_32f: convert_from<float>(view, component, targets); break;
+        default: break;
+    }
+}
+
+template <typename T, size_t L>
+void read_stream(cgltf_accessor const& accessor, VertexComponent component,
+    math::vec_stream<T, L>& stream)
+{
+    auto source = source_of(accessor);
+    stream.resize(accessor.count);
+    ComponentTarget targets[L];
+    for (size_t c = 0; c < L; c++)
+        targets[c] =
+            ComponentTarget{ reinterpret_cast<std::byte*>(stream.component(c)), sizeof(T) };
+    convert(source.view, component, targets);
+}
+
+void read_packed(cgltf_accessor const& accessor, VertexElement const& element, uint32_t stride,
+    std::vector<std::byte>& vertices)
+{
+    auto source = source_of(accessor);
+    VertexComponent component = component_of(element.format);
+    uint32_t size = component_size(component);
+    ComponentTarget targets[4];
+    uint32_t count = component_count(element.format);
+    for (uint32_t c = 0; c < count; c++)
+        targets[c] = ComponentTarget{ vertices.data() + element.offset + c * size, stride };
+    convert(source.view, component, std::span<const ComponentTarget>(targets, count));
+}
+
+std::vector<uint32_t> read_indices(cgltf_accessor const& accessor)
+{
+    std::vector<uint32_t> indices(accessor.count);
+    auto source = source_of(accessor);
+    auto const& view = source.view;
+    auto widen = [&]<typename Index>(Index) {
+        for (size_t i = 0; i < view.count; i++)
+        {
+            Index index;
+            std::memcpy(&index, view.data + i * view.stride, sizeof(Index));
+            indices[i] = static_cast<uint32_t>(index);
+        }
+    };
+    switch (view.component_type)
+    {
+        case cgltf_component_type_r_8u: widen(uint8_t{}); break;
+        case cgltf_component_type_r_16u: widen(uint16_t{}); break;
+        case cgltf_component_type_r_32u: widen(uint32_t{}); break;
+        // unpacked sparse indices
+        case cgltf_component_type_r_32f: widen(float{}); break;
+        default: break;
+    }
+    return indices;
+}
+
+// Accessor data that keeps its layout, like animation keys and matrices
+std::vector<float> read_floats(cgltf_accessor const& accessor)
+{
+    std::vector<float> values(accessor.count * cgltf_num_components(accessor.type));
+    cgltf_accessor_unpack_floats(&accessor, values.data(), values.size());
+    return values;
+}
+
+Aabb bounds_of(cgltf_accessor const& positions) noexcept
+{
+    Aabb bounds;
+    if (positions.has_min && positions.has_max)
+    {
+        bounds.min = math::vec3{ positions.min[0], positions.min[1], positions.min[2] };
+        bounds.max = math::vec3{ positions.max[0], positions.max[1], positions.max[2] };
+        return bounds;
+    }
+    // min and max are required for positions, this is for files that skip them anyway
+    for (cgltf_size i = 0; i < positions.count; i++)
+    {
+        float value[3]{};
+        cgltf_accessor_read_float(&positions, i, value, 3);
+        math::vec3 point{ value[0], value[1], value[2] };
+        bounds.min = i == 0 ? point : math::min(bounds.min, point);
+        bounds.max = i == 0 ? point : math::max(bounds.max, point);
+    }
+    return bounds;
+}
+
+std::optional<VertexAttribute> attribute_of(cgltf_attribute const& attribute) noexcept
+{
+    switch (attribute.type)
+    {
+        case cgltf_attribute_type_position: return VertexAttribute::position;
+        case cgltf_attribute_type_normal: return VertexAttribute::normal;
+        case cgltf_attribute_type_tangent: return VertexAttribute::tangent;
+        case cgltf_attribute_type_texcoord:
+            if (attribute.index == 0) return VertexAttribute::texcoord0;
+            if (attribute.index == 1) return VertexAttribute::texcoord1;
+            return std::nullopt;
+        case cgltf_attribute_type_color:
+            if (attribute.index == 0) return VertexAttribute::color0;
+            return std::nullopt;
+        case cgltf_attribute_type_joints:
+            if (attribute.index == 0) return VertexAttribute::joints0;
+            return std::nullopt;
+        case cgltf_attribute_type_weights:
+            if (attribute.index == 0) return VertexAttribute::weights0;
+            return std::nullopt;
+        default: return std::nullopt;
+    }
+}
+
+Topology topology_of(cgltf_primitive_type type) noexcept
+{
+    switch (type)
+    {
+        case cgltf_primitive_type_points: return Topology::points;
+        case cgltf_primitive_type_lines: return Topology::lines;
+        case cgltf_primitive_type_line_loop: return Topology::line_loop;
+        case cgltf_primitive_type_line_strip: return Topology::line_strip;
+        case cgltf_primitive_type_triangle_strip: return Topology::triangle_strip;
+        case cgltf_primitive_type_triangle_fan: return Topology::triangle_fan;
+        default: return Topology::triangles;
+    }
+}
+
+void read_soa(cgltf_accessor const& accessor, VertexAttribute attribute, Primitive& primitive)
+{
+    switch (attribute)
+    {
+        case VertexAttribute::position:
+            read_stream(accessor, VertexComponent::float32, primitive.positions);
+            break;
+        case VertexAttribute::normal:
+            read_stream(accessor, VertexComponent::float32, primitive.normals);
+            break;
+        case VertexAttribute::tangent:
+            read_stream(accessor, VertexComponent::float32, primitive.tangents);
+            break;
+        case VertexAttribute::texcoord0:
+            read_stream(accessor, VertexComponent::float32, primitive.texcoords0);
+            break;
+        case VertexAttribute::texcoord1:
+            read_stream(accessor, VertexComponent::float32, primitive.texcoords1);
+            break;
+        case VertexAttribute::color0:
+            read_stream(accessor, VertexComponent::float32, primitive.colors);
+            break;
+        case VertexAttribute::joints0:
+            read_stream(accessor, VertexComponent::uint16, primitive.joints);
+            break;
+        case VertexAttribute::weights0:
+            read_stream(accessor, VertexComponent::float32, primitive.weights);
+            break;
+    }
+}
+
+// The vertex of each triangle corner, for triangle list primitives
+uint32_t corner_vertex(Primitive const& primitive, size_t corner) noexcept
+{
+    return primitive.indices.empty() ? static_cast<uint32_t>(corner) : primitive.indices[corner];
+}
+
+size_t corner_count(Primitive const& primitive) noexcept
+{
+    size_t count = primitive.indices.empty() ? primitive.vertex_count : primitive.indices.size();
+    return count / 3 * 3;
+}
+
+template <typename T, size_t L>
+void gather(math::vec_stream<T, L>& stream, std::span<const uint32_t> vertices)
+{
+    if (stream.empty()) return;
+    math::vec_stream<T, L> gathered(vertices.size());
+    for (size_t c = 0; c < L; c++)
+        for (size_t i = 0; i < vertices.size(); i++)
+            gathered.component(c)[i] = stream.component(c)[vertices[i]];
+    stream = std::move(gathered);
+}
+
+// Gives every triangle corner a vertex of its own, flat normals can't be shared between triangles
+void unweld(Primitive& primitive, uint32_t stride)
+{
+    std::vector<uint32_t> vertices(corner_count(primitive));
+    for (size_t i = 0; i < vertices.size(); i++)
+        vertices[i] = corner_vertex(primitive, i);
+    gather(primitive.positions, vertices);
+    gather(primitive.normals, vertices);
+    gather(primitive.tangents, vertices);
+    gather(primitive.texcoords0, vertices);
+    gather(primitive.texcoords1, vertices);
+    gather(primitive.colors, vertices);
+    gather(primitive.joints, vertices);
+    gather(primitive.weights, vertices);
+    if (!primitive.vertices.empty())
+    {
+        std::vector<std::byte> packed(vertices.size() * stride);
+        for (size_t i = 0; i < vertices.size(); i++)
+            std::memcpy(packed.data() + i * stride,
+                primitive.vertices.data() + size_t{ vertices[i] } * stride,
+                stride);
+        primitive.vertices = std::move(packed);
+    }
+    primitive.indices.clear();
+    primitive.vertex_count = static_cast<uint32_t>(vertices.size());
+}
+
+// glTF asks for flat normals when a primitive has none, expects an unwelded primitive
+void generate_normals(Primitive& primitive)
+{
+    auto const& positions = primitive.positions;
+    primitive.normals.resize(primitive.vertex_count);
+    for (size_t i = 0; i + 2 < primitive.vertex_count; i += 3)
+    {
+        math::vec3 p0 = positions.get(i);
+        math::vec3 normal = math::cross(positions.get(i + 1) - p0, positions.get(i + 2) - p0);
+        float length = math::length(normal);
+        // degenerate triangles get any unit normal rather than NaN
+        normal = length > 0.f ? normal / length : math::vec3{ 0.f, 0.f, 1.f };
+        for (size_t v = i; v < i + 3; v++)
+            primitive.normals.set(v, normal);
+    }
+}
+
+// Tangents from the texcoord gradients of the triangles around each vertex, made orthogonal to the
+// normal (Lengyel). glTF specifies MikkTSpace, which this matches for well formed meshes.
+void generate_tangents(Primitive& primitive, math::vec_stream<float, 2> const& texcoords)
+{
+    math::vec_stream<float, 3> tangents(primitive.vertex_count);
+    math::vec_stream<float, 3> bitangents(primitive.vertex_count);
+    for (size_t i = 0; i < corner_count(primitive); i += 3)
+    {
+        uint32_t v[3] = { corner_vertex(primitive, i),
+            corner_vertex(primitive, i + 1),
+            corner_vertex(primitive, i + 2) };
+        math::vec3 e1 = primitive.positions.get(v[1]) - primitive.positions.get(v[0]);
+        math::vec3 e2 = primitive.positions.get(v[2]) - primitive.positions.get(v[0]);
+        math::vec2 d1 = texcoords.get(v[1]) - texcoords.get(v[0]);
+        math::vec2 d2 = texcoords.get(v[2]) - texcoords.get(v[0]);
+        float determinant = d1.x * d2.y - d2.x * d1.y;
+        if (determinant == 0.f) continue;
+        math::vec3 tangent = (e1 * d2.y - e2 * d1.y) / determinant;
+        math::vec3 bitangent = (e2 * d1.x - e1 * d2.x) / determinant;
+        for (uint32_t vertex : v)
+        {
+            tangents.set(vertex, tangents.get(vertex) + tangent);
+            bitangents.set(vertex, bitangents.get(vertex) + bitangent);
+        }
+    }
+    primitive.tangents.resize(primitive.vertex_count);
+    for (size_t i = 0; i < primitive.vertex_count; i++)
+    {
+        math::vec3 normal = primitive.normals.get(i);
+        math::vec3 tangent = tangents.get(i) - normal * math::dot(normal, tangents.get(i));
+        float length = math::length(tangent);
+        if (length > 0.f)
+            tangent = tangent / length;
+        else
+        {
+            // no usable texcoords, any direction perpendicular to the normal
+            math::vec3 axis = std::abs(normal.x) < 0.9f ? math::vec3{ 1.f, 0.f, 0.f }
+                                                        : math::vec3{ 0.f, 1.f, 0.f };
+            tangent = math::normalize(math::cross(normal, axis));
+        }
+        math::vec3 bitangent = math::cross(normal, tangent);
+        float handedness = math::dot(bitangent, bitangents.get(i)) < 0.f ? -1.f : 1.f;
+        primitive.tangents.set(i, math::vec4{ tangent.x, tangent.y, tangent.z, handedness });
+    }
+}
+
+// Writes a generated stream into packed vertices, a missing w is 1 as for the file's attributes
+template <size_t L>
+void write_packed(math::vec_stream<float, L> const& stream, VertexElement const& element,
+    uint32_t stride, std::vector<std::byte>& vertices)
+{
+    VertexComponent component = component_of(element.format);
+    uint32_t count = component_count(element.format);
+    const float one = 1.f;
+    for (uint32_t c = 0; c < count && (c < L || c == 3); c++)
+    {
+        auto data = reinterpret_cast<const std::byte*>(c < L ? stream.component(c) : &one);
+        AccessorView view{ .data = data,
+            .stride = c < L ? sizeof(float) : 0,
+            .count = stream.size(),
+            .components = 1 };
+        ComponentTarget target{ vertices.data() + element.offset + c * component_size(component),
+            stride };
+        convert(view, component, std::span<const ComponentTarget>(&target, 1));
+    }
+}
+
+const cgltf_accessor* find_accessor(cgltf_primitive const& source, VertexAttribute attribute)
+{
+    for (cgltf_size i = 0; i < source.attributes_count; i++)
+        if (attribute_of(source.attributes[i]) == attribute) return source.attributes[i].data;
+    return nullptr;
+}
+
+// Generates the normals and tangents a triangle list primitive is missing, tangents only when its
+// material has a normal map. Packed primitives are generated on float copies of their attributes.
+void generate_missing(cgltf_primitive const& source, std::optional<VertexLayout> const& layout,
+    Primitive& primitive)
+{
+    if (primitive.topology != Topology::triangles) return;
+    auto wanted = [&](VertexAttribute attribute) {
+        return !layout || layout->find(attribute) != nullptr;
+    };
+    const cgltf_texture_view* normal_map =
+        source.material != nullptr && source.material->normal_texture.texture != nullptr
+        ? &source.material->normal_texture
+        : nullptr;
+    auto texcoord = normal_map != nullptr && normal_map->texcoord == 1 ? VertexAttribute::texcoord1
+                                                                       : VertexAttribute::texcoord0;
+    bool tangents = normal_map != nullptr && wanted(VertexAttribute::tangent) &&
+                    find_accessor(source, VertexAttribute::tangent) == nullptr &&
+                    find_accessor(source, texcoord) != nullptr;
+    bool normals = find_accessor(source, VertexAttribute::normal) == nullptr &&
+                   (tangents || wanted(VertexAttribute::normal));
+    if (!normals && !tangents) return;
+
+    Primitive unpacked;
+    if (layout)
+    {
+        unpacked.vertex_count = primitive.vertex_count;
+        unpacked.indices = primitive.indices;
+        read_stream(*find_accessor(source, VertexAttribute::position), VertexComponent::float32,
+            unpacked.positions);
+        if (!normals)
+            read_stream(*find_accessor(source, VertexAttribute::normal), VertexComponent::float32,
+                unpacked.normals);
+        if (tangents)
+            read_soa(*find_accessor(source, texcoord), texcoord, unpacked);
+    }
+    Primitive& geometry = layout ? unpacked : primitive;
+    if (normals)
+    {
+        if (layout) unweld(primitive, layout->stride);
+        unweld(geometry, 0);
+        generate_normals(geometry);
+    }
+    if (tangents)
+        generate_tangents(geometry,
+            texcoord == VertexAttribute::texcoord1 ? geometry.texcoords1 : geometry.texcoords0);
+    if (!layout) return;
+    if (auto const* element = layout->find(VertexAttribute::normal); normals && element)
+        write_packed(geometry.normals, *element, layout->stride, primitive.vertices);
+    if (auto const* element = layout->find(VertexAttribute::tangent); tangents && element)
+        write_packed(geometry.tangents, *element, layout->stride, primitive.vertices);
+}
+
+// Decodes one primitive from start to finish, primitives are independent of each other and are
+// read on as many threads as the loader has
+Primitive read_primitive(cgltf_data const& data, cgltf_primitive const& source,
+    std::optional<VertexLayout> const& layout, std::filesystem::path const& path)
+{
+    ORANGE_PROFILE_SCOPE("read_primitive");
+    if (source.has_draco_mesh_compression)
+        throw load_error(path, "Draco compressed meshes aren't supported");
+    const cgltf_accessor* positions = find_accessor(source, VertexAttribute::position);
+    if (positions == nullptr) throw load_error(path, "primitive without POSITION");
+
+    Primitive primitive;
+    primitive.topology = topology_of(source.type);
+    primitive.vertex_count = static_cast<uint32_t>(positions->count);
+    primitive.material = index_of(source.material, data.materials);
+    primitive.bounds = bounds_of(*positions);
+    if (source.indices != nullptr) primitive.indices = read_indices(*source.indices);
+    if (std::ranges::any_of(
+            primitive.indices, [&](uint32_t index) { return index >= primitive.vertex_count; }))
+        throw load_error(path, "primitive index out of range");
+    if (layout) primitive.vertices.resize(size_t{ layout->stride } * primitive.vertex_count);
+
+    for (cgltf_size i = 0; i < source.attributes_count; i++)
+    {
+        auto const& attribute = source.attributes[i];
+        auto vertex_attribute = attribute_of(attribute);
+        if (!vertex_attribute || attribute.data == nullptr) continue;
+        if (attribute.data->count != positions->count)
+            throw load_error(path, "attribute "s + to_string(*vertex_attribute) +
+                                       " has a different vertex count than POSITION");
+        if (!layout)
+            read_soa(*attribute.data, *vertex_attribute, primitive);
+        else if (auto const* element = layout->find(*vertex_attribute))
+            read_packed(*attribute.data, *element, layout->stride, primitive.vertices);
+    }
+    generate_missing(source, layout, primitive);
+    return primitive;
+}
+
+TextureRef texture_ref(cgltf_data const& data, cgltf_texture_view const& view) noexcept
+{
+    return TextureRef{ .texture = index_of(view.texture, data.textures),
+        .texcoord = static_cast<uint32_t>(view.texcoord),
+        .scale = view.scale };
+}
+
+Material read_material(cgltf_data const& data, cgltf_material const& source)
+{
+    Material material;
+    material.name = string_of(source.name);
+    if (source.has_pbr_metallic_roughness)
+    {
+        auto const& pbr = source.pbr_metallic_roughness;
+        material.base_color_factor = math::vec4{ pbr.base_color_factor[0],
+            pbr.base_color_factor[1],
+            pbr.base_color_factor[2],
+            pbr.base_color_factor[3] };
+        material.metallic_factor = pbr.metallic_factor;
+        material.roughness_factor = pbr.roughness_factor;
+        material.base_color = texture_ref(data, pbr.base_color_texture);
+        material.metallic_roughness = texture_ref(data, pbr.metallic_roughness_texture);
+    }
+    material.emissive_factor = math::vec3{
+        source.emissive_factor[0], source.emissive_factor[1], source.emissive_factor[2] };
+    material.normal = texture_ref(data, source.normal_texture);
+    material.occlusion = texture_ref(data, source.occlusion_texture);
+    material.emissive = texture_ref(data, source.emissive_texture);
+    switch (source.alpha_mode)
+    {
+        case cgltf_alpha_mode_mask: material.alpha_mode = AlphaMode::mask; break;
+        case cgltf_alpha_mode_blend: material.alpha_mode = AlphaMode::blend; break;
+        default: material.alpha_mode = AlphaMode::opaque; break;
+    }
+    material.alpha_cutoff = source.alpha_cutoff;
+    material.double_sided = source.double_sided != 0;
+    return material;
+}
+
+Image read_image(cgltf_image const& source, std::filesystem::path const& path)
+{
+    Image image;
+    image.name = string_of(source.name);
+    image.mime_type = string_of(source.mime_type);
+    if (source.buffer_view != nullptr)
+    {
+        const std::byte* bytes = data_of(*source.buffer_view);
+        if (bytes != nullptr) image.data.assign(bytes, bytes + source.buffer_view->size);
+    }
+    else if (source.uri != nullptr && is_data_uri(source.uri))
+    {
+        // data:image/png;base64,...
+        std::string_view uri = source.uri;
+        size_t comma = uri.find(',');
+        if (comma == std::string_view::npos) throw load_error(path, "malformed image data URI");
+        if (image.mime_type.empty()) image.mime_type = uri.substr(5, uri.find(';') - 5);
+        image.data = decode_base64(uri.substr(comma + 1));
+    }
+    else if (source.uri != nullptr)
+        image.path = resolve_uri(path, source.uri).string();
+    return image;
+}
+
+// glTF allows a matrix instead of translation, rotation and scale, it has to be decomposable
+math::transform decompose(const float matrix[16]) noexcept
+{
+    math::transform out;
+    out.translation = math::vec3{ matrix[12], matrix[13], matrix[14] };
+    math::vec3 columns[3];
+    for (int c = 0; c < 3; c++)
+        columns[c] = math::vec3{ matrix[c * 4], matrix[c * 4 + 1], matrix[c * 4 + 2] };
+    out.scale =
+        math::vec3{ math::length(columns[0]), math::length(columns[1]), math::length(columns[2]) };
+    // a negative determinant mirrors, which the scale carries
+    if (math::dot(math::cross(columns[0], columns[1]), columns[2]) < 0.f)
+        out.scale.x = -out.scale.x;
+    if (out.scale.x == 0.f || out.scale.y == 0.f || out.scale.z == 0.f) return out;
+    for (int c = 0; c < 3; c++)
+        columns[c] = columns[c] / out.scale[static_cast<size_t>(c)];
+
+    // m(row, column) of the rotation
+    auto m = [&](int row, int column) { return columns[column][static_cast<size_t>(row)]; };
+    float trace = m(0, 0) + m(1, 1) + m(2, 2);
+    math::quat& q = out.rotation;
+    if (trace > 0.f)
+    {
+        float s = std::sqrt(trace + 1.f) * 2.f;
+        q = math::quat{ (m(2, 1) - m(1, 2)) / s, (m(0, 2) - m(2, 0)) / s,
+            (m(1, 0) - m(0, 1)) / s, 0.25f * s };
+    }
+    else if (m(0, 0) > m(1, 1) && m(0, 0) > m(2, 2))
+    {
+        float s = std::sqrt(1.f + m(0, 0) - m(1, 1) - m(2, 2)) * 2.f;
+        q = math::quat{ 0.25f * s, (m(0, 1) + m(1, 0)) / s, (m(0, 2) + m(2, 0)) / s,
+            (m(2, 1) - m(1, 2)) / s };
+    }
+    else if (m(1, 1) > m(2, 2))
+    {
+        float s = std::sqrt(1.f + m(1, 1) - m(0, 0) - m(2, 2)) * 2.f;
+        q = math::quat{ (m(0, 1) + m(1, 0)) / s, 0.25f * s, (m(1, 2) + m(2, 1)) / s,
+            (m(0, 2) - m(2, 0)) / s };
+    }
+    else
+    {
+        float s = std::sqrt(1.f + m(2, 2) - m(0, 0) - m(1, 1)) * 2.f;
+        q = math::quat{ (m(0, 2) + m(2, 0)) / s, (m(1, 2) + m(2, 1)) / s, 0.25f * s,
+            (m(1, 0) - m(0, 1)) / s };
+    }
+    q = math::normalize(q);
+    return out;
+}
+
+math::transform local_transform(cgltf_node const& node) noexcept
+{
+    if (node.has_matrix) return decompose(node.matrix);
+    math::transform local;
+    if (node.has_translation)
+        local.translation =
+            math::vec3{ node.translation[0], node.translation[1], node.translation[2] };
+    if (node.has_rotation)
+        local.rotation =
+            math::quat{ node.rotation[0], node.rotation[1], node.rotation[2], node.rotation[3] };
+    if (node.has_scale) local.scale = math::vec3{ node.scale[0], node.scale[1], node.scale[2] };
+    return local;
+}
+
+// Fills the nodes in depth order, returns the new index of every node of the file
+std::vector<uint32_t> read_nodes(cgltf_data const& data, Model& model)
+{
+    std::vector<uint32_t> file_parents(data.nodes_count);
+    for (cgltf_size i = 0; i < data.nodes_count; i++)
+    {
+        uint32_t parent = index_of(data.nodes[i].parent, data.nodes);
+        file_parents[i] = parent == no_index ? math::no_parent : parent;
+    }
+    std::vector<uint32_t> order = math::depth_sorted_order(file_parents);
+    model.parents = math::reorder_parents(file_parents, order);
+
+    std::vector<uint32_t> new_index(order.size());
+    model.nodes.resize(order.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+    {
+        auto const& source = data.nodes[order[i]];
+        new_index[order[i]] = i;
+        model.nodes[i] = Node{ .name = string_of(source.name),
+            .local = local_transform(source),
+            .mesh = index_of(source.mesh, data.meshes),
+            .skin = index_of(source.skin, data.skins) };
+    }
+    return new_index;
+}
+
+Skin read_skin(
+    cgltf_data const& data, cgltf_skin const& source, std::vector<uint32_t> const& new_index)
+{
+    Skin skin;
+    skin.name = string_of(source.name);
+    for (cgltf_size i = 0; i < source.joints_count; i++)
+        skin.joints.push_back(new_index[index_of(source.joints[i], data.nodes)]);
+    if (source.skeleton != nullptr)
+        skin.skeleton = new_index[index_of(source.skeleton, data.nodes)];
+    skin.inverse_bind_matrices.resize(source.joints_count, math::matrix4::identity());
+    if (source.inverse_bind_matrices != nullptr)
+    {
+        size_t count = std::min(source.inverse_bind_matrices->count, source.joints_count);
+        for (size_t i = 0; i < count; i++)
+            cgltf_accessor_read_float(
+                source.inverse_bind_matrices, i, skin.inverse_bind_matrices[i].data, 16);
+    }
+    return skin;
+}
+
+Animation read_animation(cgltf_animation const& source, std::vector<uint32_t> const& new_index,
+    cgltf_data const& data)
+{
+    Animation animation;
+    animation.name = string_of(source.name);
+    for (cgltf_size i = 0; i < source.samplers_count; i++)
+    {
+        auto const& sampler = source.samplers[i];
+        AnimationSampler out;
+        out.times = read_floats(*sampler.input);
+        out.values = read_floats(*sampler.output);
+        switch (sampler.interpolation)
+        {
+            case cgltf_interpolation_type_step: out.interpolation = Interpolation::step; break;
+            case cgltf_interpolation_type_cubic_spline:
+                out.interpolation = Interpolation::cubic_spline;
+                break;
+            default: out.interpolation = Interpolation::linear; break;
+        }
+        if (!out.times.empty()) animation.duration = std::max(animation.duration, out.times.back());
+        animation.samplers.push_back(std::move(out));
+    }
+    for (cgltf_size i = 0; i < source.channels_count; i++)
+    {
+        auto const& channel = source.channels[i];
+        // channels may target nodes of extensions
+        if (channel.target_node == nullptr || channel.sampler == nullptr) continue;
+        AnimationChannel out;
+        out.sampler = index_of(channel.sampler, source.samplers);
+        out.node = new_index[index_of(channel.target_node, data.nodes)];
+        switch (channel.target_path)
+        {
+            case cgltf_animation_path_type_translation:
+                out.path = AnimationPath::translation;
+                break;
+            case cgltf_animation_path_type_rotation: out.path = AnimationPath::rotation; break;
+            case cgltf_animation_path_type_scale: out.path = AnimationPath::scale; break;
+            case cgltf_animation_path_type_weights: out.path = AnimationPath::weights; break;
+            default: continue;
+        }
+        animation.channels.push_back(out);
+    }
+    return animation;
+}
+
+// Calls function(i) for every i in [0, count), spread over the job system's threads when there is
+// one. Every index writes only its own slot of the output, and errors are rethrown in index order
+// once all calls finished, so the result doesn't depend on the thread count or scheduling.
+template <typename F> void for_each_index(JobSystem* job_system, size_t count, F&& function)
+{
+    std::vector<std::exception_ptr> errors(count);
+    auto call = [&](size_t i) {
+        try
+        {
+            function(i);
+        }
+        catch (...)
+        {
+            errors[i] = std::current_exception();
+        }
+    };
+    // a grain of 1, the cost of a primitive or image varies too much for coarser chunks
+    if (job_system)
+        job_system->parallel_for(0, count, call, 1);
+    else
+        for (size_t i = 0; i < count; i++)
+            call(i);
+    for (auto const& error : errors)
+        if (error) std::rethrow_exception(error);
+}
+} // namespace
+
+GltfLoader::GltfLoader(CreateDetails create_details)
+: job_system(create_details.job_system), vertex_layout(std::move(create_details.vertex_layout))
+{
+}
+
+Model GltfLoader::load(std::filesystem::path const& path) const
+{
+    ORANGE_PROFILE_SCOPE("GltfLoader::load");
+    // outlives the cgltf data, a .glb's binary chunk is used in place
+    MappedFile file(path);
+    cgltf_options options{};
+    cgltf_data* parsed = nullptr;
+    cgltf_result result = cgltf_parse(&options, file.bytes().data(), file.bytes().size(), &parsed);
+    if (result != cgltf_result_success)
+        throw load_error(path, "cgltf_parse failed with "s + to_string(result));
+    CgltfData data(parsed);
+
+    std::vector<MappedFile> buffer_files = map_external_buffers(*data, path);
+    std::string path_string = path.string();
+    result = cgltf_load_buffers(&options, data.get(), path_string.c_str());
+    if (result != cgltf_result_success)
+        throw load_error(path, "cgltf_load_buffers failed with "s + to_string(result));
+    // checks every accessor lies within its buffer, which reading them directly relies on
+    result = cgltf_validate(data.get());
+    if (result != cgltf_result_success)
+        throw load_error(path, "cgltf_validate failed with "s + to_string(result));
+
+    Model model;
+    for (cgltf_size i = 0; i < data->buffer_views_count; i++)
+        if (data->buffer_views[i].has_meshopt_compression && data->buffer_views[i].data == nullptr)
+            throw load_error(path, "meshopt compressed buffers aren't supported");
+
+    // flattened, so the jobs split the work by primitive rather than by mesh
+    std::vector<std::pair<cgltf_size, cgltf_size>> primitives;
+    model.meshes.resize(data->meshes_count);
+    for (cgltf_size i = 0; i < data->meshes_count; i++)
+    {
+        model.meshes[i].name = string_of(data->meshes[i].name);
+        model.meshes[i].primitives.resize(data->meshes[i].primitives_count);
+        for (cgltf_size p = 0; p < data->meshes[i].primitives_count; p++)
+            primitives.emplace_back(i, p);
+    }
+    for_each_index(job_system, primitives.size(), [&](size_t i) {
+        auto [mesh, primitive] = primitives[i];
+        model.meshes[mesh].primitives[primitive] =
+            read_primitive(*data, data->meshes[mesh].primitives[primitive], vertex_layout, path);
+    });
+    for (cgltf_size i = 0; i < data->materials_count; i++)
+        model.materials.push_back(read_material(*data, data->materials[i]));
+    model.images.resize(data->images_count);
+    for_each_index(job_system, model.images.size(), [&](size_t i) {
+        model.images[i] = read_image(data->images[i], path);
+    });
+    for (cgltf_size i = 0; i < data->samplers_count; i++)
+    {
+        auto const& source = data->samplers[i];
+        model.samplers.push_back(Sampler{ .mag_filter = static_cast<uint32_t>(source.mag_filter),
+            .min_filter = static_cast<uint32_t>(source.min_filter),
+            .wrap_s = static_cast<uint32_t>(source.wrap_s),
+            .wrap_t = static_cast<uint32_t>(source.wrap_t) });
+    }
+    for (cgltf_size i = 0; i < data->textures_count; i++)
+    {
+        auto const& source = data->textures[i];
+        model.textures.push_back(Texture{ .name = string_of(source.name),
+            .image = index_of(source.image, data->images),
+            .sampler = index_of(source.sampler, data->samplers) });
+    }
+
+    std::vector<uint32_t> new_index = read_nodes(*data, model);
+    const cgltf_scene* scene = data->scene;
+    if (scene == nullptr && data->scenes_count > 0) scene = &data->scenes[0];
+    if (scene != nullptr)
+        for (cgltf_size i = 0; i < scene->nodes_count; i++)
+            model.scene_roots.push_back(new_index[index_of(scene->nodes[i], data->nodes)]);
+    model.skins.resize(data->skins_count);
+    for_each_index(job_system, model.skins.size(), [&](size_t i) {
+        model.skins[i] = read_skin(*data, data->skins[i], new_index);
+    });
+    model.animations.resize(data->animations_count);
+    for_each_index(job_system, model.animations.size(), [&](size_t i) {
+        model.animations[i] = read_animation(data->animations[i], new_index, *data);
+    });
+    return model;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+
+#include "core/job_system.h"
+#include "model.h"
+#include "vertex_layout.h"
+
+// Loads glTF 2.0 files, .gltf with external or embedded buffers and binary .glb, through cgltf.
+//
+// The file and its external buffers are memory mapped, and accessors are converted from the
+// mapped bytes straight into the Model's streams or packed vertices, there is no intermediate
+// copy of the buffers. Only the parts the engine uses are loaded: cameras, lights, morph targets
+// and extensions are skipped, and compressed meshes (Draco, meshopt) are rejected. Primitives
+// missing normals get flat ones, and ones with a normal map but no tangents get generated tangents.
+//
+// With a JobSystem, primitives, images, skins and animations are decoded in parallel. Each writes
+// its own slot of the Model, so the result is identical for any number of threads.
+//
+//     GltfLoader loader{ GltfLoader::CreateDetails{} };
+//     Model model = loader.load("scenes/sponza.glb");
+class GltfLoader
+{
+    public:
+    struct CreateDetails
+    {
+        // Optional, decodes on the job system's threads as well as the calling one
+        JobSystem* job_system = nullptr;
+        // Optional, vertices are interleaved in this layout instead of one stream per attribute
+        std::optional<VertexLayout> vertex_layout = std::nullopt;
+    };
+
+    GltfLoader(CreateDetails create_details);
+
+    // Throws when the file can't be read, isn't valid glTF or uses something unsupported
+    [[nodiscard]] Model load(std::filesystem::path const& path) const;
+
+    private:
+    JobSystem* job_system = nullptr;
+    std::optional<VertexLayout> vertex_layout;
+};
@@ -0,0 +1,148 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std::string_literals;
+
+#if defined(_WIN32)
+MappedFile::MappedFile(std::filesystem::path const& path)
+{
+    HANDLE file = CreateFileW(path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Failed to map "s + path.string() + ": CreateFileW failed with " +
+                                 std::to_string(GetLastError()));
+    file_handle = file;
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        unmap();
+        throw std::runtime_error("Failed to map "s + path.string() +
+                                 ": GetFileSizeEx failed with " + std::to_string(GetLastError()));
+    }
+    size = static_cast<size_t>(file_size.QuadPart);
+    // mapping an empty file fails
+    if (size == 0) return;
+    mapping_handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr)
+    {
+        unmap();
+        throw std::runtime_error("Failed to map "s + path.string() +
+                                 ": CreateFileMappingW failed with " +
+                                 std::to_string(GetLastError()));
+    }
+    data = static_cast<const std::byte*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr)
+    {
+        unmap();
+        throw std::runtime_error("Failed to map "s + path.string() +
+                                 ": MapViewOfFile failed with " + std::to_string(GetLastError()));
+    }
+}
+
+void MappedFile::unmap() noexcept
+{
+    if (data != nullptr) UnmapViewOfFile(data);
+    if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+    if (file_handle != nullptr) CloseHandle(file_handle);
+    data = nullptr;
+    size = 0;
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+: data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0)),
+  file_handle(std::exchange(other.file_handle, nullptr)),
+  mapping_handle(std::exchange(other.mapping_handle, nullptr))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this == &other) return *this;
+    unmap();
+    data = std::exchange(other.data, nullptr);
+    size = std::exchange(other.size, 0);
+    file_handle = std::exchange(other.file_handle, nullptr);
+    mapping_handle = std::exchange(other.mapping_handle, nullptr);
+    return *this;
+}
+#else
+MappedFile::MappedFile(std::filesystem::path const& path)
+{
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+        throw std::runtime_error("Failed to map "s + path.string() + ": open failed with " +
+                                 std::to_string(errno));
+    struct stat status{};
+    if (fstat(file, &status) != 0)
+    {
+        int error = errno;
+        close(file);
+        throw std::runtime_error(
+            "Failed to map "s + path.string() + ": fstat failed with " + std::to_string(error));
+    }
+    size = static_cast<size_t>(status.st_size);
+    // mapping an empty file fails
+    if (size == 0)
+    {
+        close(file);
+        return;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    int error = errno;
+    // the mapping keeps the file alive
+    close(file);
+    if (mapped == MAP_FAILED)
+    {
+        size = 0;
+        throw std::runtime_error(
+            "Failed to map "s + path.string() + ": mmap failed with " + std::to_string(error));
+    }
+    data = static_cast<const std::byte*>(mapped);
+}
+
+void MappedFile::unmap() noexcept
+{
+    if (data != nullptr) munmap(const_cast<std::byte*>(data), size);
+    data = nullptr;
+    size = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+: data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this == &other) return *this;
+    unmap();
+    data = std::exchange(other.data, nullptr);
+    size = std::exchange(other.size, 0);
+    return *this;
+}
+#endif
+
+MappedFile::~MappedFile() noexcept { unmap(); }
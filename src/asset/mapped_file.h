@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+#include <filesystem>
+#include <span>
+
+// Read only view of a whole file through the OS's memory mapping, pages are loaded on first
+// access instead of reading the file up front. Empty files map to an empty span.
+class MappedFile
+{
+    public:
+    // Throws when the file can't be opened or mapped
+    explicit MappedFile(std::filesystem::path const& path);
+    ~MappedFile() noexcept;
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return { data, size }; }
+
+    private:
+    void unmap() noexcept;
+
+    const std::byte* data = nullptr;
+    size_t size = 0;
+#if defined(_WIN32)
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include "math/matrix.h"
+#include "math/transform.h"
+#include "math/vec_stream.h"
+#include "math/vector.h"
+
+// Engine side of a loaded model, independent of the file format it came from. Objects refer to
+// each other by index into the Model's arrays, no_index when there is none.
+inline constexpr uint32_t no_index = UINT32_MAX;
+
+struct Aabb
+{
+    math::vec3 min{ 0.f, 0.f, 0.f };
+    math::vec3 max{ 0.f, 0.f, 0.f };
+};
+
+enum class Topology : uint8_t
+{
+    points,
+    lines,
+    line_loop,
+    line_strip,
+    triangles,
+    triangle_strip,
+    triangle_fan,
+};
+
+// One draw worth of vertices. Unless the loader was given a VertexLayout, every attribute is a
+// stream of its own, empty when the file doesn't have it. With a layout the streams stay empty
+// and the vertices are interleaved in `vertices`.
+struct Primitive
+{
+    Topology topology = Topology::triangles;
+    uint32_t vertex_count = 0;
+    math::vec_stream<float, 3> positions;
+    math::vec_stream<float, 3> normals;
+    // w is the handedness of the bitangent, 1 or -1
+    math::vec_stream<float, 4> tangents;
+    math::vec_stream<float, 2> texcoords0;
+    math::vec_stream<float, 2> texcoords1;
+    math::vec_stream<float, 4> colors;
+    math::vec_stream<uint16_t, 4> joints;
+    math::vec_stream<float, 4> weights;
+    std::vector<std::byte> vertices;
+    // Empty when the primitive isn't indexed
+    std::vector<uint32_t> indices;
+    uint32_t material = no_index;
+    Aabb bounds;
+};
+
+struct Mesh
+{
+    std::string name;
+    std::vector<Primitive> primitives;
+};
+
+enum class AlphaMode : uint8_t
+{
+    opaque,
+    mask,
+    blend,
+};
+
+struct TextureRef
+{
+    uint32_t texture = no_index;
+    // which texcoords stream to sample with
+    uint32_t texcoord = 0;
+    // normal map scale or occlusion strength
+    float scale = 1.f;
+};
+
+// Metallic roughness PBR
+struct Material
+{
+    std::string name;
+    math::vec4 base_color_factor{ 1.f, 1.f, 1.f, 1.f };
+    float metallic_factor = 1.f;
+    float roughness_factor = 1.f;
+    math::vec3 emissive_factor{ 0.f, 0.f, 0.f };
+    TextureRef base_color;
+    // roughness in green, metallic in blue
+    TextureRef metallic_roughness;
+    TextureRef normal;
+    TextureRef occlusion;
+    TextureRef emissive;
+    AlphaMode alpha_mode = AlphaMode::opaque;
+    float alpha_cutoff = 0.5f;
+    bool double_sided = false;
+};
+
+// Encoded image, PNG or JPEG, still to be decoded
+struct Image
+{
+    std::string name;
+    std::string mime_type;
+    // Set for images in files of their own, relative to the working directory
+    std::string path;
+    // Set for images stored in the model's buffers
+    std::vector<std::byte> data;
+};
+
+// Filters and wrap modes use the OpenGL enum values glTF does, 0 when unspecified
+struct Sampler
+{
+    uint32_t mag_filter = 0;
+    uint32_t min_filter = 0;
+    uint32_t wrap_s = 10497; // repeat
+    uint32_t wrap_t = 10497;
+};
+
+struct Texture
+{
+    std::string name;
+    uint32_t image = no_index;
+    uint32_t sampler = no_index;
+};
+
+// Nodes are sorted by depth, parents come before their children, so the math/transform.h
+// propagation functions take Model::parents as is
+struct Node
+{
+    std::string name;
+    math::transform local;
+    uint32_t mesh = no_index;
+    uint32_t skin = no_index;
+};
+
+struct Skin
+{
+    std::string name;
+    // node indices
+    std::vector<uint32_t> joints;
+    std::vector<math::matrix4> inverse_bind_matrices;
+    uint32_t skeleton = no_index;
+};
+
+enum class AnimationPath : uint8_t
+{
+    translation,
+    rotation,
+    scale,
+    weights,
+};
+
+enum class Interpolation : uint8_t
+{
+    linear,
+    step,
+    cubic_spline,
+};
+
+struct AnimationSampler
+{
+    std::vector<float> times;
+    // Tightly packed, 3 or 4 floats per key for transforms and a weight per morph target. Cubic
+    // splines store in tangent, value and out tangent for each key.
+    std::vector<float> values;
+    Interpolation interpolation = Interpolation::linear;
+};
+
+struct AnimationChannel
+{
+    uint32_t sampler = 0;
+    uint32_t node = no_index;
+    AnimationPath path = AnimationPath::translation;
+};
+
+struct Animation
+{
+    std::string name;
+    std::vector<AnimationSampler> samplers;
+    std::vector<AnimationChannel> channels;
+    // Time of the last key
+    float duration = 0.f;
+};
+
+struct Model
+{
+    std::vector<Mesh> meshes;
+    std::vector<Material> materials;
+    std::vector<Image> images;
+    std::vector<Sampler> samplers;
+    std::vector<Texture> textures;
+    std::vector<Node> nodes;
+    // parents[i] is node i's parent, math::no_parent for roots
+    std::vector<uint32_t> parents;
+    // Roots of the default scene, or of the first one when none is marked default
+    std::vector<uint32_t> scene_roots;
+    std::vector<Skin> skins;
+    std::vector<Animation> animations;
+};
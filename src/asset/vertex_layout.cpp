@@ -0,0 +1,85 @@
+#include "vertex_layout.h"
+
+const char* to_string(VertexAttribute attribute) noexcept
+{
+    switch (attribute)
+    {
+        case VertexAttribute::position: return "POSITION";
+        case VertexAttribute::normal: return "NORMAL";
+        case VertexAttribute::tangent: return "TANGENT";
+        case VertexAttribute::texcoord0: return "TEXCOORD_0";
+        case VertexAttribute::texcoord1: return "TEXCOORD_1";
+        case VertexAttribute::color0: return "COLOR_0";
+        case VertexAttribute::joints0: return "JOINTS_0";
+        case VertexAttribute::weights0: return "WEIGHTS_0";
+    }
+    return "unknown";
+}
+
+VertexComponent component_of(VertexFormat format) noexcept
+{
+    switch (format)
+    {
+        case VertexFormat::float32x1:
+        case VertexFormat::float32x2:
+        case VertexFormat::float32x3:
+        case VertexFormat::float32x4: return VertexComponent::float32;
+        case VertexFormat::unorm8x4: return VertexComponent::unorm8;
+        case VertexFormat::snorm8x4: return VertexComponent::snorm8;
+        case VertexFormat::uint8x4: return VertexComponent::uint8;
+        case VertexFormat::unorm16x2:
+        case VertexFormat::unorm16x4: return VertexComponent::unorm16;
+        case VertexFormat::snorm16x2:
+        case VertexFormat::snorm16x4: return VertexComponent::snorm16;
+        case VertexFormat::uint16x4: return VertexComponent::uint16;
+    }
+    return VertexComponent::float32;
+}
+
+uint32_t component_count(VertexFormat format) noexcept
+{
+    switch (format)
+    {
+        case VertexFormat::float32x1: return 1;
+        case VertexFormat::float32x2:
+        case VertexFormat::unorm16x2:
+        case VertexFormat::snorm16x2: return 2;
+        case VertexFormat::float32x3: return 3;
+        default: return 4;
+    }
+}
+
+uint32_t component_size(VertexComponent component) noexcept
+{
+    switch (component)
+    {
+        case VertexComponent::float32: return 4;
+        case VertexComponent::unorm8:
+        case VertexComponent::snorm8:
+        case VertexComponent::uint8: return 1;
+        case VertexComponent::unorm16:
+        case VertexComponent::snorm16:
+        case VertexComponent::uint16: return 2;
+    }
+    return 4;
+}
+
+uint32_t format_size(VertexFormat format) noexcept
+{
+    return component_count(format) * component_size(component_of(format));
+}
+
+VertexLayout& VertexLayout::add(VertexAttribute attribute, VertexFormat format)
+{
+    uint32_t offset = (stride + 3u) & ~3u;
+    elements.push_back(VertexElement{ attribute, format, offset });
+    stride = (offset + format_size(format) + 3u) & ~3u;
+    return *this;
+}
+
+const VertexElement* VertexLayout::find(VertexAttribute attribute) const noexcept
+{
+    for (auto const& element : elements)
+        if (element.attribute == attribute) return &element;
+    return nullptr;
+}
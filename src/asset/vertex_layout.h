@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+// glTF's vertex attributes, the number is the set for texcoords, colors, joints and weights
+enum class VertexAttribute : uint8_t
+{
+    position,
+    normal,
+    tangent,
+    texcoord0,
+    texcoord1,
+    color0,
+    joints0,
+    weights0,
+};
+inline constexpr size_t vertex_attribute_count = 8;
+const char* to_string(VertexAttribute attribute) noexcept;
+
+// Storage of one attribute in a packed vertex. Normalized formats map [0, 1] or [-1, 1] onto the
+// integer range, uint formats store the value itself, like joint indices.
+enum class VertexFormat : uint8_t
+{
+    float32x1,
+    float32x2,
+    float32x3,
+    float32x4,
+    unorm8x4,
+    snorm8x4,
+    uint8x4,
+    unorm16x2,
+    snorm16x2,
+    unorm16x4,
+    snorm16x4,
+    uint16x4,
+};
+
+enum class VertexComponent : uint8_t
+{
+    float32,
+    unorm8,
+    snorm8,
+    uint8,
+    unorm16,
+    snorm16,
+    uint16,
+};
+
+[[nodiscard]] VertexComponent component_of(VertexFormat format) noexcept;
+[[nodiscard]] uint32_t component_count(VertexFormat format) noexcept;
+[[nodiscard]] uint32_t component_size(VertexComponent component) noexcept;
+[[nodiscard]] uint32_t format_size(VertexFormat format) noexcept;
+
+struct VertexElement
+{
+    VertexAttribute attribute;
+    VertexFormat format;
+    uint32_t offset;
+};
+
+// Interleaved vertex the loader packs attributes into, in one pass per attribute straight from the
+// file's buffers. Attributes a primitive lacks are left zero, components beyond what the file
+// has are zero too, except a missing alpha or w which is 1.
+//
+//     VertexLayout layout;
+//     layout.add(VertexAttribute::position, VertexFormat::float32x3)
+//         .add(VertexAttribute::normal, VertexFormat::snorm8x4)
+//         .add(VertexAttribute::texcoord0, VertexFormat::unorm16x2);
+struct VertexLayout
+{
+    std::vector<VertexElement> elements;
+    uint32_t stride = 0;
+
+    // Places the attribute after the previous ones, 4 byte aligned
+    VertexLayout& add(VertexAttribute attribute, VertexFormat format);
+
+    [[nodiscard]] const VertexElement* find(VertexAttribute attribute) const noexcept;
+};
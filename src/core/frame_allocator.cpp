@@ -0,0 +1,115 @@
+#include "frame_allocator.h"
+
+#include <cassert>
+#include <new>
+
+namespace
+{
+size_t align_up(size_t value, size_t alignment) noexcept
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+constexpr size_t buffer_alignment = alignof(std::max_align_t);
+} // namespace
+
+LinearArena::LinearArena(size_t initial_size, std::pmr::memory_resource* upstream_resource)
+: upstream(upstream_resource), size(initial_size)
+{
+    if (size > 0) buffer = static_cast<std::byte*>(upstream->allocate(size, buffer_alignment));
+}
+
+LinearArena::~LinearArena() noexcept
+{
+    release_overflow();
+    if (buffer) upstream->deallocate(buffer, size, buffer_alignment);
+}
+
+void LinearArena::reset()
+{
+    size_t total = bytes_used();
+    if (total > peak) peak = total;
+    if (overflow)
+    {
+        release_overflow();
+        // grow to fit the whole frame, with some slack so a slowly growing workload doesn't
+        // reallocate every frame
+        size_t new_size = size > 0 ? size : 4096;
+        while (new_size < total + total / 4)
+            new_size *= 2;
+        std::byte* new_buffer =
+            static_cast<std::byte*>(upstream->allocate(new_size, buffer_alignment));
+        if (buffer) upstream->deallocate(buffer, size, buffer_alignment);
+        buffer = new_buffer;
+        size = new_size;
+    }
+    used = 0;
+}
+
+void* LinearArena::do_allocate(size_t bytes, size_t alignment)
+{
+    assert((alignment & (alignment - 1)) == 0 && "alignment must be a power of two");
+    // the buffer itself is only aligned to max_align_t, align the address rather than the offset
+    auto base = reinterpret_cast<uintptr_t>(buffer);
+    size_t offset = align_up(base + used, alignment) - base;
+    if (buffer && offset + bytes <= size)
+    {
+        used = offset + bytes;
+        return buffer + offset;
+    }
+    return allocate_overflow(bytes, alignment);
+}
+
+void* LinearArena::allocate_overflow(size_t bytes, size_t alignment)
+{
+    size_t header = align_up(sizeof(OverflowBlock), buffer_alignment);
+    if (overflow)
+    {
+        auto base = reinterpret_cast<uintptr_t>(overflow);
+        size_t offset = align_up(base + overflow->used, alignment) - base;
+        if (offset + bytes <= overflow->size)
+        {
+            overflow_used += offset + bytes - overflow->used;
+            overflow->used = offset + bytes;
+            return reinterpret_cast<std::byte*>(overflow) + offset;
+        }
+    }
+    size_t block_size = header + bytes + alignment;
+    if (block_size < size) block_size = size;
+    if (block_size < 4096) block_size = 4096;
+    void* memory = upstream->allocate(block_size, buffer_alignment);
+    auto* block = new (memory) OverflowBlock{ overflow, block_size, header };
+    overflow = block;
+
+    auto base = reinterpret_cast<uintptr_t>(block);
+    size_t offset = align_up(base + header, alignment) - base;
+    block->used = offset + bytes;
+    overflow_used += block->used - header;
+    return reinterpret_cast<std::byte*>(block) + offset;
+}
+
+void LinearArena::release_overflow() noexcept
+{
+    while (overflow)
+    {
+        OverflowBlock* next = overflow->next;
+        upstream->deallocate(overflow, overflow->size, buffer_alignment);
+        overflow = next;
+    }
+    overflow_used = 0;
+}
+
+FrameArena::FrameArena(CreateDetails create_details)
+{
+    assert(create_details.frame_count > 0);
+    for (uint32_t i = 0; i < create_details.frame_count; i++)
+        arenas.push_back(
+            std::make_unique<LinearArena>(create_details.frame_size, create_details.upstream));
+}
+
+void FrameArena::begin_frame(uint32_t frame_index)
+{
+    assert(frame_index < arenas.size());
+    current_index = frame_index;
+    arenas[current_index]->reset();
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Bump allocator for data that dies all at once. Allocating moves a pointer forward, deallocating
+// does nothing and reset() frees everything in one go.
+//
+// When the buffer runs out, overflow blocks are taken from the upstream resource and the next
+// reset() replaces the buffer with one big enough for everything that was allocated, so after a
+// few warm up frames a steady workload doesn't touch the upstream resource at all.
+// Not thread safe, give each thread its own arena.
+class LinearArena final : public std::pmr::memory_resource
+{
+    public:
+    explicit LinearArena(size_t initial_size,
+                         std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+    ~LinearArena() noexcept override;
+    LinearArena(LinearArena const&) = delete;
+    LinearArena& operator=(LinearArena const&) = delete;
+
+    // Invalidates every allocation made since the last reset
+    void reset();
+
+    // Bytes handed out since the last reset, including alignment padding
+    [[nodiscard]] size_t bytes_used() const noexcept { return used + overflow_used; }
+    // Size of the main buffer, allocations beyond it go to overflow blocks
+    [[nodiscard]] size_t capacity() const noexcept { return size; }
+    // Largest bytes_used() seen at a reset
+    [[nodiscard]] size_t high_water_mark() const noexcept { return peak; }
+
+    private:
+    struct OverflowBlock
+    {
+        OverflowBlock* next;
+        size_t size;
+        size_t used;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) noexcept override {}
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    void* allocate_overflow(size_t bytes, size_t alignment);
+    void release_overflow() noexcept;
+
+    std::pmr::memory_resource* upstream;
+    std::byte* buffer = nullptr;
+    size_t size = 0;
+    size_t used = 0;
+    OverflowBlock* overflow = nullptr;
+    size_t overflow_used = 0;
+    size_t peak = 0;
+};
+
+// One LinearArena per frame in flight. begin_frame(i) resets arena i, so memory allocated during a
+// frame stays valid until the same frame index comes around again, which is when the GPU is known
+// to be done with that frame.
+class FrameArena
+{
+    public:
+    struct CreateDetails
+    {
+        // Should match the renderer's number of frames in flight
+        uint32_t frame_count = 2;
+        // Initial size of each frame's arena, grows to fit the largest frame seen
+        size_t frame_size = 1024 * 1024;
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource();
+    };
+
+    FrameArena(CreateDetails create_details);
+    FrameArena(FrameArena const&) = delete;
+    FrameArena& operator=(FrameArena const&) = delete;
+    FrameArena(FrameArena&& other) noexcept = default;
+    FrameArena& operator=(FrameArena&& other) noexcept = default;
+
+    // Makes frame_index the current frame and frees everything previously allocated in it
+    void begin_frame(uint32_t frame_index);
+
+    [[nodiscard]] uint32_t frame_count() const noexcept
+    {
+        return static_cast<uint32_t>(arenas.size());
+    }
+    [[nodiscard]] uint32_t current_frame() const noexcept { return current_index; }
+    [[nodiscard]] LinearArena& current() noexcept { return *arenas[current_index]; }
+    [[nodiscard]] std::pmr::memory_resource* resource() noexcept
+    {
+        return arenas[current_index].get();
+    }
+
+    private:
+    std::vector<std::unique_ptr<LinearArena>> arenas;
+    uint32_t current_index = 0;
+};
+
+// Containers for transient per frame data, construct them with FrameArena::resource():
+//     frame_vector<VkSemaphore> semaphores{ frame_arena.resource() };
+template <typename T> using frame_vector = std::pmr::vector<T>;
+using frame_string = std::pmr::string;
@@ -0,0 +1,71 @@
+#include "frame_pacing.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+double to_ms(int64_t ns) noexcept { return static_cast<double>(ns) / 1'000'000.0; }
+} // namespace
+
+FramePacing::FramePacing(CreateDetails create_details)
+: samples(std::max(create_details.window_frames, 1u)), hitch_factor(create_details.hitch_factor)
+{
+}
+
+void FramePacing::record(Sample sample)
+{
+    samples[next] = sample;
+    next = (next + 1) % samples.size();
+    count = std::min(count + 1, samples.size());
+}
+
+FramePacing::Report FramePacing::report() const
+{
+    Report out;
+    if (count == 0) return out;
+    out.frame_count = static_cast<uint32_t>(count);
+
+    // the oldest samples start at `next` once the ring wrapped, the order doesn't matter though
+    std::vector<double> frame_ms;
+    frame_ms.reserve(count);
+    int64_t frame_total = 0;
+    int64_t fence_total = 0;
+    int64_t acquire_total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        Sample const& sample = samples[i];
+        frame_ms.push_back(to_ms(sample.frame_ns));
+        frame_total += sample.frame_ns;
+        fence_total += sample.fence_wait_ns;
+        acquire_total += sample.acquire_wait_ns;
+    }
+
+    auto frames = static_cast<double>(count);
+    out.average_ms = to_ms(frame_total) / frames;
+    out.average_fence_wait_ms = to_ms(fence_total) / frames;
+    out.average_acquire_wait_ms = to_ms(acquire_total) / frames;
+    if (frame_total > 0)
+        out.wait_fraction =
+            static_cast<double>(fence_total + acquire_total) / static_cast<double>(frame_total);
+
+    double variance = 0.0;
+    for (double ms : frame_ms)
+        variance += (ms - out.average_ms) * (ms - out.average_ms);
+    out.jitter_ms = std::sqrt(variance / frames);
+
+    std::sort(frame_ms.begin(), frame_ms.end());
+    out.median_ms = frame_ms[count / 2];
+    out.p99_ms = frame_ms[std::min(count - 1, count * 99 / 100)];
+    out.max_ms = frame_ms.back();
+    double hitch_ms = out.median_ms * hitch_factor;
+    out.hitch_count = static_cast<uint32_t>(
+        frame_ms.end() - std::upper_bound(frame_ms.begin(), frame_ms.end(), hitch_ms));
+    return out;
+}
+
+void FramePacing::clear() noexcept
+{
+    next = 0;
+    count = 0;
+}
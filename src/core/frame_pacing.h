@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+// Rolling statistics over the last frames, answering whether frames arrive evenly and where the
+// CPU spends time waiting instead of working.
+//
+//     pacing.record(FramePacing::Sample{ .frame_ns = ..., .fence_wait_ns = ... });
+//     auto report = pacing.report();
+class FramePacing
+{
+    public:
+    struct CreateDetails
+    {
+        // Frames the report covers
+        uint32_t window_frames = 240;
+        // Frames taking longer than this multiple of the median count as hitches
+        double hitch_factor = 1.5;
+    };
+
+    struct Sample
+    {
+        // Time since the previous frame started
+        int64_t frame_ns = 0;
+        // Time blocked on the GPU finishing an earlier frame
+        int64_t fence_wait_ns = 0;
+        // Time blocked acquiring a swapchain image
+        int64_t acquire_wait_ns = 0;
+    };
+
+    struct Report
+    {
+        uint32_t frame_count = 0;
+        double average_ms = 0.0;
+        double median_ms = 0.0;
+        double p99_ms = 0.0;
+        double max_ms = 0.0;
+        // Standard deviation of the frame time, 0 for perfectly even pacing
+        double jitter_ms = 0.0;
+        double average_fence_wait_ms = 0.0;
+        double average_acquire_wait_ms = 0.0;
+        // Share of the frame time the CPU spent blocked on the GPU or the swapchain
+        double wait_fraction = 0.0;
+        uint32_t hitch_count = 0;
+    };
+
+    FramePacing(CreateDetails create_details);
+
+    void record(Sample sample);
+    [[nodiscard]] Report report() const;
+    void clear() noexcept;
+
+    private:
+    std::vector<Sample> samples; // ring of the last window_frames samples
+    size_t next = 0;
+    size_t count = 0;
+    double hitch_factor;
+};
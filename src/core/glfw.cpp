@@ -6,6 +6,8 @@
 #include <GLFW/glfw3.h>
 #include "spdlog/spdlog.h"
 
+#include "core/profiler.h"
+
 void Window::static_initialization() noexcept
 {
     assert(is_static_initialized == false);
@@ -22,6 +24,7 @@ bool Window::is_static_initialized = false;
 
 void Window::poll_events()
 {
+    ORANGE_PROFILE_SCOPE("Window::poll_events");
     assert(is_static_initialized == true);
     glfwPollEvents();
 }
@@ -0,0 +1,337 @@
+#include "image_writer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#include "profiler.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+constexpr std::array<uint32_t, 256> make_crc_table() noexcept
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[n] = c;
+    }
+    return table;
+}
+constexpr std::array<uint32_t, 256> crc_table = make_crc_table();
+
+// Largest length of a stored deflate block
+constexpr size_t max_stored_block = 65535;
+
+void put_u32(std::byte* out, uint32_t value) noexcept
+{
+    out[0] = std::byte(value >> 24);
+    out[1] = std::byte(value >> 16);
+    out[2] = std::byte(value >> 8);
+    out[3] = std::byte(value);
+}
+
+// Writes one PNG chunk, its CRC is computed while the data streams through
+class ChunkWriter
+{
+    public:
+    ChunkWriter(std::ofstream& file, const char* type, uint32_t length) : out(file)
+    {
+        std::array<std::byte, 8> header;
+        put_u32(header.data(), length);
+        for (size_t i = 0; i < 4; i++)
+            header[4 + i] = std::byte(type[i]);
+        out.write(reinterpret_cast<const char*>(header.data()), 4);
+        write(std::span(header).subspan(4));
+    }
+
+    void write(std::span<const std::byte> data)
+    {
+        for (std::byte b : data)
+            crc = crc_table[(crc ^ static_cast<uint32_t>(b)) & 0xFF] ^ (crc >> 8);
+        out.write(reinterpret_cast<const char*>(data.data()),
+            static_cast<std::streamsize>(data.size()));
+    }
+
+    void end()
+    {
+        std::array<std::byte, 4> footer;
+        put_u32(footer.data(), crc ^ 0xFFFFFFFFu);
+        out.write(reinterpret_cast<const char*>(footer.data()), 4);
+    }
+
+    private:
+    std::ofstream& out;
+    uint32_t crc = 0xFFFFFFFFu;
+};
+
+// zlib stream made of stored deflate blocks, written into an IDAT chunk
+class StoredDeflateWriter
+{
+    public:
+    static size_t stream_size(size_t data_size) noexcept
+    {
+        size_t blocks = std::max<size_t>(1, (data_size + max_stored_block - 1) / max_stored_block);
+        // zlib header, a 5 byte header per block, adler32 trailer
+        return 2 + blocks * 5 + data_size + 4;
+    }
+
+    StoredDeflateWriter(ChunkWriter& chunk_writer, size_t data_size)
+    : chunk(chunk_writer), remaining(data_size)
+    {
+        // deflate, 32K window, no preset dictionary, check bits making the header a multiple of 31
+        std::array<std::byte, 2> header{ std::byte{ 0x78 }, std::byte{ 0x01 } };
+        chunk.write(header);
+        if (remaining == 0) begin_block();
+    }
+
+    void write(std::span<const std::byte> data)
+    {
+        while (!data.empty())
+        {
+            if (block_remaining == 0) begin_block();
+            size_t count = std::min(data.size(), block_remaining);
+            auto part = data.first(count);
+            update_adler(part);
+            chunk.write(part);
+            block_remaining -= count;
+            remaining -= count;
+            data = data.subspan(count);
+        }
+    }
+
+    void end()
+    {
+        std::array<std::byte, 4> trailer;
+        put_u32(trailer.data(), (adler_b << 16) | adler_a);
+        chunk.write(trailer);
+    }
+
+    private:
+    void begin_block()
+    {
+        auto length = static_cast<uint16_t>(std::min(remaining, max_stored_block));
+        auto inverse = static_cast<uint16_t>(~length);
+        bool final_block = length == remaining;
+        std::array<std::byte, 5> header{ std::byte{ final_block ? uint8_t{ 1 } : uint8_t{ 0 } },
+            std::byte(length & 0xFF),
+            std::byte(length >> 8),
+            std::byte(inverse & 0xFF),
+            std::byte(inverse >> 8) };
+        chunk.write(header);
+        block_remaining = length;
+    }
+
+    void update_adler(std::span<const std::byte> data) noexcept
+    {
+        // 5552 is the most bytes that can be summed before the 32 bit sums could overflow
+        while (!data.empty())
+        {
+            size_t count = std::min<size_t>(data.size(), 5552);
+            for (std::byte b : data.first(count))
+            {
+                adler_a += static_cast<uint32_t>(b);
+                adler_b += adler_a;
+            }
+            adler_a %= 65521;
+            adler_b %= 65521;
+            data = data.subspan(count);
+        }
+    }
+
+    ChunkWriter& chunk;
+    size_t remaining;
+    size_t block_remaining = 0;
+    uint32_t adler_a = 1;
+    uint32_t adler_b = 0;
+};
+
+uint8_t png_color_type(uint32_t channels) noexcept
+{
+    switch (channels)
+    {
+        case 1: return 0; // grayscale
+        case 2: return 4; // grayscale, alpha
+        case 3: return 2; // rgb
+        default: return 6; // rgba
+    }
+}
+} // namespace
+
+bool write_png(
+    std::filesystem::path const& path, ImageDescription image, std::span<const std::byte> pixels)
+{
+    if (image.channels < 1 || image.channels > 4 || pixels.size() < image.byte_size()) return false;
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    static constexpr std::array<uint8_t, 8> signature{
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'
+    };
+    file.write(reinterpret_cast<const char*>(signature.data()), signature.size());
+
+    {
+        std::array<std::byte, 13> header{};
+        put_u32(header.data(), image.width);
+        put_u32(header.data() + 4, image.height);
+        header[8] = std::byte{ 8 }; // bit depth
+        header[9] = std::byte{ png_color_type(image.channels) };
+        // compression, filter and interlace methods all 0
+        ChunkWriter chunk{ file, "IHDR", header.size() };
+        chunk.write(header);
+        chunk.end();
+    }
+
+    // every row starts with its filter type, 0 leaves the row unfiltered
+    size_t row_size = size_t{ image.width } * image.channels;
+    size_t data_size = (row_size + 1) * image.height;
+    size_t stream_size = StoredDeflateWriter::stream_size(data_size);
+    if (stream_size > UINT32_MAX) return false;
+    {
+        ChunkWriter chunk{ file, "IDAT", static_cast<uint32_t>(stream_size) };
+        StoredDeflateWriter deflate{ chunk, data_size };
+        bool swizzle = image.bgr_order && image.channels >= 3;
+        std::vector<std::byte> row(swizzle ? row_size : 0);
+        const std::byte filter_none[1] = { std::byte{ 0 } };
+        for (uint32_t y = 0; y < image.height; y++)
+        {
+            auto source = pixels.subspan(y * row_size, row_size);
+            deflate.write(filter_none);
+            if (!swizzle)
+            {
+                deflate.write(source);
+                continue;
+            }
+            std::copy(source.begin(), source.end(), row.begin());
+            for (size_t x = 0; x < row_size; x += image.channels)
+                std::swap(row[x], row[x + 2]);
+            deflate.write(row);
+        }
+        deflate.end();
+        chunk.end();
+    }
+
+    ChunkWriter{ file, "IEND", 0 }.end();
+    return static_cast<bool>(file);
+}
+
+bool write_raw(std::filesystem::path const& path, std::span<const std::byte> pixels)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(pixels.data()),
+        static_cast<std::streamsize>(pixels.size()));
+    return static_cast<bool>(file);
+}
+
+ImageSequenceWriter::ImageSequenceWriter(CreateDetails create_details)
+: directory(std::move(create_details.directory)),
+  file_prefix(std::move(create_details.file_prefix)),
+  format(create_details.format), max_queued_frames(std::max(create_details.max_queued_frames, 1u))
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+        throw std::runtime_error("Failed to create image sequence writer: couldn't create "s +
+                                 directory.string() + ": " + error.message());
+    thread = std::thread([this] { run(); });
+}
+
+ImageSequenceWriter::~ImageSequenceWriter() noexcept
+{
+    {
+        std::lock_guard lock(mutex);
+        stop = true;
+    }
+    work_condition.notify_one();
+    thread.join();
+}
+
+void ImageSequenceWriter::submit(
+    uint64_t frame_number, ImageDescription image, std::span<const std::byte> pixels)
+{
+    ORANGE_PROFILE_SCOPE("ImageSequenceWriter::submit");
+    QueuedFrame frame{ .frame_number = frame_number, .image = image, .pixels = {} };
+    {
+        std::unique_lock lock(mutex);
+        space_condition.wait(lock, [this] { return queue.size() < max_queued_frames; });
+        if (!free_buffers.empty())
+        {
+            frame.pixels = std::move(free_buffers.back());
+            free_buffers.pop_back();
+        }
+    }
+    // copied without the lock, the writer keeps going meanwhile
+    frame.pixels.assign(pixels.begin(), pixels.end());
+    {
+        std::lock_guard lock(mutex);
+        queue.push_back(std::move(frame));
+        ORANGE_PROFILE_COUNTER("Image writer queue", queue.size());
+    }
+    work_condition.notify_one();
+}
+
+void ImageSequenceWriter::flush()
+{
+    std::unique_lock lock(mutex);
+    space_condition.wait(lock, [this] { return queue.empty() && !writing; });
+}
+
+std::filesystem::path ImageSequenceWriter::path_of(uint64_t frame_number) const
+{
+    char number[32];
+    std::snprintf(number, sizeof(number), "%06llu", static_cast<unsigned long long>(frame_number));
+    const char* extension = format == ImageFileFormat::png ? ".png" : ".raw";
+    return directory / (file_prefix + number + extension);
+}
+
+uint64_t ImageSequenceWriter::frames_written() const
+{
+    std::lock_guard lock(mutex);
+    return written;
+}
+
+uint64_t ImageSequenceWriter::frames_failed() const
+{
+    std::lock_guard lock(mutex);
+    return failed;
+}
+
+void ImageSequenceWriter::run()
+{
+    Profiler::set_thread_name("Image writer");
+    std::unique_lock lock(mutex);
+    while (true)
+    {
+        work_condition.wait(lock, [this] { return stop || !queue.empty(); });
+        if (queue.empty()) return; // stopping, and everything was written
+
+        QueuedFrame frame = std::move(queue.front());
+        queue.pop_front();
+        writing = true;
+        lock.unlock();
+        space_condition.notify_all();
+
+        bool ok = false;
+        {
+            ORANGE_PROFILE_SCOPE("ImageSequenceWriter::write");
+            auto path = path_of(frame.frame_number);
+            ok = format == ImageFileFormat::png ? write_png(path, frame.image, frame.pixels)
+                                                : write_raw(path, frame.pixels);
+        }
+
+        lock.lock();
+        writing = false;
+        (ok ? written : failed)++;
+        free_buffers.push_back(std::move(frame.pixels));
+        space_condition.notify_all();
+    }
+}
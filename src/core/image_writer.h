@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ImageFileFormat : uint8_t
+{
+    png,
+    // The pixels as they are, row after row without padding or header
+    raw,
+};
+
+// 8 bit per channel image, tightly packed rows
+struct ImageDescription
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t channels = 4; // 1 to 4
+    // Pixels are stored blue, green, red, like VK_FORMAT_B8G8R8A8_*
+    bool bgr_order = false;
+
+    [[nodiscard]] size_t byte_size() const noexcept
+    {
+        return size_t{ width } * height * channels;
+    }
+};
+
+// Uncompressed PNG, the deflate stream only uses stored blocks. Writing is as fast as the disk,
+// which is what capturing every frame needs, at the cost of file size. Returns false if the file
+// couldn't be written.
+bool write_png(
+    std::filesystem::path const& path, ImageDescription image, std::span<const std::byte> pixels);
+bool write_raw(std::filesystem::path const& path, std::span<const std::byte> pixels);
+
+// Writes numbered images on a background thread, frame 7 becomes <directory>/<prefix>000007.png.
+//
+// submit() copies the pixels into a recycled buffer and returns, so the caller can reuse its
+// memory right away. Once max_queued_frames are waiting to be written, submit() blocks until the
+// writer caught up, frames are never dropped.
+class ImageSequenceWriter
+{
+    public:
+    struct CreateDetails
+    {
+        std::filesystem::path directory = ".";
+        std::string file_prefix = "frame_";
+        ImageFileFormat format = ImageFileFormat::png;
+        uint32_t max_queued_frames = 4;
+    };
+
+    ImageSequenceWriter(CreateDetails create_details);
+    // Writes everything still queued before returning
+    ~ImageSequenceWriter() noexcept;
+    ImageSequenceWriter(ImageSequenceWriter const&) = delete;
+    ImageSequenceWriter& operator=(ImageSequenceWriter const&) = delete;
+    ImageSequenceWriter(ImageSequenceWriter&& other) noexcept = delete;
+    ImageSequenceWriter& operator=(ImageSequenceWriter&& other) noexcept = delete;
+
+    void submit(uint64_t frame_number, ImageDescription image, std::span<const std::byte> pixels);
+
+    // Blocks until every submitted frame was written
+    void flush();
+
+    [[nodiscard]] std::filesystem::path path_of(uint64_t frame_number) const;
+    [[nodiscard]] uint64_t frames_written() const;
+    [[nodiscard]] uint64_t frames_failed() const;
+
+    private:
+    struct QueuedFrame
+    {
+        uint64_t frame_number = 0;
+        ImageDescription image;
+        std::vector<std::byte> pixels;
+    };
+
+    void run();
+
+    std::filesystem::path directory;
+    std::string file_prefix;
+    ImageFileFormat format;
+    uint32_t max_queued_frames;
+
+    mutable std::mutex mutex;
+    std::condition_variable work_condition;  // the writer waits for frames
+    std::condition_variable space_condition; // submit() and flush() wait for the writer
+    std::deque<QueuedFrame> queue;
+    std::vector<std::vector<std::byte>> free_buffers;
+    bool writing = false;
+    bool stop = false;
+    uint64_t written = 0;
+    uint64_t failed = 0;
+    std::thread thread;
+};
@@ -0,0 +1,357 @@
+#include "job_system.h"
+
+#include <cassert>
+#include <string>
+
+#include "core/profiler.h"
+
+namespace detail
+{
+// Recycles jobs for one thread. Only the owning thread allocates, jobs finished on other threads
+// are pushed onto `returned` and reclaimed in bulk once the local free list runs dry.
+struct JobPool
+{
+    static constexpr size_t block_size = 256;
+
+    Job* free_list = nullptr;
+    std::atomic<Job*> returned{ nullptr };
+    std::vector<std::unique_ptr<Job[]>> blocks;
+
+    Job* allocate()
+    {
+        if (free_list == nullptr) free_list = returned.exchange(nullptr, std::memory_order_acquire);
+        if (free_list == nullptr)
+        {
+            blocks.push_back(std::make_unique<Job[]>(block_size));
+            Job* block = blocks.back().get();
+            for (size_t i = 0; i < block_size; i++)
+            {
+                block[i].owner = this;
+                block[i].next = i + 1 < block_size ? &block[i + 1] : nullptr;
+            }
+            free_list = block;
+        }
+        Job* job = free_list;
+        free_list = job->next;
+        return job;
+    }
+
+    void release_local(Job* job) noexcept
+    {
+        job->next = free_list;
+        free_list = job;
+    }
+
+    // Only pushes and whole list exchanges happen concurrently, so this is free of ABA problems
+    void release_remote(Job* job) noexcept
+    {
+        Job* head = returned.load(std::memory_order_relaxed);
+        do
+        {
+            job->next = head;
+        } while (!returned.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+    }
+};
+
+WorkStealingDeque::WorkStealingDeque(size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size *= 2;
+    mask = static_cast<int64_t>(size) - 1;
+    buffer = std::make_unique<std::atomic<Job*>[]>(size);
+}
+
+bool WorkStealingDeque::push(Job* job) noexcept
+{
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t > mask) return false;
+    buffer[static_cast<size_t>(b & mask)].store(job, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+Job* WorkStealingDeque::pop() noexcept
+{
+    // seq_cst store and load stand in for the paper's full fence, the store of bottom must be
+    // visible to thieves before top is read
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_seq_cst);
+    if (t > b)
+    {
+        // empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Job* job = buffer[static_cast<size_t>(b & mask)].load(std::memory_order_relaxed);
+    if (t == b)
+    {
+        // last element, race the thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* WorkStealingDeque::steal() noexcept
+{
+    int64_t t = top.load(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_seq_cst);
+    if (t >= b) return nullptr;
+    Job* job = buffer[static_cast<size_t>(t & mask)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr; // lost the race to another thief or the owner
+    return job;
+}
+
+bool WorkStealingDeque::empty() const noexcept
+{
+    return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+}
+} // namespace detail
+
+struct JobSystem::ThreadState
+{
+    ThreadState(uint32_t thread_index, size_t queue_capacity)
+    : index(thread_index), deque(queue_capacity), random(thread_index + 1)
+    {
+    }
+
+    uint32_t index;
+    detail::WorkStealingDeque deque;
+    detail::JobPool pool;
+    uint32_t random; // xorshift state for picking steal victims
+
+    uint32_t next_random() noexcept
+    {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        return random;
+    }
+};
+
+namespace
+{
+// The JobSystem the calling thread is registered with and its state in it
+thread_local JobSystem const* current_system = nullptr;
+thread_local void* current_state = nullptr;
+} // namespace
+
+JobSystem::JobSystem(CreateDetails create_details)
+{
+    uint32_t worker_count = create_details.worker_count;
+    if (worker_count == 0)
+    {
+        uint32_t hardware_threads = std::thread::hardware_concurrency();
+        worker_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+    }
+    for (uint32_t i = 0; i < worker_count + 1; i++)
+        threads.push_back(std::make_unique<ThreadState>(i, create_details.queue_capacity));
+
+    current_system = this;
+    current_state = threads[0].get();
+    for (uint32_t i = 1; i < worker_count + 1; i++)
+        workers.emplace_back([this, i] { worker_main(i); });
+}
+
+JobSystem::~JobSystem() noexcept
+{
+    stop.store(true);
+    {
+        std::lock_guard lock(sleep_mutex);
+    }
+    sleep_condition.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+
+    // Jobs are expected to be waited on before shutdown, run whatever is left so their resources are freed
+    while (try_run_one())
+    {
+    }
+    assert(queued_jobs.load() == 0);
+    if (current_system == this)
+    {
+        current_system = nullptr;
+        current_state = nullptr;
+    }
+}
+
+uint32_t JobSystem::thread_count() const noexcept { return static_cast<uint32_t>(threads.size()); }
+
+uint32_t JobSystem::current_thread_index() const noexcept
+{
+    ThreadState* state = local_state();
+    return state ? state->index : thread_count();
+}
+
+JobSystem::ThreadState* JobSystem::local_state() const noexcept
+{
+    return current_system == this ? static_cast<ThreadState*>(current_state) : nullptr;
+}
+
+detail::Job* JobSystem::allocate_job()
+{
+    if (ThreadState* state = local_state()) return state->pool.allocate();
+    return new detail::Job{};
+}
+
+void JobSystem::schedule(detail::Job* job) noexcept
+{
+    if (ThreadState* state = local_state())
+    {
+        if (!state->deque.push(job))
+        {
+            // queue is full, running the job here keeps the system making progress
+            run_job(job);
+            return;
+        }
+    }
+    else
+    {
+        std::lock_guard lock(shared_mutex);
+        shared_queue.push_back(job);
+    }
+    queued_jobs.fetch_add(1);
+    wake_worker();
+}
+
+void JobSystem::schedule_deferred(detail::Job* job) noexcept
+{
+    {
+        std::lock_guard lock(shared_mutex);
+        shared_queue.push_back(job);
+    }
+    queued_jobs.fetch_add(1);
+    wake_worker();
+}
+
+void JobSystem::wake_worker() noexcept
+{
+    if (sleeping_workers.load() > 0)
+    {
+        // taking the lock orders this with a worker that is between its check and going to sleep
+        {
+            std::lock_guard lock(sleep_mutex);
+        }
+        sleep_condition.notify_one();
+    }
+}
+
+void JobSystem::run_job(detail::Job* job) noexcept
+{
+    job->invoke(*job);
+    job->destroy(*job);
+
+    JobCounter* counter = job->counter;
+    detail::JobPool* owner = job->owner;
+    if (owner == nullptr)
+        delete job;
+    else if (ThreadState* state = local_state(); state && owner == &state->pool)
+        owner->release_local(job);
+    else
+        owner->release_remote(job);
+
+    if (counter == nullptr) return;
+    std::vector<detail::Job*> ready;
+    {
+        // Decrementing under the lock keeps wait() from returning, and the counter from being
+        // destroyed, before this thread is done with it
+        std::lock_guard lock(counter->continuation_mutex);
+        if (counter->count.fetch_sub(1, std::memory_order_acq_rel) == 1) ready.swap(counter->continuations);
+    }
+    for (detail::Job* continuation : ready)
+        schedule(continuation);
+}
+
+detail::Job* JobSystem::find_job(ThreadState* state) noexcept
+{
+    detail::Job* job = nullptr;
+    if (state) job = state->deque.pop();
+    if (job == nullptr)
+    {
+        size_t count = threads.size();
+        size_t start = state ? state->next_random() % count : 0;
+        for (size_t i = 0; i < count && job == nullptr; i++)
+        {
+            ThreadState* victim = threads[(start + i) % count].get();
+            if (victim != state) job = victim->deque.steal();
+        }
+    }
+    if (job == nullptr && queued_jobs.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard lock(shared_mutex);
+        if (!shared_queue.empty())
+        {
+            job = shared_queue.front();
+            shared_queue.pop_front();
+        }
+    }
+    if (job) queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+}
+
+bool JobSystem::try_run_one() noexcept
+{
+    detail::Job* job = find_job(local_state());
+    if (job == nullptr) return false;
+    run_job(job);
+    return true;
+}
+
+void JobSystem::wait(JobCounter const& counter) noexcept
+{
+    uint32_t idle_rounds = 0;
+    while (!counter.is_done())
+    {
+        if (try_run_one())
+            idle_rounds = 0;
+        else if (++idle_rounds > 64)
+            std::this_thread::yield();
+    }
+    // The last job decrements the counter while holding the lock, wait for it to let go
+    std::lock_guard lock(counter.continuation_mutex);
+}
+
+void JobSystem::worker_main(uint32_t index) noexcept
+{
+    ThreadState* state = threads[index].get();
+    current_system = this;
+    current_state = state;
+    std::string thread_name = "Job worker " + std::to_string(index);
+    Profiler::set_thread_name(thread_name.c_str());
+    uint32_t idle_rounds = 0;
+    while (!stop.load(std::memory_order_relaxed))
+    {
+        if (detail::Job* job = find_job(state))
+        {
+            run_job(job);
+            idle_rounds = 0;
+            continue;
+        }
+        if (++idle_rounds < 64)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex);
+        sleeping_workers.fetch_add(1);
+        sleep_condition.wait(lock, [this] { return stop.load() || queued_jobs.load() > 0; });
+        sleeping_workers.fetch_sub(1);
+        idle_rounds = 0;
+    }
+    current_system = nullptr;
+    current_state = nullptr;
+}
+
+size_t JobSystem::chunk_size(size_t count, size_t grain_size) const noexcept
+{
+    // A few chunks per thread leaves room for stealing to even out uneven progress
+    size_t target_chunks = threads.size() * 4;
+    size_t chunk = (count + target_chunks - 1) / target_chunks;
+    if (chunk < grain_size) chunk = grain_size;
+    return chunk > 0 ? chunk : 1;
+}
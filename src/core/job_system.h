@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class JobCounter;
+class JobSystem;
+
+namespace detail
+{
+struct JobPool;
+
+// A unit of work. Callables up to `inline_size` bytes are stored in place, larger ones on the heap.
+// Jobs are recycled through per thread pools, so submitting a job doesn't touch the global allocator.
+struct Job
+{
+    static constexpr size_t inline_size = 64;
+
+    void (*invoke)(Job& job) = nullptr;
+    void (*destroy)(Job& job) = nullptr;
+    JobCounter* counter = nullptr;
+    JobPool* owner = nullptr;
+    Job* next = nullptr; // intrusive free list link
+    alignas(std::max_align_t) unsigned char storage[inline_size];
+
+    template <typename F> void emplace(F&& function)
+    {
+        using Callable = std::decay_t<F>;
+        if constexpr (sizeof(Callable) <= inline_size && alignof(Callable) <= alignof(std::max_align_t))
+        {
+            new (storage) Callable(std::forward<F>(function));
+            invoke = [](Job& job) { (*std::launder(reinterpret_cast<Callable*>(job.storage)))(); };
+            destroy = [](Job& job) { std::launder(reinterpret_cast<Callable*>(job.storage))->~Callable(); };
+        }
+        else
+        {
+            Callable* heap = new Callable(std::forward<F>(function));
+            std::memcpy(storage, &heap, sizeof(heap));
+            invoke = [](Job& job) { (*job.heap_callable<Callable>())(); };
+            destroy = [](Job& job) { delete job.heap_callable<Callable>(); };
+        }
+    }
+
+    template <typename Callable> Callable* heap_callable() noexcept
+    {
+        Callable* heap = nullptr;
+        std::memcpy(&heap, storage, sizeof(heap));
+        return heap;
+    }
+};
+
+// Chase-Lev work stealing deque of jobs. The owning thread pushes and pops at the bottom, any other
+// thread may steal from the top. The capacity is fixed, push() fails when the deque is full.
+// Follows "Correct and Efficient Work-Stealing for Weak Memory Models", Lê et al. 2013.
+class WorkStealingDeque
+{
+    public:
+    explicit WorkStealingDeque(size_t capacity);
+
+    bool push(Job* job) noexcept;
+    Job* pop() noexcept;
+    Job* steal() noexcept;
+    bool empty() const noexcept;
+
+    private:
+    // top and bottom on separate cache lines, thieves hammer top while the owner works on bottom
+    alignas(64) std::atomic<int64_t> top{ 0 };
+    alignas(64) std::atomic<int64_t> bottom{ 0 };
+    int64_t mask;
+    std::unique_ptr<std::atomic<Job*>[]> buffer;
+};
+} // namespace detail
+
+// Counts outstanding jobs. A counter is incremented for every job submitted with it and decremented
+// once the job finishes, so waiting on it waits for all of those jobs. Continuations registered with
+// JobSystem::submit_after() are submitted when the count drops to zero.
+// A counter must only be destroyed or reused for a new batch after JobSystem::wait() returned for it.
+class JobCounter
+{
+    public:
+    JobCounter() noexcept = default;
+    JobCounter(JobCounter const&) = delete;
+    JobCounter& operator=(JobCounter const&) = delete;
+
+    [[nodiscard]] bool is_done() const noexcept { return count.load(std::memory_order_acquire) == 0; }
+    [[nodiscard]] uint32_t pending() const noexcept { return count.load(std::memory_order_acquire); }
+
+    private:
+    friend class JobSystem;
+    std::atomic<uint32_t> count{ 0 };
+    // Guards continuations and the final decrement, see JobSystem::run_job()
+    mutable std::mutex continuation_mutex;
+    std::vector<detail::Job*> continuations;
+};
+
+// Fixed pool of worker threads with per thread work stealing deques.
+//
+// Jobs submitted from a worker go to that worker's deque and are run last in first out, idle
+// workers steal the oldest jobs from other deques. The thread that created the JobSystem is
+// registered as thread 0 and gets a deque too, so it can submit cheaply and run jobs while it waits.
+// Other threads may submit as well, their jobs go through a shared queue.
+class JobSystem
+{
+    public:
+    struct CreateDetails
+    {
+        // Number of worker threads in addition to the creating thread, 0 picks hardware_concurrency - 1
+        uint32_t worker_count = 0;
+        // Maximum number of queued jobs per thread, rounded up to a power of two. Jobs that don't fit
+        // are run immediately by the submitting thread.
+        size_t queue_capacity = 4096;
+    };
+
+    JobSystem(CreateDetails create_details);
+    ~JobSystem() noexcept;
+    JobSystem(JobSystem const&) = delete;
+    JobSystem& operator=(JobSystem const&) = delete;
+    JobSystem(JobSystem&& other) noexcept = delete;
+    JobSystem& operator=(JobSystem&& other) noexcept = delete;
+
+    // Total number of threads running jobs, including the creating thread
+    [[nodiscard]] uint32_t thread_count() const noexcept;
+    // Index of the calling thread in [0, thread_count()), or thread_count() for unregistered threads
+    [[nodiscard]] uint32_t current_thread_index() const noexcept;
+
+    // Queue `function` to run on any thread, `counter` (optional) tracks its completion
+    template <std::invocable F> void submit(F&& function, JobCounter* counter = nullptr)
+    {
+        detail::Job* job = allocate_job();
+        job->emplace(std::forward<F>(function));
+        job->counter = counter;
+        if (counter) counter->count.fetch_add(1, std::memory_order_relaxed);
+        schedule(job);
+    }
+    template <std::invocable F> void submit(F&& function, JobCounter& counter)
+    {
+        submit(std::forward<F>(function), &counter);
+    }
+
+    // Queue `function` behind every job already queued. It runs once a thread has no jobs of its own
+    // left and nothing to steal, which is what jobs that re-queue themselves, like polls, need: a
+    // regular submit() would put them on top of the submitting thread's deque to be popped again
+    // right away.
+    template <std::invocable F> void submit_deferred(F&& function, JobCounter* counter = nullptr)
+    {
+        detail::Job* job = allocate_job();
+        job->emplace(std::forward<F>(function));
+        job->counter = counter;
+        if (counter) counter->count.fetch_add(1, std::memory_order_relaxed);
+        schedule_deferred(job);
+    }
+
+    // Queue `function` once every job of `dependency` has finished. `counter` is incremented now, so
+    // waiting on it also waits for the dependency.
+    template <std::invocable F>
+    void submit_after(JobCounter& dependency, F&& function, JobCounter* counter = nullptr)
+    {
+        detail::Job* job = allocate_job();
+        job->emplace(std::forward<F>(function));
+        job->counter = counter;
+        if (counter) counter->count.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard lock(dependency.continuation_mutex);
+            if (!dependency.is_done())
+            {
+                dependency.continuations.push_back(job);
+                return;
+            }
+        }
+        schedule(job);
+    }
+
+    // Runs queued jobs on the calling thread until `counter` reaches zero
+    void wait(JobCounter const& counter) noexcept;
+
+    // Runs a single queued job if there is one, returns whether a job ran
+    bool try_run_one() noexcept;
+
+    // Calls function(begin, end) over sub ranges covering [first, last) on all threads and returns once
+    // every range is done. grain_size is the minimum number of indices per call, with 0 the range is
+    // split into a few chunks per thread, which balances well when iterations cost about the same.
+    template <typename F>
+        requires std::invocable<F&, size_t, size_t>
+    void parallel_for(size_t first, size_t last, F&& function, size_t grain_size = 0)
+    {
+        if (first >= last) return;
+        size_t count = last - first;
+        size_t chunk = chunk_size(count, grain_size);
+        if (chunk >= count)
+        {
+            function(first, last);
+            return;
+        }
+        JobCounter counter;
+        auto* callable = &function;
+        // the calling thread takes the first chunk itself instead of going idle
+        for (size_t begin = first + chunk; begin < last; begin += chunk)
+        {
+            size_t end = count - (begin - first) > chunk ? begin + chunk : last;
+            submit([callable, begin, end] { (*callable)(begin, end); }, counter);
+        }
+        function(first, first + chunk);
+        wait(counter);
+    }
+    // Calls function(index) for every index in [first, last)
+    template <typename F>
+        requires(std::invocable<F&, size_t> && !std::invocable<F&, size_t, size_t>)
+    void parallel_for(size_t first, size_t last, F&& function, size_t grain_size = 0)
+    {
+        parallel_for(
+            first,
+            last,
+            [&function](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                    function(i);
+            },
+            grain_size);
+    }
+
+    private:
+    struct ThreadState;
+
+    ThreadState* local_state() const noexcept;
+    detail::Job* allocate_job();
+    void schedule(detail::Job* job) noexcept;
+    void schedule_deferred(detail::Job* job) noexcept;
+    void wake_worker() noexcept;
+    void run_job(detail::Job* job) noexcept;
+    detail::Job* find_job(ThreadState* state) noexcept;
+    void worker_main(uint32_t index) noexcept;
+    size_t chunk_size(size_t count, size_t grain_size) const noexcept;
+
+    std::vector<std::unique_ptr<ThreadState>> threads;
+    std::vector<std::thread> workers;
+
+    // Jobs from unregistered threads and deferred jobs, run first in first out
+    std::mutex shared_mutex;
+    std::deque<detail::Job*> shared_queue;
+
+    // Idle workers sleep until the number of queued jobs is non zero
+    std::atomic<int64_t> queued_jobs{ 0 };
+    std::atomic<uint32_t> sleeping_workers{ 0 };
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_condition;
+    std::atomic<bool> stop{ false };
+};
@@ -0,0 +1,306 @@
+#include "pool_allocator.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <new>
+#include <unordered_map>
+
+namespace
+{
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+// Slabs start with a header naming their owner and size class, blocks find it by masking their
+// address. 64 bytes keeps the blocks after it aligned to min(block size, 64).
+constexpr size_t slab_header_size = 64;
+
+constexpr size_t class_size(size_t size_class) noexcept
+{
+    return PoolAllocator::min_pooled_size << size_class;
+}
+
+size_t size_class_of(size_t bytes) noexcept
+{
+    if (bytes <= PoolAllocator::min_pooled_size) return 0;
+    return static_cast<size_t>(std::countr_zero(std::bit_ceil(bytes)) -
+                               std::countr_zero(PoolAllocator::min_pooled_size));
+}
+static_assert(class_size(PoolAllocator::size_class_count - 1) == PoolAllocator::max_pooled_size);
+
+bool is_pooled(size_t bytes, size_t alignment) noexcept
+{
+    if (bytes > PoolAllocator::max_pooled_size) return false;
+    size_t block_size = class_size(size_class_of(bytes));
+    return alignment <= (block_size < slab_header_size ? block_size : slab_header_size);
+}
+
+// Live allocators by id, lets exiting threads tell whether their caches' allocators still exist
+struct Registry
+{
+    std::mutex mutex;
+    std::unordered_map<uint64_t, PoolAllocator*> allocators;
+    uint64_t next_id = 1;
+};
+
+Registry& registry()
+{
+    // leaked, threads may exit after static destructors ran
+    static Registry* instance = new Registry();
+    return *instance;
+}
+} // namespace
+
+struct PoolAllocator::ThreadCache
+{
+    struct SlabHeader
+    {
+        ThreadCache* owner;
+        size_t size_class;
+    };
+    struct SizeClass
+    {
+        FreeBlock* free_list = nullptr;
+        // untouched part of the newest slab
+        std::byte* bump = nullptr;
+        std::byte* bump_end = nullptr;
+    };
+    // Blocks this thread freed for another cache, waiting to be handed back
+    struct RemoteBatch
+    {
+        ThreadCache* owner = nullptr;
+        FreeBlock* head = nullptr;
+        FreeBlock* tail = nullptr;
+        uint32_t count = 0;
+    };
+
+    std::array<SizeClass, size_class_count> classes{};
+    std::array<RemoteBatch, 4> pending{};
+    // Blocks of this cache freed by other threads
+    std::atomic<FreeBlock*> remote_frees{ nullptr };
+    std::vector<void*> slabs;
+
+    static SlabHeader* slab_of(void* pointer) noexcept
+    {
+        return reinterpret_cast<SlabHeader*>(reinterpret_cast<uintptr_t>(pointer) &
+                                             ~uintptr_t{ slab_size - 1 });
+    }
+
+    RemoteBatch& batch_for(ThreadCache* owner) noexcept
+    {
+        size_t slot = reinterpret_cast<uintptr_t>(owner) / alignof(ThreadCache);
+        return pending[slot % pending.size()];
+    }
+
+    static void push_remote(ThreadCache* owner, FreeBlock* head, FreeBlock* tail) noexcept
+    {
+        FreeBlock* current = owner->remote_frees.load(std::memory_order_relaxed);
+        do
+        {
+            tail->next = current;
+        } while (!owner->remote_frees.compare_exchange_weak(
+            current, head, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    static void flush(RemoteBatch& batch) noexcept
+    {
+        if (batch.count > 0) push_remote(batch.owner, batch.head, batch.tail);
+        batch = RemoteBatch{};
+    }
+};
+
+// Per thread list of caches, one per allocator the thread used. Its destructor runs at thread exit
+// and hands the caches back to their allocators.
+struct PoolThreadExit
+{
+    struct Entry
+    {
+        uint64_t allocator_id;
+        PoolAllocator::ThreadCache* cache;
+    };
+    std::vector<Entry> entries;
+
+    ~PoolThreadExit()
+    {
+        if (entries.empty()) return;
+        Registry& live = registry();
+        std::lock_guard lock(live.mutex);
+        for (auto const& entry : entries)
+            if (auto it = live.allocators.find(entry.allocator_id); it != live.allocators.end())
+                it->second->release_cache(entry.cache);
+    }
+
+    PoolAllocator::ThreadCache* find(uint64_t allocator_id) const noexcept
+    {
+        for (auto const& entry : entries)
+            if (entry.allocator_id == allocator_id) return entry.cache;
+        return nullptr;
+    }
+};
+
+namespace
+{
+thread_local PoolThreadExit thread_caches;
+} // namespace
+
+PoolAllocator::PoolAllocator(CreateDetails create_details)
+: upstream(create_details.upstream),
+  remote_batch_size(create_details.remote_batch_size > 0 ? create_details.remote_batch_size : 1)
+{
+    Registry& live = registry();
+    std::lock_guard lock(live.mutex);
+    id = live.next_id++;
+    live.allocators.emplace(id, this);
+}
+
+PoolAllocator::~PoolAllocator() noexcept
+{
+    {
+        Registry& live = registry();
+        std::lock_guard lock(live.mutex);
+        live.allocators.erase(id);
+    }
+    for (auto& cache : caches)
+        for (void* slab : cache->slabs)
+            upstream->deallocate(slab, slab_size, slab_size);
+}
+
+size_t PoolAllocator::slab_count() const noexcept
+{
+    return slab_total.load(std::memory_order_relaxed);
+}
+
+PoolAllocator::ThreadCache& PoolAllocator::local_cache()
+{
+    if (ThreadCache* cache = thread_caches.find(id)) return *cache;
+    return *acquire_cache();
+}
+
+PoolAllocator::ThreadCache* PoolAllocator::acquire_cache()
+{
+    thread_caches.entries.reserve(thread_caches.entries.size() + 1);
+    ThreadCache* cache = nullptr;
+    {
+        std::lock_guard lock(caches_mutex);
+        if (!orphaned_caches.empty())
+        {
+            cache = orphaned_caches.back();
+            orphaned_caches.pop_back();
+        }
+        else
+        {
+            caches.push_back(std::make_unique<ThreadCache>());
+            cache = caches.back().get();
+        }
+    }
+    thread_caches.entries.push_back(PoolThreadExit::Entry{ id, cache });
+    return cache;
+}
+
+void PoolAllocator::release_cache(ThreadCache* cache) noexcept
+{
+    for (auto& batch : cache->pending)
+        ThreadCache::flush(batch);
+    std::lock_guard lock(caches_mutex);
+    orphaned_caches.push_back(cache);
+}
+
+void PoolAllocator::refill(ThreadCache& cache, size_t size_class)
+{
+    // blocks returned by other threads can be of any class, sort them into their free lists
+    FreeBlock* returned = cache.remote_frees.exchange(nullptr, std::memory_order_acquire);
+    while (returned)
+    {
+        FreeBlock* next = returned->next;
+        auto& pool = cache.classes[ThreadCache::slab_of(returned)->size_class];
+        returned->next = pool.free_list;
+        pool.free_list = returned;
+        returned = next;
+    }
+    auto& pool = cache.classes[size_class];
+    if (pool.free_list) return;
+
+    cache.slabs.reserve(cache.slabs.size() + 1);
+    auto* slab = static_cast<std::byte*>(upstream->allocate(slab_size, slab_size));
+    cache.slabs.push_back(slab);
+    slab_total.fetch_add(1, std::memory_order_relaxed);
+    new (slab) ThreadCache::SlabHeader{ &cache, size_class };
+    size_t block_count = (slab_size - slab_header_size) / class_size(size_class);
+    pool.bump = slab + slab_header_size;
+    pool.bump_end = pool.bump + block_count * class_size(size_class);
+}
+
+void* PoolAllocator::do_allocate(size_t bytes, size_t alignment)
+{
+    if (!is_pooled(bytes, alignment)) return upstream->allocate(bytes, alignment);
+
+    size_t size_class = size_class_of(bytes);
+    ThreadCache& cache = local_cache();
+    auto& pool = cache.classes[size_class];
+    if (pool.free_list == nullptr && pool.bump == pool.bump_end) refill(cache, size_class);
+    if (FreeBlock* block = pool.free_list)
+    {
+        pool.free_list = block->next;
+        return block;
+    }
+    void* block = pool.bump;
+    pool.bump += class_size(size_class);
+    return block;
+}
+
+void PoolAllocator::do_deallocate(void* pointer, size_t bytes, size_t alignment) noexcept
+{
+    if (pointer == nullptr) return;
+    if (!is_pooled(bytes, alignment))
+    {
+        upstream->deallocate(pointer, bytes, alignment);
+        return;
+    }
+
+    auto* block = static_cast<FreeBlock*>(pointer);
+    ThreadCache* owner = ThreadCache::slab_of(pointer)->owner;
+    ThreadCache* cache = thread_caches.find(id);
+    if (cache == nullptr)
+    {
+        // a thread that never allocated from this pool has nowhere to batch, return right away
+        ThreadCache::push_remote(owner, block, block);
+    }
+    else if (cache == owner)
+    {
+        auto& pool = cache->classes[size_class_of(bytes)];
+        block->next = pool.free_list;
+        pool.free_list = block;
+    }
+    else
+    {
+        free_remote(*cache, owner, block);
+    }
+}
+
+void PoolAllocator::free_remote(ThreadCache& cache, ThreadCache* owner, void* pointer) noexcept
+{
+    auto* block = static_cast<FreeBlock*>(pointer);
+    auto& batch = cache.batch_for(owner);
+    if (batch.owner != owner) ThreadCache::flush(batch);
+    batch.owner = owner;
+    block->next = batch.head;
+    batch.head = block;
+    if (batch.tail == nullptr) batch.tail = block;
+    if (++batch.count >= remote_batch_size) ThreadCache::flush(batch);
+}
+
+void PoolAllocator::flush_remote_frees() noexcept
+{
+    if (ThreadCache* cache = thread_caches.find(id))
+        for (auto& batch : cache->pending)
+            ThreadCache::flush(batch);
+}
+
+PoolAllocator& default_pool_allocator()
+{
+    static PoolAllocator* pool = new PoolAllocator(PoolAllocator::CreateDetails{});
+    return *pool;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+// Size class allocator for small objects, usable as a std::pmr::memory_resource.
+//
+// Requests up to max_pooled_size bytes are rounded up to a power of two size class and served from
+// 64 KiB slabs owned by the calling thread, allocating and freeing on the owning thread is a free
+// list push or pop without locks or atomics. Blocks freed by another thread are collected in small
+// per owner batches and handed back with a single atomic push once a batch is full, the owner picks
+// them up the next time one of its free lists runs dry. Larger or over aligned requests go straight
+// to the upstream resource.
+//
+// Each thread gets its cache on first use. When a thread exits its cache is kept and handed to the
+// next new thread, so memory isn't stranded by short lived threads.
+class PoolAllocator final : public std::pmr::memory_resource
+{
+    public:
+    static constexpr size_t slab_size = 64 * 1024;
+    static constexpr size_t min_pooled_size = 16;
+    static constexpr size_t max_pooled_size = 2048;
+    static constexpr size_t size_class_count = 8;
+
+    struct CreateDetails
+    {
+        // Source of slabs and of allocations too big to pool, must support slab_size alignment
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource();
+        // Number of blocks freed by this thread for another thread before they are handed back
+        uint32_t remote_batch_size = 32;
+    };
+
+    PoolAllocator(CreateDetails create_details);
+    ~PoolAllocator() noexcept override;
+    PoolAllocator(PoolAllocator const&) = delete;
+    PoolAllocator& operator=(PoolAllocator const&) = delete;
+
+    // Hands blocks the calling thread freed for other threads back to them now instead of waiting
+    // for the batches to fill up
+    void flush_remote_frees() noexcept;
+
+    // Number of slabs taken from upstream so far
+    [[nodiscard]] size_t slab_count() const noexcept;
+
+    private:
+    struct ThreadCache;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) noexcept override;
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    ThreadCache& local_cache();
+    ThreadCache* acquire_cache();
+    void refill(ThreadCache& cache, size_t size_class);
+    void free_remote(ThreadCache& cache, ThreadCache* owner, void* pointer) noexcept;
+    void release_cache(ThreadCache* cache) noexcept;
+
+    friend struct PoolThreadExit;
+
+    std::pmr::memory_resource* upstream;
+    uint32_t remote_batch_size;
+    uint64_t id = 0;
+    std::atomic<size_t> slab_total{ 0 };
+
+    mutable std::mutex caches_mutex;
+    std::vector<std::unique_ptr<ThreadCache>> caches;
+    std::vector<ThreadCache*> orphaned_caches;
+};
+
+// Engine wide pool, never destroyed so containers in static storage can still free into it
+PoolAllocator& default_pool_allocator();
+
+// Stateless std allocator over default_pool_allocator(), a drop in replacement for std::allocator
+// in long lived engine containers
+template <typename T> class PoolStlAllocator
+{
+    public:
+    using value_type = T;
+
+    PoolStlAllocator() noexcept = default;
+    template <typename U> PoolStlAllocator(PoolStlAllocator<U> const&) noexcept {}
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(default_pool_allocator().allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* pointer, size_t count) noexcept
+    {
+        default_pool_allocator().deallocate(pointer, count * sizeof(T), alignof(T));
+    }
+
+    template <typename U> bool operator==(PoolStlAllocator<U> const&) const noexcept
+    {
+        return true;
+    }
+};
+
+template <typename T> using pool_vector = std::vector<T, PoolStlAllocator<T>>;
@@ -0,0 +1,310 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+
+namespace
+{
+struct Frame
+{
+    int64_t start_ns = 0;
+    int64_t end_ns = 0;
+    std::vector<Profiler::Event> events;
+};
+} // namespace
+
+// Single producer, single consumer ring of events. The owning thread pushes, mark_frame() drains
+// while holding the profiler mutex. When full, new events are dropped instead of overwriting ones
+// the reader may be copying. Every thread gets one, tracks are ones without a thread.
+struct Profiler::Track
+{
+    static constexpr uint64_t capacity = 8192;
+
+    Track(uint32_t track_index, std::string track_name)
+    : index(track_index), name(std::move(track_name)),
+      events(std::make_unique<Profiler::Event[]>(capacity))
+    {
+    }
+
+    uint32_t index;
+    std::string name; // guarded by the profiler mutex
+    std::unique_ptr<Profiler::Event[]> events;
+    alignas(64) std::atomic<uint64_t> write{ 0 };
+    alignas(64) std::atomic<uint64_t> read{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+
+    void push(Profiler::Event const& event) noexcept
+    {
+        uint64_t w = write.load(std::memory_order_relaxed);
+        if (w - read.load(std::memory_order_acquire) >= capacity)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[w % capacity] = event;
+        write.store(w + 1, std::memory_order_release);
+    }
+
+    template <typename F> void drain(F&& function)
+    {
+        uint64_t r = read.load(std::memory_order_relaxed);
+        uint64_t w = write.load(std::memory_order_acquire);
+        for (; r < w; r++)
+            function(events[r % capacity]);
+        read.store(w, std::memory_order_release);
+    }
+};
+
+namespace
+{
+using ThreadBuffer = Profiler::Track;
+
+struct State
+{
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::atomic<bool> enabled{ true };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
+    std::deque<Frame> frames;
+    size_t history_frames = 300;
+    int64_t frame_start_ns = 0;
+};
+
+State& state()
+{
+    // leaked, threads may still record while static destructors run
+    static State* instance = new State();
+    return *instance;
+}
+
+thread_local ThreadBuffer* local_buffer = nullptr;
+
+ThreadBuffer* thread_buffer() noexcept
+{
+    if (local_buffer) return local_buffer;
+    try
+    {
+        State& s = state();
+        std::lock_guard lock(s.mutex);
+        auto index = static_cast<uint32_t>(s.threads.size());
+        std::string name = "Thread " + std::to_string(index);
+        s.threads.push_back(std::make_unique<ThreadBuffer>(index, std::move(name)));
+        local_buffer = s.threads.back().get();
+    }
+    catch (...)
+    {
+        // out of memory, the event is lost
+    }
+    return local_buffer;
+}
+
+void trim_history(State& s)
+{
+    while (s.frames.size() > s.history_frames)
+        s.frames.pop_front();
+}
+} // namespace
+
+void Profiler::set_enabled(bool enabled) noexcept
+{
+    state().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::is_enabled() noexcept { return state().enabled.load(std::memory_order_relaxed); }
+
+void Profiler::set_history_frames(uint32_t frame_count)
+{
+    State& s = state();
+    std::lock_guard lock(s.mutex);
+    s.history_frames = frame_count > 0 ? frame_count : 1;
+    trim_history(s);
+}
+
+int64_t Profiler::now_ns() noexcept
+{
+    auto elapsed = std::chrono::steady_clock::now() - state().epoch;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+void Profiler::record_scope(const char* name, int64_t start_ns, int64_t end_ns) noexcept
+{
+    if (ThreadBuffer* buffer = thread_buffer())
+        buffer->push(Event{ .name = name,
+            .type = EventType::scope,
+            .thread_index = buffer->index,
+            .start_ns = start_ns,
+            .duration_ns = end_ns - start_ns });
+}
+
+void Profiler::record_counter(const char* name, double value) noexcept
+{
+    if (!is_enabled()) return;
+    if (ThreadBuffer* buffer = thread_buffer())
+        buffer->push(Event{ .name = name,
+            .type = EventType::counter,
+            .thread_index = buffer->index,
+            .start_ns = now_ns(),
+            .value = value });
+}
+
+void Profiler::set_thread_name(const char* name)
+{
+    if (ThreadBuffer* buffer = thread_buffer())
+    {
+        std::lock_guard lock(state().mutex);
+        buffer->name = name;
+    }
+}
+
+Profiler::Track* Profiler::create_track(const char* name)
+{
+    State& s = state();
+    std::lock_guard lock(s.mutex);
+    for (auto& track : s.threads)
+        if (track->name == name) return track.get();
+    auto index = static_cast<uint32_t>(s.threads.size());
+    s.threads.push_back(std::make_unique<Track>(index, name));
+    return s.threads.back().get();
+}
+
+void Profiler::record_scope(
+    Track* track, const char* name, int64_t start_ns, int64_t end_ns) noexcept
+{
+    if (track == nullptr || !is_enabled()) return;
+    track->push(Event{ .name = name,
+        .type = EventType::scope,
+        .thread_index = track->index,
+        .start_ns = start_ns,
+        .duration_ns = end_ns - start_ns });
+}
+
+void Profiler::mark_frame()
+{
+    State& s = state();
+    int64_t end_ns = now_ns();
+    std::lock_guard lock(s.mutex);
+
+    // reuse the oldest frame's storage once the history is full
+    Frame frame;
+    if (s.frames.size() >= s.history_frames)
+    {
+        frame = std::move(s.frames.front());
+        s.frames.pop_front();
+        frame.events.clear();
+    }
+    frame.start_ns = s.frame_start_ns;
+    frame.end_ns = end_ns;
+    for (auto& buffer : s.threads)
+        buffer->drain([&](Event const& event) { frame.events.push_back(event); });
+    s.frames.push_back(std::move(frame));
+    s.frame_start_ns = end_ns;
+}
+
+std::vector<Profiler::ScopeStats> Profiler::aggregate(uint32_t frame_count)
+{
+    State& s = state();
+    std::lock_guard lock(s.mutex);
+
+    std::unordered_map<std::string_view, ScopeStats> by_name;
+    size_t first = s.frames.size() > frame_count ? s.frames.size() - frame_count : 0;
+    for (size_t i = first; i < s.frames.size(); i++)
+    {
+        for (auto const& event : s.frames[i].events)
+        {
+            if (event.type != EventType::scope) continue;
+            auto [it, inserted] = by_name.try_emplace(event.name);
+            ScopeStats& stats = it->second;
+            if (inserted)
+            {
+                stats.name = event.name;
+                stats.min_ns = event.duration_ns;
+                stats.max_ns = event.duration_ns;
+            }
+            stats.count++;
+            stats.total_ns += event.duration_ns;
+            stats.min_ns = std::min(stats.min_ns, event.duration_ns);
+            stats.max_ns = std::max(stats.max_ns, event.duration_ns);
+        }
+    }
+
+    std::vector<ScopeStats> result;
+    result.reserve(by_name.size());
+    for (auto const& [name, stats] : by_name)
+        result.push_back(stats);
+    std::sort(result.begin(), result.end(), [](ScopeStats const& a, ScopeStats const& b) {
+        return a.total_ns > b.total_ns;
+    });
+    return result;
+}
+
+bool Profiler::write_chrome_trace(const char* path)
+{
+    State& s = state();
+    nlohmann::json events = nlohmann::json::array();
+    {
+        std::lock_guard lock(s.mutex);
+        for (auto const& buffer : s.threads)
+            events.push_back({ { "name", "thread_name" },
+                { "ph", "M" },
+                { "pid", 0 },
+                { "tid", buffer->index },
+                { "args",
+                    { { "name", buffer->name }, { "dropped_events", buffer->dropped.load() } } } });
+
+        // trace timestamps are in microseconds
+        auto micros = [](int64_t ns) { return static_cast<double>(ns) / 1000.0; };
+        for (auto const& frame : s.frames)
+        {
+            for (auto const& event : frame.events)
+            {
+                if (event.type == EventType::scope)
+                    events.push_back({ { "name", event.name },
+                        { "ph", "X" },
+                        { "pid", 0 },
+                        { "tid", event.thread_index },
+                        { "ts", micros(event.start_ns) },
+                        { "dur", micros(event.duration_ns) } });
+                else
+                    events.push_back({ { "name", event.name },
+                        { "ph", "C" },
+                        { "pid", 0 },
+                        { "tid", event.thread_index },
+                        { "ts", micros(event.start_ns) },
+                        { "args", { { "value", event.value } } } });
+            }
+            events.push_back({ { "name", "Frame" },
+                { "ph", "i" },
+                { "s", "g" },
+                { "pid", 0 },
+                { "tid", 0 },
+                { "ts", micros(frame.end_ns) } });
+        }
+    }
+
+    std::ofstream file(path);
+    if (!file) return false;
+    file << nlohmann::json{ { "traceEvents", std::move(events) }, { "displayTimeUnit", "ms" } };
+    return static_cast<bool>(file);
+}
+
+void Profiler::clear()
+{
+    State& s = state();
+    int64_t start_ns = now_ns();
+    std::lock_guard lock(s.mutex);
+    for (auto& buffer : s.threads)
+        buffer->drain([](Event const&) {});
+    s.frames.clear();
+    s.frame_start_ns = start_ns;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vector>
+
+// Built in CPU profiler.
+//
+// Scopes and counters are written into a ring buffer owned by the recording thread, so recording
+// takes no locks. Profiler::mark_frame() moves everything recorded so far into a history of the
+// last few frames, which can be summarized with aggregate() or written out as a Chrome trace
+// (chrome://tracing, ui.perfetto.dev).
+//
+// Names must outlive the profiler, string literals are the intended use.
+//
+//     void Renderer::draw()
+//     {
+//         ORANGE_PROFILE_SCOPE("Renderer::draw");
+//         ...
+//     }
+class Profiler
+{
+    public:
+    enum class EventType : uint8_t
+    {
+        scope,
+        counter,
+    };
+    struct Event
+    {
+        const char* name = nullptr;
+        EventType type = EventType::scope;
+        uint32_t thread_index = 0;
+        int64_t start_ns = 0;
+        int64_t duration_ns = 0; // scopes only
+        double value = 0.0;      // counters only
+    };
+    struct ScopeStats
+    {
+        const char* name = nullptr;
+        uint64_t count = 0;
+        int64_t total_ns = 0;
+        int64_t min_ns = 0;
+        int64_t max_ns = 0;
+    };
+
+    // Timeline that isn't a CPU thread, like a GPU queue. Only one thread may record to a track at
+    // a time.
+    struct Track;
+
+    // Recording is on by default, turning it off makes scopes and counters no-ops
+    static void set_enabled(bool enabled) noexcept;
+    [[nodiscard]] static bool is_enabled() noexcept;
+
+    // Number of frames kept by mark_frame(), older frames are dropped
+    static void set_history_frames(uint32_t frame_count);
+
+    // Nanoseconds since the profiler started
+    [[nodiscard]] static int64_t now_ns() noexcept;
+
+    static void record_scope(const char* name, int64_t start_ns, int64_t end_ns) noexcept;
+    static void record_counter(const char* name, double value) noexcept;
+    // Name shown for the calling thread in traces
+    static void set_thread_name(const char* name);
+
+    // Tracks live as long as the profiler, creating one with an existing name returns that track
+    [[nodiscard]] static Track* create_track(const char* name);
+    static void record_scope(
+        Track* track, const char* name, int64_t start_ns, int64_t end_ns) noexcept;
+
+    // Ends the current frame, collecting the events of every thread into the history
+    static void mark_frame();
+
+    // Per scope name totals over the last `frame_count` frames in the history, sorted by total time
+    [[nodiscard]] static std::vector<ScopeStats> aggregate(uint32_t frame_count);
+
+    // Writes the history in the Chrome trace event format, returns false if the file couldn't be
+    // written
+    static bool write_chrome_trace(const char* path);
+
+    // Drops the history and anything recorded but not yet collected
+    static void clear();
+};
+
+// Records the time between construction and destruction as a scope
+class ProfileScope
+{
+    public:
+    explicit ProfileScope(const char* scope_name) noexcept
+    : name(scope_name), start_ns(Profiler::is_enabled() ? Profiler::now_ns() : -1)
+    {
+    }
+    ~ProfileScope() noexcept
+    {
+        if (start_ns >= 0) Profiler::record_scope(name, start_ns, Profiler::now_ns());
+    }
+    ProfileScope(ProfileScope const&) = delete;
+    ProfileScope& operator=(ProfileScope const&) = delete;
+
+    private:
+    const char* name;
+    int64_t start_ns;
+};
+
+#if defined(ORANGE_ENABLE_PROFILER)
+#define ORANGE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ORANGE_PROFILE_CONCAT(a, b) ORANGE_PROFILE_CONCAT_IMPL(a, b)
+#define ORANGE_PROFILE_SCOPE(name) \
+    ProfileScope ORANGE_PROFILE_CONCAT(orange_profile_scope_, __LINE__) { name }
+#define ORANGE_PROFILE_COUNTER(name, value) \
+    Profiler::record_counter(name, static_cast<double>(value))
+#define ORANGE_PROFILE_FRAME() Profiler::mark_frame()
+#else
+#define ORANGE_PROFILE_SCOPE(name) static_cast<void>(0)
+#define ORANGE_PROFILE_COUNTER(name, value) static_cast<void>(0)
+#define ORANGE_PROFILE_FRAME() static_cast<void>(0)
+#endif
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "core/job_system.h"
+
+// C++20 coroutines on top of JobSystem.
+//
+// A task<T> is a lazily started coroutine which runs when it is co_awaited and resumes the awaiting
+// coroutine once it completes. Suspending a task (waiting on a JobCounter, an async_event, a polled
+// condition or being moved to a worker) releases the thread to run other jobs, nothing blocks an OS
+// thread except sync_wait(), which runs jobs itself while it waits.
+//
+//     orange::task<Mesh> load_mesh(JobSystem& jobs, Path path)
+//     {
+//         co_await orange::schedule_on(jobs);   // continue on a worker
+//         auto bytes = co_await read_file(jobs, path);
+//         co_return parse(bytes);
+//     }
+//     Mesh mesh = orange::sync_wait(jobs, load_mesh(jobs, "cube.gltf"));
+namespace orange
+{
+template <typename T = void> class task;
+
+namespace detail
+{
+struct task_promise_base
+{
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr exception;
+
+    // Completion transfers straight to the awaiting coroutine instead of growing the stack
+    struct final_awaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            return handle.promise().continuation;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    final_awaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+    void rethrow_if_failed() const
+    {
+        if (exception) std::rethrow_exception(exception);
+    }
+};
+
+template <typename T> struct task_promise : task_promise_base
+{
+    std::optional<T> value;
+
+    task<T> get_return_object() noexcept;
+    template <typename U>
+        requires std::is_convertible_v<U&&, T>
+    void return_value(U&& result) noexcept(std::is_nothrow_constructible_v<T, U&&>)
+    {
+        value.emplace(std::forward<U>(result));
+    }
+    T take_result()
+    {
+        rethrow_if_failed();
+        return std::move(*value);
+    }
+};
+
+template <> struct task_promise<void> : task_promise_base
+{
+    task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void take_result() const { rethrow_if_failed(); }
+};
+
+// Eagerly started coroutine which owns its frame, used to drive tasks from non coroutine code
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+} // namespace detail
+
+template <typename T> class [[nodiscard]] task
+{
+    public:
+    using promise_type = detail::task_promise<T>;
+
+    task() noexcept = default;
+    explicit task(std::coroutine_handle<promise_type> coroutine) noexcept : handle(coroutine) {}
+    ~task() noexcept
+    {
+        if (handle) handle.destroy();
+    }
+    task(task const&) = delete;
+    task& operator=(task const&) = delete;
+    task(task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    task& operator=(task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    [[nodiscard]] bool is_done() const noexcept { return !handle || handle.done(); }
+
+    // Starts the task and suspends the awaiting coroutine until it completes
+    auto operator co_await() && noexcept
+    {
+        struct awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().take_result(); }
+        };
+        return awaiter{ handle };
+    }
+
+    private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+namespace detail
+{
+template <typename T> task<T> task_promise<T>::get_return_object() noexcept
+{
+    return task<T>{ std::coroutine_handle<task_promise<T>>::from_promise(*this) };
+}
+inline task<void> task_promise<void>::get_return_object() noexcept
+{
+    return task<void>{ std::coroutine_handle<task_promise<void>>::from_promise(*this) };
+}
+} // namespace detail
+
+// co_await schedule_on(jobs) continues the coroutine as a job on the job system
+inline auto schedule_on(JobSystem& jobs) noexcept
+{
+    struct awaiter
+    {
+        JobSystem& jobs;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            jobs.submit([handle] { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+    return awaiter{ jobs };
+}
+
+// co_await wait_for(jobs, counter) continues the coroutine as a job once every job of `counter` is
+// done
+inline auto wait_for(JobSystem& jobs, JobCounter& counter) noexcept
+{
+    struct awaiter
+    {
+        JobSystem& jobs;
+        JobCounter& counter;
+        bool await_ready() const noexcept { return counter.is_done(); }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            jobs.submit_after(counter, [handle] { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+    return awaiter{ jobs, counter };
+}
+
+// co_await poll_until(jobs, condition) re-queues the coroutine as a deferred job until condition()
+// returns true, for completions that can only be polled, like a VkFence or a non blocking read.
+// Every other queued job gets to run in between polls.
+template <typename Condition>
+    requires std::is_invocable_r_v<bool, Condition&>
+auto poll_until(JobSystem& jobs, Condition condition)
+{
+    struct awaiter
+    {
+        JobSystem& jobs;
+        Condition condition;
+        bool await_ready() { return condition(); }
+        void await_suspend(std::coroutine_handle<> handle) { poll(handle); }
+        void await_resume() const noexcept {}
+        void poll(std::coroutine_handle<> handle)
+        {
+            jobs.submit_deferred([this, handle] {
+                if (condition())
+                    handle.resume();
+                else
+                    poll(handle);
+            });
+        }
+    };
+    return awaiter{ jobs, std::move(condition) };
+}
+
+// Manually set event, coroutines awaiting it are resumed as jobs once set() is called. Used to
+// signal completions coming from outside the job system, like a finished I/O request.
+class async_event
+{
+    public:
+    explicit async_event(JobSystem& job_system, bool initially_set = false) noexcept
+    : jobs(job_system), set_flag(initially_set)
+    {
+    }
+    async_event(async_event const&) = delete;
+    async_event& operator=(async_event const&) = delete;
+
+    [[nodiscard]] bool is_set() const noexcept { return set_flag.load(std::memory_order_acquire); }
+
+    void set()
+    {
+        std::vector<std::coroutine_handle<>> ready;
+        {
+            std::lock_guard lock(mutex);
+            set_flag.store(true, std::memory_order_release);
+            ready.swap(waiters);
+        }
+        for (auto handle : ready)
+            jobs.submit([handle] { handle.resume(); });
+    }
+    void reset() noexcept { set_flag.store(false, std::memory_order_release); }
+
+    auto operator co_await() noexcept
+    {
+        struct awaiter
+        {
+            async_event& event;
+            bool await_ready() const noexcept { return event.is_set(); }
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                std::lock_guard lock(event.mutex);
+                if (event.is_set()) return false;
+                event.waiters.push_back(handle);
+                return true;
+            }
+            void await_resume() const noexcept {}
+        };
+        return awaiter{ *this };
+    }
+
+    private:
+    JobSystem& jobs;
+    std::atomic<bool> set_flag;
+    std::mutex mutex;
+    std::vector<std::coroutine_handle<>> waiters;
+};
+
+namespace detail
+{
+struct when_all_state
+{
+    explicit when_all_state(size_t count) noexcept : remaining(count) {}
+
+    std::atomic<size_t> remaining;
+    std::coroutine_handle<> continuation;
+    std::atomic<bool> failed{ false };
+    std::exception_ptr exception;
+
+    void finish()
+    {
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) continuation.resume();
+    }
+};
+
+inline detached_task run_when_all_child(JobSystem& jobs, task<void>& child, when_all_state& state)
+{
+    co_await schedule_on(jobs);
+    try
+    {
+        co_await std::move(child);
+    }
+    catch (...)
+    {
+        if (!state.failed.exchange(true)) state.exception = std::current_exception();
+    }
+    state.finish();
+}
+} // namespace detail
+
+// co_await when_all(jobs, tasks) runs every task as its own job and continues once all are done.
+// Rethrows the first exception thrown by any of them.
+inline task<void> when_all(JobSystem& jobs, std::vector<task<void>> tasks)
+{
+    struct awaiter
+    {
+        JobSystem& jobs;
+        std::span<task<void>> tasks;
+        detail::when_all_state& state;
+
+        bool await_ready() const noexcept { return tasks.empty(); }
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            state.continuation = handle;
+            for (auto& child : tasks)
+                detail::run_when_all_child(jobs, child, state);
+            // the extra count keeps the children from resuming us before this returns
+            return state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+        void await_resume() const
+        {
+            if (state.exception) std::rethrow_exception(state.exception);
+        }
+    };
+    // one count per child plus one for the awaiter itself
+    detail::when_all_state state{ tasks.size() + 1 };
+    co_await awaiter{ jobs, tasks, state };
+}
+
+namespace detail
+{
+template <typename T, typename Result>
+detached_task run_sync_wait(task<T>& work, std::atomic<bool>& done, std::exception_ptr& exception,
+                            Result& result)
+{
+    try
+    {
+        if constexpr (std::is_void_v<T>)
+            co_await std::move(work);
+        else
+            result.emplace(co_await std::move(work));
+    }
+    catch (...)
+    {
+        exception = std::current_exception();
+    }
+    done.store(true, std::memory_order_release);
+}
+} // namespace detail
+
+// Runs `work` to completion and returns its result. The calling thread runs other jobs while the
+// task is suspended, so this is safe to use from the main thread and from inside jobs.
+template <typename T> T sync_wait(JobSystem& jobs, task<T> work)
+{
+    std::atomic<bool> done = false;
+    std::exception_ptr exception;
+    std::optional<std::conditional_t<std::is_void_v<T>, bool, T>> result;
+    detail::run_sync_wait(work, done, exception, result);
+
+    uint32_t idle_rounds = 0;
+    while (!done.load(std::memory_order_acquire))
+    {
+        if (jobs.try_run_one())
+            idle_rounds = 0;
+        else if (++idle_rounds > 64)
+            std::this_thread::yield();
+    }
+    if (exception) std::rethrow_exception(exception);
+    if constexpr (!std::is_void_v<T>) return std::move(*result);
+}
+
+} // namespace orange
@@ -1,39 +1,170 @@
 
 // Add our header only library definitions here
-// Necessary to make VUK work currently
+// VMA's implementation is compiled here for the renderer
 #define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.h>
 
 #include "core/glfw.h"
+#include "core/job_system.h"
+#include "core/profiler.h"
 #include "spdlog/spdlog.h"
 
+#include "asset/gltf_loader.h"
 #include "render/renderer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
 struct StaticInit
 {
     StaticInit() { Window::static_initialization(); }
     ~StaticInit() { Window::static_shutdown(); }
 };
 
-int main()
+// Latency and startup settings per deployment:
+//     --frames-in-flight <1-4>
+//     --present-mode <fifo|fifo_relaxed|mailbox|immediate>
+//     --low-latency
+//     --pipeline-cache <path>
+//     --bindless
+//     --model <path.gltf|path.glb>
+void parse_arguments(
+    int argc, char** argv, Renderer::CreateDetails& details, const char*& model_path)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : "";
+        if (std::strcmp(arg, "--frames-in-flight") == 0)
+        {
+            details.frames_in_flight = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            i++;
+        }
+        else if (std::strcmp(arg, "--present-mode") == 0)
+        {
+            if (std::strcmp(value, "fifo") == 0)
+                details.present_mode = VK_PRESENT_MODE_FIFO_KHR;
+            else if (std::strcmp(value, "fifo_relaxed") == 0)
+                details.present_mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+            else if (std::strcmp(value, "mailbox") == 0)
+                details.present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+            else if (std::strcmp(value, "immediate") == 0)
+                details.present_mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+            else
+                spdlog::warn("Unknown present mode '{}'", value);
+            i++;
+        }
+        else if (std::strcmp(arg, "--low-latency") == 0)
+        {
+            details.low_latency = true;
+        }
+        else if (std::strcmp(arg, "--pipeline-cache") == 0)
+        {
+            details.pipeline_cache_path = value;
+            i++;
+        }
+        else if (std::strcmp(arg, "--bindless") == 0)
+        {
+            details.bindless = true;
+        }
+        else if (std::strcmp(arg, "--model") == 0)
+        {
+            model_path = value;
+            i++;
+        }
+        else
+        {
+            spdlog::warn("Unknown argument '{}'", arg);
+        }
+    }
+}
+
+void load_model(const char* path, JobSystem& job_system)
+{
+    int64_t start_ns = Profiler::now_ns();
+    try
+    {
+        GltfLoader loader{ GltfLoader::CreateDetails{ .job_system = &job_system } };
+        Model model = loader.load(path);
+        size_t primitive_count = 0;
+        size_t vertex_count = 0;
+        for (auto const& mesh : model.meshes)
+            for (auto const& primitive : mesh.primitives)
+            {
+                primitive_count++;
+                vertex_count += primitive.vertex_count;
+            }
+        spdlog::info("Loaded {} in {:.1f} ms: {} meshes, {} primitives, {} vertices, {} materials, "
+                     "{} nodes, {} animations",
+            path,
+            static_cast<double>(Profiler::now_ns() - start_ns) / 1e6,
+            model.meshes.size(),
+            primitive_count,
+            vertex_count,
+            model.materials.size(),
+            model.nodes.size(),
+            model.animations.size());
+    }
+    catch (std::exception const& error)
+    {
+        spdlog::error("{}", error.what());
+    }
+}
+
+int main(int argc, char** argv)
 {
     StaticInit static_init{};
+    JobSystem job_system{ JobSystem::CreateDetails{} };
     Window main_win{ Window::CreateDetails{
         .window_title = "TestWindow", .size = math::vec2i{ 800, 600 }, .position = math::vec2i{ 100, 100 } } };
 
-    Renderer renderer{ Renderer::CreateDetails{
-        .app_name = "Test", .enable_validation = true, .window = &main_win } };
+    Renderer::CreateDetails renderer_details{ .app_name = "Test",
+        .enable_validation = true,
+        .window = &main_win,
+        .job_system = &job_system,
+        .pipeline_cache_path = "pipeline_cache.bin" };
+    const char* model_path = nullptr;
+    parse_arguments(argc, argv, renderer_details, model_path);
+    Renderer renderer{ renderer_details };
+    if (model_path != nullptr) load_model(model_path, job_system);
 
     while (!main_win.should_close())
     {
+        renderer.wait_for_frame();
         Window::poll_events();
 
         if (main_win.get_key(Input::KeyCode::ESCAPE))
         {
             main_win.set_close();
         }
+        if (main_win.get_key_down(Input::KeyCode::F12))
+        {
+            if (Profiler::write_chrome_trace("orange_trace.json"))
+                spdlog::info("Wrote profiler trace to orange_trace.json");
+        }
+        if (main_win.get_key_down(Input::KeyCode::F11))
+        {
+            auto pacing = renderer.pacing_report();
+            spdlog::info("Frame pacing over {} frames: avg {:.2f} ms, median {:.2f} ms, p99 {:.2f} "
+                         "ms, max {:.2f} ms, jitter {:.2f} ms, {} hitches",
+                pacing.frame_count,
+                pacing.average_ms,
+                pacing.median_ms,
+                pacing.p99_ms,
+                pacing.max_ms,
+                pacing.jitter_ms,
+                pacing.hitch_count);
+            spdlog::info("Waiting: fence {:.2f} ms, acquire {:.2f} ms, {:.0f}% of the frame",
+                pacing.average_fence_wait_ms,
+                pacing.average_acquire_wait_ms,
+                pacing.wait_fraction * 100.0);
+        }
+        if (main_win.get_key_down(Input::KeyCode::F10)) renderer.memory().log_report();
         renderer.update();
         renderer.draw();
 
         main_win.next_frame();
+        ORANGE_PROFILE_FRAME();
     }
 }
@@ -0,0 +1,194 @@
+#include "matrix.h"
+
+#include <cassert>
+
+#include "simd.h"
+
+namespace math
+{
+namespace
+{
+struct columns
+{
+    simd::f32x4 c[4];
+};
+columns load_columns(matrix4 const& value) noexcept
+{
+    return columns{ { simd::load4(&value.data[0]),
+        simd::load4(&value.data[4]),
+        simd::load4(&value.data[8]),
+        simd::load4(&value.data[12]) } };
+}
+matrix4 store_columns(simd::f32x4 c0, simd::f32x4 c1, simd::f32x4 c2, simd::f32x4 c3) noexcept
+{
+    matrix4 out;
+    simd::store4(&out.data[0], c0);
+    simd::store4(&out.data[4], c1);
+    simd::store4(&out.data[8], c2);
+    simd::store4(&out.data[12], c3);
+    return out;
+}
+
+// m * v, as a linear combination of the columns
+simd::f32x4 combine(columns const& m, simd::f32x4 v) noexcept
+{
+    simd::f32x4 out = simd::mul(m.c[0], simd::splat_lane<0>(v));
+    out = simd::madd(m.c[1], simd::splat_lane<1>(v), out);
+    out = simd::madd(m.c[2], simd::splat_lane<2>(v), out);
+    return simd::madd(m.c[3], simd::splat_lane<3>(v), out);
+}
+
+// Helpers for the 2x2 block inverse, each register holds a row major 2x2 matrix
+// 2x2 matrix multiply a * b
+simd::f32x4 mat2_mul(simd::f32x4 a, simd::f32x4 b) noexcept
+{
+    return simd::add(simd::mul(a, simd::shuffle<0, 3, 0, 3>(b, b)),
+        simd::mul(simd::shuffle<1, 0, 3, 2>(a, a), simd::shuffle<2, 1, 2, 1>(b, b)));
+}
+// 2x2 matrix adjugate multiply adj(a) * b
+simd::f32x4 mat2_adj_mul(simd::f32x4 a, simd::f32x4 b) noexcept
+{
+    return simd::sub(simd::mul(simd::shuffle<3, 3, 0, 0>(a, a), b),
+        simd::mul(simd::shuffle<1, 1, 2, 2>(a, a), simd::shuffle<2, 3, 0, 1>(b, b)));
+}
+// 2x2 matrix multiply adjugate a * adj(b)
+simd::f32x4 mat2_mul_adj(simd::f32x4 a, simd::f32x4 b) noexcept
+{
+    return simd::sub(simd::mul(a, simd::shuffle<3, 0, 3, 0>(b, b)),
+        simd::mul(simd::shuffle<1, 0, 3, 2>(a, a), simd::shuffle<2, 1, 2, 1>(b, b)));
+}
+
+simd::f32x4 cross(simd::f32x4 a, simd::f32x4 b) noexcept
+{
+    return simd::sub(simd::mul(simd::shuffle<1, 2, 0, 3>(a, a), simd::shuffle<2, 0, 1, 3>(b, b)),
+        simd::mul(simd::shuffle<2, 0, 1, 3>(a, a), simd::shuffle<1, 2, 0, 3>(b, b)));
+}
+} // namespace
+
+namespace detail
+{
+matrix4 multiply(matrix4 const& left, matrix4 const& right) noexcept
+{
+    columns l = load_columns(left);
+    return store_columns(combine(l, simd::load4(&right.data[0])),
+        combine(l, simd::load4(&right.data[4])),
+        combine(l, simd::load4(&right.data[8])),
+        combine(l, simd::load4(&right.data[12])));
+}
+
+vec4 multiply(matrix4 const& left, vec4 const& right) noexcept
+{
+    simd::f32x4 out = combine(load_columns(left), simd::set(right.x, right.y, right.z, right.w));
+    float lanes[4];
+    simd::store4(lanes, out);
+    return vec4{ lanes[0], lanes[1], lanes[2], lanes[3] };
+}
+
+matrix4 transpose(matrix4 const& value) noexcept
+{
+    columns m = load_columns(value);
+    simd::transpose(m.c[0], m.c[1], m.c[2], m.c[3]);
+    return store_columns(m.c[0], m.c[1], m.c[2], m.c[3]);
+}
+
+// Block wise inverse, splitting the matrix into four 2x2 matrices A B / C D. The columns are treated
+// as rows, which computes the inverse of the transpose, and its rows are the columns of the inverse.
+matrix4 inverse(matrix4 const& value) noexcept
+{
+    columns m = load_columns(value);
+    simd::f32x4 a = simd::shuffle<0, 1, 0, 1>(m.c[0], m.c[1]);
+    simd::f32x4 b = simd::shuffle<2, 3, 2, 3>(m.c[0], m.c[1]);
+    simd::f32x4 c = simd::shuffle<0, 1, 0, 1>(m.c[2], m.c[3]);
+    simd::f32x4 d = simd::shuffle<2, 3, 2, 3>(m.c[2], m.c[3]);
+
+    // determinants of the blocks as (|A|, |B|, |C|, |D|)
+    simd::f32x4 det_sub = simd::sub(
+        simd::mul(simd::shuffle<0, 2, 0, 2>(m.c[0], m.c[2]), simd::shuffle<1, 3, 1, 3>(m.c[1], m.c[3])),
+        simd::mul(simd::shuffle<1, 3, 1, 3>(m.c[0], m.c[2]), simd::shuffle<0, 2, 0, 2>(m.c[1], m.c[3])));
+    simd::f32x4 det_a = simd::splat_lane<0>(det_sub);
+    simd::f32x4 det_b = simd::splat_lane<1>(det_sub);
+    simd::f32x4 det_c = simd::splat_lane<2>(det_sub);
+    simd::f32x4 det_d = simd::splat_lane<3>(det_sub);
+
+    simd::f32x4 d_c = mat2_adj_mul(d, c);
+    simd::f32x4 a_b = mat2_adj_mul(a, b);
+    simd::f32x4 x = simd::sub(simd::mul(det_d, a), mat2_mul(b, d_c));
+    simd::f32x4 w = simd::sub(simd::mul(det_a, d), mat2_mul(c, a_b));
+    simd::f32x4 y = simd::sub(simd::mul(det_b, c), mat2_mul_adj(d, a_b));
+    simd::f32x4 z = simd::sub(simd::mul(det_c, b), mat2_mul_adj(a, d_c));
+
+    // |M| = |A|*|D| + |B|*|C| - trace(adj(A)B * adj(D)C)
+    simd::f32x4 det_m = simd::add(simd::mul(det_a, det_d), simd::mul(det_b, det_c));
+    simd::f32x4 trace = simd::horizontal_add(simd::mul(a_b, simd::shuffle<0, 2, 1, 3>(d_c, d_c)));
+    det_m = simd::sub(det_m, trace);
+
+    simd::f32x4 reciprocal_det = simd::div(simd::set(1.f, -1.f, -1.f, 1.f), det_m);
+    x = simd::mul(x, reciprocal_det);
+    y = simd::mul(y, reciprocal_det);
+    z = simd::mul(z, reciprocal_det);
+    w = simd::mul(w, reciprocal_det);
+
+    // apply the adjugate and reassemble the blocks
+    return store_columns(simd::shuffle<3, 1, 3, 1>(x, y),
+        simd::shuffle<2, 0, 2, 0>(x, y),
+        simd::shuffle<3, 1, 3, 1>(z, w),
+        simd::shuffle<2, 0, 2, 0>(z, w));
+}
+
+// The inverse of the upper 3x3 has the cross products of its columns as rows
+matrix4 affine_inverse(matrix4 const& value) noexcept
+{
+    columns m = load_columns(value);
+    // the w lanes of the upper columns are zero, so the crosses have w == 0 as well
+    simd::f32x4 r0 = cross(m.c[1], m.c[2]);
+    simd::f32x4 r1 = cross(m.c[2], m.c[0]);
+    simd::f32x4 r2 = cross(m.c[0], m.c[1]);
+    simd::f32x4 reciprocal_det = simd::div(simd::splat(1.f), simd::horizontal_add(simd::mul(m.c[0], r0)));
+    r0 = simd::mul(r0, reciprocal_det);
+    r1 = simd::mul(r1, reciprocal_det);
+    r2 = simd::mul(r2, reciprocal_det);
+    simd::f32x4 r3 = simd::splat(0.f);
+    simd::transpose(r0, r1, r2, r3);
+
+    simd::f32x4 t = m.c[3];
+    simd::f32x4 translation = simd::mul(r0, simd::splat_lane<0>(t));
+    translation = simd::madd(r1, simd::splat_lane<1>(t), translation);
+    translation = simd::madd(r2, simd::splat_lane<2>(t), translation);
+    translation = simd::sub(simd::set(0.f, 0.f, 0.f, 1.f), translation);
+    return store_columns(r0, r1, r2, translation);
+}
+} // namespace detail
+
+void transform_points(matrix4 const& transform, std::span<vec3 const> in, std::span<vec3> out) noexcept
+{
+    assert(in.size() == out.size());
+    columns m = load_columns(transform);
+    for (size_t i = 0; i < in.size(); i++)
+    {
+        vec3 const& p = in[i];
+        simd::f32x4 result = simd::madd(m.c[0], simd::splat(p.x), m.c[3]);
+        result = simd::madd(m.c[1], simd::splat(p.y), result);
+        result = simd::madd(m.c[2], simd::splat(p.z), result);
+        float lanes[4];
+        simd::store4(lanes, result);
+        out[i] = vec3{ lanes[0], lanes[1], lanes[2] };
+    }
+}
+
+void transform_vectors(matrix4 const& transform, std::span<vec3 const> in, std::span<vec3> out) noexcept
+{
+    assert(in.size() == out.size());
+    columns m = load_columns(transform);
+    for (size_t i = 0; i < in.size(); i++)
+    {
+        vec3 const& p = in[i];
+        simd::f32x4 result = simd::mul(m.c[0], simd::splat(p.x));
+        result = simd::madd(m.c[1], simd::splat(p.y), result);
+        result = simd::madd(m.c[2], simd::splat(p.z), result);
+        float lanes[4];
+        simd::store4(lanes, result);
+        out[i] = vec3{ lanes[0], lanes[1], lanes[2] };
+    }
+}
+
+} // namespace math
@@ -2,17 +2,305 @@
 
 #include "cstdint"
 
+#include <cmath>
+#include <span>
+#include <type_traits>
+
 #include "vector.h"
 
 namespace math
 {
 
+// Column major, element (column, row) lives at data[column * Dimension + row], matching GLSL
 template <typename T, uint32_t Dimension> struct matrix
 {
     T data[Dimension * Dimension];
+
+    static constexpr matrix identity() noexcept
+    {
+        matrix out{};
+        for (uint32_t i = 0; i < Dimension; i++)
+            out(i, i) = T{ 1 };
+        return out;
+    }
+
+    constexpr T const& operator()(uint32_t column, uint32_t row) const noexcept
+    {
+        return data[column * Dimension + row];
+    }
+    constexpr T& operator()(uint32_t column, uint32_t row) noexcept
+    {
+        return data[column * Dimension + row];
+    }
+
+    constexpr vec<T, Dimension> column(uint32_t index) const noexcept
+    {
+        vec<T, Dimension> out;
+        for (uint32_t i = 0; i < Dimension; i++)
+            out[i] = (*this)(index, i);
+        return out;
+    }
+    constexpr void set_column(uint32_t index, vec<T, Dimension> const& value) noexcept
+    {
+        for (uint32_t i = 0; i < Dimension; i++)
+            (*this)(index, i) = value[i];
+    }
+    constexpr vec<T, Dimension> row(uint32_t index) const noexcept
+    {
+        vec<T, Dimension> out;
+        for (uint32_t i = 0; i < Dimension; i++)
+            out[i] = (*this)(i, index);
+        return out;
+    }
+
+    constexpr bool operator==(matrix<T, Dimension> const& right) const = default;
 };
 
 using matrix3 = matrix<float, 3>;
 using matrix4 = matrix<float, 4>;
 
-}
\ No newline at end of file
+namespace detail
+{
+// matrix4 kernels built on math/simd.h, implemented in matrix.cpp
+matrix4 multiply(matrix4 const& left, matrix4 const& right) noexcept;
+vec4 multiply(matrix4 const& left, vec4 const& right) noexcept;
+matrix4 transpose(matrix4 const& value) noexcept;
+matrix4 inverse(matrix4 const& value) noexcept;
+matrix4 affine_inverse(matrix4 const& value) noexcept;
+
+template <typename T, uint32_t D>
+inline constexpr bool simd_matrix = simd::native && std::is_same_v<T, float> && D == 4;
+} // namespace detail
+
+// matrix * matrix -> matrix
+template <arithmetic T, uint32_t D>
+constexpr auto operator*(matrix<T, D> const& left, matrix<T, D> const& right) noexcept
+{
+    if constexpr (detail::simd_matrix<T, D>)
+    {
+        if (!std::is_constant_evaluated()) return detail::multiply(left, right);
+    }
+    matrix<T, D> out{};
+    for (uint32_t c = 0; c < D; c++)
+        for (uint32_t r = 0; r < D; r++)
+        {
+            T sum{};
+            for (uint32_t k = 0; k < D; k++)
+                sum += left(k, r) * right(c, k);
+            out(c, r) = sum;
+        }
+    return out;
+}
+// matrix *= matrix -> left
+template <arithmetic T, uint32_t D>
+constexpr auto operator*=(matrix<T, D>& left, matrix<T, D> const& right) noexcept
+{
+    left = left * right;
+    return left;
+}
+
+// matrix * vec -> vec
+template <arithmetic T, uint32_t D, size_t L>
+    requires(D == L)
+constexpr auto operator*(matrix<T, D> const& left, vec<T, L> const& right) noexcept
+{
+    if constexpr (detail::simd_matrix<T, D>)
+    {
+        if (!std::is_constant_evaluated()) return detail::multiply(left, right);
+    }
+    vec<T, L> out{};
+    for (uint32_t r = 0; r < D; r++)
+    {
+        T sum{};
+        for (uint32_t k = 0; k < D; k++)
+            sum += left(k, r) * right[k];
+        out[r] = sum;
+    }
+    return out;
+}
+
+// transpose(matrix) -> matrix
+template <arithmetic T, uint32_t D> constexpr auto transpose(matrix<T, D> const& value) noexcept
+{
+    if constexpr (detail::simd_matrix<T, D>)
+    {
+        if (!std::is_constant_evaluated()) return detail::transpose(value);
+    }
+    matrix<T, D> out{};
+    for (uint32_t c = 0; c < D; c++)
+        for (uint32_t r = 0; r < D; r++)
+            out(r, c) = value(c, r);
+    return out;
+}
+
+// determinant(matrix) -> scalar, through gaussian elimination with partial pivoting
+template <std::floating_point F, uint32_t D> constexpr auto determinant(matrix<F, D> const& value) noexcept
+{
+    matrix<F, D> m = value;
+    F det{ 1 };
+    for (uint32_t c = 0; c < D; c++)
+    {
+        uint32_t pivot = c;
+        for (uint32_t r = c + 1; r < D; r++)
+            if ((m(c, r) < 0 ? -m(c, r) : m(c, r)) > (m(c, pivot) < 0 ? -m(c, pivot) : m(c, pivot)))
+                pivot = r;
+        if (m(c, pivot) == F{ 0 }) return F{ 0 };
+        if (pivot != c)
+        {
+            for (uint32_t k = 0; k < D; k++)
+            {
+                F temp = m(k, c);
+                m(k, c) = m(k, pivot);
+                m(k, pivot) = temp;
+            }
+            det = -det;
+        }
+        det *= m(c, c);
+        for (uint32_t r = c + 1; r < D; r++)
+        {
+            F factor = m(c, r) / m(c, c);
+            for (uint32_t k = c; k < D; k++)
+                m(k, r) -= factor * m(k, c);
+        }
+    }
+    return det;
+}
+
+// inverse(matrix) -> matrix, the result is undefined for singular matrices
+template <std::floating_point F, uint32_t D> constexpr auto inverse(matrix<F, D> const& value) noexcept
+{
+    if constexpr (detail::simd_matrix<F, D>)
+    {
+        if (!std::is_constant_evaluated()) return detail::inverse(value);
+    }
+    // Gauss-Jordan elimination with partial pivoting, operating on rows
+    matrix<F, D> m = value;
+    matrix<F, D> out = matrix<F, D>::identity();
+    for (uint32_t c = 0; c < D; c++)
+    {
+        uint32_t pivot = c;
+        for (uint32_t r = c + 1; r < D; r++)
+            if ((m(c, r) < 0 ? -m(c, r) : m(c, r)) > (m(c, pivot) < 0 ? -m(c, pivot) : m(c, pivot)))
+                pivot = r;
+        if (pivot != c)
+        {
+            for (uint32_t k = 0; k < D; k++)
+            {
+                F temp = m(k, c);
+                m(k, c) = m(k, pivot);
+                m(k, pivot) = temp;
+                temp = out(k, c);
+                out(k, c) = out(k, pivot);
+                out(k, pivot) = temp;
+            }
+        }
+        F inverse_pivot = F{ 1 } / m(c, c);
+        for (uint32_t k = 0; k < D; k++)
+        {
+            m(k, c) *= inverse_pivot;
+            out(k, c) *= inverse_pivot;
+        }
+        for (uint32_t r = 0; r < D; r++)
+        {
+            if (r == c) continue;
+            F factor = m(c, r);
+            for (uint32_t k = 0; k < D; k++)
+            {
+                m(k, r) -= factor * m(k, c);
+                out(k, r) -= factor * out(k, c);
+            }
+        }
+    }
+    return out;
+}
+
+// affine_inverse(matrix4) -> matrix4, cheaper inverse for matrices whose last row is (0, 0, 0, 1)
+template <std::floating_point F> constexpr auto affine_inverse(matrix<F, 4> const& value) noexcept
+{
+    if constexpr (detail::simd_matrix<F, 4>)
+    {
+        if (!std::is_constant_evaluated()) return detail::affine_inverse(value);
+    }
+    matrix<F, 3> upper{};
+    for (uint32_t c = 0; c < 3; c++)
+        for (uint32_t r = 0; r < 3; r++)
+            upper(c, r) = value(c, r);
+    matrix<F, 3> inverse_upper = inverse(upper);
+    vec<F, 3> translation = inverse_upper * vec<F, 3>{ value(3, 0), value(3, 1), value(3, 2) };
+    matrix<F, 4> out{};
+    for (uint32_t c = 0; c < 3; c++)
+        for (uint32_t r = 0; r < 3; r++)
+            out(c, r) = inverse_upper(c, r);
+    out.set_column(3, vec<F, 4>{ -translation.x, -translation.y, -translation.z, F{ 1 } });
+    return out;
+}
+
+// translation(vec3) -> matrix4
+template <arithmetic T> constexpr auto translation(vec<T, 3> const& offset) noexcept
+{
+    auto out = matrix<T, 4>::identity();
+    out.set_column(3, vec<T, 4>{ offset.x, offset.y, offset.z, T{ 1 } });
+    return out;
+}
+
+// scaling(vec3) -> matrix4
+template <arithmetic T> constexpr auto scaling(vec<T, 3> const& scale) noexcept
+{
+    auto out = matrix<T, 4>::identity();
+    out(0, 0) = scale.x;
+    out(1, 1) = scale.y;
+    out(2, 2) = scale.z;
+    return out;
+}
+
+// Right handed view matrix looking from `eye` towards `center`
+template <std::floating_point F>
+auto look_at(vec<F, 3> const& eye, vec<F, 3> const& center, vec<F, 3> const& up) noexcept
+{
+    auto forward = normalize(center - eye);
+    auto side = normalize(cross(forward, up));
+    auto new_up = cross(side, forward);
+    auto out = matrix<F, 4>::identity();
+    out.set_column(0, vec<F, 4>{ side.x, new_up.x, -forward.x, F{ 0 } });
+    out.set_column(1, vec<F, 4>{ side.y, new_up.y, -forward.y, F{ 0 } });
+    out.set_column(2, vec<F, 4>{ side.z, new_up.z, -forward.z, F{ 0 } });
+    out.set_column(3, vec<F, 4>{ -dot(side, eye), -dot(new_up, eye), dot(forward, eye), F{ 1 } });
+    return out;
+}
+
+// Right handed perspective projection for Vulkan clip space with reversed Z: the near plane maps
+// to depth 1 and the far plane to depth 0, which spreads float precision evenly over the depth
+// range. Use a GREATER depth compare and clear depth to 0. Y is flipped to match Vulkan's
+// downward pointing clip space. `fov_y` is in radians.
+template <std::floating_point F> auto perspective(F fov_y, F aspect, F z_near, F z_far) noexcept
+{
+    F focal_length = F{ 1 } / std::tan(fov_y / F{ 2 });
+    matrix<F, 4> out{};
+    out(0, 0) = focal_length / aspect;
+    out(1, 1) = -focal_length;
+    out(2, 2) = z_near / (z_far - z_near);
+    out(2, 3) = F{ -1 };
+    out(3, 2) = (z_far * z_near) / (z_far - z_near);
+    return out;
+}
+
+// Reversed Z perspective projection with the far plane at infinity, see perspective()
+template <std::floating_point F> auto perspective_infinite(F fov_y, F aspect, F z_near) noexcept
+{
+    F focal_length = F{ 1 } / std::tan(fov_y / F{ 2 });
+    matrix<F, 4> out{};
+    out(0, 0) = focal_length / aspect;
+    out(1, 1) = -focal_length;
+    out(2, 3) = F{ -1 };
+    out(3, 2) = z_near;
+    return out;
+}
+
+// out[i] = (transform * vec4(in[i], 1)).xyz, no perspective divide. `in` and `out` must be the same
+// size and may be the same span.
+void transform_points(matrix4 const& transform, std::span<vec3 const> in, std::span<vec3> out) noexcept;
+
+// out[i] = (transform * vec4(in[i], 0)).xyz, for directions which ignore the translation
+void transform_vectors(matrix4 const& transform, std::span<vec3 const> in, std::span<vec3> out) noexcept;
+
+} // namespace math
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cmath>
+#include <concepts>
+
+#include "matrix.h"
+#include "vector.h"
+
+namespace math
+{
+
+// Rotation quaternion, (x, y, z) is the imaginary part and w the real part, matching glTF's layout
+template <std::floating_point F> struct quaternion
+{
+    F x, y, z, w;
+
+    static constexpr quaternion identity() noexcept { return quaternion{ F{ 0 }, F{ 0 }, F{ 0 }, F{ 1 } }; }
+
+    constexpr vec<F, 3> imaginary() const noexcept { return vec<F, 3>{ x, y, z }; }
+
+    constexpr bool operator==(quaternion<F> const& right) const = default;
+};
+
+using quat = quaternion<float>;
+
+// from_axis_angle(axis: normalized vec3, angle: radians) -> quat
+template <std::floating_point F> auto from_axis_angle(vec<F, 3> const& axis, F angle) noexcept
+{
+    F half_sin = std::sin(angle / F{ 2 });
+    return quaternion<F>{ axis.x * half_sin, axis.y * half_sin, axis.z * half_sin, std::cos(angle / F{ 2 }) };
+}
+
+// quat * quat -> quat, applies `right` first and then `left`
+template <std::floating_point F>
+constexpr auto operator*(quaternion<F> const& left, quaternion<F> const& right) noexcept
+{
+    return quaternion<F>{ left.w * right.x + left.x * right.w + left.y * right.z - left.z * right.y,
+        left.w * right.y - left.x * right.z + left.y * right.w + left.z * right.x,
+        left.w * right.z + left.x * right.y - left.y * right.x + left.z * right.w,
+        left.w * right.w - left.x * right.x - left.y * right.y - left.z * right.z };
+}
+
+// quat * vec3 -> vec3, rotates the vector
+template <std::floating_point F>
+constexpr auto operator*(quaternion<F> const& left, vec<F, 3> const& right) noexcept
+{
+    vec<F, 3> imaginary = left.imaginary();
+    vec<F, 3> t = F{ 2 } * cross(imaginary, right);
+    return right + left.w * t + cross(imaginary, t);
+}
+
+// -quat -> quat, represents the same rotation
+template <std::floating_point F> constexpr auto operator-(quaternion<F> const& right) noexcept
+{
+    return quaternion<F>{ -right.x, -right.y, -right.z, -right.w };
+}
+
+// dot(quat, quat) -> scalar
+template <std::floating_point F> constexpr auto dot(quaternion<F> const& left, quaternion<F> const& right) noexcept
+{
+    return left.x * right.x + left.y * right.y + left.z * right.z + left.w * right.w;
+}
+
+// conjugate(quat) -> quat, the inverse rotation of a unit quaternion
+template <std::floating_point F> constexpr auto conjugate(quaternion<F> const& value) noexcept
+{
+    return quaternion<F>{ -value.x, -value.y, -value.z, value.w };
+}
+
+// length(quat) -> scalar
+template <std::floating_point F> auto length(quaternion<F> const& value) noexcept
+{
+    return std::sqrt(dot(value, value));
+}
+
+// normalize(quat) -> quat, zero length quaternions produce NaN
+template <std::floating_point F> auto normalize(quaternion<F> const& value) noexcept
+{
+    F inverse_length = F{ 1 } / length(value);
+    return quaternion<F>{ value.x * inverse_length, value.y * inverse_length, value.z * inverse_length,
+        value.w * inverse_length };
+}
+
+// nlerp(quat, quat, t) -> quat, normalized linear interpolation along the shortest path. Cheaper than
+// slerp but doesn't move at a constant angular velocity.
+template <std::floating_point F>
+auto nlerp(quaternion<F> const& lower, quaternion<F> const& upper, F interp) noexcept
+{
+    F sign = dot(lower, upper) < F{ 0 } ? F{ -1 } : F{ 1 };
+    F lower_weight = F{ 1 } - interp;
+    F upper_weight = interp * sign;
+    return normalize(quaternion<F>{ lower.x * lower_weight + upper.x * upper_weight,
+        lower.y * lower_weight + upper.y * upper_weight,
+        lower.z * lower_weight + upper.z * upper_weight,
+        lower.w * lower_weight + upper.w * upper_weight });
+}
+
+// slerp(quat, quat, t) -> quat, spherical linear interpolation along the shortest path
+template <std::floating_point F>
+auto slerp(quaternion<F> const& lower, quaternion<F> const& upper, F interp) noexcept
+{
+    F cos_theta = dot(lower, upper);
+    F sign = F{ 1 };
+    if (cos_theta < F{ 0 })
+    {
+        cos_theta = -cos_theta;
+        sign = F{ -1 };
+    }
+    // sin(theta) approaches zero for nearly identical rotations, where nlerp is indistinguishable
+    if (cos_theta > static_cast<F>(0.9995)) return nlerp(lower, upper, interp);
+
+    F theta = std::acos(cos_theta);
+    F inverse_sin = F{ 1 } / std::sin(theta);
+    F lower_weight = std::sin((F{ 1 } - interp) * theta) * inverse_sin;
+    F upper_weight = std::sin(interp * theta) * inverse_sin * sign;
+    return quaternion<F>{ lower.x * lower_weight + upper.x * upper_weight,
+        lower.y * lower_weight + upper.y * upper_weight,
+        lower.z * lower_weight + upper.z * upper_weight,
+        lower.w * lower_weight + upper.w * upper_weight };
+}
+
+// to_matrix(quat) -> matrix4, expects a unit quaternion
+template <std::floating_point F> constexpr auto to_matrix(quaternion<F> const& value) noexcept
+{
+    F xx = value.x * value.x, yy = value.y * value.y, zz = value.z * value.z;
+    F xy = value.x * value.y, xz = value.x * value.z, yz = value.y * value.z;
+    F wx = value.w * value.x, wy = value.w * value.y, wz = value.w * value.z;
+    matrix<F, 4> out{};
+    out.set_column(0, vec<F, 4>{ F{ 1 } - F{ 2 } * (yy + zz), F{ 2 } * (xy + wz), F{ 2 } * (xz - wy), F{ 0 } });
+    out.set_column(1, vec<F, 4>{ F{ 2 } * (xy - wz), F{ 1 } - F{ 2 } * (xx + zz), F{ 2 } * (yz + wx), F{ 0 } });
+    out.set_column(2, vec<F, 4>{ F{ 2 } * (xz + wy), F{ 2 } * (yz - wx), F{ 1 } - F{ 2 } * (xx + yy), F{ 0 } });
+    out.set_column(3, vec<F, 4>{ F{ 0 }, F{ 0 }, F{ 0 }, F{ 1 } });
+    return out;
+}
+
+} // namespace math
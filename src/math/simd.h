@@ -0,0 +1,487 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Thin abstraction over 4 wide SIMD registers. SSE2 is the baseline on x86-64, NEON on ARM, and a
+// plain array implementation is used everywhere else (or when ORANGE_MATH_NO_SIMD is defined).
+// Wider instruction sets (AVX, FMA) are picked up by the compiler through the VEX encoding of
+// these same intrinsics when the target is built with them enabled.
+#if !defined(ORANGE_MATH_NO_SIMD) &&                                                               \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ORANGE_MATH_SIMD_SSE 1
+#include <emmintrin.h>
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define ORANGE_MATH_SIMD_SSE41 1
+#include <smmintrin.h>
+#endif
+#if defined(__FMA__)
+#include <immintrin.h>
+#endif
+#elif !defined(ORANGE_MATH_NO_SIMD) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define ORANGE_MATH_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define ORANGE_MATH_SIMD_SCALAR 1
+#endif
+
+namespace math::simd
+{
+
+#if defined(ORANGE_MATH_SIMD_SSE)
+using f32x4 = __m128;
+using i32x4 = __m128i;
+inline constexpr bool native = true;
+#elif defined(ORANGE_MATH_SIMD_NEON)
+using f32x4 = float32x4_t;
+using i32x4 = int32x4_t;
+inline constexpr bool native = true;
+#else
+struct f32x4
+{
+    float v[4];
+};
+struct i32x4
+{
+    int32_t v[4];
+};
+inline constexpr bool native = false;
+#endif
+
+// f32x4
+
+inline f32x4 load4(float const* ptr) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_loadu_ps(ptr);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vld1q_f32(ptr);
+#else
+    return f32x4{ { ptr[0], ptr[1], ptr[2], ptr[3] } };
+#endif
+}
+inline f32x4 set(float x, float y, float z, float w) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_setr_ps(x, y, z, w);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    float32x4_t out = { x, y, z, w };
+    return out;
+#else
+    return f32x4{ { x, y, z, w } };
+#endif
+}
+inline f32x4 splat(float value) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_set1_ps(value);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vdupq_n_f32(value);
+#else
+    return f32x4{ { value, value, value, value } };
+#endif
+}
+inline void store4(float* ptr, f32x4 value) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    _mm_storeu_ps(ptr, value);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    vst1q_f32(ptr, value);
+#else
+    for (int i = 0; i < 4; i++)
+        ptr[i] = value.v[i];
+#endif
+}
+// Writes only the first 3 lanes
+inline void store3(float* ptr, f32x4 value) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    _mm_store_ss(ptr, value);
+    _mm_store_ss(ptr + 1, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 1, 1, 1)));
+    _mm_store_ss(ptr + 2, _mm_movehl_ps(value, value));
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    vst1_f32(ptr, vget_low_f32(value));
+    vst1q_lane_f32(ptr + 2, value, 2);
+#else
+    for (int i = 0; i < 3; i++)
+        ptr[i] = value.v[i];
+#endif
+}
+template <int Lane> inline float get_lane(f32x4 value) noexcept
+{
+    static_assert(Lane >= 0 && Lane < 4);
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_cvtss_f32(_mm_shuffle_ps(value, value, _MM_SHUFFLE(Lane, Lane, Lane, Lane)));
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vgetq_lane_f32(value, Lane);
+#else
+    return value.v[Lane];
+#endif
+}
+
+#if defined(ORANGE_MATH_SIMD_SCALAR)
+#define ORANGE_SIMD_SCALAR_OP(a, b, expr)                                                          \
+    f32x4 out;                                                                                     \
+    for (int i = 0; i < 4; i++)                                                                    \
+        out.v[i] = expr;                                                                           \
+    return out;
+#endif
+
+inline f32x4 add(f32x4 a, f32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_add_ps(a, b);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vaddq_f32(a, b);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] + b.v[i])
+#endif
+}
+inline f32x4 sub(f32x4 a, f32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_sub_ps(a, b);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vsubq_f32(a, b);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] - b.v[i])
+#endif
+}
+inline f32x4 mul(f32x4 a, f32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_mul_ps(a, b);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vmulq_f32(a, b);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] * b.v[i])
+#endif
+}
+inline f32x4 div(f32x4 a, f32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_div_ps(a, b);
+#elif defined(ORANGE_MATH_SIMD_NEON) && defined(__aarch64__)
+    return vdivq_f32(a, b);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    float32x4_t out = { vgetq_lane_f32(a, 0) / vgetq_lane_f32(b, 0),
+        vgetq_lane_f32(a, 1) / vgetq_lane_f32(b, 1),
+        vgetq_lane_f32(a, 2) / vgetq_lane_f32(b, 2),
+        vgetq_lane_f32(a, 3) / vgetq_lane_f32(b, 3) };
+    return out;
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] / b.v[i])
+#endif
+}
+// a * b + c, fused when the target supports it
+inline f32x4 madd(f32x4 a, f32x4 b, f32x4 c) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE) && defined(__FMA__)
+    return _mm_fmadd_ps(a, b, c);
+#elif defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vmlaq_f32(c, a, b);
+#else
+    f32x4 out;
+    for (int i = 0; i < 4; i++)
+        out.v[i] = a.v[i] * b.v[i] + c.v[i];
+    return out;
+#endif
+}
+// Matches `a < b ? a : b` per lane, including which operand wins on NaN
+inline f32x4 min(f32x4 a, f32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_min_ps(a, b);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vbslq_f32(vcltq_f32(a, b), a, b);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+#endif
+}
+// Matches `a > b ? a : b` per lane, including which operand wins on NaN
+inline f32x4 max(f32x4 a, f32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_max_ps(a, b);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vbslq_f32(vcgtq_f32(a, b), a, b);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+#endif
+}
+inline f32x4 neg(f32x4 a) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_xor_ps(a, _mm_set1_ps(-0.f));
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vnegq_f32(a);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, a, -a.v[i])
+#endif
+}
+inline f32x4 abs(f32x4 a) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_andnot_ps(_mm_set1_ps(-0.f), a);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vabsq_f32(a);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, a, a.v[i] < 0.f ? -a.v[i] : a.v[i])
+#endif
+}
+inline f32x4 sqrt(f32x4 a) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_sqrt_ps(a);
+#elif defined(ORANGE_MATH_SIMD_NEON) && defined(__aarch64__)
+    return vsqrtq_f32(a);
+#else
+    float lanes[4];
+    store4(lanes, a);
+    for (int i = 0; i < 4; i++)
+        lanes[i] = std::sqrt(lanes[i]);
+    return load4(lanes);
+#endif
+}
+// Returns `a < b ? if_true : if_false` per lane, a NaN comparison picks `if_false`
+inline f32x4 select_less(f32x4 a, f32x4 b, f32x4 if_true, f32x4 if_false) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    __m128 mask = _mm_cmplt_ps(a, b);
+    return _mm_or_ps(_mm_and_ps(mask, if_true), _mm_andnot_ps(mask, if_false));
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vbslq_f32(vcltq_f32(a, b), if_true, if_false);
+#else
+    f32x4 out;
+    for (int i = 0; i < 4; i++)
+        out.v[i] = a.v[i] < b.v[i] ? if_true.v[i] : if_false.v[i];
+    return out;
+#endif
+}
+
+// Result is { x[A], x[B], y[C], y[D] }, same as _mm_shuffle_ps
+template <int A, int B, int C, int D> inline f32x4 shuffle(f32x4 x, f32x4 y) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_shuffle_ps(x, y, _MM_SHUFFLE(D, C, B, A));
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    float32x4_t out = {
+        vgetq_lane_f32(x, A), vgetq_lane_f32(x, B), vgetq_lane_f32(y, C), vgetq_lane_f32(y, D)
+    };
+    return out;
+#else
+    return f32x4{ { x.v[A], x.v[B], y.v[C], y.v[D] } };
+#endif
+}
+// Broadcasts lane `Lane` into all four lanes
+template <int Lane> inline f32x4 splat_lane(f32x4 value) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_NEON) && defined(__aarch64__)
+    return vdupq_laneq_f32(value, Lane);
+#else
+    return shuffle<Lane, Lane, Lane, Lane>(value, value);
+#endif
+}
+
+// Sum of all four lanes, broadcast into every lane
+inline f32x4 horizontal_add(f32x4 a) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    __m128 shuf = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)); // y x w z
+    __m128 sums = _mm_add_ps(a, shuf);                           // x+y, x+y, z+w, z+w
+    shuf = _mm_shuffle_ps(sums, sums, _MM_SHUFFLE(1, 0, 3, 2));  // z+w, z+w, x+y, x+y
+    return _mm_add_ps(sums, shuf);
+#elif defined(ORANGE_MATH_SIMD_NEON) && defined(__aarch64__)
+    return vdupq_n_f32(vaddvq_f32(a));
+#else
+    float in[4];
+    store4(in, a);
+    return splat((in[0] + in[1]) + (in[2] + in[3]));
+#endif
+}
+inline float dot4(f32x4 a, f32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_cvtss_f32(horizontal_add(_mm_mul_ps(a, b)));
+#elif defined(ORANGE_MATH_SIMD_NEON) && defined(__aarch64__)
+    return vaddvq_f32(vmulq_f32(a, b));
+#else
+    return get_lane<0>(horizontal_add(mul(a, b)));
+#endif
+}
+
+// Transposes the 4x4 matrix whose rows are r0..r3 in place
+inline void transpose(f32x4& r0, f32x4& r1, f32x4& r2, f32x4& r3) noexcept
+{
+    f32x4 t0 = shuffle<0, 1, 0, 1>(r0, r1); // r0.x r0.y r1.x r1.y
+    f32x4 t1 = shuffle<2, 3, 2, 3>(r0, r1); // r0.z r0.w r1.z r1.w
+    f32x4 t2 = shuffle<0, 1, 0, 1>(r2, r3); // r2.x r2.y r3.x r3.y
+    f32x4 t3 = shuffle<2, 3, 2, 3>(r2, r3); // r2.z r2.w r3.z r3.w
+    r0 = shuffle<0, 2, 0, 2>(t0, t2);
+    r1 = shuffle<1, 3, 1, 3>(t0, t2);
+    r2 = shuffle<0, 2, 0, 2>(t1, t3);
+    r3 = shuffle<1, 3, 1, 3>(t1, t3);
+}
+
+#if defined(ORANGE_MATH_SIMD_SCALAR)
+#undef ORANGE_SIMD_SCALAR_OP
+#define ORANGE_SIMD_SCALAR_OP(a, b, expr)                                                          \
+    i32x4 out;                                                                                     \
+    for (int i = 0; i < 4; i++)                                                                    \
+        out.v[i] = expr;                                                                           \
+    return out;
+#endif
+
+// i32x4
+
+inline i32x4 load4(int32_t const* ptr) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    __m128i out;
+    std::memcpy(&out, ptr, sizeof(out));
+    return out;
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vld1q_s32(ptr);
+#else
+    return i32x4{ { ptr[0], ptr[1], ptr[2], ptr[3] } };
+#endif
+}
+inline i32x4 set(int32_t x, int32_t y, int32_t z, int32_t w) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_setr_epi32(x, y, z, w);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    int32x4_t out = { x, y, z, w };
+    return out;
+#else
+    return i32x4{ { x, y, z, w } };
+#endif
+}
+inline i32x4 splat(int32_t value) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_set1_epi32(value);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vdupq_n_s32(value);
+#else
+    return i32x4{ { value, value, value, value } };
+#endif
+}
+inline void store4(int32_t* ptr, i32x4 value) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    std::memcpy(ptr, &value, sizeof(value));
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    vst1q_s32(ptr, value);
+#else
+    for (int i = 0; i < 4; i++)
+        ptr[i] = value.v[i];
+#endif
+}
+inline i32x4 add(i32x4 a, i32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_add_epi32(a, b);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vaddq_s32(a, b);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] + b.v[i])
+#endif
+}
+inline i32x4 sub(i32x4 a, i32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_sub_epi32(a, b);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vsubq_s32(a, b);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] - b.v[i])
+#endif
+}
+inline i32x4 mul(i32x4 a, i32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE41)
+    return _mm_mullo_epi32(a, b);
+#elif defined(ORANGE_MATH_SIMD_SSE)
+    // SSE2 only has a 32x32->64 multiply on the even lanes, do the odd lanes separately
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+        _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vmulq_s32(a, b);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] * b.v[i])
+#endif
+}
+inline i32x4 min(i32x4 a, i32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE41)
+    return _mm_min_epi32(a, b);
+#elif defined(ORANGE_MATH_SIMD_SSE)
+    __m128i mask = _mm_cmplt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vminq_s32(a, b);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+#endif
+}
+inline i32x4 max(i32x4 a, i32x4 b) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE41)
+    return _mm_max_epi32(a, b);
+#elif defined(ORANGE_MATH_SIMD_SSE)
+    __m128i mask = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vmaxq_s32(a, b);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, b, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+#endif
+}
+inline i32x4 neg(i32x4 a) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return _mm_sub_epi32(_mm_setzero_si128(), a);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vnegq_s32(a);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, a, -a.v[i])
+#endif
+}
+inline i32x4 abs(i32x4 a) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    __m128i sign = _mm_srai_epi32(a, 31);
+    return _mm_sub_epi32(_mm_xor_si128(a, sign), sign);
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vabsq_s32(a);
+#else
+    ORANGE_SIMD_SCALAR_OP(a, a, a.v[i] > 0 ? a.v[i] : -a.v[i])
+#endif
+}
+// Returns `a < b ? if_true : if_false` per lane
+inline i32x4 select_less(i32x4 a, i32x4 b, i32x4 if_true, i32x4 if_false) noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    __m128i mask = _mm_cmplt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(mask, if_true), _mm_andnot_si128(mask, if_false));
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return vbslq_s32(vcltq_s32(a, b), if_true, if_false);
+#else
+    i32x4 out;
+    for (int i = 0; i < 4; i++)
+        out.v[i] = a.v[i] < b.v[i] ? if_true.v[i] : if_false.v[i];
+    return out;
+#endif
+}
+
+#if defined(ORANGE_MATH_SIMD_SCALAR)
+#undef ORANGE_SIMD_SCALAR_OP
+#endif
+
+} // namespace math::simd
@@ -0,0 +1,111 @@
+#include "transform.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace math
+{
+
+std::vector<uint32_t> depth_sorted_order(std::span<uint32_t const> parents)
+{
+    // Depths are resolved by walking up to the first node with a known depth, so every node is
+    // visited a constant number of times regardless of the input order.
+    constexpr uint32_t unknown_depth = UINT32_MAX;
+    std::vector<uint32_t> depths(parents.size(), unknown_depth);
+    std::vector<uint32_t> chain;
+    uint32_t max_depth = 0;
+    for (size_t i = 0; i < parents.size(); i++)
+    {
+        uint32_t node = static_cast<uint32_t>(i);
+        while (depths[node] == unknown_depth && parents[node] != no_parent)
+        {
+            chain.push_back(node);
+            node = parents[node];
+            if (node >= parents.size())
+                throw std::runtime_error("Failed to sort hierarchy: node " +
+                                         std::to_string(chain.back()) +
+                                         " has an out of range parent");
+            // a walk longer than the node count has gone around a cycle
+            if (chain.size() > parents.size())
+                throw std::runtime_error(
+                    "Failed to sort hierarchy: the parents of node " + std::to_string(i) +
+                    " form a cycle");
+        }
+        if (depths[node] == unknown_depth) depths[node] = 0;
+        uint32_t depth = depths[node];
+        while (!chain.empty())
+        {
+            depths[chain.back()] = ++depth;
+            chain.pop_back();
+        }
+        max_depth = depths[i] > max_depth ? depths[i] : max_depth;
+    }
+
+    // counting sort, which keeps the relative order of nodes at the same depth
+    std::vector<uint32_t> offsets(parents.empty() ? 0 : max_depth + 2, 0);
+    for (uint32_t depth : depths)
+        offsets[depth + 1]++;
+    for (size_t i = 1; i < offsets.size(); i++)
+        offsets[i] += offsets[i - 1];
+    std::vector<uint32_t> order(parents.size());
+    for (size_t i = 0; i < parents.size(); i++)
+        order[offsets[depths[i]]++] = static_cast<uint32_t>(i);
+    return order;
+}
+
+std::vector<uint32_t> reorder_parents(std::span<uint32_t const> parents, std::span<uint32_t const> order)
+{
+    assert(parents.size() == order.size());
+    std::vector<uint32_t> new_index(order.size());
+    for (size_t i = 0; i < order.size(); i++)
+        new_index[order[i]] = static_cast<uint32_t>(i);
+    std::vector<uint32_t> out(order.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        uint32_t parent = parents[order[i]];
+        out[i] = parent == no_parent ? no_parent : new_index[parent];
+    }
+    return out;
+}
+
+bool is_depth_sorted(std::span<uint32_t const> parents) noexcept
+{
+    for (size_t i = 0; i < parents.size(); i++)
+        if (parents[i] != no_parent && parents[i] >= i) return false;
+    return true;
+}
+
+void to_matrices(std::span<transform const> local, std::span<matrix4> out) noexcept
+{
+    assert(local.size() == out.size());
+    for (size_t i = 0; i < local.size(); i++)
+        out[i] = to_matrix(local[i]);
+}
+
+void propagate_world_matrices(
+    std::span<matrix4 const> local, std::span<uint32_t const> parents, std::span<matrix4> world) noexcept
+{
+    assert(local.size() == parents.size() && local.size() == world.size());
+    assert(is_depth_sorted(parents));
+    for (size_t i = 0; i < local.size(); i++)
+    {
+        uint32_t parent = parents[i];
+        world[i] = parent == no_parent ? local[i] : world[parent] * local[i];
+    }
+}
+
+void propagate_world_matrices(
+    std::span<transform const> local, std::span<uint32_t const> parents, std::span<matrix4> world) noexcept
+{
+    assert(local.size() == parents.size() && local.size() == world.size());
+    assert(is_depth_sorted(parents));
+    for (size_t i = 0; i < local.size(); i++)
+    {
+        uint32_t parent = parents[i];
+        matrix4 local_matrix = to_matrix(local[i]);
+        world[i] = parent == no_parent ? local_matrix : world[parent] * local_matrix;
+    }
+}
+
+} // namespace math
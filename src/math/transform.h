@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+#include <span>
+#include <vector>
+
+#include "matrix.h"
+#include "quat.h"
+#include "vector.h"
+
+namespace math
+{
+
+// Translation, rotation and scale, applied to a point as T * R * S
+struct transform
+{
+    vec3 translation{ 0.f, 0.f, 0.f };
+    quat rotation = quat::identity();
+    vec3 scale{ 1.f, 1.f, 1.f };
+
+    constexpr bool operator==(transform const& right) const = default;
+};
+
+// to_matrix(transform) -> matrix4
+constexpr matrix4 to_matrix(transform const& value) noexcept
+{
+    matrix4 out = to_matrix(value.rotation);
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        out(0, r) *= value.scale.x;
+        out(1, r) *= value.scale.y;
+        out(2, r) *= value.scale.z;
+    }
+    out.set_column(3, vec4{ value.translation.x, value.translation.y, value.translation.z, 1.f });
+    return out;
+}
+
+// Hierarchies are stored as flat arrays where parents[i] is the index of node i's parent, or
+// no_parent for roots. The propagation routines require every parent to come before its children,
+// which depth_sorted_order() establishes, so a single forward pass resolves the whole hierarchy.
+inline constexpr uint32_t no_parent = UINT32_MAX;
+
+// Order of the nodes sorted by depth, roots first. Nodes at the same depth keep their relative order.
+// order[new_index] = old_index. Throws when a parent is out of range or the parents form a cycle.
+std::vector<uint32_t> depth_sorted_order(std::span<uint32_t const> parents);
+
+// Parent indices of the hierarchy after reordering it by `order`
+std::vector<uint32_t> reorder_parents(std::span<uint32_t const> parents, std::span<uint32_t const> order);
+
+// Gathers `values` into the order given by `order`, out[i] = values[order[i]]
+template <typename T> std::vector<T> reorder(std::span<T const> values, std::span<uint32_t const> order)
+{
+    std::vector<T> out;
+    out.reserve(order.size());
+    for (uint32_t index : order)
+        out.push_back(values[index]);
+    return out;
+}
+
+// True when every node's parent precedes it
+bool is_depth_sorted(std::span<uint32_t const> parents) noexcept;
+
+// out[i] = to_matrix(local[i])
+void to_matrices(std::span<transform const> local, std::span<matrix4> out) noexcept;
+
+// world[i] = world[parents[i]] * local[i], or local[i] for roots. `parents` must be depth sorted and
+// all spans the same size.
+void propagate_world_matrices(
+    std::span<matrix4 const> local, std::span<uint32_t const> parents, std::span<matrix4> world) noexcept;
+void propagate_world_matrices(
+    std::span<transform const> local, std::span<uint32_t const> parents, std::span<matrix4> world) noexcept;
+
+} // namespace math
@@ -0,0 +1,129 @@
+#include "vec_stream.h"
+
+#include "simd.h"
+#include "vec_stream_kernels.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace math
+{
+namespace detail
+{
+#if defined(ORANGE_MATH_HAS_AVX2_KERNELS)
+stream_kernels make_avx2_stream_kernels() noexcept;
+#endif
+#if defined(ORANGE_MATH_HAS_AVX512_KERNELS)
+stream_kernels make_avx512_stream_kernels() noexcept;
+#endif
+} // namespace detail
+
+namespace
+{
+// Baseline kernels, 4 wide through math/simd.h
+struct isa_f32x4
+{
+    using reg = simd::f32x4;
+    static constexpr size_t width = 4;
+    static reg load(float const* ptr) noexcept { return simd::load4(ptr); }
+    static void store(float* ptr, reg value) noexcept { simd::store4(ptr, value); }
+    static reg splat(float value) noexcept { return simd::splat(value); }
+    static reg add(reg a, reg b) noexcept { return simd::add(a, b); }
+    static reg sub(reg a, reg b) noexcept { return simd::sub(a, b); }
+    static reg mul(reg a, reg b) noexcept { return simd::mul(a, b); }
+    static reg div(reg a, reg b) noexcept { return simd::div(a, b); }
+    static reg madd(reg a, reg b, reg c) noexcept { return simd::madd(a, b, c); }
+    static reg min(reg a, reg b) noexcept { return simd::min(a, b); }
+    static reg max(reg a, reg b) noexcept { return simd::max(a, b); }
+    static reg sqrt(reg a) noexcept { return simd::sqrt(a); }
+    static reg select_less(reg a, reg b, reg if_true, reg if_false) noexcept
+    {
+        return simd::select_less(a, b, if_true, if_false);
+    }
+};
+
+stream_isa baseline_isa() noexcept
+{
+#if defined(ORANGE_MATH_SIMD_SSE)
+    return stream_isa::sse2;
+#elif defined(ORANGE_MATH_SIMD_NEON)
+    return stream_isa::neon;
+#else
+    return stream_isa::scalar;
+#endif
+}
+
+#if defined(ORANGE_MATH_HAS_AVX2_KERNELS) || defined(ORANGE_MATH_HAS_AVX512_KERNELS)
+#if defined(_MSC_VER) && !defined(__clang__)
+// Checks both CPU support and that the OS saves the wider register state
+bool cpu_supports(int leaf7_ebx_bit, unsigned long long xcr0_mask) noexcept
+{
+    int info[4];
+    __cpuid(info, 1);
+    bool has_osxsave = (info[2] & (1 << 27)) != 0;
+    bool has_fma = (info[2] & (1 << 12)) != 0;
+    if (!has_osxsave || !has_fma) return false;
+    if ((_xgetbv(0) & xcr0_mask) != xcr0_mask) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << leaf7_ebx_bit)) != 0;
+}
+bool cpu_has_avx2() noexcept { return cpu_supports(5, 0x6); }
+bool cpu_has_avx512() noexcept { return cpu_supports(16, 0xE6); }
+#else
+bool cpu_has_avx2() noexcept
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+bool cpu_has_avx512() noexcept
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+}
+#endif
+#endif
+
+detail::stream_kernels select_kernels() noexcept
+{
+#if defined(ORANGE_MATH_HAS_AVX512_KERNELS)
+    if (cpu_has_avx512()) return detail::make_avx512_stream_kernels();
+#endif
+#if defined(ORANGE_MATH_HAS_AVX2_KERNELS)
+    if (cpu_has_avx2()) return detail::make_avx2_stream_kernels();
+#endif
+    return kernels::make_table<isa_f32x4>(baseline_isa());
+}
+} // namespace
+
+namespace detail
+{
+stream_kernels const& get_stream_kernels() noexcept
+{
+    static const stream_kernels table = select_kernels();
+    return table;
+}
+} // namespace detail
+
+stream_isa get_stream_isa() noexcept { return detail::get_stream_kernels().isa; }
+
+const char* to_string(stream_isa isa) noexcept
+{
+    switch (isa)
+    {
+        case (stream_isa::scalar):
+            return "scalar";
+        case (stream_isa::sse2):
+            return "sse2";
+        case (stream_isa::neon):
+            return "neon";
+        case (stream_isa::avx2):
+            return "avx2";
+        case (stream_isa::avx512):
+            return "avx512";
+        default:
+            return "";
+    }
+}
+
+} // namespace math
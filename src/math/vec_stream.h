@@ -0,0 +1,392 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <span>
+#include <utility>
+
+#include "vector.h"
+
+namespace math
+{
+
+/**
+ * vec_stream is a structure of arrays container for vec<T, L>. Each component is stored in its own
+ * array (x[], y[], z[], w[]) so that the batch functions below process many elements per
+ * instruction instead of one vec at a time.
+ *
+ * All component arrays live in a single allocation. Every array starts on an `alignment` boundary
+ * and the capacity is always a multiple of `lane_count`, so kernels always operate on whole
+ * registers and never need a remainder loop. Elements between size() and padded_size() are
+ * scratch space and may hold any value after a batch operation.
+ **/
+template <arithmetic T, size_t L> class vec_stream
+{
+    public:
+    static constexpr size_t alignment = 64;
+    static constexpr size_t lane_count = alignment / sizeof(T);
+
+    vec_stream() noexcept = default;
+    explicit vec_stream(size_t element_count) { resize(element_count); }
+    ~vec_stream() noexcept { release(); }
+    vec_stream(vec_stream const& other) { *this = other; }
+    vec_stream& operator=(vec_stream const& other)
+    {
+        if (this == &other) return *this;
+        count = 0;
+        reserve(other.count);
+        count = other.count;
+        if (count == 0) return *this;
+        for (size_t c = 0; c < L; c++)
+            std::memcpy(component(c), other.component(c), other.padded_size() * sizeof(T));
+        return *this;
+    }
+    vec_stream(vec_stream&& other) noexcept
+    : storage(std::exchange(other.storage, nullptr)),
+      count(std::exchange(other.count, 0)),
+      stride(std::exchange(other.stride, 0))
+    {
+    }
+    vec_stream& operator=(vec_stream&& other) noexcept
+    {
+        release();
+        storage = std::exchange(other.storage, nullptr);
+        count = std::exchange(other.count, 0);
+        stride = std::exchange(other.stride, 0);
+        return *this;
+    }
+
+    constexpr size_t size() const noexcept { return count; }
+    constexpr size_t capacity() const noexcept { return stride; }
+    constexpr bool empty() const noexcept { return count == 0; }
+    // Number of elements the batch kernels touch, size() rounded up to a multiple of lane_count
+    constexpr size_t padded_size() const noexcept { return round_up(count); }
+
+    void reserve(size_t new_capacity)
+    {
+        new_capacity = round_up(new_capacity);
+        if (new_capacity <= stride) return;
+        T* new_storage = static_cast<T*>(
+            ::operator new(new_capacity * L * sizeof(T), std::align_val_t{ alignment }));
+        std::memset(new_storage, 0, new_capacity * L * sizeof(T));
+        if (storage != nullptr)
+        {
+            for (size_t c = 0; c < L; c++)
+                std::memcpy(new_storage + c * new_capacity, component(c), count * sizeof(T));
+        }
+        release();
+        storage = new_storage;
+        stride = new_capacity;
+    }
+    // New elements are zero initialized
+    void resize(size_t new_size)
+    {
+        if (new_size > stride) reserve(new_size > stride * 2 ? new_size : stride * 2);
+        if (new_size > count)
+        {
+            for (size_t c = 0; c < L; c++)
+                std::memset(component(c) + count, 0, (new_size - count) * sizeof(T));
+        }
+        count = new_size;
+    }
+    void clear() noexcept { count = 0; }
+
+    void push_back(vec<T, L> const& value)
+    {
+        resize(count + 1);
+        set(count - 1, value);
+    }
+
+    vec<T, L> get(size_t index) const noexcept
+    {
+        assert(index < count);
+        vec<T, L> out;
+        for (size_t c = 0; c < L; c++)
+            out[c] = storage[c * stride + index];
+        return out;
+    }
+    void set(size_t index, vec<T, L> const& value) noexcept
+    {
+        assert(index < count);
+        for (size_t c = 0; c < L; c++)
+            storage[c * stride + index] = value[c];
+    }
+
+    T* component(size_t c) noexcept { return storage + c * stride; }
+    T const* component(size_t c) const noexcept { return storage + c * stride; }
+
+    std::span<T> x() noexcept { return { component(0), count }; }
+    std::span<T const> x() const noexcept { return { component(0), count }; }
+    std::span<T> y() noexcept requires(L >= 2) { return { component(1), count }; }
+    std::span<T const> y() const noexcept requires(L >= 2) { return { component(1), count }; }
+    std::span<T> z() noexcept requires(L >= 3) { return { component(2), count }; }
+    std::span<T const> z() const noexcept requires(L >= 3) { return { component(2), count }; }
+    std::span<T> w() noexcept requires(L >= 4) { return { component(3), count }; }
+    std::span<T const> w() const noexcept requires(L >= 4) { return { component(3), count }; }
+
+    private:
+    T* storage = nullptr;
+    size_t count = 0;
+    size_t stride = 0; // capacity of each component array
+
+    static constexpr size_t round_up(size_t value) noexcept
+    {
+        return (value + lane_count - 1) / lane_count * lane_count;
+    }
+    void release() noexcept
+    {
+        if (storage != nullptr) ::operator delete(storage, std::align_val_t{ alignment });
+        storage = nullptr;
+        stride = 0;
+    }
+};
+
+// Instruction set the float batch kernels were dispatched to on this machine
+enum class stream_isa
+{
+    scalar,
+    sse2,
+    neon,
+    avx2,
+    avx512,
+};
+stream_isa get_stream_isa() noexcept;
+const char* to_string(stream_isa isa) noexcept;
+
+namespace detail
+{
+// Kernels over single component arrays. `count` is a multiple of 16 and every pointer is aligned
+// to 64 bytes. Implemented in vec_stream*.cpp, one table per instruction set, with the best one
+// the CPU supports picked on first use.
+struct stream_kernels
+{
+    stream_isa isa;
+    void (*add)(float const* a, float const* b, float* out, size_t count) noexcept;
+    void (*sub)(float const* a, float const* b, float* out, size_t count) noexcept;
+    void (*mul)(float const* a, float const* b, float* out, size_t count) noexcept;
+    void (*scale)(float const* a, float b, float* out, size_t count) noexcept;
+    void (*fma)(float const* a, float const* b, float const* c, float* out, size_t count) noexcept;
+    void (*min)(float const* a, float const* b, float* out, size_t count) noexcept;
+    void (*max)(float const* a, float const* b, float* out, size_t count) noexcept;
+    void (*lerp)(float const* a, float const* b, float t, float* out, size_t count) noexcept;
+    void (*lerp_stream)(float const* a, float const* b, float const* t, float* out, size_t count) noexcept;
+    void (*clamp)(float const* a, float low, float high, float* out, size_t count) noexcept;
+    // out[i] = sum over the components of a[c][i] * b[c][i]
+    void (*dot)(float const* const* a, float const* const* b, size_t components, float* out, size_t count) noexcept;
+    // out[c][i] = in[c][i] / length(in[...][i]), in and out may be the same arrays
+    void (*normalize)(float const* const* in, float* const* out, size_t components, size_t count) noexcept;
+};
+stream_kernels const& get_stream_kernels() noexcept;
+
+// Generic versions for non float streams, the compiler is left to vectorize these
+template <typename T> void stream_add(T const* a, T const* b, T* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = a[i] + b[i];
+}
+template <typename T> void stream_sub(T const* a, T const* b, T* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = a[i] - b[i];
+}
+template <typename T> void stream_mul(T const* a, T const* b, T* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = a[i] * b[i];
+}
+template <typename T> void stream_scale(T const* a, T b, T* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = a[i] * b;
+}
+template <typename T> void stream_fma(T const* a, T const* b, T const* c, T* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = a[i] * b[i] + c[i];
+}
+template <typename T> void stream_min(T const* a, T const* b, T* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = a[i] < b[i] ? a[i] : b[i];
+}
+template <typename T> void stream_max(T const* a, T const* b, T* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = a[i] > b[i] ? a[i] : b[i];
+}
+template <typename T> void stream_clamp(T const* a, T low, T high, T* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = a[i] < high ? ((a[i] > low) ? a[i] : low) : high;
+}
+
+inline void stream_add(float const* a, float const* b, float* out, size_t count) noexcept
+{
+    get_stream_kernels().add(a, b, out, count);
+}
+inline void stream_sub(float const* a, float const* b, float* out, size_t count) noexcept
+{
+    get_stream_kernels().sub(a, b, out, count);
+}
+inline void stream_mul(float const* a, float const* b, float* out, size_t count) noexcept
+{
+    get_stream_kernels().mul(a, b, out, count);
+}
+inline void stream_scale(float const* a, float b, float* out, size_t count) noexcept
+{
+    get_stream_kernels().scale(a, b, out, count);
+}
+inline void stream_fma(float const* a, float const* b, float const* c, float* out, size_t count) noexcept
+{
+    get_stream_kernels().fma(a, b, c, out, count);
+}
+inline void stream_min(float const* a, float const* b, float* out, size_t count) noexcept
+{
+    get_stream_kernels().min(a, b, out, count);
+}
+inline void stream_max(float const* a, float const* b, float* out, size_t count) noexcept
+{
+    get_stream_kernels().max(a, b, out, count);
+}
+inline void stream_clamp(float const* a, float low, float high, float* out, size_t count) noexcept
+{
+    get_stream_kernels().clamp(a, low, high, out, count);
+}
+} // namespace detail
+
+// Batch operations. `out` is resized to match the inputs and may be the same stream as an input.
+
+// out = a + b (memberwise)
+template <arithmetic T, size_t L>
+void add(vec_stream<T, L> const& a, vec_stream<T, L> const& b, vec_stream<T, L>& out)
+{
+    assert(a.size() == b.size());
+    out.resize(a.size());
+    for (size_t c = 0; c < L; c++)
+        detail::stream_add(a.component(c), b.component(c), out.component(c), a.padded_size());
+}
+// out = a - b (memberwise)
+template <arithmetic T, size_t L>
+void sub(vec_stream<T, L> const& a, vec_stream<T, L> const& b, vec_stream<T, L>& out)
+{
+    assert(a.size() == b.size());
+    out.resize(a.size());
+    for (size_t c = 0; c < L; c++)
+        detail::stream_sub(a.component(c), b.component(c), out.component(c), a.padded_size());
+}
+// out = a * b (memberwise)
+template <arithmetic T, size_t L>
+void mul(vec_stream<T, L> const& a, vec_stream<T, L> const& b, vec_stream<T, L>& out)
+{
+    assert(a.size() == b.size());
+    out.resize(a.size());
+    for (size_t c = 0; c < L; c++)
+        detail::stream_mul(a.component(c), b.component(c), out.component(c), a.padded_size());
+}
+// out = a * scalar
+template <arithmetic T, size_t L> void mul(vec_stream<T, L> const& a, T b, vec_stream<T, L>& out)
+{
+    out.resize(a.size());
+    for (size_t c = 0; c < L; c++)
+        detail::stream_scale(a.component(c), b, out.component(c), a.padded_size());
+}
+// out = a * b + c (memberwise), fused when the CPU supports it
+template <arithmetic T, size_t L>
+void fma(vec_stream<T, L> const& a, vec_stream<T, L> const& b, vec_stream<T, L> const& c, vec_stream<T, L>& out)
+{
+    assert(a.size() == b.size() && a.size() == c.size());
+    out.resize(a.size());
+    for (size_t i = 0; i < L; i++)
+        detail::stream_fma(a.component(i), b.component(i), c.component(i), out.component(i), a.padded_size());
+}
+// out = min(a, b) (memberwise)
+template <arithmetic T, size_t L>
+void min(vec_stream<T, L> const& a, vec_stream<T, L> const& b, vec_stream<T, L>& out)
+{
+    assert(a.size() == b.size());
+    out.resize(a.size());
+    for (size_t c = 0; c < L; c++)
+        detail::stream_min(a.component(c), b.component(c), out.component(c), a.padded_size());
+}
+// out = max(a, b) (memberwise)
+template <arithmetic T, size_t L>
+void max(vec_stream<T, L> const& a, vec_stream<T, L> const& b, vec_stream<T, L>& out)
+{
+    assert(a.size() == b.size());
+    out.resize(a.size());
+    for (size_t c = 0; c < L; c++)
+        detail::stream_max(a.component(c), b.component(c), out.component(c), a.padded_size());
+}
+// out = clamp(value, low, high) (memberwise)
+template <arithmetic T, size_t L>
+void clamp(vec_stream<T, L> const& value, T low, T high, vec_stream<T, L>& out)
+{
+    out.resize(value.size());
+    for (size_t c = 0; c < L; c++)
+        detail::stream_clamp(value.component(c), low, high, out.component(c), value.padded_size());
+}
+
+// out = lower + interp * (upper - lower)
+template <size_t L>
+void lerp(vec_stream<float, L> const& lower, vec_stream<float, L> const& upper, float interp, vec_stream<float, L>& out)
+{
+    assert(lower.size() == upper.size());
+    out.resize(lower.size());
+    auto const& kernels = detail::get_stream_kernels();
+    for (size_t c = 0; c < L; c++)
+        kernels.lerp(lower.component(c), upper.component(c), interp, out.component(c), lower.padded_size());
+}
+// out[i] = lower[i] + interp[i] * (upper[i] - lower[i])
+template <size_t L>
+void lerp(vec_stream<float, L> const& lower,
+    vec_stream<float, L> const& upper,
+    vec_stream<float, 1> const& interp,
+    vec_stream<float, L>& out)
+{
+    assert(lower.size() == upper.size() && lower.size() == interp.size());
+    out.resize(lower.size());
+    auto const& kernels = detail::get_stream_kernels();
+    for (size_t c = 0; c < L; c++)
+        kernels.lerp_stream(
+            lower.component(c), upper.component(c), interp.component(0), out.component(c), lower.padded_size());
+}
+
+// out[i] = dot(a[i], b[i])
+template <size_t L>
+void dot(vec_stream<float, L> const& a, vec_stream<float, L> const& b, vec_stream<float, 1>& out)
+{
+    assert(a.size() == b.size());
+    out.resize(a.size());
+    float const* a_components[L];
+    float const* b_components[L];
+    for (size_t c = 0; c < L; c++)
+    {
+        a_components[c] = a.component(c);
+        b_components[c] = b.component(c);
+    }
+    detail::get_stream_kernels().dot(a_components, b_components, L, out.component(0), a.padded_size());
+}
+
+// out[i] = in[i] / length(in[i]), zero length vectors produce NaN like the scalar math::normalize
+template <size_t L> void normalize(vec_stream<float, L> const& in, vec_stream<float, L>& out)
+{
+    out.resize(in.size());
+    float const* in_components[L];
+    float* out_components[L];
+    for (size_t c = 0; c < L; c++)
+    {
+        in_components[c] = in.component(c);
+        out_components[c] = out.component(c);
+    }
+    detail::get_stream_kernels().normalize(in_components, out_components, L, in.padded_size());
+}
+
+using vec2_stream = vec_stream<float, 2>;
+using vec3_stream = vec_stream<float, 3>;
+using vec4_stream = vec_stream<float, 4>;
+using float_stream = vec_stream<float, 1>;
+
+} // namespace math
@@ -0,0 +1,40 @@
+// Compiled with AVX2 and FMA enabled, see CMakeLists.txt. Only reached after a runtime CPU check.
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#include "vec_stream_kernels.h"
+
+namespace
+{
+struct isa_avx2
+{
+    using reg = __m256;
+    static constexpr size_t width = 8;
+    static reg load(float const* ptr) noexcept { return _mm256_load_ps(ptr); }
+    static void store(float* ptr, reg value) noexcept { _mm256_store_ps(ptr, value); }
+    static reg splat(float value) noexcept { return _mm256_set1_ps(value); }
+    static reg add(reg a, reg b) noexcept { return _mm256_add_ps(a, b); }
+    static reg sub(reg a, reg b) noexcept { return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b) noexcept { return _mm256_mul_ps(a, b); }
+    static reg div(reg a, reg b) noexcept { return _mm256_div_ps(a, b); }
+    static reg madd(reg a, reg b, reg c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+    static reg min(reg a, reg b) noexcept { return _mm256_min_ps(a, b); }
+    static reg max(reg a, reg b) noexcept { return _mm256_max_ps(a, b); }
+    static reg sqrt(reg a) noexcept { return _mm256_sqrt_ps(a); }
+    static reg select_less(reg a, reg b, reg if_true, reg if_false) noexcept
+    {
+        return _mm256_blendv_ps(if_false, if_true, _mm256_cmp_ps(a, b, _CMP_LT_OQ));
+    }
+};
+} // namespace
+
+namespace math::detail
+{
+stream_kernels make_avx2_stream_kernels() noexcept
+{
+    return kernels::make_table<isa_avx2>(stream_isa::avx2);
+}
+} // namespace math::detail
+
+#endif
@@ -0,0 +1,45 @@
+// Compiled with AVX-512F enabled, see CMakeLists.txt. Only reached after a runtime CPU check.
+#if defined(__AVX512F__)
+
+// GCC 12 reports false positives for the _mm512_undefined_ps() inside its own intrinsic headers
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include <immintrin.h>
+
+#include "vec_stream_kernels.h"
+
+namespace
+{
+struct isa_avx512
+{
+    using reg = __m512;
+    static constexpr size_t width = 16;
+    static reg load(float const* ptr) noexcept { return _mm512_load_ps(ptr); }
+    static void store(float* ptr, reg value) noexcept { _mm512_store_ps(ptr, value); }
+    static reg splat(float value) noexcept { return _mm512_set1_ps(value); }
+    static reg add(reg a, reg b) noexcept { return _mm512_add_ps(a, b); }
+    static reg sub(reg a, reg b) noexcept { return _mm512_sub_ps(a, b); }
+    static reg mul(reg a, reg b) noexcept { return _mm512_mul_ps(a, b); }
+    static reg div(reg a, reg b) noexcept { return _mm512_div_ps(a, b); }
+    static reg madd(reg a, reg b, reg c) noexcept { return _mm512_fmadd_ps(a, b, c); }
+    static reg min(reg a, reg b) noexcept { return _mm512_min_ps(a, b); }
+    static reg max(reg a, reg b) noexcept { return _mm512_max_ps(a, b); }
+    static reg sqrt(reg a) noexcept { return _mm512_sqrt_ps(a); }
+    static reg select_less(reg a, reg b, reg if_true, reg if_false) noexcept
+    {
+        return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ), if_false, if_true);
+    }
+};
+} // namespace
+
+namespace math::detail
+{
+stream_kernels make_avx512_stream_kernels() noexcept
+{
+    return kernels::make_table<isa_avx512>(stream_isa::avx512);
+}
+} // namespace math::detail
+
+#endif
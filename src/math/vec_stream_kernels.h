@@ -0,0 +1,127 @@
+#pragma once
+
+// Private to the vec_stream*.cpp files. The kernels are written once against an `Isa` type
+// providing a register type and the handful of operations below, and each translation unit
+// instantiates them with its own instruction set. Everything here has internal linkage so that code
+// compiled for a wider instruction set can never be picked by the linker for a different TU.
+
+#include <cstddef>
+
+#include "vec_stream.h"
+
+namespace
+{
+namespace kernels
+{
+template <typename Isa> void add(float const* a, float const* b, float* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i += Isa::width)
+        Isa::store(out + i, Isa::add(Isa::load(a + i), Isa::load(b + i)));
+}
+template <typename Isa> void sub(float const* a, float const* b, float* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i += Isa::width)
+        Isa::store(out + i, Isa::sub(Isa::load(a + i), Isa::load(b + i)));
+}
+template <typename Isa> void mul(float const* a, float const* b, float* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i += Isa::width)
+        Isa::store(out + i, Isa::mul(Isa::load(a + i), Isa::load(b + i)));
+}
+template <typename Isa> void scale(float const* a, float b, float* out, size_t count) noexcept
+{
+    auto scalar = Isa::splat(b);
+    for (size_t i = 0; i < count; i += Isa::width)
+        Isa::store(out + i, Isa::mul(Isa::load(a + i), scalar));
+}
+template <typename Isa>
+void fma(float const* a, float const* b, float const* c, float* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i += Isa::width)
+        Isa::store(out + i, Isa::madd(Isa::load(a + i), Isa::load(b + i), Isa::load(c + i)));
+}
+template <typename Isa> void min(float const* a, float const* b, float* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i += Isa::width)
+        Isa::store(out + i, Isa::min(Isa::load(a + i), Isa::load(b + i)));
+}
+template <typename Isa> void max(float const* a, float const* b, float* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i += Isa::width)
+        Isa::store(out + i, Isa::max(Isa::load(a + i), Isa::load(b + i)));
+}
+template <typename Isa>
+void lerp(float const* a, float const* b, float t, float* out, size_t count) noexcept
+{
+    auto interp = Isa::splat(t);
+    for (size_t i = 0; i < count; i += Isa::width)
+    {
+        auto lower = Isa::load(a + i);
+        Isa::store(out + i, Isa::madd(interp, Isa::sub(Isa::load(b + i), lower), lower));
+    }
+}
+template <typename Isa>
+void lerp_stream(float const* a, float const* b, float const* t, float* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i += Isa::width)
+    {
+        auto lower = Isa::load(a + i);
+        Isa::store(out + i, Isa::madd(Isa::load(t + i), Isa::sub(Isa::load(b + i), lower), lower));
+    }
+}
+// Same semantics as math::clamp: `value < high ? max(value, low) : high`
+template <typename Isa>
+void clamp(float const* a, float low, float high, float* out, size_t count) noexcept
+{
+    auto lower = Isa::splat(low);
+    auto upper = Isa::splat(high);
+    for (size_t i = 0; i < count; i += Isa::width)
+    {
+        auto value = Isa::load(a + i);
+        Isa::store(out + i, Isa::select_less(value, upper, Isa::max(value, lower), upper));
+    }
+}
+template <typename Isa>
+void dot(float const* const* a, float const* const* b, size_t components, float* out, size_t count) noexcept
+{
+    for (size_t i = 0; i < count; i += Isa::width)
+    {
+        auto sum = Isa::mul(Isa::load(a[0] + i), Isa::load(b[0] + i));
+        for (size_t c = 1; c < components; c++)
+            sum = Isa::madd(Isa::load(a[c] + i), Isa::load(b[c] + i), sum);
+        Isa::store(out + i, sum);
+    }
+}
+template <typename Isa>
+void normalize(float const* const* in, float* const* out, size_t components, size_t count) noexcept
+{
+    auto one = Isa::splat(1.f);
+    for (size_t i = 0; i < count; i += Isa::width)
+    {
+        auto length_squared = Isa::mul(Isa::load(in[0] + i), Isa::load(in[0] + i));
+        for (size_t c = 1; c < components; c++)
+            length_squared = Isa::madd(Isa::load(in[c] + i), Isa::load(in[c] + i), length_squared);
+        auto inverse_length = Isa::div(one, Isa::sqrt(length_squared));
+        for (size_t c = 0; c < components; c++)
+            Isa::store(out[c] + i, Isa::mul(Isa::load(in[c] + i), inverse_length));
+    }
+}
+
+template <typename Isa> math::detail::stream_kernels make_table(math::stream_isa isa) noexcept
+{
+    return math::detail::stream_kernels{ isa,
+        add<Isa>,
+        sub<Isa>,
+        mul<Isa>,
+        scale<Isa>,
+        fma<Isa>,
+        min<Isa>,
+        max<Isa>,
+        lerp<Isa>,
+        lerp_stream<Isa>,
+        clamp<Isa>,
+        dot<Isa>,
+        normalize<Isa> };
+}
+} // namespace kernels
+} // namespace
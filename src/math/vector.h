@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <concepts>
+#include <type_traits>
+
+#include "simd.h"
 
 template <class T>
 concept arithmetic = std::is_arithmetic_v<T>;
@@ -32,7 +37,7 @@ template <typename T> struct vec<T, 2>
 {
     T x{}, y{};
     constexpr vec() noexcept = default;
-    constexpr vec(T x, T y) noexcept : x(x), y(y) {}
+    constexpr vec(T x_, T y_) noexcept : x(x_), y(y_) {}
     constexpr size_t size() const noexcept { return 2; };
 
     constexpr T const& operator[](size_t index) const noexcept
@@ -54,7 +59,7 @@ template <typename T> struct vec<T, 3>
 {
     T x{}, y{}, z{};
     constexpr vec() noexcept = default;
-    constexpr vec(T x, T y, T z) noexcept : x(x), y(y), z(z) {}
+    constexpr vec(T x_, T y_, T z_) noexcept : x(x_), y(y_), z(z_) {}
     constexpr size_t size() const noexcept { return 3; };
 
     constexpr T const& operator[](size_t index) const noexcept
@@ -78,7 +83,7 @@ template <typename T> struct vec<T, 4>
 {
     T x{}, y{}, z{}, w{};
     constexpr vec() noexcept = default;
-    constexpr vec(T x, T y, T z, T w) noexcept : x(x), y(y), z(z), w(w) {}
+    constexpr vec(T x_, T y_, T z_, T w_) noexcept : x(x_), y(y_), z(z_), w(w_) {}
     constexpr size_t size() const noexcept { return 4; };
 
     constexpr T const& operator[](size_t index) const noexcept
@@ -101,9 +106,47 @@ template <typename T> struct vec<T, 4>
     constexpr bool operator==(vec<T, 4> const& right) const = default;
 };
 
+namespace detail
+{
+// vec types which map onto a SIMD register from math/simd.h. At runtime the memberwise operators
+// below go through the register path for these, constant evaluation keeps the scalar loops.
+template <typename T, size_t L>
+inline constexpr bool simd_float = simd::native && std::is_same_v<T, float> && (L == 3 || L == 4);
+template <typename T, size_t L>
+inline constexpr bool simd_int = simd::native && std::is_same_v<T, int32_t> && L == 4;
+template <typename T, size_t L> inline constexpr bool simd_vec = simd_float<T, L> || simd_int<T, L>;
+
+// Unused lanes of a vec3 are filled with `pad`
+template <typename T, size_t L> inline auto load(vec<T, L> const& value, T pad = T{}) noexcept
+{
+    // Building from the members lets the compiler pick the best load sequence, a vec3 going
+    // through memory would cause a store forwarding stall
+    if constexpr (L == 3)
+        return simd::set(value.x, value.y, value.z, pad);
+    else
+        return simd::set(value.x, value.y, value.z, value.w);
+}
+template <typename T, size_t L, typename Register> inline vec<T, L> store(Register reg) noexcept
+{
+    static_assert(std::is_trivially_copyable_v<vec<T, L>> && sizeof(vec<T, L>) == sizeof(T) * L);
+    T lanes[4];
+    simd::store4(lanes, reg);
+    vec<T, L> out;
+    std::memcpy(&out, lanes, sizeof(out));
+    return out;
+}
+} // namespace detail
+
 // -vec -> vec (memberwise)
 template <arithmetic T, size_t L> constexpr auto operator-(vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::neg(detail::load(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -116,6 +159,13 @@ template <arithmetic T, size_t L> constexpr auto operator-(vec<T, L> const& righ
 template <arithmetic T, size_t L>
 constexpr auto operator+(vec<T, L> const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::add(detail::load(left), detail::load(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -127,6 +177,14 @@ constexpr auto operator+(vec<T, L> const& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator+=(vec<T, L>& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            left = detail::store<T, L>(simd::add(detail::load(left), detail::load(right)));
+            return left;
+        }
+    }
     for (size_t i = 0; i < L; i++)
     {
         left[i] += right[i];
@@ -137,6 +195,14 @@ constexpr auto operator+=(vec<T, L>& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator+=(vec<T, L>& left, T const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            left = detail::store<T, L>(simd::add(detail::load(left), simd::splat(right)));
+            return left;
+        }
+    }
     for (size_t i = 0; i < L; i++)
     {
         left[i] += right;
@@ -147,6 +213,13 @@ constexpr auto operator+=(vec<T, L>& left, T const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator+(T const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::add(simd::splat(left), detail::load(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -158,6 +231,13 @@ constexpr auto operator+(T const& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator+(vec<T, L> const& left, T const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::add(detail::load(left), simd::splat(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -170,6 +250,13 @@ constexpr auto operator+(vec<T, L> const& left, T const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator-(vec<T, L> const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::sub(detail::load(left), detail::load(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -181,6 +268,14 @@ constexpr auto operator-(vec<T, L> const& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator-=(vec<T, L>& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            left = detail::store<T, L>(simd::sub(detail::load(left), detail::load(right)));
+            return left;
+        }
+    }
     for (size_t i = 0; i < L; i++)
     {
         left[i] -= right[i];
@@ -191,6 +286,14 @@ constexpr auto operator-=(vec<T, L>& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator-=(vec<T, L>& left, T const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            left = detail::store<T, L>(simd::sub(detail::load(left), simd::splat(right)));
+            return left;
+        }
+    }
     for (size_t i = 0; i < L; i++)
     {
         left[i] -= right;
@@ -201,6 +304,13 @@ constexpr auto operator-=(vec<T, L>& left, T const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator-(T const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::sub(simd::splat(left), detail::load(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -212,6 +322,13 @@ constexpr auto operator-(T const& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator-(vec<T, L> const& left, T const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::sub(detail::load(left), simd::splat(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -224,6 +341,13 @@ constexpr auto operator-(vec<T, L> const& left, T const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator*(vec<T, L> const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::mul(detail::load(left), detail::load(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -235,6 +359,14 @@ constexpr auto operator*(vec<T, L> const& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator*=(vec<T, L>& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            left = detail::store<T, L>(simd::mul(detail::load(left), detail::load(right)));
+            return left;
+        }
+    }
     for (size_t i = 0; i < L; i++)
     {
         left[i] *= right[i];
@@ -245,6 +377,14 @@ constexpr auto operator*=(vec<T, L>& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator*=(vec<T, L>& left, T const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            left = detail::store<T, L>(simd::mul(detail::load(left), simd::splat(right)));
+            return left;
+        }
+    }
     for (size_t i = 0; i < L; i++)
     {
         left[i] *= right;
@@ -255,6 +395,13 @@ constexpr auto operator*=(vec<T, L>& left, T const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator*(T const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::mul(simd::splat(left), detail::load(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -266,6 +413,13 @@ constexpr auto operator*(T const& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator*(vec<T, L> const& left, T const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::mul(detail::load(left), simd::splat(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -278,6 +432,13 @@ constexpr auto operator*(vec<T, L> const& left, T const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator/(vec<T, L> const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_float<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::div(detail::load(left), detail::load(right, T{ 1 })));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -289,6 +450,14 @@ constexpr auto operator/(vec<T, L> const& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator/=(vec<T, L>& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_float<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            left = detail::store<T, L>(simd::div(detail::load(left), detail::load(right, T{ 1 })));
+            return left;
+        }
+    }
     for (size_t i = 0; i < L; i++)
     {
         left[i] /= right[i];
@@ -299,6 +468,14 @@ constexpr auto operator/=(vec<T, L>& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator/=(vec<T, L>& left, T const& right) noexcept
 {
+    if constexpr (detail::simd_float<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            left = detail::store<T, L>(simd::div(detail::load(left), simd::splat(right)));
+            return left;
+        }
+    }
     for (size_t i = 0; i < L; i++)
     {
         left[i] /= right;
@@ -309,6 +486,13 @@ constexpr auto operator/=(vec<T, L>& left, T const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator/(T const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_float<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::div(simd::splat(left), detail::load(right, T{ 1 })));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -320,6 +504,13 @@ constexpr auto operator/(T const& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto operator/(vec<T, L> const& left, T const& right) noexcept
 {
+    if constexpr (detail::simd_float<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::div(detail::load(left), simd::splat(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -332,6 +523,13 @@ constexpr auto operator/(vec<T, L> const& left, T const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto dot(vec<T, L> const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_float<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return simd::dot4(detail::load(left), detail::load(right));
+        }
+    }
     T out{};
     for (size_t i = 0; i < L; i++)
     {
@@ -340,10 +538,37 @@ constexpr auto dot(vec<T, L> const& left, vec<T, L> const& right) noexcept
     return out;
 }
 
+// cross(vec3, vec3) -> vec3
+template <arithmetic T> constexpr auto cross(vec<T, 3> const& left, vec<T, 3> const& right) noexcept
+{
+    return vec<T, 3>{ left.y * right.z - left.z * right.y,
+        left.z * right.x - left.x * right.z,
+        left.x * right.y - left.y * right.x };
+}
+
+// length(vec) -> scalar
+template <std::floating_point F, size_t L> auto length(vec<F, L> const& value) noexcept
+{
+    return std::sqrt(dot(value, value));
+}
+
+// normalize(vec) -> vec, zero length vectors produce NaN
+template <std::floating_point F, size_t L> auto normalize(vec<F, L> const& value) noexcept
+{
+    return value / length(value);
+}
+
 // min(vec) -> scalar
 template <arithmetic T, size_t L>
 constexpr auto min(vec<T, L> const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::min(detail::load(left), detail::load(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -356,6 +581,13 @@ constexpr auto min(vec<T, L> const& left, vec<T, L> const& right) noexcept
 template <arithmetic T, size_t L>
 constexpr auto max(vec<T, L> const& left, vec<T, L> const& right) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::max(detail::load(left), detail::load(right)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -367,6 +599,13 @@ constexpr auto max(vec<T, L> const& left, vec<T, L> const& right) noexcept
 // abs(vec) -> vec
 template <arithmetic T, size_t L> constexpr auto abs(vec<T, L> const& left) noexcept
 {
+    if constexpr (detail::simd_vec<T, L>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            return detail::store<T, L>(simd::abs(detail::load(left)));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -379,6 +618,18 @@ template <arithmetic T, size_t L> constexpr auto abs(vec<T, L> const& left) noex
 template <arithmetic T, size_t L, arithmetic U, arithmetic V>
 constexpr auto clamp(vec<T, L> const& value, U min, V max) noexcept -> vec<T, L>
 {
+    // Only take the register path when comparing in T gives the same answer as the scalar code
+    if constexpr (detail::simd_vec<T, L> && std::is_same_v<std::common_type_t<T, U>, T> &&
+                  std::is_same_v<std::common_type_t<T, V>, T>)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            auto in = detail::load(value);
+            auto upper = simd::splat(static_cast<T>(max));
+            return detail::store<T, L>(
+                simd::select_less(in, upper, simd::max(in, simd::splat(static_cast<T>(min))), upper));
+        }
+    }
     vec<T, L> out;
     for (size_t i = 0; i < L; i++)
     {
@@ -0,0 +1,201 @@
+#include "bindless_table.h"
+
+#include <cassert>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "core/profiler.h"
+#include "descriptor_layout_cache.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+// Partially bound, so unused slots may hold anything. Update unused while pending, so adding a
+// texture doesn't have to wait for the frames in flight that bound the set.
+constexpr VkDescriptorBindingFlags binding_flags =
+    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+    VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+} // namespace
+
+BindlessTable::BindlessTable(CreateDetails create_details)
+: device(create_details.device), timeline(create_details.timeline)
+{
+    VkPhysicalDeviceVulkan12Properties properties_12{};
+    properties_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &properties_12;
+    vkGetPhysicalDeviceProperties2(create_details.physical_device, &properties);
+    // combined image samplers count against both the sampler and the sampled image limits
+    textures.capacity = std::min({ create_details.max_textures,
+        properties_12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        properties_12.maxPerStageDescriptorUpdateAfterBindSamplers,
+        properties_12.maxDescriptorSetUpdateAfterBindSampledImages,
+        properties_12.maxDescriptorSetUpdateAfterBindSamplers });
+    buffers.capacity = std::min({ create_details.max_buffers,
+        properties_12.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+        properties_12.maxDescriptorSetUpdateAfterBindStorageBuffers });
+
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    bindings[0].binding = texture_binding;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = textures.capacity;
+    bindings[0].stageFlags = create_details.stages;
+    bindings[1].binding = buffer_binding;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = buffers.capacity;
+    bindings[1].stageFlags = create_details.stages;
+    VkDescriptorBindingFlags flags[2] = { binding_flags, binding_flags };
+    // owned by the cache
+    set_layout = create_details.layout_cache->get(
+        bindings, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT, flags);
+
+    VkDescriptorPoolSize pool_sizes[2] = {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textures.capacity },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, buffers.capacity },
+    };
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 2;
+    pool_info.pPoolSizes = pool_sizes;
+    VkResult result = vkCreateDescriptorPool(device, &pool_info, nullptr, &pool);
+    if (result != VK_SUCCESS)
+        throw std::runtime_error(
+            "Failed to create bindless table: vkCreateDescriptorPool failed with "s +
+            std::to_string(result));
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &set_layout;
+    result = vkAllocateDescriptorSets(device, &alloc_info, &descriptor_set);
+    if (result != VK_SUCCESS)
+    {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+        throw std::runtime_error(
+            "Failed to create bindless table: vkAllocateDescriptorSets failed with "s +
+            std::to_string(result));
+    }
+}
+
+BindlessTable::~BindlessTable() noexcept { vkDestroyDescriptorPool(device, pool, nullptr); }
+
+uint32_t BindlessTable::add_texture(VkImageView view, VkSampler sampler, VkImageLayout layout)
+{
+    std::lock_guard lock(mutex);
+    uint32_t index = acquire(textures, "texture");
+    pending_textures.push_back({ index, VkDescriptorImageInfo{ sampler, view, layout } });
+    return index;
+}
+
+uint32_t BindlessTable::add_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    std::lock_guard lock(mutex);
+    uint32_t index = acquire(buffers, "buffer");
+    pending_buffers.push_back({ index, VkDescriptorBufferInfo{ buffer, offset, range } });
+    return index;
+}
+
+void BindlessTable::remove_texture(uint32_t index)
+{
+    std::lock_guard lock(mutex);
+    release(textures, index);
+}
+
+void BindlessTable::remove_buffer(uint32_t index)
+{
+    std::lock_guard lock(mutex);
+    release(buffers, index);
+}
+
+uint32_t BindlessTable::acquire(Slots& slots, const char* what)
+{
+    while (!slots.retired.empty() && timeline->is_complete(slots.retired.front().value))
+    {
+        slots.free.push_back(slots.retired.front().index);
+        slots.retired.pop_front();
+    }
+    if (!slots.free.empty())
+    {
+        uint32_t index = slots.free.back();
+        slots.free.pop_back();
+        return index;
+    }
+    if (slots.next == slots.capacity)
+        throw std::runtime_error("Failed to add "s + what + " to bindless table: all " +
+                                 std::to_string(slots.capacity) + " slots are in use");
+    return slots.next++;
+}
+
+void BindlessTable::release(Slots& slots, uint32_t index)
+{
+    assert(index < slots.next && "slot was never added");
+    slots.retired.push_back(Retired{ index, timeline->next_value() });
+}
+
+void BindlessTable::flush()
+{
+    ORANGE_PROFILE_SCOPE("BindlessTable::flush");
+    std::lock_guard lock(mutex);
+    if (pending_textures.empty() && pending_buffers.empty()) return;
+    writes.clear();
+    write_runs(pending_textures, texture_binding, image_infos);
+    write_runs(pending_buffers, buffer_binding, buffer_infos);
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    ORANGE_PROFILE_COUNTER("Bindless descriptor writes", writes.size());
+}
+
+template <typename Info>
+void BindlessTable::write_runs(
+    std::vector<Pending<Info>>& pending, uint32_t binding, std::vector<Info>& infos)
+{
+    if (pending.empty()) return;
+    // stable, so a slot removed and added again in one frame ends with its latest descriptor
+    std::stable_sort(pending.begin(), pending.end(),
+        [](Pending<Info> const& a, Pending<Info> const& b) { return a.index < b.index; });
+    infos.clear();
+    // every run points into infos, which must not reallocate until the update
+    infos.reserve(pending.size());
+    size_t run_start = 0;
+    uint32_t run_first = 0;
+    auto end_run = [&] {
+        if (infos.size() == run_start) return;
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = descriptor_set;
+        write.dstBinding = binding;
+        write.dstArrayElement = run_first;
+        write.descriptorCount = static_cast<uint32_t>(infos.size() - run_start);
+        if constexpr (std::is_same_v<Info, VkDescriptorImageInfo>)
+        {
+            write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write.pImageInfo = infos.data() + run_start;
+        }
+        else
+        {
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write.pBufferInfo = infos.data() + run_start;
+        }
+        writes.push_back(write);
+    };
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        if (i + 1 < pending.size() && pending[i + 1].index == pending[i].index) continue;
+        if (infos.size() != run_start && pending[i].index != run_first + (infos.size() - run_start))
+        {
+            end_run();
+            run_start = infos.size();
+        }
+        if (infos.size() == run_start) run_first = pending[i].index;
+        infos.push_back(pending[i].info);
+    }
+    end_run();
+    pending.clear();
+}
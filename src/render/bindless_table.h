@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "gpu_timeline.h"
+
+class DescriptorLayoutCache;
+
+// One global descriptor set holding every texture and storage buffer, through Vulkan 1.2
+// descriptor indexing.
+//
+// Materials refer to textures and buffers by index instead of by descriptor set, so draws with
+// different materials bind nothing in between and can be merged. The set is bound once per
+// command buffer and updated after binding: descriptors not used by pending work may change at
+// any time. A removed slot is only handed out again once the graphics timeline passed every
+// submission made before the removal and the one being recorded, since those may still read it.
+//
+// Binding 0 is `sampler2D textures[]`, binding 1 is `buffer buffers[]`.
+//
+//     uint32_t albedo = table.add_texture(view, sampler);
+//     // once per frame, before the GPU can read the new descriptors
+//     table.flush();
+//     vkCmdBindDescriptorSets(cmd, ..., 1, &table.set(), 0, nullptr);
+class BindlessTable
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+        DescriptorLayoutCache* layout_cache = nullptr;
+        GpuTimeline* timeline = nullptr;
+        // Clamped to the device's update after bind limits
+        uint32_t max_textures = 16384;
+        uint32_t max_buffers = 16384;
+        VkShaderStageFlags stages = VK_SHADER_STAGE_ALL;
+    };
+
+    static constexpr uint32_t texture_binding = 0;
+    static constexpr uint32_t buffer_binding = 1;
+
+    BindlessTable(CreateDetails create_details);
+    ~BindlessTable() noexcept;
+    BindlessTable(BindlessTable const&) = delete;
+    BindlessTable& operator=(BindlessTable const&) = delete;
+    BindlessTable(BindlessTable&& other) noexcept = delete;
+    BindlessTable& operator=(BindlessTable&& other) noexcept = delete;
+
+    // Returns the slot to index with in shaders, visible to the GPU after the next flush(). Safe to
+    // call from any thread, throws when every slot is taken.
+    uint32_t add_texture(VkImageView view, VkSampler sampler,
+        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    uint32_t add_buffer(
+        VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+    // Give a slot back. Nothing submitted afterwards may use it. Safe to call from any thread.
+    void remove_texture(uint32_t index);
+    void remove_buffer(uint32_t index);
+
+    // Writes the descriptors added since the last flush, in as few writes as there are runs of
+    // consecutive slots. Call on the submitting thread before recording the frame.
+    void flush();
+
+    [[nodiscard]] VkDescriptorSetLayout layout() const noexcept { return set_layout; }
+    [[nodiscard]] VkDescriptorSet const& set() const noexcept { return descriptor_set; }
+    [[nodiscard]] uint32_t texture_capacity() const noexcept { return textures.capacity; }
+    [[nodiscard]] uint32_t buffer_capacity() const noexcept { return buffers.capacity; }
+
+    private:
+    struct Retired
+    {
+        uint32_t index;
+        uint64_t value;
+    };
+    // Slot indices of one binding
+    struct Slots
+    {
+        uint32_t capacity = 0;
+        // never used slots are [next, capacity)
+        uint32_t next = 0;
+        std::vector<uint32_t> free;
+        // in submission order, so only the front needs checking
+        std::deque<Retired> retired;
+    };
+    template <typename Info> struct Pending
+    {
+        uint32_t index;
+        Info info;
+    };
+
+    uint32_t acquire(Slots& slots, const char* what);
+    void release(Slots& slots, uint32_t index);
+    // Appends the writes of `pending` to writes, their descriptors are stored in `infos`
+    template <typename Info>
+    void write_runs(
+        std::vector<Pending<Info>>& pending, uint32_t binding, std::vector<Info>& infos);
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuTimeline* timeline = nullptr;
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+
+    std::mutex mutex;
+    Slots textures;
+    Slots buffers;
+    std::vector<Pending<VkDescriptorImageInfo>> pending_textures;
+    std::vector<Pending<VkDescriptorBufferInfo>> pending_buffers;
+    // only used by flush(), reused between flushes
+    std::vector<VkDescriptorImageInfo> image_infos;
+    std::vector<VkDescriptorBufferInfo> buffer_infos;
+    std::vector<VkWriteDescriptorSet> writes;
+};
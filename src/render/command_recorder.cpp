@@ -0,0 +1,124 @@
+#include "command_recorder.h"
+
+#include <cassert>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "core/profiler.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+// Secondary buffers are allocated in groups, most threads record a few per frame
+constexpr uint32_t allocation_batch = 8;
+} // namespace
+
+CommandRecorder::CommandRecorder(CreateDetails create_details)
+: device(create_details.device), threads(std::max(create_details.thread_count, 1u)),
+  thread_frames(size_t{ std::max(create_details.frame_count, 1u) } * threads)
+{
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    // only ever reset as a whole, so no RESET_COMMAND_BUFFER flag
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = create_details.queue_family_index;
+    for (auto& frame : thread_frames)
+    {
+        VkResult result = vkCreateCommandPool(device, &pool_info, nullptr, &frame.command_pool);
+        if (result != VK_SUCCESS)
+        {
+            destroy_pools();
+            throw std::runtime_error(
+                "Failed to create command recorder: vkCreateCommandPool failed with "s +
+                std::to_string(result));
+        }
+    }
+}
+
+CommandRecorder::~CommandRecorder() noexcept { destroy_pools(); }
+
+void CommandRecorder::destroy_pools() noexcept
+{
+    // destroying a pool frees its command buffers
+    for (auto& frame : thread_frames)
+        if (frame.command_pool != VK_NULL_HANDLE)
+            vkDestroyCommandPool(device, frame.command_pool, nullptr);
+    thread_frames.clear();
+}
+
+void CommandRecorder::begin_frame(uint32_t frame_index)
+{
+    ORANGE_PROFILE_SCOPE("CommandRecorder::begin_frame");
+    assert(frame_index * threads < thread_frames.size() && "frame index out of range");
+    current_frame = frame_index;
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        auto& frame = thread_frame(i);
+        if (frame.used == 0) continue;
+        vkResetCommandPool(device, frame.command_pool, 0);
+        frame.used = 0;
+        frame.recorded.clear();
+    }
+}
+
+VkCommandBuffer CommandRecorder::begin(uint32_t thread_index, uint64_t order,
+    VkCommandBufferInheritanceInfo const* inheritance, VkCommandBufferUsageFlags usage)
+{
+    assert(thread_index < threads && "thread index out of range");
+    auto& frame = thread_frame(thread_index);
+    if (frame.used == frame.command_buffers.size())
+    {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = frame.command_pool;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        alloc_info.commandBufferCount = allocation_batch;
+        frame.command_buffers.resize(frame.used + allocation_batch);
+        VkResult result =
+            vkAllocateCommandBuffers(device, &alloc_info, &frame.command_buffers[frame.used]);
+        if (result != VK_SUCCESS)
+        {
+            frame.command_buffers.resize(frame.used);
+            throw std::runtime_error(
+                "Failed to begin secondary command buffer: vkAllocateCommandBuffers failed with "s +
+                std::to_string(result));
+        }
+    }
+    VkCommandBuffer command_buffer = frame.command_buffers[frame.used++];
+
+    VkCommandBufferInheritanceInfo outside_render_pass{};
+    outside_render_pass.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | usage;
+    begin_info.pInheritanceInfo = inheritance ? inheritance : &outside_render_pass;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    frame.recorded.push_back(Recorded{ order, command_buffer });
+    return command_buffer;
+}
+
+uint32_t CommandRecorder::execute(VkCommandBuffer primary)
+{
+    ORANGE_PROFILE_SCOPE("CommandRecorder::execute");
+    merged.clear();
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        auto& frame = thread_frame(i);
+        merged.insert(merged.end(), frame.recorded.begin(), frame.recorded.end());
+        frame.recorded.clear();
+    }
+    if (merged.empty()) return 0;
+
+    std::stable_sort(merged.begin(), merged.end(),
+        [](Recorded const& a, Recorded const& b) { return a.order < b.order; });
+    merged_buffers.clear();
+    for (auto const& recorded : merged)
+        merged_buffers.push_back(recorded.command_buffer);
+    auto count = static_cast<uint32_t>(merged_buffers.size());
+    vkCmdExecuteCommands(primary, count, merged_buffers.data());
+    ORANGE_PROFILE_COUNTER("Secondary command buffers", count);
+    return count;
+}
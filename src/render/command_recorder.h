@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// Secondary command buffers recorded on many threads, merged into one primary on submit.
+//
+// Every (thread, frame in flight) pair has its own command pool, so threads never share a pool and
+// need no locking. Pools are reset as a whole once the GPU is done with their frame instead of
+// resetting buffers one by one, and their buffers are reused the next time the frame comes around.
+//
+// Each recorded buffer carries an order key, execute() runs them sorted by it. With unique keys,
+// such as the first draw each buffer records, the result doesn't depend on which thread recorded
+// what.
+//
+//     recorder.begin_frame(frame_index);
+//     // on any thread
+//     VkCommandBuffer commands = recorder.begin(thread_index, first_draw);
+//     ...
+//     vkEndCommandBuffer(commands);
+//     // once every thread finished
+//     recorder.execute(primary);
+class CommandRecorder
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        uint32_t queue_family_index = 0;
+        uint32_t frame_count = 2;
+        // Number of distinct thread indices passed to begin()
+        uint32_t thread_count = 1;
+    };
+
+    CommandRecorder(CreateDetails create_details);
+    ~CommandRecorder() noexcept;
+    CommandRecorder(CommandRecorder const&) = delete;
+    CommandRecorder& operator=(CommandRecorder const&) = delete;
+    CommandRecorder(CommandRecorder&& other) noexcept = delete;
+    CommandRecorder& operator=(CommandRecorder&& other) noexcept = delete;
+
+    // Resets the pools of frame_index, the GPU must be done with that frame's last submission
+    void begin_frame(uint32_t frame_index);
+
+    // Begins a secondary command buffer for the calling thread, which has to end it. Only one
+    // thread may use a thread_index at a time. Without `inheritance` the buffer executes outside
+    // of render passes.
+    VkCommandBuffer begin(uint32_t thread_index, uint64_t order,
+        VkCommandBufferInheritanceInfo const* inheritance = nullptr,
+        VkCommandBufferUsageFlags usage = 0);
+
+    // Executes the frame's secondary buffers in order of their key, call once every buffer ended.
+    // Returns the number of buffers executed.
+    uint32_t execute(VkCommandBuffer primary);
+
+    [[nodiscard]] uint32_t thread_count() const noexcept { return threads; }
+
+    private:
+    struct Recorded
+    {
+        uint64_t order;
+        VkCommandBuffer command_buffer;
+    };
+    // One per thread and frame, on its own cache line since neighbours are recorded concurrently
+    struct alignas(64) ThreadFrame
+    {
+        VkCommandPool command_pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> command_buffers;
+        size_t used = 0;
+        std::vector<Recorded> recorded;
+    };
+
+    ThreadFrame& thread_frame(uint32_t thread_index) noexcept
+    {
+        return thread_frames[current_frame * threads + thread_index];
+    }
+    void destroy_pools() noexcept;
+
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t threads = 1;
+    uint32_t current_frame = 0;
+    std::vector<ThreadFrame> thread_frames;
+    // reused by execute()
+    std::vector<Recorded> merged;
+    std::vector<VkCommandBuffer> merged_buffers;
+};
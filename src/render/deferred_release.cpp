@@ -0,0 +1,222 @@
+#include "deferred_release.h"
+
+#include <cassert>
+
+#include "core/profiler.h"
+
+namespace
+{
+// How long the background thread blocks on the timeline before checking whether to stop
+constexpr uint64_t wait_timeout_ns = 100'000'000;
+
+template <typename Handle> Handle from_bits(uint64_t bits) noexcept
+{
+    return reinterpret_cast<Handle>(bits);
+}
+} // namespace
+
+DeferredReleaseQueue::DeferredReleaseQueue(CreateDetails create_details)
+: device(create_details.device), allocator(create_details.allocator),
+  timeline(create_details.timeline)
+{
+    assert(timeline != nullptr && "releases are keyed on a GPU timeline");
+    if (create_details.background_thread) thread = std::thread([this] { run(); });
+}
+
+DeferredReleaseQueue::~DeferredReleaseQueue() noexcept
+{
+    if (thread.joinable())
+    {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        work_condition.notify_one();
+        thread.join();
+    }
+    destroy_all();
+}
+
+void DeferredReleaseQueue::release(VkBuffer buffer, VmaAllocation allocation)
+{
+    assert(allocator != VK_NULL_HANDLE && "releasing VMA objects needs the allocator");
+    if (buffer == VK_NULL_HANDLE && allocation == VK_NULL_HANDLE) return;
+    push(Entry{ Kind::vma_buffer, to_bits(buffer), allocation }, timeline->next_value());
+}
+
+void DeferredReleaseQueue::release(VkImage image, VmaAllocation allocation)
+{
+    assert(allocator != VK_NULL_HANDLE && "releasing VMA objects needs the allocator");
+    if (image == VK_NULL_HANDLE && allocation == VK_NULL_HANDLE) return;
+    push(Entry{ Kind::vma_image, to_bits(image), allocation }, timeline->next_value());
+}
+
+void DeferredReleaseQueue::push(Entry entry, uint64_t value)
+{
+    {
+        std::lock_guard lock(mutex);
+        // Values released out of order join the newest batch, which completes after theirs
+        if (batches.empty() || value > batches.back().value)
+        {
+            Batch batch{ .value = value, .entries = {} };
+            if (!free_entry_vectors.empty())
+            {
+                batch.entries = std::move(free_entry_vectors.back());
+                free_entry_vectors.pop_back();
+            }
+            batches.push_back(std::move(batch));
+        }
+        batches.back().entries.push_back(entry);
+        pending++;
+        ORANGE_PROFILE_COUNTER("Deferred releases", pending);
+    }
+    if (thread.joinable()) work_condition.notify_one();
+}
+
+void DeferredReleaseQueue::collect()
+{
+    if (thread.joinable()) return;
+    take_completed(completed);
+    destroy_batches(completed);
+}
+
+void DeferredReleaseQueue::destroy_all() noexcept
+{
+    std::vector<Batch> remaining;
+    {
+        std::lock_guard lock(mutex);
+        remaining.reserve(batches.size());
+        for (auto& batch : batches)
+            remaining.push_back(std::move(batch));
+        batches.clear();
+    }
+    destroy_batches(remaining);
+}
+
+size_t DeferredReleaseQueue::pending_count() const
+{
+    std::lock_guard lock(mutex);
+    return pending;
+}
+
+void DeferredReleaseQueue::take_completed(std::vector<Batch>& out)
+{
+    // queried once up front, the driver call stays outside the lock
+    uint64_t completed_value = timeline->completed_value();
+    std::lock_guard lock(mutex);
+    while (!batches.empty() && batches.front().value <= completed_value)
+    {
+        out.push_back(std::move(batches.front()));
+        batches.pop_front();
+    }
+}
+
+void DeferredReleaseQueue::destroy_batches(std::vector<Batch>& to_destroy)
+{
+    if (to_destroy.empty()) return;
+    ORANGE_PROFILE_SCOPE("DeferredReleaseQueue::destroy");
+    size_t destroyed = 0;
+    for (auto& batch : to_destroy)
+    {
+        for (auto const& entry : batch.entries)
+            destroy(entry);
+        destroyed += batch.entries.size();
+        batch.entries.clear();
+    }
+
+    std::lock_guard lock(mutex);
+    for (auto& batch : to_destroy)
+        free_entry_vectors.push_back(std::move(batch.entries));
+    to_destroy.clear();
+    pending -= destroyed;
+    ORANGE_PROFILE_COUNTER("Deferred releases", pending);
+}
+
+void DeferredReleaseQueue::destroy(Entry const& entry) noexcept
+{
+    uint64_t bits = entry.handle;
+    switch (entry.kind)
+    {
+        case Kind::buffer:
+            vkDestroyBuffer(device, from_bits<VkBuffer>(bits), nullptr);
+            break;
+        case Kind::buffer_view:
+            vkDestroyBufferView(device, from_bits<VkBufferView>(bits), nullptr);
+            break;
+        case Kind::image:
+            vkDestroyImage(device, from_bits<VkImage>(bits), nullptr);
+            break;
+        case Kind::image_view:
+            vkDestroyImageView(device, from_bits<VkImageView>(bits), nullptr);
+            break;
+        case Kind::sampler:
+            vkDestroySampler(device, from_bits<VkSampler>(bits), nullptr);
+            break;
+        case Kind::shader_module:
+            vkDestroyShaderModule(device, from_bits<VkShaderModule>(bits), nullptr);
+            break;
+        case Kind::pipeline:
+            vkDestroyPipeline(device, from_bits<VkPipeline>(bits), nullptr);
+            break;
+        case Kind::pipeline_layout:
+            vkDestroyPipelineLayout(device, from_bits<VkPipelineLayout>(bits), nullptr);
+            break;
+        case Kind::render_pass:
+            vkDestroyRenderPass(device, from_bits<VkRenderPass>(bits), nullptr);
+            break;
+        case Kind::framebuffer:
+            vkDestroyFramebuffer(device, from_bits<VkFramebuffer>(bits), nullptr);
+            break;
+        case Kind::descriptor_set_layout:
+            vkDestroyDescriptorSetLayout(device, from_bits<VkDescriptorSetLayout>(bits), nullptr);
+            break;
+        case Kind::descriptor_pool:
+            vkDestroyDescriptorPool(device, from_bits<VkDescriptorPool>(bits), nullptr);
+            break;
+        case Kind::command_pool:
+            vkDestroyCommandPool(device, from_bits<VkCommandPool>(bits), nullptr);
+            break;
+        case Kind::query_pool:
+            vkDestroyQueryPool(device, from_bits<VkQueryPool>(bits), nullptr);
+            break;
+        case Kind::semaphore:
+            vkDestroySemaphore(device, from_bits<VkSemaphore>(bits), nullptr);
+            break;
+        case Kind::fence:
+            vkDestroyFence(device, from_bits<VkFence>(bits), nullptr);
+            break;
+        case Kind::event:
+            vkDestroyEvent(device, from_bits<VkEvent>(bits), nullptr);
+            break;
+        case Kind::allocation:
+            vmaFreeMemory(allocator, from_bits<VmaAllocation>(bits));
+            break;
+        case Kind::vma_buffer:
+            vmaDestroyBuffer(allocator, from_bits<VkBuffer>(bits), entry.allocation);
+            break;
+        case Kind::vma_image:
+            vmaDestroyImage(allocator, from_bits<VkImage>(bits), entry.allocation);
+            break;
+    }
+}
+
+void DeferredReleaseQueue::run()
+{
+    Profiler::set_thread_name("Deferred release");
+    std::unique_lock lock(mutex);
+    while (true)
+    {
+        work_condition.wait(lock, [this] { return stop || !batches.empty(); });
+        if (stop) return; // the destructor destroys what is left
+
+        uint64_t value = batches.front().value;
+        lock.unlock();
+        // times out so a stop request isn't stuck behind a value that was never submitted
+        if (timeline->wait(value, wait_timeout_ns))
+        {
+            take_completed(completed);
+            destroy_batches(completed);
+        }
+        lock.lock();
+    }
+}
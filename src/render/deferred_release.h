@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+
+#include "gpu_timeline.h"
+
+// Destroys Vulkan objects once the GPU is done with them.
+//
+// An object released now may still be used by everything submitted so far and by the frame being
+// recorded, so it is tagged with the timeline's next value and destroyed once the GPU signaled
+// it, no matter how many frames that takes. Releases with the same value share a batch and are
+// destroyed together.
+//
+// Any thread may release. Destruction happens in collect(), called once per frame, or on a
+// background thread that waits on the timeline when `background_thread` is set.
+//
+//     release_queue.release(buffer, allocation);
+//     release_queue.release(pipeline);
+class DeferredReleaseQueue
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        // Needed to release VMA allocations
+        VmaAllocator allocator = VK_NULL_HANDLE;
+        GpuTimeline* timeline = nullptr;
+        bool background_thread = false;
+    };
+
+    DeferredReleaseQueue(CreateDetails create_details);
+    // Destroys everything still queued, the GPU must be idle
+    ~DeferredReleaseQueue() noexcept;
+    DeferredReleaseQueue(DeferredReleaseQueue const&) = delete;
+    DeferredReleaseQueue& operator=(DeferredReleaseQueue const&) = delete;
+    DeferredReleaseQueue(DeferredReleaseQueue&& other) noexcept = delete;
+    DeferredReleaseQueue& operator=(DeferredReleaseQueue&& other) noexcept = delete;
+
+    // Destroys `handle` once the next submission, and every one before it, completed
+    template <typename Handle> void release(Handle handle)
+    {
+        release(handle, timeline->next_value());
+    }
+    // Destroys `handle` once the timeline reached `value`
+    template <typename Handle> void release(Handle handle, uint64_t value)
+    {
+        if (handle != VK_NULL_HANDLE)
+            push(Entry{ kind_of<Handle>(), to_bits(handle), nullptr }, value);
+    }
+    // Buffers and images created through VMA, destroyed together with their allocation
+    void release(VkBuffer buffer, VmaAllocation allocation);
+    void release(VkImage image, VmaAllocation allocation);
+
+    // Destroys everything the GPU is done with. Does nothing when a background thread does it.
+    void collect();
+    // Destroys everything, the GPU must be idle
+    void destroy_all() noexcept;
+
+    [[nodiscard]] size_t pending_count() const;
+
+    private:
+    enum class Kind : uint8_t
+    {
+        buffer,
+        buffer_view,
+        image,
+        image_view,
+        sampler,
+        shader_module,
+        pipeline,
+        pipeline_layout,
+        render_pass,
+        framebuffer,
+        descriptor_set_layout,
+        descriptor_pool,
+        command_pool,
+        query_pool,
+        semaphore,
+        fence,
+        event,
+        allocation,       // VmaAllocation only
+        vma_buffer,       // VkBuffer with its VmaAllocation
+        vma_image,        // VkImage with its VmaAllocation
+    };
+    struct Entry
+    {
+        Kind kind;
+        uint64_t handle;
+        VmaAllocation allocation;
+    };
+    struct Batch
+    {
+        uint64_t value = 0;
+        std::vector<Entry> entries;
+    };
+
+    template <typename Handle> static constexpr Kind kind_of()
+    {
+        // Non-dispatchable handles are only distinct types on 64 bit platforms
+        static_assert(sizeof(void*) == 8, "DeferredReleaseQueue needs type safe Vulkan handles");
+        if constexpr (std::is_same_v<Handle, VkBuffer>) return Kind::buffer;
+        else if constexpr (std::is_same_v<Handle, VkBufferView>) return Kind::buffer_view;
+        else if constexpr (std::is_same_v<Handle, VkImage>) return Kind::image;
+        else if constexpr (std::is_same_v<Handle, VkImageView>) return Kind::image_view;
+        else if constexpr (std::is_same_v<Handle, VkSampler>) return Kind::sampler;
+        else if constexpr (std::is_same_v<Handle, VkShaderModule>) return Kind::shader_module;
+        else if constexpr (std::is_same_v<Handle, VkPipeline>) return Kind::pipeline;
+        else if constexpr (std::is_same_v<Handle, VkPipelineLayout>) return Kind::pipeline_layout;
+        else if constexpr (std::is_same_v<Handle, VkRenderPass>) return Kind::render_pass;
+        else if constexpr (std::is_same_v<Handle, VkFramebuffer>) return Kind::framebuffer;
+        else if constexpr (std::is_same_v<Handle, VkDescriptorSetLayout>)
+            return Kind::descriptor_set_layout;
+        else if constexpr (std::is_same_v<Handle, VkDescriptorPool>) return Kind::descriptor_pool;
+        else if constexpr (std::is_same_v<Handle, VkCommandPool>) return Kind::command_pool;
+        else if constexpr (std::is_same_v<Handle, VkQueryPool>) return Kind::query_pool;
+        else if constexpr (std::is_same_v<Handle, VkSemaphore>) return Kind::semaphore;
+        else if constexpr (std::is_same_v<Handle, VkFence>) return Kind::fence;
+        else if constexpr (std::is_same_v<Handle, VkEvent>) return Kind::event;
+        else if constexpr (std::is_same_v<Handle, VmaAllocation>) return Kind::allocation;
+        else static_assert(sizeof(Handle) == 0, "unsupported handle type");
+    }
+    template <typename Handle> static uint64_t to_bits(Handle handle) noexcept
+    {
+        return reinterpret_cast<uint64_t>(handle);
+    }
+
+    void push(Entry entry, uint64_t value);
+    void destroy(Entry const& entry) noexcept;
+    // Moves the batches the GPU is done with into `out`
+    void take_completed(std::vector<Batch>& out);
+    void destroy_batches(std::vector<Batch>& to_destroy);
+    void run();
+
+    VkDevice device = VK_NULL_HANDLE;
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    GpuTimeline* timeline = nullptr;
+
+    mutable std::mutex mutex;
+    std::condition_variable work_condition;
+    std::deque<Batch> batches;
+    std::vector<std::vector<Entry>> free_entry_vectors;
+    size_t pending = 0;
+    // only used by the thread destroying, reused between collections
+    std::vector<Batch> completed;
+    bool stop = false;
+    std::thread thread;
+};
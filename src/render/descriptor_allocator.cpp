@@ -0,0 +1,106 @@
+#include "descriptor_allocator.h"
+
+#include <cassert>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "core/profiler.h"
+
+using namespace std::string_literals;
+
+DescriptorAllocator::DescriptorAllocator(CreateDetails create_details)
+: device(create_details.device), threads(std::max(create_details.thread_count, 1u)),
+  sets_per_pool(std::max(create_details.sets_per_pool, 1u)),
+  thread_frames(size_t{ std::max(create_details.frame_count, 1u) } * threads)
+{
+    for (auto const& ratio : create_details.ratios)
+    {
+        auto count = static_cast<uint32_t>(ratio.per_set * static_cast<float>(sets_per_pool));
+        if (count > 0) pool_sizes.push_back(VkDescriptorPoolSize{ ratio.type, count });
+    }
+}
+
+DescriptorAllocator::~DescriptorAllocator() noexcept
+{
+    // destroying a pool frees its sets
+    for (auto& frame : thread_frames)
+        for (VkDescriptorPool pool : frame.pools)
+            vkDestroyDescriptorPool(device, pool, nullptr);
+}
+
+void DescriptorAllocator::begin_frame(uint32_t frame_index)
+{
+    ORANGE_PROFILE_SCOPE("DescriptorAllocator::begin_frame");
+    assert(frame_index * threads < thread_frames.size() && "frame index out of range");
+    current_frame = frame_index;
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        auto& frame = thread_frame(i);
+        if (!frame.touched) continue;
+        for (size_t pool = 0; pool <= frame.used && pool < frame.pools.size(); pool++)
+            vkResetDescriptorPool(device, frame.pools[pool], 0);
+        frame.used = 0;
+        frame.touched = false;
+    }
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(uint32_t thread_index, VkDescriptorSetLayout layout)
+{
+    assert(thread_index < threads && "thread index out of range");
+    auto& frame = thread_frame(thread_index);
+    frame.touched = true;
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &layout;
+    // a fresh pool failing means the layout doesn't fit in one, retrying wouldn't help
+    bool fresh_pool = false;
+    while (true)
+    {
+        if (frame.used == frame.pools.size())
+        {
+            frame.pools.push_back(create_pool());
+            fresh_pool = true;
+        }
+        alloc_info.descriptorPool = frame.pools[frame.used];
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkResult result = vkAllocateDescriptorSets(device, &alloc_info, &set);
+        if (result == VK_SUCCESS) return set;
+        if ((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) ||
+            fresh_pool)
+            throw std::runtime_error(
+                "Failed to allocate descriptor set: vkAllocateDescriptorSets failed with "s +
+                std::to_string(result));
+        frame.used++;
+        fresh_pool = frame.used == frame.pools.size();
+    }
+}
+
+size_t DescriptorAllocator::pool_count() const noexcept
+{
+    size_t count = 0;
+    for (auto const& frame : thread_frames)
+        count += frame.pools.size();
+    return count;
+}
+
+VkDescriptorPool DescriptorAllocator::create_pool()
+{
+    ORANGE_PROFILE_SCOPE("DescriptorAllocator::create_pool");
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    // sets are never freed one by one, so no FREE_DESCRIPTOR_SET flag
+    pool_info.maxSets = sets_per_pool;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkResult result = vkCreateDescriptorPool(device, &pool_info, nullptr, &pool);
+    if (result != VK_SUCCESS)
+        throw std::runtime_error(
+            "Failed to create descriptor pool: vkCreateDescriptorPool failed with "s +
+            std::to_string(result));
+    return pool;
+}
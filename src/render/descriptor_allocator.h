@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// Per-frame descriptor sets, allocated from pools that are reset wholesale.
+//
+// Like CommandRecorder, every (thread, frame in flight) pair owns its pools, so allocation takes no
+// locks. A pool that runs out is not an error: the next one is taken, created on first use, and
+// all of them are reset together once the GPU is done with the frame. Sets never need freeing and
+// after the first few frames no pools are created at all.
+//
+//     allocator.begin_frame(frame_index);
+//     // on any thread
+//     VkDescriptorSet set = allocator.allocate(thread_index, layout);
+class DescriptorAllocator
+{
+    public:
+    // Descriptors of a type to reserve per set, multiplied by sets_per_pool
+    struct PoolRatio
+    {
+        VkDescriptorType type;
+        float per_set;
+    };
+
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        uint32_t frame_count = 2;
+        // Number of distinct thread indices passed to allocate()
+        uint32_t thread_count = 1;
+        uint32_t sets_per_pool = 256;
+        std::vector<PoolRatio> ratios = {
+            { VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f },
+            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f },
+            { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.f },
+            { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f },
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f },
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f },
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f },
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.f },
+            { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f },
+        };
+    };
+
+    DescriptorAllocator(CreateDetails create_details);
+    ~DescriptorAllocator() noexcept;
+    DescriptorAllocator(DescriptorAllocator const&) = delete;
+    DescriptorAllocator& operator=(DescriptorAllocator const&) = delete;
+    DescriptorAllocator(DescriptorAllocator&& other) noexcept = delete;
+    DescriptorAllocator& operator=(DescriptorAllocator&& other) noexcept = delete;
+
+    // Resets the pools of frame_index, the GPU must be done with that frame's last submission
+    void begin_frame(uint32_t frame_index);
+
+    // A set valid until frame_index comes around again. Only one thread may use a thread_index at
+    // a time.
+    VkDescriptorSet allocate(uint32_t thread_index, VkDescriptorSetLayout layout);
+
+    // Pools created so far, across every thread and frame
+    [[nodiscard]] size_t pool_count() const noexcept;
+
+    private:
+    // One per thread and frame, on its own cache line since neighbours allocate concurrently
+    struct alignas(64) ThreadFrame
+    {
+        std::vector<VkDescriptorPool> pools;
+        // pools[0, used] were allocated from since the last reset, `used` is the current one
+        size_t used = 0;
+        bool touched = false;
+    };
+
+    ThreadFrame& thread_frame(uint32_t thread_index) noexcept
+    {
+        return thread_frames[current_frame * threads + thread_index];
+    }
+    VkDescriptorPool create_pool();
+
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t threads = 1;
+    uint32_t current_frame = 0;
+    std::vector<VkDescriptorPoolSize> pool_sizes;
+    uint32_t sets_per_pool = 256;
+    std::vector<ThreadFrame> thread_frames;
+};
@@ -0,0 +1,134 @@
+#include "descriptor_layout_cache.h"
+
+#include <cassert>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+using namespace std::string_literals;
+
+namespace
+{
+size_t hash_combine(size_t seed, uint64_t value) noexcept
+{
+    return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
+} // namespace
+
+size_t DescriptorLayoutCache::KeyHash::operator()(Key const& key) const noexcept
+{
+    size_t hash = hash_combine(0, key.flags);
+    for (auto const& binding : key.bindings)
+    {
+        hash = hash_combine(hash, binding.binding);
+        hash = hash_combine(hash, static_cast<uint64_t>(binding.type));
+        hash = hash_combine(hash, binding.count);
+        hash = hash_combine(hash, binding.stages);
+        hash = hash_combine(hash, binding.flags);
+        for (VkSampler sampler : binding.immutable_samplers)
+        {
+            // a pointer or a 64 bit integer depending on the platform
+            uint64_t bits = 0;
+            std::memcpy(&bits, &sampler, sizeof(sampler));
+            hash = hash_combine(hash, bits);
+        }
+    }
+    return hash;
+}
+
+DescriptorLayoutCache::DescriptorLayoutCache(CreateDetails create_details)
+: device(create_details.device)
+{
+}
+
+DescriptorLayoutCache::~DescriptorLayoutCache() noexcept
+{
+    for (auto const& [key, layout] : layouts)
+        vkDestroyDescriptorSetLayout(device, layout, nullptr);
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::get(
+    std::span<const VkDescriptorSetLayoutBinding> bindings,
+    VkDescriptorSetLayoutCreateFlags flags,
+    std::span<const VkDescriptorBindingFlags> binding_flags)
+{
+    assert((binding_flags.empty() || binding_flags.size() == bindings.size()) &&
+           "binding_flags needs one entry per binding");
+    Key key{ .flags = flags, .bindings = {} };
+    key.bindings.reserve(bindings.size());
+    for (size_t i = 0; i < bindings.size(); i++)
+    {
+        auto const& binding = bindings[i];
+        // Vulkan ignores pImmutableSamplers for other descriptor types
+        bool samples = binding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+                       binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        std::vector<VkSampler> immutable_samplers;
+        if (samples && binding.pImmutableSamplers != nullptr)
+            immutable_samplers.assign(binding.pImmutableSamplers,
+                binding.pImmutableSamplers + binding.descriptorCount);
+        key.bindings.push_back(Binding{ .binding = binding.binding,
+            .type = binding.descriptorType,
+            .count = binding.descriptorCount,
+            .stages = binding.stageFlags,
+            .flags = binding_flags.empty() ? 0 : binding_flags[i],
+            .immutable_samplers = std::move(immutable_samplers) });
+    }
+    std::sort(key.bindings.begin(), key.bindings.end(),
+        [](Binding const& a, Binding const& b) { return a.binding < b.binding; });
+
+    std::lock_guard lock(mutex);
+    auto it = layouts.find(key);
+    if (it != layouts.end()) return it->second;
+    // created under the lock, two threads asking for a new layout must not both create it
+    VkDescriptorSetLayout layout = create(key);
+    layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+size_t DescriptorLayoutCache::size() const
+{
+    std::lock_guard lock(mutex);
+    return layouts.size();
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::create(Key const& key)
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    std::vector<VkDescriptorBindingFlags> binding_flags;
+    bool has_binding_flags = false;
+    for (auto const& binding : key.bindings)
+    {
+        VkDescriptorSetLayoutBinding layout_binding{};
+        layout_binding.binding = binding.binding;
+        layout_binding.descriptorType = binding.type;
+        layout_binding.descriptorCount = binding.count;
+        layout_binding.stageFlags = binding.stages;
+        layout_binding.pImmutableSamplers =
+            binding.immutable_samplers.empty() ? nullptr : binding.immutable_samplers.data();
+        bindings.push_back(layout_binding);
+        binding_flags.push_back(binding.flags);
+        has_binding_flags = has_binding_flags || binding.flags != 0;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info{};
+    flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flags_info.bindingCount = static_cast<uint32_t>(binding_flags.size());
+    flags_info.pBindingFlags = binding_flags.data();
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.pNext = has_binding_flags ? &flags_info : nullptr;
+    layout_info.flags = key.flags;
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkResult result = vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &layout);
+    if (result != VK_SUCCESS)
+        throw std::runtime_error(
+            "Failed to create descriptor set layout: vkCreateDescriptorSetLayout failed with "s +
+            std::to_string(result));
+    return layout;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// Hash-consed descriptor set layouts.
+//
+// Equal binding lists get the same VkDescriptorSetLayout, no matter the order the bindings are
+// listed in, so pipelines built from the same shaders share layouts and compatible sets. Layouts
+// live as long as the cache. Safe to use from any thread.
+class DescriptorLayoutCache
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+    };
+
+    DescriptorLayoutCache(CreateDetails create_details);
+    ~DescriptorLayoutCache() noexcept;
+    DescriptorLayoutCache(DescriptorLayoutCache const&) = delete;
+    DescriptorLayoutCache& operator=(DescriptorLayoutCache const&) = delete;
+    DescriptorLayoutCache(DescriptorLayoutCache&& other) noexcept = delete;
+    DescriptorLayoutCache& operator=(DescriptorLayoutCache&& other) noexcept = delete;
+
+    // `binding_flags` is empty or has one entry per binding, for descriptor indexing
+    VkDescriptorSetLayout get(std::span<const VkDescriptorSetLayoutBinding> bindings,
+        VkDescriptorSetLayoutCreateFlags flags = 0,
+        std::span<const VkDescriptorBindingFlags> binding_flags = {});
+
+    [[nodiscard]] size_t size() const;
+
+    private:
+    struct Binding
+    {
+        uint32_t binding;
+        VkDescriptorType type;
+        uint32_t count;
+        VkShaderStageFlags stages;
+        VkDescriptorBindingFlags flags;
+        // copied, the caller's array may be gone or reused by the next get()
+        std::vector<VkSampler> immutable_samplers;
+
+        bool operator==(Binding const& other) const noexcept = default;
+    };
+    struct Key
+    {
+        VkDescriptorSetLayoutCreateFlags flags = 0;
+        // sorted by binding number
+        std::vector<Binding> bindings;
+
+        bool operator==(Key const& other) const noexcept = default;
+    };
+    struct KeyHash
+    {
+        size_t operator()(Key const& key) const noexcept;
+    };
+
+    VkDescriptorSetLayout create(Key const& key);
+
+    VkDevice device = VK_NULL_HANDLE;
+    mutable std::mutex mutex;
+    std::unordered_map<Key, VkDescriptorSetLayout, KeyHash> layouts;
+};
@@ -0,0 +1,131 @@
+#include "frame_readback.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "core/profiler.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+bool is_bgra(VkFormat format) noexcept
+{
+    return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+bool is_rgba(VkFormat format) noexcept
+{
+    return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+} // namespace
+
+FrameReadback::FrameReadback(CreateDetails create_details)
+: allocator(create_details.allocator), memory(create_details.memory),
+  image_extent(create_details.extent),
+  description(ImageDescription{ .width = create_details.extent.width,
+      .height = create_details.extent.height,
+      .channels = 4,
+      .bgr_order = is_bgra(create_details.format) })
+{
+    if (!is_rgba(create_details.format) && !is_bgra(create_details.format))
+        throw std::runtime_error("Failed to create frame readback: unsupported format "s +
+                                 std::to_string(create_details.format));
+
+    slots.resize(create_details.slot_count);
+    for (auto& slot : slots)
+    {
+        VkBufferCreateInfo buffer_info{};
+        buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buffer_info.size = description.byte_size();
+        buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        // random access asks for host cached memory, reading uncached memory is very slow
+        VmaAllocationCreateInfo allocation_info{};
+        allocation_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+        allocation_info.flags =
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        VmaAllocationInfo allocation_result{};
+        VkResult buffer_ret = vmaCreateBuffer(allocator,
+            &buffer_info,
+            &allocation_info,
+            &slot.buffer,
+            &slot.allocation,
+            &allocation_result);
+        if (buffer_ret != VK_SUCCESS)
+        {
+            destroy();
+            throw std::runtime_error(
+                "Failed to create frame readback: vmaCreateBuffer failed with "s +
+                std::to_string(buffer_ret));
+        }
+        slot.mapped = static_cast<const std::byte*>(allocation_result.pMappedData);
+        if (memory) memory->track(slot.allocation, MemoryCategory::staging);
+    }
+}
+
+FrameReadback::~FrameReadback() noexcept { destroy(); }
+
+void FrameReadback::destroy() noexcept
+{
+    for (auto& slot : slots)
+    {
+        if (slot.buffer != VK_NULL_HANDLE)
+        {
+            if (memory) memory->untrack(slot.allocation);
+            vmaDestroyBuffer(allocator, slot.buffer, slot.allocation);
+        }
+        slot = Slot{};
+    }
+}
+
+void FrameReadback::record_copy(
+    VkCommandBuffer command_buffer, VkImage image, uint32_t slot, uint64_t frame_number)
+{
+    Slot& target = slots[slot];
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { image_extent.width, image_extent.height, 1 };
+    vkCmdCopyImageToBuffer(
+        command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target.buffer, 1, &region);
+
+    // makes the copy visible to host reads once the fence signaled
+    VkBufferMemoryBarrier to_host{};
+    to_host.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    to_host.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    to_host.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    to_host.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_host.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_host.buffer = target.buffer;
+    to_host.offset = 0;
+    to_host.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        0,
+        nullptr,
+        1,
+        &to_host,
+        0,
+        nullptr);
+
+    target.frame_number = frame_number;
+    target.pending = true;
+}
+
+std::optional<FrameReadback::Frame> FrameReadback::take(uint32_t slot)
+{
+    Slot& source = slots[slot];
+    if (!source.pending) return std::nullopt;
+    source.pending = false;
+
+    ORANGE_PROFILE_SCOPE("FrameReadback::take");
+    // no-op on host coherent memory
+    vmaInvalidateAllocation(allocator, source.allocation, 0, VK_WHOLE_SIZE);
+    return Frame{ .frame_number = source.frame_number,
+        .image = description,
+        .pixels = std::span(source.mapped, description.byte_size()) };
+}
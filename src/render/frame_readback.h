@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+
+#include "core/image_writer.h"
+#include "gpu_memory.h"
+
+// Copies rendered images into persistently mapped host buffers without stalling the GPU.
+//
+// There is one buffer per slot, and the renderer uses its frame index as the slot. A frame records
+// its copy into its slot, and the pixels are picked up with take() the next time that frame index
+// comes around, after its fence was waited on anyway. The CPU never waits for the frame it just
+// submitted, readback runs as many frames behind as there are frames in flight.
+class FrameReadback
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        VmaAllocator allocator = VK_NULL_HANDLE;
+        VkExtent2D extent = { 1280, 720 };
+        // 8 bit, 4 channel color formats (RGBA or BGRA)
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+        uint32_t slot_count = 2;
+        // Optional, counts the readback buffers as staging memory
+        GpuMemory* memory = nullptr;
+    };
+
+    struct Frame
+    {
+        uint64_t frame_number = 0;
+        ImageDescription image;
+        std::span<const std::byte> pixels;
+    };
+
+    FrameReadback(CreateDetails create_details);
+    ~FrameReadback() noexcept;
+    FrameReadback(FrameReadback const&) = delete;
+    FrameReadback& operator=(FrameReadback const&) = delete;
+    FrameReadback(FrameReadback&& other) noexcept = delete;
+    FrameReadback& operator=(FrameReadback&& other) noexcept = delete;
+
+    [[nodiscard]] uint32_t slot_count() const noexcept
+    {
+        return static_cast<uint32_t>(slots.size());
+    }
+
+    // Records copying `image`, which must be in TRANSFER_SRC_OPTIMAL, into `slot`
+    void record_copy(
+        VkCommandBuffer command_buffer, VkImage image, uint32_t slot, uint64_t frame_number);
+
+    // Call once the submission that recorded the copy into `slot` completed. Returns the copied
+    // frame, its pixels stay valid until the next record_copy() into the slot. Returns nothing if
+    // no copy is pending in the slot.
+    [[nodiscard]] std::optional<Frame> take(uint32_t slot);
+
+    private:
+    struct Slot
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        const std::byte* mapped = nullptr;
+        uint64_t frame_number = 0;
+        bool pending = false;
+    };
+
+    void destroy() noexcept;
+
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    GpuMemory* memory = nullptr;
+    VkExtent2D image_extent{};
+    ImageDescription description;
+    std::vector<Slot> slots;
+};
@@ -0,0 +1,322 @@
+#include "gpu_memory.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "core/profiler.h"
+#include "gpu_timeline.h"
+
+namespace
+{
+// Checking for fragmentation walks every block, so it only happens every few seconds
+constexpr uint64_t defragment_check_interval = 256;
+
+double to_mib(VkDeviceSize bytes) noexcept
+{
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+} // namespace
+
+const char* to_string(MemoryCategory category) noexcept
+{
+    switch (category)
+    {
+        case MemoryCategory::mesh: return "meshes";
+        case MemoryCategory::texture: return "textures";
+        case MemoryCategory::render_target: return "render targets";
+        case MemoryCategory::staging: return "staging";
+        case MemoryCategory::other: return "other";
+    }
+    return "unknown";
+}
+
+GpuMemory::GpuMemory(CreateDetails create_details)
+: allocator(create_details.allocator), budget_warning(create_details.budget_warning),
+  defragment_threshold(create_details.defragment_threshold),
+  max_bytes_per_pass(create_details.max_bytes_per_pass),
+  max_moves_per_pass(create_details.max_moves_per_pass)
+{
+    const VkPhysicalDeviceMemoryProperties* properties = nullptr;
+    vmaGetMemoryProperties(allocator, &properties);
+    memory_properties = *properties;
+    budgets.resize(memory_properties.memoryHeapCount);
+    over_budget.resize(memory_properties.memoryHeapCount);
+    vmaGetHeapBudgets(allocator, budgets.data());
+}
+
+GpuMemory::~GpuMemory() noexcept { end_defragmentation(); }
+
+void GpuMemory::track(VmaAllocation allocation, MemoryCategory category, Relocate relocate)
+{
+    if (allocation == VK_NULL_HANDLE || category == MemoryCategory::other) return;
+    VmaAllocationInfo info{};
+    vmaGetAllocationInfo(allocator, allocation, &info);
+    std::lock_guard lock(mutex);
+    auto [it, inserted] =
+        tracked.try_emplace(allocation, Tracked{ category, info.size, std::move(relocate) });
+    if (!inserted) return;
+    auto& counter = counters[static_cast<size_t>(category)];
+    counter.allocation_count++;
+    counter.bytes += info.size;
+    counter.peak_bytes = std::max(counter.peak_bytes, counter.bytes);
+}
+
+void GpuMemory::untrack(VmaAllocation allocation)
+{
+    if (allocation == VK_NULL_HANDLE) return;
+    std::lock_guard lock(mutex);
+    auto it = tracked.find(allocation);
+    if (it == tracked.end()) return;
+    auto& counter = counters[static_cast<size_t>(it->second.category)];
+    counter.allocation_count--;
+    counter.bytes -= it->second.size;
+    tracked.erase(it);
+}
+
+void GpuMemory::begin_frame(uint64_t frame_number)
+{
+    ORANGE_PROFILE_SCOPE("GpuMemory::begin_frame");
+    current_frame = frame_number;
+    // VMA refreshes its budget from the driver when the frame index changes
+    vmaSetCurrentFrameIndex(allocator, static_cast<uint32_t>(frame_number));
+    VkDeviceSize device_usage = 0;
+    std::lock_guard lock(mutex);
+    vmaGetHeapBudgets(allocator, budgets.data());
+    for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++)
+    {
+        if (!(memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+        device_usage += budgets[i].usage;
+        bool over = static_cast<double>(budgets[i].usage) >
+                    static_cast<double>(budgets[i].budget) * static_cast<double>(budget_warning);
+        if (over && !over_budget[i])
+            spdlog::warn("GPU memory heap {} uses {:.1f} MiB of its {:.1f} MiB budget",
+                i,
+                to_mib(budgets[i].usage),
+                to_mib(budgets[i].budget));
+        over_budget[i] = over;
+    }
+    ORANGE_PROFILE_COUNTER("GPU memory used (MiB)", device_usage >> 20);
+}
+
+std::vector<GpuMemory::HeapReport> GpuMemory::heaps() const
+{
+    std::vector<HeapReport> reports;
+    std::lock_guard lock(mutex);
+    for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++)
+    {
+        auto const& budget = budgets[i];
+        reports.push_back(HeapReport{ .heap_index = i,
+            .device_local =
+                (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+            .size = memory_properties.memoryHeaps[i].size,
+            .usage = budget.usage,
+            .budget = budget.budget,
+            .block_count = budget.statistics.blockCount,
+            .allocation_count = budget.statistics.allocationCount,
+            .block_bytes = budget.statistics.blockBytes,
+            .allocation_bytes = budget.statistics.allocationBytes });
+    }
+    return reports;
+}
+
+std::array<GpuMemory::CategoryReport, memory_category_count> GpuMemory::categories() const
+{
+    std::array<CategoryReport, memory_category_count> reports{};
+    std::lock_guard lock(mutex);
+    uint64_t tracked_count = 0;
+    VkDeviceSize tracked_bytes = 0;
+    for (size_t i = 0; i < memory_category_count; i++)
+    {
+        reports[i] = CategoryReport{ counters[i].allocation_count,
+            counters[i].bytes,
+            counters[i].peak_bytes };
+        tracked_count += counters[i].allocation_count;
+        tracked_bytes += counters[i].bytes;
+    }
+    uint64_t total_count = 0;
+    VkDeviceSize total_bytes = 0;
+    for (auto const& budget : budgets)
+    {
+        total_count += budget.statistics.allocationCount;
+        total_bytes += budget.statistics.allocationBytes;
+    }
+    auto& other = reports[static_cast<size_t>(MemoryCategory::other)];
+    other.allocation_count = total_count - std::min(total_count, tracked_count);
+    other.bytes = total_bytes - std::min(total_bytes, tracked_bytes);
+    other.peak_bytes = other.bytes;
+    return reports;
+}
+
+std::vector<GpuMemory::FragmentationReport> GpuMemory::fragmentation() const
+{
+    ORANGE_PROFILE_SCOPE("GpuMemory::fragmentation");
+    VmaTotalStatistics statistics{};
+    vmaCalculateStatistics(allocator, &statistics);
+    std::vector<FragmentationReport> reports;
+    for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++)
+    {
+        auto const& heap = statistics.memoryHeap[i];
+        if (heap.statistics.blockCount == 0) continue;
+        FragmentationReport report{};
+        report.heap_index = i;
+        report.unused_bytes = heap.statistics.blockBytes - heap.statistics.allocationBytes;
+        report.unused_range_count = heap.unusedRangeCount;
+        report.largest_unused_range = heap.unusedRangeCount > 0 ? heap.unusedRangeSizeMax : 0;
+        if (report.unused_bytes > 0)
+            report.fragmentation =
+                1.f - static_cast<float>(static_cast<double>(report.largest_unused_range) /
+                                         static_cast<double>(report.unused_bytes));
+        reports.push_back(report);
+    }
+    return reports;
+}
+
+void GpuMemory::log_report() const
+{
+    for (auto const& heap : heaps())
+        spdlog::info("GPU heap {}{}: {:.1f} / {:.1f} MiB budget, {} blocks holding {} allocations "
+                     "({:.1f} of {:.1f} MiB)",
+            heap.heap_index,
+            heap.device_local ? " (device local)" : "",
+            to_mib(heap.usage),
+            to_mib(heap.budget),
+            heap.block_count,
+            heap.allocation_count,
+            to_mib(heap.allocation_bytes),
+            to_mib(heap.block_bytes));
+    auto reports = categories();
+    for (size_t i = 0; i < memory_category_count; i++)
+        spdlog::info("GPU memory {}: {} allocations, {:.1f} MiB, peak {:.1f} MiB",
+            to_string(static_cast<MemoryCategory>(i)),
+            reports[i].allocation_count,
+            to_mib(reports[i].bytes),
+            to_mib(reports[i].peak_bytes));
+    for (auto const& heap : fragmentation())
+        spdlog::info("GPU heap {} fragmentation: {:.1f} MiB unused in {} ranges, largest {:.1f} "
+                     "MiB ({:.0f}%)",
+            heap.heap_index,
+            to_mib(heap.unused_bytes),
+            heap.unused_range_count,
+            to_mib(heap.largest_unused_range),
+            heap.fragmentation * 100.f);
+}
+
+bool GpuMemory::should_defragment() const
+{
+    auto reports = fragmentation();
+    return std::any_of(reports.begin(), reports.end(), [this](FragmentationReport const& heap) {
+        return heap.unused_bytes >= defragment_threshold && heap.fragmentation > 0.5f;
+    });
+}
+
+void GpuMemory::defragment(VkCommandBuffer command_buffer, GpuTimeline& timeline, bool idle)
+{
+    ORANGE_PROFILE_SCOPE("GpuMemory::defragment");
+    if (pass_in_flight)
+    {
+        if (!timeline.is_complete(pass_value)) return;
+        // frees the old locations, nothing uses them anymore
+        pass_in_flight = false;
+        if (vmaEndDefragmentationPass(allocator, context, &pass) == VK_SUCCESS)
+        {
+            end_defragmentation();
+            return;
+        }
+    }
+    if (!idle) return;
+    if (context == VK_NULL_HANDLE)
+    {
+        if (current_frame < last_check_frame + defragment_check_interval) return;
+        last_check_frame = current_frame;
+        if (!should_defragment()) return;
+        VmaDefragmentationInfo info{};
+        info.maxBytesPerPass = max_bytes_per_pass;
+        info.maxAllocationsPerPass = max_moves_per_pass;
+        if (vmaBeginDefragmentation(allocator, &info, &context) != VK_SUCCESS)
+        {
+            context = VK_NULL_HANDLE;
+            return;
+        }
+        spdlog::info("Defragmenting GPU memory");
+    }
+
+    VkResult result = vmaBeginDefragmentationPass(allocator, context, &pass);
+    if (result != VK_INCOMPLETE)
+    {
+        // VK_SUCCESS, nothing left to move
+        end_defragmentation();
+        return;
+    }
+
+    // the moved resources were last written by earlier submissions
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+    uint32_t moved = 0;
+    for (uint32_t i = 0; i < pass.moveCount; i++)
+    {
+        auto& move = pass.pMoves[i];
+        Relocate relocate;
+        {
+            std::lock_guard lock(mutex);
+            auto it = tracked.find(move.srcAllocation);
+            if (it != tracked.end()) relocate = it->second.relocate;
+        }
+        if (relocate && relocate(command_buffer, move.dstTmpAllocation))
+            moved++;
+        else
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+    }
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+    ORANGE_PROFILE_COUNTER("Defragmentation moves", moved);
+
+    if (moved == 0)
+    {
+        // no copies to wait for
+        if (vmaEndDefragmentationPass(allocator, context, &pass) == VK_SUCCESS)
+            end_defragmentation();
+        return;
+    }
+    pass_in_flight = true;
+    pass_value = timeline.next_value();
+}
+
+void GpuMemory::end_defragmentation() noexcept
+{
+    if (context == VK_NULL_HANDLE) return;
+    if (pass_in_flight) vmaEndDefragmentationPass(allocator, context, &pass);
+    pass_in_flight = false;
+    VmaDefragmentationStats stats{};
+    vmaEndDefragmentation(allocator, context, &stats);
+    context = VK_NULL_HANDLE;
+    if (stats.allocationsMoved > 0)
+        spdlog::info("Defragmented GPU memory: moved {} allocations ({:.1f} MiB), freed {} blocks "
+                     "({:.1f} MiB)",
+            stats.allocationsMoved,
+            to_mib(stats.bytesMoved),
+            stats.deviceMemoryBlocksFreed,
+            to_mib(stats.bytesFreed));
+}
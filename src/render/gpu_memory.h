@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+
+class GpuTimeline;
+
+enum class MemoryCategory : uint8_t
+{
+    mesh,
+    texture,
+    render_target,
+    staging,
+    // Everything not tracked, derived from VMA's totals
+    other,
+};
+inline constexpr size_t memory_category_count = 5;
+const char* to_string(MemoryCategory category) noexcept;
+
+// What the GPU memory is used for, how close each heap is to its budget, and defragmentation.
+//
+// Budgets come from VK_EXT_memory_budget when the allocator was created with it, otherwise VMA
+// estimates them. Allocations tracked with a category count towards it until untracked, which
+// their owner does right before freeing them.
+//
+// Defragmentation runs in small passes spread over frames, only moving allocations tracked with
+// a relocate function, since only their owner can recreate and copy the resource bound to them.
+//
+//     memory.track(allocation, MemoryCategory::mesh);
+//     ...
+//     memory.untrack(allocation);
+//     vmaDestroyBuffer(allocator, buffer, allocation);
+class GpuMemory
+{
+    public:
+    struct CreateDetails
+    {
+        VmaAllocator allocator = VK_NULL_HANDLE;
+        // Warns once a device local heap's usage crosses this fraction of its budget
+        float budget_warning = 0.9f;
+        // Defragmentation starts once this many bytes in a heap's blocks are unused and the
+        // largest free range holds less than half of them
+        VkDeviceSize defragment_threshold = VkDeviceSize{ 64 } << 20;
+        VkDeviceSize max_bytes_per_pass = VkDeviceSize{ 16 } << 20;
+        uint32_t max_moves_per_pass = 64;
+    };
+
+    struct HeapReport
+    {
+        uint32_t heap_index = 0;
+        bool device_local = false;
+        VkDeviceSize size = 0;
+        // By this process, and what it can use without hurting the rest of the system
+        VkDeviceSize usage = 0;
+        VkDeviceSize budget = 0;
+        uint32_t block_count = 0;
+        uint32_t allocation_count = 0;
+        VkDeviceSize block_bytes = 0;
+        VkDeviceSize allocation_bytes = 0;
+    };
+    struct CategoryReport
+    {
+        uint64_t allocation_count = 0;
+        VkDeviceSize bytes = 0;
+        VkDeviceSize peak_bytes = 0;
+    };
+    struct FragmentationReport
+    {
+        uint32_t heap_index = 0;
+        // Free space inside the allocated blocks
+        VkDeviceSize unused_bytes = 0;
+        uint32_t unused_range_count = 0;
+        VkDeviceSize largest_unused_range = 0;
+        // 0 when the free space is one range, close to 1 when it is scattered in small ones
+        float fragmentation = 0.f;
+    };
+
+    // Recreates the resource bound to the allocation on `destination`, with vmaBindBufferMemory or
+    // vmaBindImageMemory, records copying its contents in command_buffer and switches to it. The
+    // old handle, not the allocation, goes to the DeferredReleaseQueue. Returns false to leave the
+    // allocation where it is.
+    using Relocate = std::function<bool(VkCommandBuffer command_buffer, VmaAllocation destination)>;
+
+    GpuMemory(CreateDetails create_details);
+    // Ends a defragmentation in progress, the GPU must be idle
+    ~GpuMemory() noexcept;
+    GpuMemory(GpuMemory const&) = delete;
+    GpuMemory& operator=(GpuMemory const&) = delete;
+    GpuMemory(GpuMemory&& other) noexcept = delete;
+    GpuMemory& operator=(GpuMemory&& other) noexcept = delete;
+
+    // Safe to call from any thread. A relocatable allocation must not be freed while a
+    // defragmentation pass is in flight, check defragmenting().
+    void track(VmaAllocation allocation, MemoryCategory category, Relocate relocate = {});
+    // Does nothing for allocations that weren't tracked
+    void untrack(VmaAllocation allocation);
+
+    // Updates the budgets and warns about heaps running out. Call once per frame.
+    void begin_frame(uint64_t frame_number);
+
+    // Cheap, from the budgets of the last begin_frame()
+    [[nodiscard]] std::vector<HeapReport> heaps() const;
+    [[nodiscard]] std::array<CategoryReport, memory_category_count> categories() const;
+    // Walks every block, meant for reports rather than every frame
+    [[nodiscard]] std::vector<FragmentationReport> fragmentation() const;
+    // Logs heaps, categories and fragmentation
+    void log_report() const;
+
+    // Continues defragmentation, recording this frame's moves into command_buffer, which the
+    // frame signaling `timeline` at its next value submits. New defragmentations and passes only
+    // start when `idle`, a pass in flight is finished regardless.
+    void defragment(VkCommandBuffer command_buffer, GpuTimeline& timeline, bool idle);
+    [[nodiscard]] bool defragmenting() const noexcept { return context != VK_NULL_HANDLE; }
+
+    private:
+    struct Tracked
+    {
+        MemoryCategory category;
+        VkDeviceSize size;
+        Relocate relocate;
+    };
+    // Guarded by the mutex
+    struct Counter
+    {
+        uint64_t allocation_count = 0;
+        VkDeviceSize bytes = 0;
+        VkDeviceSize peak_bytes = 0;
+    };
+
+    bool should_defragment() const;
+    void end_defragmentation() noexcept;
+
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    float budget_warning = 0.9f;
+    VkDeviceSize defragment_threshold = 0;
+    VkDeviceSize max_bytes_per_pass = 0;
+    uint32_t max_moves_per_pass = 0;
+    VkPhysicalDeviceMemoryProperties memory_properties{};
+
+    mutable std::mutex mutex;
+    std::unordered_map<VmaAllocation, Tracked> tracked;
+    std::array<Counter, memory_category_count> counters{};
+    std::vector<VmaBudget> budgets;
+    std::vector<bool> over_budget;
+
+    // only used by defragment()
+    VmaDefragmentationContext context = VK_NULL_HANDLE;
+    VmaDefragmentationPassMoveInfo pass{};
+    bool pass_in_flight = false;
+    uint64_t pass_value = 0;
+    uint64_t last_check_frame = 0;
+    uint64_t current_frame = 0;
+};
@@ -0,0 +1,125 @@
+#include "gpu_profiler.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+using namespace std::string_literals;
+
+GpuProfiler::GpuProfiler(CreateDetails create_details)
+: device(create_details.device), max_scopes(create_details.max_scopes_per_frame)
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(create_details.physical_device, &properties);
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        create_details.physical_device, &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        create_details.physical_device, &family_count, families.data());
+
+    uint32_t valid_bits = create_details.queue_family_index < family_count
+                              ? families[create_details.queue_family_index].timestampValidBits
+                              : 0;
+    if (valid_bits == 0 || properties.limits.timestampPeriod <= 0.0f) return;
+    timestamp_mask = valid_bits >= 64 ? UINT64_MAX : (uint64_t{ 1 } << valid_bits) - 1;
+    ns_per_tick = static_cast<double>(properties.limits.timestampPeriod);
+
+    frames.resize(create_details.frame_count);
+    for (auto& frame : frames)
+    {
+        VkQueryPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        pool_info.queryCount = max_scopes * 2;
+        VkResult result = vkCreateQueryPool(device, &pool_info, nullptr, &frame.query_pool);
+        if (result != VK_SUCCESS)
+        {
+            destroy_query_pools();
+            throw std::runtime_error(
+                "Failed to create GPU profiler: vkCreateQueryPool failed with "s +
+                std::to_string(result));
+        }
+        frame.scope_names.reserve(max_scopes);
+    }
+    results.resize(max_scopes * 2);
+    track = Profiler::create_track("GPU");
+}
+
+GpuProfiler::~GpuProfiler() noexcept { destroy_query_pools(); }
+
+void GpuProfiler::destroy_query_pools() noexcept
+{
+    for (auto& frame : frames)
+    {
+        if (frame.query_pool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(device, frame.query_pool, nullptr);
+        frame.query_pool = VK_NULL_HANDLE;
+    }
+}
+
+void GpuProfiler::begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index)
+{
+    if (!is_supported()) return;
+    assert(frame_index < frames.size());
+    current_frame = frame_index;
+    Frame& frame = frames[current_frame];
+    report(frame);
+    frame.scope_names.clear();
+    frame.submit_ns = -1;
+    vkCmdResetQueryPool(command_buffer, frame.query_pool, 0, max_scopes * 2);
+}
+
+void GpuProfiler::end_frame() noexcept
+{
+    if (!is_supported()) return;
+    frames[current_frame].submit_ns = Profiler::now_ns();
+}
+
+uint32_t GpuProfiler::begin_scope(VkCommandBuffer command_buffer, const char* name)
+{
+    if (!is_supported()) return UINT32_MAX;
+    Frame& frame = frames[current_frame];
+    if (frame.scope_names.size() >= max_scopes) return UINT32_MAX;
+    auto scope = static_cast<uint32_t>(frame.scope_names.size());
+    frame.scope_names.push_back(name);
+    vkCmdWriteTimestamp(
+        command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.query_pool, scope * 2);
+    return scope;
+}
+
+void GpuProfiler::end_scope(VkCommandBuffer command_buffer, uint32_t scope) noexcept
+{
+    if (scope == UINT32_MAX) return;
+    vkCmdWriteTimestamp(command_buffer,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        frames[current_frame].query_pool,
+        scope * 2 + 1);
+}
+
+void GpuProfiler::report(Frame& frame)
+{
+    // never submitted, or nothing recorded
+    if (frame.submit_ns < 0 || frame.scope_names.empty()) return;
+
+    auto query_count = static_cast<uint32_t>(frame.scope_names.size() * 2);
+    VkResult result = vkGetQueryPoolResults(device,
+        frame.query_pool,
+        0,
+        query_count,
+        query_count * sizeof(uint64_t),
+        results.data(),
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT);
+    // VK_NOT_READY means a scope was left open, its frame is dropped
+    if (result != VK_SUCCESS) return;
+
+    uint64_t first_tick = results[0] & timestamp_mask;
+    auto to_ns = [&](uint64_t tick) {
+        uint64_t elapsed = ((tick & timestamp_mask) - first_tick) & timestamp_mask;
+        return frame.submit_ns + static_cast<int64_t>(static_cast<double>(elapsed) * ns_per_tick);
+    };
+    for (size_t i = 0; i < frame.scope_names.size(); i++)
+        Profiler::record_scope(
+            track, frame.scope_names[i], to_ns(results[i * 2]), to_ns(results[i * 2 + 1]));
+}
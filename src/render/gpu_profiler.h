@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "core/profiler.h"
+
+// GPU timestamp scopes, reported to the Profiler on a "GPU" track next to the CPU threads.
+//
+// Each frame in flight has its own timestamp query pool. A frame's results are read back the next
+// time its index comes around, after the renderer waited for its fence, so reading never stalls.
+// GPU ticks are placed on the CPU timeline by anchoring the frame's first timestamp to the moment
+// its command buffer was submitted, which is accurate enough to line passes up with the CPU work
+// and only needs core Vulkan 1.0 (lavapipe included).
+class GpuProfiler
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+        // Queue family the profiled command buffers are submitted to
+        uint32_t queue_family_index = 0;
+        uint32_t frame_count = 2;
+        uint32_t max_scopes_per_frame = 128;
+    };
+
+    GpuProfiler(CreateDetails create_details);
+    ~GpuProfiler() noexcept;
+    GpuProfiler(GpuProfiler const&) = delete;
+    GpuProfiler& operator=(GpuProfiler const&) = delete;
+    GpuProfiler(GpuProfiler&& other) noexcept = delete;
+    GpuProfiler& operator=(GpuProfiler&& other) noexcept = delete;
+
+    // False when the queue family has no timestamp support, every other call is a no-op then
+    [[nodiscard]] bool is_supported() const noexcept { return timestamp_mask != 0; }
+
+    // Call after frame_index's fence signaled, at the start of recording its command buffer.
+    // Reports the scopes from the last use of frame_index and resets its queries.
+    void begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index);
+    // Call right before submitting the frame's command buffer
+    void end_frame() noexcept;
+
+    // Returns an id for end_scope(), scopes beyond max_scopes_per_frame are ignored
+    uint32_t begin_scope(VkCommandBuffer command_buffer, const char* name);
+    void end_scope(VkCommandBuffer command_buffer, uint32_t scope) noexcept;
+
+    private:
+    struct Frame
+    {
+        VkQueryPool query_pool = VK_NULL_HANDLE;
+        std::vector<const char*> scope_names;
+        int64_t submit_ns = -1;
+    };
+
+    void report(Frame& frame);
+    void destroy_query_pools() noexcept;
+
+    VkDevice device = VK_NULL_HANDLE;
+    double ns_per_tick = 1.0;
+    uint64_t timestamp_mask = 0;
+    uint32_t max_scopes = 0;
+    std::vector<Frame> frames;
+    uint32_t current_frame = 0;
+    std::vector<uint64_t> results;
+    Profiler::Track* track = nullptr;
+};
+
+// Writes a begin timestamp now and an end timestamp when it goes out of scope
+class GpuProfileScope
+{
+    public:
+    GpuProfileScope(GpuProfiler& gpu_profiler, VkCommandBuffer recording, const char* name)
+    : profiler(gpu_profiler), command_buffer(recording),
+      scope(gpu_profiler.begin_scope(recording, name))
+    {
+    }
+    ~GpuProfileScope() noexcept { profiler.end_scope(command_buffer, scope); }
+    GpuProfileScope(GpuProfileScope const&) = delete;
+    GpuProfileScope& operator=(GpuProfileScope const&) = delete;
+
+    private:
+    GpuProfiler& profiler;
+    VkCommandBuffer command_buffer;
+    uint32_t scope;
+};
+
+#if defined(ORANGE_ENABLE_PROFILER)
+#define ORANGE_GPU_PROFILE_SCOPE(gpu_profiler, command_buffer, name)           \
+    GpuProfileScope ORANGE_PROFILE_CONCAT(orange_gpu_profile_scope_, __LINE__) \
+    {                                                                          \
+        gpu_profiler, command_buffer, name                                     \
+    }
+#else
+#define ORANGE_GPU_PROFILE_SCOPE(gpu_profiler, command_buffer, name) static_cast<void>(0)
+#endif
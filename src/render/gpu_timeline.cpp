@@ -0,0 +1,73 @@
+#include "gpu_timeline.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+using namespace std::string_literals;
+
+GpuTimeline::GpuTimeline(CreateDetails create_details)
+: device(create_details.device), last_submitted(create_details.initial_value),
+  last_completed(create_details.initial_value)
+{
+    VkSemaphoreTypeCreateInfo type_info{};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = create_details.initial_value;
+
+    VkSemaphoreCreateInfo semaphore_info{};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_info.pNext = &type_info;
+    VkResult result = vkCreateSemaphore(device, &semaphore_info, nullptr, &timeline);
+    if (result != VK_SUCCESS)
+        throw std::runtime_error(
+            "Failed to create GPU timeline: vkCreateSemaphore failed with "s +
+            std::to_string(result));
+}
+
+GpuTimeline::~GpuTimeline() noexcept
+{
+    if (timeline != VK_NULL_HANDLE) vkDestroySemaphore(device, timeline, nullptr);
+}
+
+void GpuTimeline::submitted(uint64_t value) noexcept
+{
+    assert(value > last_submitted.load(std::memory_order_relaxed) &&
+           "timeline values must increase");
+    last_submitted.store(value, std::memory_order_release);
+}
+
+void GpuTimeline::update_completed(uint64_t value) noexcept
+{
+    uint64_t current = last_completed.load(std::memory_order_relaxed);
+    while (current < value &&
+           !last_completed.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t GpuTimeline::completed_value() noexcept
+{
+    uint64_t value = 0;
+    if (vkGetSemaphoreCounterValue(device, timeline, &value) == VK_SUCCESS)
+        update_completed(value);
+    return last_completed.load(std::memory_order_relaxed);
+}
+
+bool GpuTimeline::is_complete(uint64_t value) noexcept
+{
+    return value <= last_completed.load(std::memory_order_relaxed) || value <= completed_value();
+}
+
+bool GpuTimeline::wait(uint64_t value, uint64_t timeout_ns) noexcept
+{
+    if (value <= last_completed.load(std::memory_order_relaxed)) return true;
+    VkSemaphoreWaitInfo wait_info{};
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &timeline;
+    wait_info.pValues = &value;
+    if (vkWaitSemaphores(device, &wait_info, timeout_ns) != VK_SUCCESS) return false;
+    update_completed(value);
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+#include <atomic>
+
+#include <vulkan/vulkan.h>
+
+// Timeline semaphore counting the submissions to one queue.
+//
+// Every submission signals the next value, so "the GPU finished submission N" is a single number
+// instead of a fence per frame. The host waits on values, and other queues can wait on them in
+// their submissions without any extra binary semaphores.
+//
+//     uint64_t value = timeline.next_value();
+//     // signal `value` from the submission, through VkTimelineSemaphoreSubmitInfo
+//     if (vkQueueSubmit(...) == VK_SUCCESS) timeline.submitted(value);
+//     ...
+//     timeline.wait(value);
+class GpuTimeline
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        uint64_t initial_value = 0;
+    };
+
+    GpuTimeline(CreateDetails create_details);
+    ~GpuTimeline() noexcept;
+    GpuTimeline(GpuTimeline const&) = delete;
+    GpuTimeline& operator=(GpuTimeline const&) = delete;
+    GpuTimeline(GpuTimeline&& other) noexcept = delete;
+    GpuTimeline& operator=(GpuTimeline&& other) noexcept = delete;
+
+    [[nodiscard]] VkSemaphore semaphore() const noexcept { return timeline; }
+
+    // Value for the next submission to signal
+    [[nodiscard]] uint64_t next_value() const noexcept
+    {
+        return last_submitted.load(std::memory_order_relaxed) + 1;
+    }
+    // Call once the submission signaling `value` was accepted by the queue
+    void submitted(uint64_t value) noexcept;
+    // Safe to read from any thread, only the submitting thread may call submitted()
+    [[nodiscard]] uint64_t last_submitted_value() const noexcept
+    {
+        return last_submitted.load(std::memory_order_acquire);
+    }
+
+    // Largest value the GPU signaled so far. Safe to call from any thread, as are is_complete()
+    // and wait().
+    [[nodiscard]] uint64_t completed_value() noexcept;
+    [[nodiscard]] bool is_complete(uint64_t value) noexcept;
+
+    // Blocks until `value` was signaled, returns false on timeout or device loss
+    bool wait(uint64_t value, uint64_t timeout_ns = UINT64_MAX) noexcept;
+
+    private:
+    void update_completed(uint64_t value) noexcept;
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkSemaphore timeline = VK_NULL_HANDLE;
+    std::atomic<uint64_t> last_submitted{ 0 };
+    // cached, querying the semaphore is a driver call. Atomic so jobs on any thread can poll.
+    std::atomic<uint64_t> last_completed{ 0 };
+};
@@ -0,0 +1,73 @@
+#include "offscreen_target.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std::string_literals;
+
+OffscreenTarget::OffscreenTarget(CreateDetails create_details)
+: device(create_details.device), allocator(create_details.allocator), memory(create_details.memory),
+  image_extent(create_details.extent), image_format(create_details.format)
+{
+    images.resize(create_details.image_count);
+    for (auto& target : images)
+    {
+        VkImageCreateInfo image_info{};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = image_format;
+        image_info.extent = { image_extent.width, image_extent.height, 1 };
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        // transfer src for readback, transfer dst for clears
+        image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                           VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VmaAllocationCreateInfo allocation_info{};
+        allocation_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+        VkResult image_ret = vmaCreateImage(
+            allocator, &image_info, &allocation_info, &target.image, &target.allocation, nullptr);
+        if (image_ret != VK_SUCCESS)
+        {
+            destroy();
+            throw std::runtime_error(
+                "Failed to create offscreen target: vmaCreateImage failed with "s +
+                std::to_string(image_ret));
+        }
+        if (memory) memory->track(target.allocation, MemoryCategory::render_target);
+
+        VkImageViewCreateInfo view_info{};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = target.image;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = image_format;
+        view_info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        VkResult view_ret = vkCreateImageView(device, &view_info, nullptr, &target.view);
+        if (view_ret != VK_SUCCESS)
+        {
+            destroy();
+            throw std::runtime_error(
+                "Failed to create offscreen target: vkCreateImageView failed with "s +
+                std::to_string(view_ret));
+        }
+    }
+}
+
+OffscreenTarget::~OffscreenTarget() noexcept { destroy(); }
+
+void OffscreenTarget::destroy() noexcept
+{
+    for (auto& target : images)
+    {
+        if (target.view != VK_NULL_HANDLE) vkDestroyImageView(device, target.view, nullptr);
+        if (target.image != VK_NULL_HANDLE)
+        {
+            if (memory) memory->untrack(target.allocation);
+            vmaDestroyImage(allocator, target.image, target.allocation);
+        }
+        target = Image{};
+    }
+}
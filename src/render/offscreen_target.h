@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vector>
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+
+#include "gpu_memory.h"
+
+// Ring of color images rendered to instead of a swapchain. Frame index i renders into image i, so
+// an image is only reused once the fence of the frame that last used it signaled, the same pacing
+// the swapchain path gets from its per frame resources.
+class OffscreenTarget
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        VmaAllocator allocator = VK_NULL_HANDLE;
+        VkExtent2D extent = { 1280, 720 };
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+        uint32_t image_count = 2;
+        // Optional, counts the images as render targets
+        GpuMemory* memory = nullptr;
+    };
+
+    OffscreenTarget(CreateDetails create_details);
+    ~OffscreenTarget() noexcept;
+    OffscreenTarget(OffscreenTarget const&) = delete;
+    OffscreenTarget& operator=(OffscreenTarget const&) = delete;
+    OffscreenTarget(OffscreenTarget&& other) noexcept = delete;
+    OffscreenTarget& operator=(OffscreenTarget&& other) noexcept = delete;
+
+    [[nodiscard]] VkExtent2D extent() const noexcept { return image_extent; }
+    [[nodiscard]] VkFormat format() const noexcept { return image_format; }
+    [[nodiscard]] uint32_t image_count() const noexcept
+    {
+        return static_cast<uint32_t>(images.size());
+    }
+    [[nodiscard]] VkImage image(uint32_t index) const noexcept { return images[index].image; }
+    [[nodiscard]] VkImageView image_view(uint32_t index) const noexcept
+    {
+        return images[index].view;
+    }
+
+    private:
+    struct Image
+    {
+        VkImage image = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+    };
+
+    void destroy() noexcept;
+
+    VkDevice device = VK_NULL_HANDLE;
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    GpuMemory* memory = nullptr;
+    VkExtent2D image_extent{};
+    VkFormat image_format = VK_FORMAT_UNDEFINED;
+    std::vector<Image> images;
+};
@@ -0,0 +1,250 @@
+#include "pipeline_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+
+#include "core/job_system.h"
+#include "core/profiler.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+constexpr uint32_t file_magic = 0x4350524F; // "ORPC"
+constexpr uint32_t file_version = 1;
+
+// Followed by permutation_count uint64_t keys, then data_size bytes of vkGetPipelineCacheData
+struct FileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t cache_uuid[VK_UUID_SIZE];
+    uint32_t permutation_count;
+    uint64_t data_size;
+    // over everything after the header
+    uint64_t checksum;
+};
+
+static_assert(sizeof(FileHeader) == 56, "the header is written as is, without padding");
+
+// Start of the data vkGetPipelineCacheData returns, VkPipelineCacheHeaderVersionOne
+constexpr size_t vulkan_header_size = 16 + VK_UUID_SIZE;
+
+uint64_t fnv1a(uint64_t hash, const uint8_t* data, size_t size) noexcept
+{
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    return hash;
+}
+constexpr uint64_t fnv_offset_basis = 14695981039346656037ull;
+
+uint32_t read_u32(const uint8_t* data) noexcept
+{
+    uint32_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+} // namespace
+
+PipelineCache::PipelineCache(CreateDetails create_details)
+: device(create_details.device), path(std::move(create_details.path))
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(create_details.physical_device, &properties);
+    identity.vendor_id = properties.vendorID;
+    identity.device_id = properties.deviceID;
+    identity.driver_version = properties.driverVersion;
+    std::memcpy(identity.cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::vector<uint8_t> data = load();
+    VkPipelineCacheCreateInfo cache_info{};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_info.initialDataSize = data.size();
+    cache_info.pInitialData = data.empty() ? nullptr : data.data();
+    VkResult result = vkCreatePipelineCache(device, &cache_info, nullptr, &cache);
+    if (result != VK_SUCCESS && !data.empty())
+    {
+        // the driver has the last word on its own data
+        spdlog::warn("Pipeline cache {}: rejected by the driver, starting empty", path.string());
+        cache_info.initialDataSize = 0;
+        cache_info.pInitialData = nullptr;
+        result = vkCreatePipelineCache(device, &cache_info, nullptr, &cache);
+        data.clear();
+    }
+    if (result != VK_SUCCESS)
+        throw std::runtime_error(
+            "Failed to create pipeline cache: vkCreatePipelineCache failed with "s +
+            std::to_string(result));
+    loaded = !data.empty();
+}
+
+PipelineCache::~PipelineCache() noexcept
+{
+    if (cache != VK_NULL_HANDLE) vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+std::vector<uint8_t> PipelineCache::load()
+{
+    ORANGE_PROFILE_SCOPE("PipelineCache::load");
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return {}; // first run
+    std::vector<uint8_t> bytes(
+        (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    auto reject = [this](const char* reason) {
+        spdlog::warn("Pipeline cache {}: {}, starting empty", path.string(), reason);
+        return std::vector<uint8_t>{};
+    };
+    FileHeader header{};
+    if (bytes.size() < sizeof(header)) return reject("file is too small");
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != file_magic) return reject("not a pipeline cache file");
+    if (header.version != file_version) return reject("written by another version");
+    size_t keys_size = size_t{ header.permutation_count } * sizeof(uint64_t);
+    // compared against what is left, a huge data_size in a crafted header can't wrap the sum
+    if (bytes.size() - sizeof(header) < keys_size) return reject("file is truncated");
+    if (header.data_size != bytes.size() - sizeof(header) - keys_size)
+        return reject("file is truncated");
+    const uint8_t* keys = bytes.data() + sizeof(header);
+    const uint8_t* data = keys + keys_size;
+    if (fnv1a(fnv_offset_basis, keys, bytes.size() - sizeof(header)) != header.checksum)
+        return reject("checksum mismatch");
+
+    for (uint32_t i = 0; i < header.permutation_count; i++)
+    {
+        uint64_t key = 0;
+        std::memcpy(&key, keys + i * sizeof(key), sizeof(key));
+        permutations.insert(key);
+    }
+
+    // the permutations are still worth compiling ahead after a driver update
+    if (header.vendor_id != identity.vendor_id || header.device_id != identity.device_id ||
+        header.driver_version != identity.driver_version ||
+        std::memcmp(header.cache_uuid, identity.cache_uuid, VK_UUID_SIZE) != 0)
+    {
+        spdlog::info("Pipeline cache {}: written for another device or driver, {} permutations "
+                     "will be compiled again",
+            path.string(),
+            permutations.size());
+        return {};
+    }
+
+    // the Vulkan header repeats the identity, checked in case the blob itself was swapped
+    if (header.data_size < vulkan_header_size) return reject("Vulkan data is too small");
+    if (read_u32(data) < vulkan_header_size ||
+        read_u32(data + 4) != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        read_u32(data + 8) != identity.vendor_id || read_u32(data + 12) != identity.device_id ||
+        std::memcmp(data + 16, identity.cache_uuid, VK_UUID_SIZE) != 0)
+        return reject("Vulkan header doesn't match the device");
+
+    return std::vector<uint8_t>(data, data + header.data_size);
+}
+
+void PipelineCache::record_permutation(uint64_t key)
+{
+    std::lock_guard lock(mutex);
+    permutations.insert(key);
+}
+
+size_t PipelineCache::permutation_count() const
+{
+    std::lock_guard lock(mutex);
+    return permutations.size();
+}
+
+void PipelineCache::warm_up(JobSystem& job_system, JobCounter& counter, WarmupFunction create)
+{
+    std::vector<uint64_t> keys;
+    {
+        std::lock_guard lock(mutex);
+        keys.assign(permutations.begin(), permutations.end());
+    }
+    // shared by the jobs, which outlive this call
+    auto function = std::make_shared<WarmupFunction>(std::move(create));
+    for (uint64_t key : keys)
+        job_system.submit(
+            [function, key, handle = cache] {
+                ORANGE_PROFILE_SCOPE("PipelineCache::warm_up");
+                (*function)(key, handle);
+            },
+            counter);
+}
+
+void PipelineCache::warm_up(WarmupFunction const& create)
+{
+    ORANGE_PROFILE_SCOPE("PipelineCache::warm_up");
+    std::vector<uint64_t> keys;
+    {
+        std::lock_guard lock(mutex);
+        keys.assign(permutations.begin(), permutations.end());
+    }
+    for (uint64_t key : keys)
+        create(key, cache);
+}
+
+bool PipelineCache::save()
+{
+    ORANGE_PROFILE_SCOPE("PipelineCache::save");
+    size_t data_size = 0;
+    if (vkGetPipelineCacheData(device, cache, &data_size, nullptr) != VK_SUCCESS) return false;
+    std::vector<uint8_t> data(data_size);
+    if (vkGetPipelineCacheData(device, cache, &data_size, data.data()) != VK_SUCCESS) return false;
+    data.resize(data_size);
+
+    std::vector<uint64_t> keys;
+    {
+        std::lock_guard lock(mutex);
+        keys.assign(permutations.begin(), permutations.end());
+    }
+    // sorted, so the same permutations always write the same file
+    std::sort(keys.begin(), keys.end());
+
+    FileHeader header{};
+    header.magic = file_magic;
+    header.version = file_version;
+    header.vendor_id = identity.vendor_id;
+    header.device_id = identity.device_id;
+    header.driver_version = identity.driver_version;
+    std::memcpy(header.cache_uuid, identity.cache_uuid, VK_UUID_SIZE);
+    header.permutation_count = static_cast<uint32_t>(keys.size());
+    header.data_size = data.size();
+    auto keys_bytes = reinterpret_cast<const uint8_t*>(keys.data());
+    header.checksum = fnv1a(fnv_offset_basis, keys_bytes, keys.size() * sizeof(uint64_t));
+    header.checksum = fnv1a(header.checksum, data.data(), data.size());
+
+    std::error_code error;
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), error);
+    auto temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(keys_bytes),
+            static_cast<std::streamsize>(keys.size() * sizeof(uint64_t)));
+        file.write(reinterpret_cast<const char*>(data.data()),
+            static_cast<std::streamsize>(data.size()));
+        if (!file)
+        {
+            spdlog::warn("Pipeline cache {}: couldn't write {}", path.string(), temporary.string());
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        spdlog::warn("Pipeline cache {}: couldn't replace it, {}", path.string(), error.message());
+        return false;
+    }
+    return true;
+}
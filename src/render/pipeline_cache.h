@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+class JobCounter;
+class JobSystem;
+
+// VkPipelineCache persisted to disk between runs, plus the pipeline permutations created in them.
+//
+// The file is only loaded into the VkPipelineCache when it was written for the same device, driver
+// version and pipelineCacheUUID, and its checksum and Vulkan header check out, so a stale or
+// corrupted file can't reach the driver. The recorded permutations survive a driver update: they
+// are compiled again by warm_up() on worker threads at startup, instead of on first use in a
+// frame.
+//
+//     PipelineCache cache{ { .device = device, .physical_device = gpu, .path = "pipelines.bin" } };
+//     cache.warm_up(job_system, counter, [&](uint64_t key, VkPipelineCache vk_cache) { ... });
+//     // whenever a pipeline is created
+//     vkCreateGraphicsPipelines(device, cache.handle(), ...);
+//     cache.record_permutation(key);
+//     ...
+//     cache.save();
+class PipelineCache
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+        std::filesystem::path path;
+    };
+
+    // Creates the pipeline cache with path's contents, an empty one if they don't validate
+    PipelineCache(CreateDetails create_details);
+    ~PipelineCache() noexcept;
+    PipelineCache(PipelineCache const&) = delete;
+    PipelineCache& operator=(PipelineCache const&) = delete;
+    PipelineCache(PipelineCache&& other) noexcept = delete;
+    PipelineCache& operator=(PipelineCache&& other) noexcept = delete;
+
+    [[nodiscard]] VkPipelineCache handle() const noexcept { return cache; }
+    // Whether the Vulkan cache data from disk was used
+    [[nodiscard]] bool loaded_from_disk() const noexcept { return loaded; }
+
+    // Remembers a permutation, an application defined key, to compile again on the next start.
+    // Safe to call from any thread.
+    void record_permutation(uint64_t key);
+    [[nodiscard]] size_t permutation_count() const;
+
+    // Calls create(key, handle()) on the job system's threads for every permutation recorded by
+    // earlier runs, tracked by `counter`. `create` must be safe to call concurrently.
+    using WarmupFunction = std::function<void(uint64_t key, VkPipelineCache cache)>;
+    void warm_up(JobSystem& job_system, JobCounter& counter, WarmupFunction create);
+    // Same, on the calling thread
+    void warm_up(WarmupFunction const& create);
+
+    // Writes the cache and permutations next to the path and renames them over it, so a crash
+    // never leaves a partial file. Returns false on failure.
+    bool save();
+
+    private:
+    // Identifies the driver a Vulkan cache blob is valid for
+    struct DeviceIdentity
+    {
+        uint32_t vendor_id = 0;
+        uint32_t device_id = 0;
+        uint32_t driver_version = 0;
+        uint8_t cache_uuid[VK_UUID_SIZE]{};
+    };
+
+    // Returns the Vulkan cache data to create the cache with, empty if there is none or it is
+    // invalid. Fills permutations either way when the file itself is intact.
+    std::vector<uint8_t> load();
+
+    VkDevice device = VK_NULL_HANDLE;
+    std::filesystem::path path;
+    DeviceIdentity identity;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    bool loaded = false;
+
+    mutable std::mutex mutex;
+    std::unordered_set<uint64_t> permutations;
+};
@@ -0,0 +1,491 @@
+#include "render_graph.h"
+
+#include <cassert>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "core/profiler.h"
+#include "deferred_release.h"
+#include "gpu_memory.h"
+#include "gpu_profiler.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+// Frames a physical image may go unused before it is released, so resolution changes or passes
+// toggled off don't keep their images forever
+constexpr uint32_t max_unused_frames = 16;
+
+constexpr VkAccessFlags write_accesses = VK_ACCESS_SHADER_WRITE_BIT |
+                                         VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                         VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                         VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT |
+                                         VK_ACCESS_MEMORY_WRITE_BIT;
+
+struct UsageInfo
+{
+    VkPipelineStageFlags stage;
+    VkAccessFlags access;
+    VkImageLayout layout;
+    VkImageUsageFlags image_usage;
+};
+
+UsageInfo usage_info(RenderGraph::Usage usage) noexcept
+{
+    using Usage = RenderGraph::Usage;
+    constexpr VkPipelineStageFlags depth_stages =
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    switch (usage)
+    {
+        case Usage::color_attachment:
+            return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+        case Usage::depth_attachment:
+            return { depth_stages,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+        case Usage::depth_read:
+            return { depth_stages,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+        case Usage::fragment_sampled:
+            return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_IMAGE_USAGE_SAMPLED_BIT };
+        case Usage::compute_sampled:
+            return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_IMAGE_USAGE_SAMPLED_BIT };
+        case Usage::compute_storage_read:
+            return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL,
+                VK_IMAGE_USAGE_STORAGE_BIT };
+        case Usage::compute_storage_write:
+            return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL,
+                VK_IMAGE_USAGE_STORAGE_BIT };
+        case Usage::transfer_read:
+            return { VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+        case Usage::transfer_write:
+            return { VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+    }
+    return {};
+}
+
+bool is_write(RenderGraph::Usage usage) noexcept
+{
+    return (usage_info(usage).access & write_accesses) != 0;
+}
+} // namespace
+
+RenderGraph::RenderGraph(CreateDetails create_details)
+: device(create_details.device), allocator(create_details.allocator),
+  release_queue(create_details.release_queue), gpu_profiler(create_details.gpu_profiler),
+  memory(create_details.memory)
+{
+}
+
+RenderGraph::~RenderGraph() noexcept
+{
+    for (auto& physical : physical_images)
+        destroy_physical_image(physical);
+}
+
+void RenderGraph::destroy_physical_image(PhysicalImage& physical) noexcept
+{
+    if (physical.view != VK_NULL_HANDLE) vkDestroyImageView(device, physical.view, nullptr);
+    if (physical.image != VK_NULL_HANDLE)
+    {
+        if (memory) memory->untrack(physical.allocation);
+        vmaDestroyImage(allocator, physical.image, physical.allocation);
+    }
+    physical = {};
+}
+
+void RenderGraph::begin_frame()
+{
+    images.clear();
+    passes.clear();
+    uses.clear();
+    next_pass = 0;
+    recorded = false;
+    frame_stats = {};
+}
+
+RenderGraph::ImageId RenderGraph::import_image(ImportedImage const& imported)
+{
+    Image image{};
+    image.name = imported.name;
+    image.imported = true;
+    image.aspect = imported.aspect;
+    image.image = imported.image;
+    image.view = imported.view;
+    image.state = { imported.initial_layout, imported.initial_stage, imported.initial_access };
+    image.final_state = { imported.final_layout, imported.final_stage, imported.final_access };
+    images.push_back(image);
+    return ImageId{ static_cast<uint32_t>(images.size() - 1) };
+}
+
+RenderGraph::ImageId RenderGraph::create_image(TransientImage const& transient)
+{
+    Image image{};
+    image.name = transient.name;
+    image.aspect = transient.aspect;
+    image.extent = transient.extent;
+    image.format = transient.format;
+    images.push_back(image);
+    return ImageId{ static_cast<uint32_t>(images.size() - 1) };
+}
+
+void RenderGraph::bind_image(ImageId id, VkImage image, VkImageView view) noexcept
+{
+    assert(images[id.index].imported && "only imported images can be bound");
+    images[id.index].image = image;
+    images[id.index].view = view;
+}
+
+void RenderGraph::add_pass(const char* name, std::initializer_list<ImageUse> images_used,
+    std::function<void(VkCommandBuffer)> execute, bool side_effects)
+{
+    auto first_use = static_cast<uint32_t>(uses.size());
+    for (auto const& use : images_used)
+    {
+        assert(use.image.index < images.size() && "image from another frame");
+        [[maybe_unused]] auto same_image = [&use](ImageUse const& other) {
+            return other.image.index == use.image.index;
+        };
+        assert(std::none_of(uses.begin() + first_use, uses.end(), same_image) &&
+               "an image may be used only once per pass");
+        uses.push_back(use);
+    }
+    passes.push_back(Pass{ .name = name,
+        .first_use = first_use,
+        .use_count = static_cast<uint32_t>(images_used.size()),
+        .execute = std::move(execute),
+        .side_effects = side_effects,
+        .culled = false });
+}
+
+VkImage RenderGraph::image(ImageId id) const noexcept
+{
+    auto const& entry = images[id.index];
+    if (entry.imported) return entry.image;
+    return entry.physical < physical_images.size() ? physical_images[entry.physical].image
+                                                   : VK_NULL_HANDLE;
+}
+
+VkImageView RenderGraph::image_view(ImageId id) const noexcept
+{
+    auto const& entry = images[id.index];
+    if (entry.imported) return entry.view;
+    return entry.physical < physical_images.size() ? physical_images[entry.physical].view
+                                                   : VK_NULL_HANDLE;
+}
+
+void RenderGraph::compile()
+{
+    ORANGE_PROFILE_SCOPE("RenderGraph::compile");
+    cull_passes();
+    compute_lifetimes();
+    assign_physical_images();
+
+    frame_stats.pass_count = static_cast<uint32_t>(passes.size());
+    for (auto const& pass : passes)
+        if (pass.culled) frame_stats.culled_pass_count++;
+    for (auto const& image : images)
+        if (!image.imported && image.physical != UINT32_MAX) frame_stats.transient_image_count++;
+    for (auto const& physical : physical_images)
+        if (physical.unused_frames == 0) frame_stats.physical_image_count++;
+}
+
+// Walks the passes backwards from the outputs. A pass is kept when it writes an image something
+// later needs, and then everything it uses is needed too. Earlier writers of a needed image stay,
+// a later pass might only partially overwrite it.
+void RenderGraph::cull_passes()
+{
+    for (auto& image : images)
+        image.needed = image.imported && image.final_state.layout != VK_IMAGE_LAYOUT_UNDEFINED;
+
+    for (size_t i = passes.size(); i-- > 0;)
+    {
+        auto& pass = passes[i];
+        bool writes_needed = false;
+        for (uint32_t u = pass.first_use; u < pass.first_use + pass.use_count; u++)
+            if (images[uses[u].image.index].needed && is_write(uses[u].usage)) writes_needed = true;
+        pass.culled = !pass.side_effects && !writes_needed;
+        if (pass.culled) continue;
+        for (uint32_t u = pass.first_use; u < pass.first_use + pass.use_count; u++)
+            images[uses[u].image.index].needed = true;
+    }
+}
+
+void RenderGraph::compute_lifetimes()
+{
+    for (uint32_t p = 0; p < passes.size(); p++)
+    {
+        if (passes[p].culled) continue;
+        for (uint32_t u = passes[p].first_use; u < passes[p].first_use + passes[p].use_count; u++)
+        {
+            auto& image = images[uses[u].image.index];
+            image.first_pass = std::min(image.first_pass, p);
+            image.last_pass = std::max(image.last_pass, p);
+            if (!image.imported) image.usage |= usage_info(uses[u].usage).image_usage;
+        }
+    }
+}
+
+// Transients get an image at their first pass and give it back after their last, so transients
+// that don't overlap can share one
+void RenderGraph::assign_physical_images()
+{
+    release_unused_physical_images();
+    for (auto& physical : physical_images)
+    {
+        physical.in_use = false;
+        physical.unused_frames++;
+    }
+
+    for (uint32_t p = 0; p < passes.size(); p++)
+    {
+        auto const& pass = passes[p];
+        if (pass.culled) continue;
+        for (uint32_t u = pass.first_use; u < pass.first_use + pass.use_count; u++)
+        {
+            auto& image = images[uses[u].image.index];
+            if (!image.imported && image.first_pass == p)
+                image.physical = acquire_physical_image(image);
+        }
+        for (uint32_t u = pass.first_use; u < pass.first_use + pass.use_count; u++)
+        {
+            auto const& image = images[uses[u].image.index];
+            if (!image.imported && image.last_pass == p)
+                physical_images[image.physical].in_use = false;
+        }
+    }
+}
+
+uint32_t RenderGraph::acquire_physical_image(Image const& transient)
+{
+    for (uint32_t i = 0; i < physical_images.size(); i++)
+    {
+        auto& physical = physical_images[i];
+        if (physical.in_use || physical.format != transient.format ||
+            physical.aspect != transient.aspect ||
+            physical.extent.width != transient.extent.width ||
+            physical.extent.height != transient.extent.height ||
+            (physical.usage & transient.usage) != transient.usage)
+            continue;
+        physical.in_use = true;
+        physical.unused_frames = 0;
+        return i;
+    }
+
+    PhysicalImage physical{};
+    physical.extent = transient.extent;
+    physical.format = transient.format;
+    physical.aspect = transient.aspect;
+    physical.usage = transient.usage;
+
+    VkImageCreateInfo image_info{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = transient.format;
+    image_info.extent = { transient.extent.width, transient.extent.height, 1 };
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = transient.usage;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VmaAllocationCreateInfo allocation_info{};
+    allocation_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+    VkResult result = vmaCreateImage(
+        allocator, &image_info, &allocation_info, &physical.image, &physical.allocation, nullptr);
+    if (result != VK_SUCCESS)
+        throw std::runtime_error("Failed to create render graph image "s + transient.name +
+                                 ": vmaCreateImage failed with " + std::to_string(result));
+    if (memory) memory->track(physical.allocation, MemoryCategory::render_target);
+
+    VkImageViewCreateInfo view_info{};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = physical.image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = transient.format;
+    view_info.subresourceRange = { transient.aspect, 0, 1, 0, 1 };
+    result = vkCreateImageView(device, &view_info, nullptr, &physical.view);
+    if (result != VK_SUCCESS)
+    {
+        destroy_physical_image(physical);
+        throw std::runtime_error("Failed to create render graph image "s + transient.name +
+                                 ": vkCreateImageView failed with " + std::to_string(result));
+    }
+
+    physical.in_use = true;
+    physical_images.push_back(physical);
+    return static_cast<uint32_t>(physical_images.size() - 1);
+}
+
+void RenderGraph::release_unused_physical_images()
+{
+    // without a release queue there is no safe point to destroy them before the destructor
+    if (!release_queue) return;
+    auto unused = [](PhysicalImage const& physical) {
+        return physical.unused_frames > max_unused_frames;
+    };
+    for (auto& physical : physical_images)
+    {
+        if (!unused(physical)) continue;
+        release_queue->release(physical.view);
+        if (memory) memory->untrack(physical.allocation);
+        release_queue->release(physical.image, physical.allocation);
+    }
+    physical_images.erase(
+        std::remove_if(physical_images.begin(), physical_images.end(), unused),
+        physical_images.end());
+}
+
+bool RenderGraph::record(VkCommandBuffer command_buffer)
+{
+    ORANGE_PROFILE_SCOPE("RenderGraph::record");
+    if (recorded) return true;
+    for (; next_pass < passes.size(); next_pass++)
+    {
+        auto& pass = passes[next_pass];
+        if (pass.culled) continue;
+        for (uint32_t u = pass.first_use; u < pass.first_use + pass.use_count; u++)
+            if (image(uses[u].image) == VK_NULL_HANDLE) return false;
+
+        record_barriers(command_buffer, next_pass);
+        if (!pass.execute) continue;
+        if (gpu_profiler)
+        {
+            ORANGE_GPU_PROFILE_SCOPE(*gpu_profiler, command_buffer, pass.name);
+            pass.execute(command_buffer);
+        }
+        else
+            pass.execute(command_buffer);
+    }
+    // an output no pass used still needs its final transition, like the swapchain image to
+    // PRESENT_SRC
+    for (auto const& image : images)
+        if (image.imported && image.final_state.layout != VK_IMAGE_LAYOUT_UNDEFINED &&
+            image.image == VK_NULL_HANDLE)
+            return false;
+    record_final_transitions(command_buffer);
+    recorded = true;
+    ORANGE_PROFILE_COUNTER("Render graph barriers", frame_stats.barrier_count);
+    return true;
+}
+
+RenderGraph::ImageState& RenderGraph::state_of(Image& image) noexcept
+{
+    return image.imported ? image.state : physical_images[image.physical].state;
+}
+
+void RenderGraph::record_barriers(VkCommandBuffer command_buffer, uint32_t pass_index)
+{
+    auto const& pass = passes[pass_index];
+    for (uint32_t u = pass.first_use; u < pass.first_use + pass.use_count; u++)
+    {
+        auto& image = images[uses[u].image.index];
+        auto& state = state_of(image);
+        UsageInfo info = usage_info(uses[u].usage);
+        // a transient doesn't inherit the contents of the image's previous user
+        VkImageLayout old_layout = !image.imported && image.first_pass == pass_index
+                                       ? VK_IMAGE_LAYOUT_UNDEFINED
+                                       : state.layout;
+        bool hazard = (state.access & write_accesses) != 0 || (info.access & write_accesses) != 0;
+        if (old_layout == info.layout && !hazard)
+        {
+            // reads after reads only need to be waited for together by the next write
+            state.stage |= info.stage;
+            state.access |= info.access;
+            continue;
+        }
+        add_barrier(image.imported ? image.image : physical_images[image.physical].image,
+            image.aspect,
+            state,
+            old_layout,
+            ImageState{ info.layout, info.stage, info.access });
+    }
+    flush_barriers(command_buffer);
+}
+
+void RenderGraph::record_final_transitions(VkCommandBuffer command_buffer)
+{
+    for (uint32_t i = 0; i < images.size(); i++)
+    {
+        auto& image = images[i];
+        if (!image.imported || image.final_state.layout == VK_IMAGE_LAYOUT_UNDEFINED) continue;
+        // record() only gets here once every output is bound
+        assert(image.image != VK_NULL_HANDLE && "output image was never bound");
+        if (image.state.layout == image.final_state.layout &&
+            (image.state.access & write_accesses) == 0)
+            continue;
+        add_barrier(image.image, image.aspect, image.state, image.state.layout, image.final_state);
+    }
+    flush_barriers(command_buffer);
+}
+
+void RenderGraph::add_barrier(VkImage vk_image, VkImageAspectFlags aspect, ImageState& state,
+    VkImageLayout old_layout, ImageState const& next)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    // only writes have to be made available, reads just have to finish
+    barrier.srcAccessMask = state.access & write_accesses;
+    barrier.dstAccessMask = next.access;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = next.layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = vk_image;
+    barrier.subresourceRange = {
+        aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS
+    };
+    barriers.push_back(barrier);
+    // nothing to wait for on first use
+    VkPipelineStageFlags src_stage = state.stage;
+    if (src_stage == 0) src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    barrier_src_stages |= src_stage;
+    barrier_dst_stages |= next.stage;
+    state = next;
+}
+
+void RenderGraph::flush_barriers(VkCommandBuffer command_buffer)
+{
+    if (barriers.empty()) return;
+    vkCmdPipelineBarrier(command_buffer,
+        barrier_src_stages,
+        barrier_dst_stages,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        static_cast<uint32_t>(barriers.size()),
+        barriers.data());
+    frame_stats.barrier_count += static_cast<uint32_t>(barriers.size());
+    barriers.clear();
+    barrier_src_stages = 0;
+    barrier_dst_stages = 0;
+}
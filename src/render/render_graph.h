@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstdint>
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+
+class DeferredReleaseQueue;
+class GpuMemory;
+class GpuProfiler;
+
+// A frame described as passes and the images they use.
+//
+// Passes declare how they use each image, the graph places the barriers and layout transitions in
+// between, batched into one vkCmdPipelineBarrier per pass. Passes that neither write an output
+// image nor have side effects are culled. Transient images only live from their first to their
+// last use, transients whose lifetimes don't overlap share one VkImage when format, extent and
+// aspect match, and those images are kept across frames.
+//
+// Passes record their own rendering, render passes or dynamic rendering, the graph synchronizes.
+//
+//     graph.begin_frame();
+//     auto hdr = graph.create_image({ .name = "HDR", .extent = extent, .format = hdr_format });
+//     auto target = graph.import_image({ .name = "Target", .image = image, .view = view,
+//         .final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR });
+//     graph.add_pass("Lighting", { { hdr, Usage::color_attachment } }, record_lighting);
+//     graph.add_pass("Tonemap",
+//         { { hdr, Usage::fragment_sampled }, { target, Usage::color_attachment } },
+//         record_tonemap);
+//     graph.compile();
+//     graph.record(command_buffer);
+class RenderGraph
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        VmaAllocator allocator = VK_NULL_HANDLE;
+        // Transient images that went unused for a while are released through this
+        DeferredReleaseQueue* release_queue = nullptr;
+        // Optional, wraps every pass in a GPU profile scope
+        GpuProfiler* gpu_profiler = nullptr;
+        // Optional, counts the transient images as render targets
+        GpuMemory* memory = nullptr;
+    };
+
+    enum class Usage : uint8_t
+    {
+        color_attachment, // written, and read when blending or loading
+        depth_attachment, // tested and written
+        depth_read,       // tested only
+        fragment_sampled,
+        compute_sampled,
+        compute_storage_read,
+        compute_storage_write, // includes reading
+        transfer_read,
+        transfer_write,
+    };
+
+    struct ImageId
+    {
+        uint32_t index = UINT32_MAX;
+    };
+    struct ImageUse
+    {
+        ImageId image;
+        Usage usage;
+    };
+
+    // An image owned by someone else, like the swapchain image or a texture
+    struct ImportedImage
+    {
+        const char* name = "";
+        // May be left null and bound later with bind_image()
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        // State before the frame, an UNDEFINED layout discards the contents
+        VkImageLayout initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags initial_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        VkAccessFlags initial_access = 0;
+        // Layout to leave the image in. Images with one are outputs, passes writing into them are
+        // kept. UNDEFINED leaves the image as the last pass used it.
+        VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags final_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        VkAccessFlags final_access = 0;
+    };
+    // An image owned by the graph, only valid during the frame. Its usage flags are the union of
+    // how passes use it.
+    struct TransientImage
+    {
+        const char* name = "";
+        VkExtent2D extent{};
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    };
+
+    struct Stats
+    {
+        uint32_t pass_count = 0;
+        uint32_t culled_pass_count = 0;
+        uint32_t transient_image_count = 0;
+        // VkImages backing this frame's transients, fewer than transient_image_count when aliased
+        uint32_t physical_image_count = 0;
+        uint32_t barrier_count = 0;
+    };
+
+    RenderGraph(CreateDetails create_details);
+    // The GPU must be done with every frame the graph recorded
+    ~RenderGraph() noexcept;
+    RenderGraph(RenderGraph const&) = delete;
+    RenderGraph& operator=(RenderGraph const&) = delete;
+    RenderGraph(RenderGraph&& other) noexcept = delete;
+    RenderGraph& operator=(RenderGraph&& other) noexcept = delete;
+
+    // Forgets the passes and images of the previous frame
+    void begin_frame();
+
+    ImageId import_image(ImportedImage const& imported);
+    ImageId create_image(TransientImage const& transient);
+    // Sets an imported image that wasn't known when it was imported
+    void bind_image(ImageId id, VkImage image, VkImageView view) noexcept;
+
+    // An image may be used only once per pass. Passes with `side_effects`, like readbacks, are
+    // never culled.
+    void add_pass(const char* name, std::initializer_list<ImageUse> images,
+        std::function<void(VkCommandBuffer)> execute, bool side_effects = false);
+
+    // Culls passes and assigns VkImages to the transients, creating them as needed
+    void compile();
+    // Records the passes in order, stopping before the first pass that uses an imported image
+    // without a VkImage, and before the final layout transitions while an output has none. Call
+    // again after bind_image() to continue. Returns true once everything, including the final
+    // layout transitions, was recorded.
+    bool record(VkCommandBuffer command_buffer);
+
+    // Valid during compile() and record(), so in pass functions
+    [[nodiscard]] VkImage image(ImageId id) const noexcept;
+    [[nodiscard]] VkImageView image_view(ImageId id) const noexcept;
+
+    [[nodiscard]] Stats stats() const noexcept { return frame_stats; }
+
+    private:
+    struct ImageState
+    {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags stage = 0;
+        VkAccessFlags access = 0;
+    };
+    struct Image
+    {
+        const char* name = "";
+        bool imported = false;
+        VkImageAspectFlags aspect = 0;
+        // imported only
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        ImageState state;
+        ImageState final_state;
+        // transient only
+        VkExtent2D extent{};
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkImageUsageFlags usage = 0;
+        uint32_t physical = UINT32_MAX;
+
+        bool needed = false;
+        // in pass indices, over the passes that weren't culled
+        uint32_t first_pass = UINT32_MAX;
+        uint32_t last_pass = 0;
+    };
+    struct Pass
+    {
+        const char* name;
+        uint32_t first_use;
+        uint32_t use_count;
+        std::function<void(VkCommandBuffer)> execute;
+        bool side_effects;
+        bool culled;
+    };
+    // Backs transients, kept across frames. Its state carries over from whichever transient used
+    // it last, so the next one waits for that.
+    struct PhysicalImage
+    {
+        VkImage image = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkExtent2D extent{};
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkImageAspectFlags aspect = 0;
+        VkImageUsageFlags usage = 0;
+        ImageState state;
+        bool in_use = false;
+        uint32_t unused_frames = 0;
+    };
+
+    void cull_passes();
+    void compute_lifetimes();
+    void assign_physical_images();
+    uint32_t acquire_physical_image(Image const& transient);
+    void release_unused_physical_images();
+    void destroy_physical_image(PhysicalImage& physical) noexcept;
+
+    ImageState& state_of(Image& image) noexcept;
+    void record_barriers(VkCommandBuffer command_buffer, uint32_t pass_index);
+    void record_final_transitions(VkCommandBuffer command_buffer);
+    void add_barrier(VkImage vk_image, VkImageAspectFlags aspect, ImageState& state,
+        VkImageLayout old_layout, ImageState const& next);
+    void flush_barriers(VkCommandBuffer command_buffer);
+
+    VkDevice device = VK_NULL_HANDLE;
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    DeferredReleaseQueue* release_queue = nullptr;
+    GpuProfiler* gpu_profiler = nullptr;
+    GpuMemory* memory = nullptr;
+
+    std::vector<Image> images;
+    std::vector<Pass> passes;
+    std::vector<ImageUse> uses;
+    std::vector<PhysicalImage> physical_images;
+    uint32_t next_pass = 0;
+    bool recorded = false;
+
+    // pending batch for the pass being recorded
+    std::vector<VkImageMemoryBarrier> barriers;
+    VkPipelineStageFlags barrier_src_stages = 0;
+    VkPipelineStageFlags barrier_dst_stages = 0;
+
+    Stats frame_stats;
+};
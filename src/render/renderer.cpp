@@ -1,9 +1,11 @@
 #include "renderer.h"
 
 #include "GLFW/glfw3.h"
-#include "vuk/Context.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
 #include <string>
+
+#include "core/profiler.h"
 using namespace std::string_literals;
 
 VKAPI_ATTR VkBool32 VKAPI_CALL vulkan_debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
@@ -33,11 +35,18 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vulkan_debug_callback(VkDebugUtilsMessageSeverity
 }
 
 Renderer::Renderer(Renderer::CreateDetails create_details)
+: job_system(create_details.job_system),
+  defragment_when_idle(create_details.defragment_when_idle),
+  frames_in_flight(std::clamp(create_details.frames_in_flight, 1u, max_frames_in_flight)),
+  low_latency(create_details.low_latency),
+  frame_arena(FrameArena::CreateDetails{ .frame_count = frames_in_flight })
 {
+    bool headless = create_details.window == nullptr;
     vkb::InstanceBuilder inst_builder;
 
     auto inst_ret = inst_builder.set_app_name(create_details.app_name)
                         .set_engine_name(create_details.engine_name)
+                        .set_headless(headless)
                         .enable_validation_layers(create_details.enable_validation)
                         .require_api_version(1, 2)
                         .set_debug_callback(vulkan_debug_callback)
@@ -49,14 +58,36 @@ Renderer::Renderer(Renderer::CreateDetails create_details)
     };
     instance = inst_ret.value();
 
-    auto surface_ret = glfwCreateWindowSurface(instance, create_details.window->handle(), nullptr, &surface);
-    if (surface_ret != VK_SUCCESS)
+    if (!headless)
     {
-        throw std::runtime_error("Failed to create renderer: Failed to create VkSurfaceKHR");
+        auto surface_ret =
+            glfwCreateWindowSurface(instance, create_details.window->handle(), nullptr, &surface);
+        if (surface_ret != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create renderer: Failed to create VkSurfaceKHR");
+        }
+    }
+
+    // core in 1.2 and required of every 1.2 device, but still has to be enabled
+    VkPhysicalDeviceVulkan12Features features_12{};
+    features_12.timelineSemaphore = VK_TRUE;
+    if (create_details.bindless)
+    {
+        // indexing a runtime sized array with values that differ across a draw, and updating it
+        // while frames that bound it are in flight
+        features_12.descriptorIndexing = VK_TRUE;
+        features_12.runtimeDescriptorArray = VK_TRUE;
+        features_12.descriptorBindingPartiallyBound = VK_TRUE;
+        features_12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        features_12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        features_12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        features_12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        features_12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
     }
 
     vkb::PhysicalDeviceSelector phys_device_selector{ instance };
-    phys_device_selector.set_surface(surface);
+    phys_device_selector.set_required_features_12(features_12);
+    if (!headless) phys_device_selector.set_surface(surface);
     auto phys_dev_ret = phys_device_selector.defer_surface_initialization().select();
     if (!phys_dev_ret)
     {
@@ -64,6 +95,9 @@ Renderer::Renderer(Renderer::CreateDetails create_details)
                                  phys_dev_ret.error().message());
     }
     physical_device = phys_dev_ret.value();
+    // real budgets instead of VMA's estimates, which don't know about other processes
+    bool memory_budget =
+        physical_device.enable_extension_if_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
 
     vkb::DeviceBuilder device_builder{ physical_device };
     auto dev_ret = device_builder.build();
@@ -81,26 +115,78 @@ Renderer::Renderer(Renderer::CreateDetails create_details)
     // if we have a queue, we know we have the index
     graphics_queue = graphics_queue_ret.value();
     graphics_queue_index = device.get_queue_index(vkb::QueueType::graphics).value();
+    // a family other than graphics, preferably a dedicated one
+    VkQueue upload_vk_queue = graphics_queue;
+    uint32_t upload_queue_index = graphics_queue_index;
+    if (create_details.transfer_queue)
+    {
+        auto transfer_queue_ret = device.get_queue(vkb::QueueType::transfer);
+        if (transfer_queue_ret)
+        {
+            upload_vk_queue = transfer_queue_ret.value();
+            upload_queue_index = device.get_queue_index(vkb::QueueType::transfer).value();
+        }
+    }
 
-    delete_queue = vkb::DeletionQueue(device, frames_in_flight + 3);
+    if (create_details.pipeline_cache_path != nullptr)
+        pipeline_cache = std::make_unique<PipelineCache>(
+            PipelineCache::CreateDetails{ .device = device.device,
+                .physical_device = physical_device.physical_device,
+                .path = create_details.pipeline_cache_path });
 
-    vkb::SwapchainBuilder swapchain_builder(device, surface);
+    graphics_timeline =
+        std::make_unique<GpuTimeline>(GpuTimeline::CreateDetails{ .device = device.device });
 
-    auto swapchain_ret = swapchain_builder.build();
-    if (!swapchain_ret.has_value())
-    {
-        throw std::runtime_error("Failed to create renderer: Failed to create swapchain builder with "s +
-                                 swapchain_ret.error().message());
-    }
+    VmaAllocatorCreateInfo allocator_info{};
+    allocator_info.vulkanApiVersion = VK_API_VERSION_1_2;
+    allocator_info.physicalDevice = physical_device.physical_device;
+    allocator_info.device = device.device;
+    allocator_info.instance = instance.instance;
+    if (memory_budget) allocator_info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    if (vmaCreateAllocator(&allocator_info, &allocator) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create renderer: vmaCreateAllocator failed");
+    gpu_memory = std::make_unique<GpuMemory>(GpuMemory::CreateDetails{ .allocator = allocator });
+    release_queue = std::make_unique<DeferredReleaseQueue>(DeferredReleaseQueue::CreateDetails{
+        .device = device.device,
+        .allocator = allocator,
+        .timeline = graphics_timeline.get(),
+        .background_thread = create_details.background_release });
+    bool separate_upload_queue = upload_vk_queue != graphics_queue;
+    upload_queue = std::make_unique<UploadQueue>(UploadQueue::CreateDetails{
+        .device = device.device,
+        .allocator = allocator,
+        .queue = upload_vk_queue,
+        .queue_family_index = upload_queue_index,
+        .graphics_queue_family_index = graphics_queue_index,
+        .bytes_per_frame = create_details.upload_bytes_per_frame,
+        .frame_count = frames_in_flight,
+        .memory = gpu_memory.get(),
+        .graphics_timeline = separate_upload_queue ? graphics_timeline.get() : nullptr });
 
-    auto swapchain_resources_ret = vkb::SwapchainManager::create_swapchain_resources(swapchain_ret.value());
-    if (!swapchain_resources_ret.has_value())
+    if (headless)
+        offscreen_target = std::make_unique<OffscreenTarget>(OffscreenTarget::CreateDetails{
+            .device = device.device,
+            .allocator = allocator,
+            .extent = create_details.offscreen_extent,
+            .format = create_details.offscreen_format,
+            .image_count = frames_in_flight,
+            .memory = gpu_memory.get() });
+    else
+        create_swapchain(create_details.present_mode);
+
+    if (headless && create_details.capture_directory != nullptr)
     {
-        throw std::runtime_error("Failed to create renderer: Failed to create swapchain manager with "s +
-                                 swapchain_ret.error().message());
+        frame_readback = std::make_unique<FrameReadback>(FrameReadback::CreateDetails{
+            .device = device.device,
+            .allocator = allocator,
+            .extent = create_details.offscreen_extent,
+            .format = create_details.offscreen_format,
+            .slot_count = frames_in_flight,
+            .memory = gpu_memory.get() });
+        capture_writer = std::make_unique<ImageSequenceWriter>(ImageSequenceWriter::CreateDetails{
+            .directory = create_details.capture_directory,
+            .format = create_details.capture_format });
     }
-    swapchain_manager = std::make_unique<vkb::SwapchainManager>(
-        device, swapchain_builder, swapchain_ret.value(), swapchain_resources_ret.value());
 
     for (uint32_t i = 0; i < frames_in_flight; i++)
     {
@@ -118,82 +204,339 @@ Renderer::Renderer(Renderer::CreateDetails create_details)
         auto cmd_alloc_res = vkAllocateCommandBuffers(device, &cmd_buf_alloc_info, &frame.command_buffer);
         if (cmd_alloc_res != VK_SUCCESS)
             throw std::runtime_error("Failed to allocate command buffer");
+    }
+
+    // unregistered threads share the index after the job system's threads
+    uint32_t recording_threads = job_system ? job_system->thread_count() + 1 : 1;
+    command_recorder = std::make_unique<CommandRecorder>(CommandRecorder::CreateDetails{
+        .device = device.device,
+        .queue_family_index = graphics_queue_index,
+        .frame_count = frames_in_flight,
+        .thread_count = recording_threads });
+    layout_cache = std::make_unique<DescriptorLayoutCache>(
+        DescriptorLayoutCache::CreateDetails{ .device = device.device });
+    descriptor_allocator = std::make_unique<DescriptorAllocator>(DescriptorAllocator::CreateDetails{
+        .device = device.device,
+        .frame_count = frames_in_flight,
+        .thread_count = recording_threads });
+    if (create_details.bindless)
+        bindless_table = std::make_unique<BindlessTable>(BindlessTable::CreateDetails{
+            .device = device.device,
+            .physical_device = physical_device.physical_device,
+            .layout_cache = layout_cache.get(),
+            .timeline = graphics_timeline.get() });
 
-        VkFenceCreateInfo fence_info{};
-        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-        auto fence_ret = vkCreateFence(device, &fence_info, nullptr, &frame.fence);
-        if (fence_ret != VK_SUCCESS) throw std::runtime_error("Failed to create fence");
+    gpu_profiler = std::make_unique<GpuProfiler>(
+        GpuProfiler::CreateDetails{ .device = device,
+            .physical_device = physical_device.physical_device,
+            .queue_family_index = graphics_queue_index,
+            .frame_count = frames_in_flight });
+
+    frame_graph = std::make_unique<RenderGraph>(RenderGraph::CreateDetails{
+        .device = device.device,
+        .allocator = allocator,
+        .release_queue = release_queue.get(),
+        .gpu_profiler = gpu_profiler.get(),
+        .memory = gpu_memory.get() });
+
+    // last, the warm up function may use anything the renderer created
+    if (pipeline_cache && create_details.pipeline_warm_up)
+    {
+        if (job_system)
+            pipeline_cache->warm_up(
+                *job_system, pipeline_warm_up, std::move(create_details.pipeline_warm_up));
+        else
+            pipeline_cache->warm_up(create_details.pipeline_warm_up);
+    }
+}
+
+void Renderer::create_swapchain(VkPresentModeKHR present_mode)
+{
+    vkb::SwapchainBuilder swapchain_builder(device, surface);
+    swapchain_builder.set_desired_present_mode(present_mode)
+        .add_fallback_present_mode(VK_PRESENT_MODE_FIFO_KHR);
+
+    auto swapchain_ret = swapchain_builder.build();
+    if (!swapchain_ret.has_value())
+    {
+        throw std::runtime_error("Failed to create renderer: Failed to create swapchain builder with "s +
+                                 swapchain_ret.error().message());
+    }
+
+    auto swapchain_resources_ret = vkb::SwapchainManager::create_swapchain_resources(swapchain_ret.value());
+    if (!swapchain_resources_ret.has_value())
+    {
+        throw std::runtime_error("Failed to create renderer: Failed to create swapchain manager with "s +
+                                 swapchain_ret.error().message());
     }
+    swapchain_manager = std::make_unique<vkb::SwapchainManager>(device,
+        swapchain_builder,
+        swapchain_ret.value(),
+        swapchain_resources_ret.value(),
+        frames_in_flight);
 }
 
 Renderer::~Renderer() noexcept
 {
+    if (job_system) job_system->wait(pipeline_warm_up);
     vkQueueWaitIdle(graphics_queue);
-    delete_queue.destroy();
-    swapchain_manager->destroy();
+    // the last frames in flight were never picked up by a later frame
+    if (frame_readback)
+        for (uint32_t i = 0; i < frames_in_flight; i++)
+            write_captured_frame((current_index + i) % frames_in_flight);
+    capture_writer.reset();
+    frame_readback.reset();
+    for (uint32_t i = 0; i < frames_in_flight; i++)
+        vkDestroyCommandPool(device, per_frame_resources[i].command_pool, nullptr);
+    frame_graph.reset();
+    command_recorder.reset();
+    bindless_table.reset();
+    descriptor_allocator.reset();
+    layout_cache.reset();
+    if (swapchain_manager) swapchain_manager->destroy();
+    gpu_profiler.reset();
+    offscreen_target.reset();
+    upload_queue.reset();
+    release_queue.reset();
+    gpu_memory.reset();
+    graphics_timeline.reset();
+    vmaDestroyAllocator(allocator);
 
-    vkDestroySurfaceKHR(instance, surface, nullptr);
+    if (surface != VK_NULL_HANDLE) vkDestroySurfaceKHR(instance, surface, nullptr);
+    if (pipeline_cache)
+    {
+        pipeline_cache->save();
+        pipeline_cache.reset();
+    }
     vkb::destroy_device(device);
     vkb::destroy_instance(instance);
 }
-void Renderer::update() {}
-void Renderer::draw()
+void Renderer::wait_for_frame()
+{
+    if (!low_latency) return;
+    ORANGE_PROFILE_SCOPE("Renderer::wait_for_frame");
+    graphics_timeline->wait(per_frame_resources[current_index].submit_value);
+}
+
+// Runs while the GPU still executes the previous frames, so it must not touch
+// per_frame_resources[current_index]. draw() waits for that frame's submission only once it needs
+// them.
+void Renderer::update() { ORANGE_PROFILE_SCOPE("Renderer::update"); }
+
+int64_t Renderer::wait_for_frame_resources()
+{
+    int64_t start_ns = Profiler::now_ns();
+    ORANGE_PROFILE_SCOPE("Renderer::wait_for_frame_resources");
+    // with a job system the waiting thread keeps running jobs instead of sleeping
+    if (job_system)
+        orange::sync_wait(*job_system, frame_completed(current_index));
+    else
+        graphics_timeline->wait(per_frame_resources[current_index].submit_value);
+    return Profiler::now_ns() - start_ns;
+}
+
+orange::task<void> Renderer::frame_completed(uint32_t frame_index)
+{
+    // spans the suspension, it is recorded on whichever thread resumes the task
+    ORANGE_PROFILE_SCOPE("Renderer::frame_completed");
+    uint64_t value = per_frame_resources[frame_index].submit_value;
+    co_await orange::poll_until(
+        *job_system, [this, value] { return graphics_timeline->is_complete(value); });
+}
+
+// Frame order: wait for the frame's resources, record everything that doesn't need the swapchain
+// image, then acquire, finish recording and submit. The frame's last submission is waited for
+// right before its resources are reused, and acquiring, which may block on presentation, happens
+// after the CPU work.
+void Renderer::draw(BuildFunction const& build)
 {
-    vkb::SwapchainAcquireInfo acquire_info;
-    auto acquire_ret = swapchain_manager->acquire_image();
-    if (!acquire_ret && acquire_ret.error().value() ==
-                            static_cast<int>(vkb::SwapchainManagerError::swapchain_out_of_date))
+    ORANGE_PROFILE_SCOPE("Renderer::draw");
+    int64_t frame_start_ns = Profiler::now_ns();
+    FramePacing::Sample pacing_sample{};
+    if (last_frame_start_ns >= 0) pacing_sample.frame_ns = frame_start_ns - last_frame_start_ns;
+    last_frame_start_ns = frame_start_ns;
+
+    if (job_system && !pipeline_warm_up.is_done()) job_system->wait(pipeline_warm_up);
+    pacing_sample.fence_wait_ns = wait_for_frame_resources();
+    // the GPU is done with this frame index, so is everything allocated for it
+    frame_arena.begin_frame(current_index);
+    write_captured_frame(current_index);
+
+    VkCommandBuffer command_buffer = per_frame_resources[current_index].command_buffer;
+    vkResetCommandPool(device, per_frame_resources[current_index].command_pool, 0);
+    command_recorder->begin_frame(current_index);
+    descriptor_allocator->begin_frame(current_index);
+    gpu_memory->begin_frame(frame_number);
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    // reports the GPU scopes of the last frame that used this index, which the wait above finished
+    gpu_profiler->begin_frame(command_buffer, current_index);
+    // the uploads made since the last frame, this frame's submission waits for them
+    bool uploading = upload_queue->flush() != 0;
+    upload_queue->record_acquires(command_buffer);
+
+    RenderGraph::ImageId target = build_frame_graph(build);
+    // after building, which may add textures the passes use
+    if (bindless_table) bindless_table->flush();
+    frame_graph->compile();
+    // stops at the first pass drawing into the swapchain image, which isn't acquired yet
+    frame_graph->record(command_buffer);
+
+    vkb::SwapchainAcquireInfo acquire_info{};
+    if (swapchain_manager)
     {
-        return;
+        int64_t acquire_start_ns = Profiler::now_ns();
+        auto acquire_ret = swapchain_manager->acquire_image();
+        pacing_sample.acquire_wait_ns = Profiler::now_ns() - acquire_start_ns;
+        // the recorded commands are dropped, the command pool is reset before its next use
+        if (!acquire_ret && acquire_ret.error().value() ==
+                                static_cast<int>(vkb::SwapchainManagerError::swapchain_out_of_date))
+        {
+            vkEndCommandBuffer(command_buffer);
+            return;
+        }
+        else if (!acquire_ret.has_value())
+        {
+            spdlog::error("failed to acquire swapchain image");
+            vkEndCommandBuffer(command_buffer);
+            return;
+        }
+        acquire_info = acquire_ret.value();
+        frame_graph->bind_image(target, acquire_info.image, acquire_info.image_view);
+        frame_graph->record(command_buffer);
     }
-    else if (!acquire_ret.has_value())
+    // after the last early return, the moves have to be submitted once recorded
+    gpu_memory->defragment(
+        command_buffer, *graphics_timeline, defragment_when_idle && !uploading);
+    vkEndCommandBuffer(command_buffer);
+
+    // The swapchain semaphores have to stay binary, everything else is a timeline. Binary
+    // semaphores ignore their entry in the value arrays. Headless frames have no swapchain image
+    // to wait for or to hand to present.
+    uint64_t submit_value = graphics_timeline->next_value();
+    VkSemaphore wait_semaphores[2]{};
+    VkPipelineStageFlags wait_stages[2]{};
+    uint64_t wait_values[2]{};
+    uint32_t wait_count = 0;
+    if (uint64_t upload_value = upload_queue->timeline().last_submitted_value(); upload_value > 0)
     {
-        spdlog::error("failed to acquire swapchain image");
-        return;
+        wait_semaphores[wait_count] = upload_queue->timeline().semaphore();
+        wait_stages[wait_count] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        wait_values[wait_count++] = upload_value;
     }
+    if (swapchain_manager)
+    {
+        wait_semaphores[wait_count] = acquire_info.wait_semaphore;
+        wait_stages[wait_count++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+    VkSemaphore signal_semaphores[2] = { graphics_timeline->semaphore(),
+        acquire_info.signal_semaphore };
+    uint64_t signal_values[2] = { submit_value, 0 };
+    uint32_t signal_count = swapchain_manager ? 2 : 1;
 
-    acquire_info = acquire_ret.value();
-
-    vkWaitForFences(device, 1, &per_frame_resources[current_index].fence, VK_TRUE, UINT64_MAX);
-
-    // record_command_buffer(renderer, command_buffers[current_index], acquire_info.image_view);
-
-    VkSemaphore wait_semaphores[1] = { acquire_info.wait_semaphore };
-    VkSemaphore signal_semaphores[1] = { acquire_info.signal_semaphore };
-    VkPipelineStageFlags wait_stages[1] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    VkTimelineSemaphoreSubmitInfo timeline_info{};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.waitSemaphoreValueCount = wait_count;
+    timeline_info.pWaitSemaphoreValues = wait_values;
+    timeline_info.signalSemaphoreValueCount = signal_count;
+    timeline_info.pSignalSemaphoreValues = signal_values;
 
     VkSubmitInfo submit_info = {};
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info.waitSemaphoreCount = 1;
+    submit_info.pNext = &timeline_info;
+    submit_info.waitSemaphoreCount = wait_count;
     submit_info.pWaitSemaphores = wait_semaphores;
     submit_info.pWaitDstStageMask = wait_stages;
     submit_info.commandBufferCount = 1;
     submit_info.pCommandBuffers = &per_frame_resources[current_index].command_buffer;
-    submit_info.signalSemaphoreCount = 1;
+    submit_info.signalSemaphoreCount = signal_count;
     submit_info.pSignalSemaphores = signal_semaphores;
 
-    // only reset if we are going to submit, this prevents the issue where we reset the fence but try to wait on it again
-    vkResetFences(device, 1, &per_frame_resources[current_index].fence);
-    if (vkQueueSubmit(graphics_queue, 1, &submit_info, per_frame_resources[current_index].fence) != VK_SUCCESS)
+    gpu_profiler->end_frame();
+    if (vkQueueSubmit(graphics_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
     {
         spdlog::error("failed to submit command buffer");
         return;
     }
+    graphics_timeline->submitted(submit_value);
+    upload_queue->acquires_submitted();
+    per_frame_resources[current_index].submit_value = submit_value;
     current_index = (current_index + 1) % frames_in_flight;
+    frame_number++;
+    if (pacing_sample.frame_ns > 0) frame_pacing.record(pacing_sample);
+    ORANGE_PROFILE_COUNTER("Frame wait (us)", pacing_sample.fence_wait_ns / 1000);
+    ORANGE_PROFILE_COUNTER("Acquire wait (us)", pacing_sample.acquire_wait_ns / 1000);
+    release_queue->collect();
 
-    // No need to cancel, if a resize has started, then present will bail
-    auto present_ret = swapchain_manager->present();
-    if (!present_ret && present_ret.error().value() ==
-                            static_cast<int>(vkb::SwapchainManagerError::swapchain_out_of_date))
+    if (swapchain_manager)
     {
-        return;
+        // No need to cancel, if a resize has started, then present will bail
+        auto present_ret = swapchain_manager->present();
+        if (!present_ret && present_ret.error().value() ==
+                                static_cast<int>(vkb::SwapchainManagerError::swapchain_out_of_date))
+        {
+            return;
+        }
+        else if (!present_ret)
+        {
+            spdlog::error("failed to present swapchain image");
+            return;
+        }
     }
-    else if (!present_ret)
+}
+
+void Renderer::write_captured_frame(uint32_t frame_index)
+{
+    if (!frame_readback) return;
+    if (auto frame = frame_readback->take(frame_index))
+        capture_writer->submit(frame->frame_number, frame->image, frame->pixels);
+}
+
+RenderGraph::ImageId Renderer::build_frame_graph(BuildFunction const& build)
+{
+    ORANGE_PROFILE_SCOPE("Renderer::build_frame_graph");
+    frame_graph->begin_frame();
+    RenderGraph::ImageId target;
+    if (offscreen_target)
     {
-        spdlog::error("failed to present swapchain image");
-        return;
+        // every frame starts from a clear and leaves the image ready to be copied out
+        VkImage image = offscreen_target->image(current_index);
+        target = frame_graph->import_image(RenderGraph::ImportedImage{
+            .name = "Offscreen target",
+            .image = image,
+            .view = offscreen_target->image_view(current_index),
+            .final_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL });
+        frame_graph->add_pass(
+            "Clear", { { target, RenderGraph::Usage::transfer_write } }, [image](VkCommandBuffer cmd) {
+                VkClearColorValue clear_color{ { 0.0f, 0.0f, 0.0f, 1.0f } };
+                VkImageSubresourceRange range{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+                vkCmdClearColorImage(
+                    cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear_color, 1, &range);
+            });
     }
-    delete_queue.tick();
-    return;
+    else
+    {
+        // bound once acquired, the acquire semaphore is waited for at color attachment output
+        target = frame_graph->import_image(RenderGraph::ImportedImage{
+            .name = "Swapchain image",
+            .initial_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR });
+    }
+
+    if (build) build(*frame_graph, target);
+
+    if (frame_readback)
+        frame_graph->add_pass(
+            "Readback",
+            { { target, RenderGraph::Usage::transfer_read } },
+            [readback = frame_readback.get(),
+                image = offscreen_target->image(current_index),
+                slot = current_index,
+                number = frame_number](VkCommandBuffer cmd) {
+                readback->record_copy(cmd, image, slot, number);
+            },
+            true);
+    return target;
 }
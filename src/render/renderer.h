@@ -1,12 +1,29 @@
 #pragma once
 
 #include <array>
+#include <functional>
 
-#include "tl/optional.hpp"
 #include "VkBootstrap.h"
+#include "core/frame_allocator.h"
+#include "core/frame_pacing.h"
+#include "core/image_writer.h"
 #include "core/glfw.h"
+#include "core/job_system.h"
+#include "core/task.h"
+#include "bindless_table.h"
+#include "command_recorder.h"
+#include "descriptor_allocator.h"
+#include "descriptor_layout_cache.h"
+#include "deferred_release.h"
+#include "frame_readback.h"
+#include "gpu_memory.h"
+#include "gpu_profiler.h"
+#include "gpu_timeline.h"
+#include "offscreen_target.h"
+#include "pipeline_cache.h"
+#include "render_graph.h"
 #include "swapchain.h"
-#include "vuk/Context.hpp"
+#include "upload_queue.h"
 
 class Renderer
 {
@@ -16,9 +33,47 @@ class Renderer
         const char* app_name;
         const char* engine_name;
         bool enable_validation = true;
-        Window* window;
+        // Optional, without a window the renderer runs headless and draws into an offscreen image
+        // ring, frames are then only limited by the GPU instead of by presentation
+        Window* window = nullptr;
+        // Size and format of the offscreen images when headless
+        VkExtent2D offscreen_extent = { 1280, 720 };
+        VkFormat offscreen_format = VK_FORMAT_R8G8B8A8_UNORM;
+        // Optional, when headless every frame is read back and written into this directory as an
+        // image sequence
+        const char* capture_directory = nullptr;
+        ImageFileFormat capture_format = ImageFileFormat::png;
+        // Optional, when set the thread waiting for an earlier frame runs jobs in the meantime
+        JobSystem* job_system = nullptr;
+        // Frames the CPU may record ahead of the GPU, clamped to 1 to max_frames_in_flight. More
+        // frames keep the GPU busier, fewer frames reduce input latency.
+        uint32_t frames_in_flight = 2;
+        // Falls back to FIFO, the only mode every device supports, when the surface lacks it
+        VkPresentModeKHR present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+        // wait_for_frame() blocks until the GPU finished the frame slot about to be reused, so the
+        // caller samples input right before recording instead of a frame in flight earlier
+        bool low_latency = false;
+        // Destroys released objects on a thread of their own instead of in draw()
+        bool background_release = false;
+        // Optional, pipeline cache file loaded at startup and saved on destruction
+        const char* pipeline_cache_path = nullptr;
+        // Optional, creates the pipeline of a permutation recorded by earlier runs. Called for each
+        // of them once the renderer is created, on the job system's threads when there is one, and
+        // draw() waits for them before recording the first frame. Needs pipeline_cache_path.
+        PipelineCache::WarmupFunction pipeline_warm_up;
+        // Requires the Vulkan 1.2 descriptor indexing features and creates the global bindless
+        // table, devices without them are not selected
+        bool bindless = false;
+        // Uploads run on a transfer queue family of their own when the device has one
+        bool transfer_queue = true;
+        // Staging memory per frame in flight, uploads beyond it wait for a later frame
+        VkDeviceSize upload_bytes_per_frame = VkDeviceSize{ 32 } << 20;
+        // Moves fragmented allocations in frames without uploads, a few per frame
+        bool defragment_when_idle = true;
     };
 
+    static constexpr uint32_t max_frames_in_flight = vkb::MAX_FRAMES_IN_FLIGHT;
+
     Renderer(CreateDetails create_details);
     ~Renderer() noexcept;
     Renderer(Renderer const&) = delete;
@@ -26,33 +81,181 @@ class Renderer
     Renderer(Renderer&& other) noexcept;
     Renderer& operator=(Renderer&& other) noexcept;
 
+    // Call before polling input. In low latency mode, waits for the GPU to finish the frame whose
+    // resources the next draw() reuses. Does nothing otherwise, the wait then happens in draw() as
+    // late as possible.
+    void wait_for_frame();
+
+    // CPU work for the next frame, overlaps the GPU executing the frames in flight
     void update();
 
-    void draw();
+    // Adds the frame's passes to the graph, between clearing `target` and reading it back when
+    // headless. `target` is the swapchain image or the offscreen image.
+    using BuildFunction = std::function<void(RenderGraph& graph, RenderGraph::ImageId target)>;
+    void draw(BuildFunction const& build = {});
+
+    // Calls record(command_buffer, begin, end) for sub ranges of [0, count) on the job system's
+    // threads, each range into a secondary command buffer of its own, then executes them in index
+    // order in `primary`. Meant for the passes of the graph built in draw(). The secondaries are
+    // recorded outside of any render pass.
+    template <typename F>
+        requires std::invocable<F&, VkCommandBuffer, size_t, size_t>
+    void record_parallel(VkCommandBuffer primary, size_t count, F&& record, size_t grain_size = 0)
+    {
+        record_secondaries(primary, nullptr, count, record, grain_size);
+    }
+    // Same, for draws inside the render pass or dynamic rendering instance active in `primary`.
+    // The secondaries continue it as `inheritance` describes: its renderPass and subpass, or for
+    // dynamic rendering a VkCommandBufferInheritanceRenderingInfo chained in pNext with the
+    // attachment formats. The render pass has to be begun with
+    // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, dynamic rendering with
+    // VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT.
+    //
+    //     VkCommandBufferInheritanceRenderingInfo rendering{};
+    //     rendering.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    //     rendering.colorAttachmentCount = 1;
+    //     rendering.pColorAttachmentFormats = &color_format;
+    //     rendering.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    //     VkCommandBufferInheritanceInfo inheritance{};
+    //     inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    //     inheritance.pNext = &rendering;
+    //     renderer.record_parallel(primary, inheritance, draws.size(), record_draws);
+    template <typename F>
+        requires std::invocable<F&, VkCommandBuffer, size_t, size_t>
+    void record_parallel(VkCommandBuffer primary, VkCommandBufferInheritanceInfo const& inheritance,
+        size_t count, F&& record, size_t grain_size = 0)
+    {
+        record_secondaries(primary, &inheritance, count, record, grain_size);
+    }
+
+    // Frame times and where draw() blocked, over the last few seconds of frames
+    [[nodiscard]] FramePacing::Report pacing_report() const { return frame_pacing.report(); }
+
+    // Transient allocations for the frame being recorded, valid until the GPU finished that frame
+    FrameArena& frame_memory() noexcept { return frame_arena; }
+
+    // Vulkan objects released here are destroyed once the GPU finished every frame submitted
+    // before the release and the frame being recorded
+    DeferredReleaseQueue& deferred_release() noexcept { return *release_queue; }
+
+    // Pass handle() to every pipeline creation and warm it up at startup, null without a
+    // pipeline_cache_path
+    [[nodiscard]] PipelineCache* pipelines() noexcept { return pipeline_cache.get(); }
+
+    // Buffer and image uploads from any thread, visible to the next draw() and the frames after it
+    UploadQueue& uploads() noexcept { return *upload_queue; }
+
+    // Heap budgets, memory per category and fragmentation. Track allocations made outside the
+    // renderer here.
+    GpuMemory& memory() noexcept { return *gpu_memory; }
 
+    // Every descriptor set layout should come from here, so equal layouts are shared
+    DescriptorLayoutCache& descriptor_layouts() noexcept { return *layout_cache; }
+    // Descriptor sets valid for the frame being recorded, the thread index is the one
+    // record_parallel() uses
+    DescriptorAllocator& frame_descriptors() noexcept { return *descriptor_allocator; }
+    // Global texture and buffer table, flushed by draw() before recording. Null unless created
+    // with bindless.
+    [[nodiscard]] BindlessTable* bindless() noexcept { return bindless_table.get(); }
+    // Index for frame_descriptors() and the command recorder on the calling thread
+    [[nodiscard]] uint32_t recording_thread_index() const noexcept
+    {
+        return job_system ? job_system->current_thread_index() : 0;
+    }
+
+    [[nodiscard]] uint32_t frame_count() const noexcept { return frames_in_flight; }
+
+    [[nodiscard]] bool is_headless() const noexcept { return offscreen_target != nullptr; }
+    // Images rendered to when headless, frame index i draws into image i. Null with a window.
+    [[nodiscard]] OffscreenTarget* offscreen() noexcept { return offscreen_target.get(); }
 
     private:
+    template <typename F>
+    void record_secondaries(VkCommandBuffer primary,
+        VkCommandBufferInheritanceInfo const* inheritance, size_t count, F& record,
+        size_t grain_size)
+    {
+        VkCommandBufferUsageFlags usage = 0;
+        if (inheritance) usage = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        auto record_range = [this, &record, inheritance, usage](size_t begin, size_t end) {
+            VkCommandBuffer command_buffer =
+                command_recorder->begin(recording_thread_index(), begin, inheritance, usage);
+            record(command_buffer, begin, end);
+            vkEndCommandBuffer(command_buffer);
+        };
+        if (count == 0) return;
+        if (job_system)
+            job_system->parallel_for(0, count, record_range, grain_size);
+        else
+            record_range(0, count);
+        command_recorder->execute(primary);
+    }
+
+    // Blocks until per_frame_resources[current_index] are free, returns the time spent waiting
+    int64_t wait_for_frame_resources();
+    // Completes once the GPU is done with the previous submission of
+    // per_frame_resources[frame_index]
+    orange::task<void> frame_completed(uint32_t frame_index);
+    void create_swapchain(VkPresentModeKHR present_mode);
+    // Returns the frame's target image
+    RenderGraph::ImageId build_frame_graph(BuildFunction const& build);
+    // Hands the frame read back into `frame_index`'s slot to the capture writer, if there is one
+    void write_captured_frame(uint32_t frame_index);
+
+    JobSystem* job_system = nullptr;
+
     vkb::Instance instance;
-    VkSurfaceKHR surface;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
     vkb::PhysicalDevice physical_device;
     vkb::Device device;
     uint32_t graphics_queue_index{};
     VkQueue graphics_queue{};
 
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    std::unique_ptr<GpuMemory> gpu_memory;
+    bool defragment_when_idle = true;
+    std::unique_ptr<PipelineCache> pipeline_cache;
+    JobCounter pipeline_warm_up;
+    // Counts graphics queue submissions, replaces per frame fences
+    std::unique_ptr<GpuTimeline> graphics_timeline;
+    std::unique_ptr<DeferredReleaseQueue> release_queue;
+    // On the transfer queue when there is one, flushed by draw() and waited for by its submission
+    std::unique_ptr<UploadQueue> upload_queue;
+
+    // Exactly one of these exists, depending on whether a window was given
     std::unique_ptr<vkb::SwapchainManager> swapchain_manager;
+    std::unique_ptr<OffscreenTarget> offscreen_target;
     vkb::SwapchainInfo swap_info;
-    vkb::DeletionQueue delete_queue;
-
-    tl::optional<vuk::Context> context;
 
-    static const int frames_in_flight = 2;
+    uint32_t frames_in_flight = 2;
+    bool low_latency = false;
     uint32_t current_index = 0;
     struct PerFrame
     {
         VkCommandPool command_pool;
         VkCommandBuffer command_buffer;
-        VkFence fence;
+        // Graphics timeline value signaled by the last submission using these, 0 when unused
+        uint64_t submit_value;
     };
 
-    std::array<PerFrame, frames_in_flight> per_frame_resources;
+    // only the first frames_in_flight are used
+    std::array<PerFrame, max_frames_in_flight> per_frame_resources{};
+    // Secondary command buffers of every thread, merged into the frame's command buffer
+    std::unique_ptr<CommandRecorder> command_recorder;
+    std::unique_ptr<DescriptorLayoutCache> layout_cache;
+    // Per-frame sets of every thread, reset together with the command recorder
+    std::unique_ptr<DescriptorAllocator> descriptor_allocator;
+    std::unique_ptr<BindlessTable> bindless_table;
+    // Rebuilt every frame, keeps its transient images across frames
+    std::unique_ptr<RenderGraph> frame_graph;
+    FrameArena frame_arena;
+    std::unique_ptr<GpuProfiler> gpu_profiler;
+
+    // Only when capturing a headless renderer
+    std::unique_ptr<FrameReadback> frame_readback;
+    std::unique_ptr<ImageSequenceWriter> capture_writer;
+    uint64_t frame_number = 0;
+
+    FramePacing frame_pacing{ FramePacing::CreateDetails{} };
+    int64_t last_frame_start_ns = -1;
 };
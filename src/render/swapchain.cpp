@@ -2,6 +2,8 @@
 
 #include <assert.h>
 
+#include "core/profiler.h"
+
 #if !defined(NDEBUG)
 #define VKB_CHECK(x)                                                                               \
     do                                                                                             \
@@ -66,7 +68,7 @@ ImagelessFramebufferBuilder::ImagelessFramebufferBuilder(Device const& device) n
 }
 VkFramebuffer ImagelessFramebufferBuilder::build() noexcept
 {
-    std::vector<VkFramebufferAttachmentImageInfo> attachment_infos;
+    pool_vector<VkFramebufferAttachmentImageInfo> attachment_infos;
     for (auto& attachment : _attachments)
     {
         VkFramebufferAttachmentImageInfo attach_image_info{};
@@ -252,9 +254,13 @@ void DeletionQueue::destroy() noexcept
 }
 
 // Swapchain Synchronization resources (semaphores, fences, & tracking)
-SemaphoreManager::SemaphoreManager(VkDevice device, uint32_t image_count) noexcept : device(device)
+SemaphoreManager::SemaphoreManager(
+    VkDevice device, uint32_t image_count, uint32_t frames_in_flight) noexcept
+: device(device)
 {
+    assert(frames_in_flight >= 1 && frames_in_flight <= MAX_FRAMES_IN_FLIGHT);
     detail.swapchain_image_count = image_count;
+    detail.frames_in_flight = frames_in_flight;
 
     VkSemaphoreCreateInfo info{};
     info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -270,7 +276,7 @@ SemaphoreManager::SemaphoreManager(VkDevice device, uint32_t image_count) noexce
     {
         VKB_CHECK(vkCreateSemaphore(device, &info, nullptr, &semaphore));
     }
-    for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < detail.frames_in_flight; i++)
         detail.expired_semaphores[i].reserve(10);
     detail.current_acquire_semaphore = get_fresh_semaphore();
 }
@@ -319,7 +325,7 @@ void SemaphoreManager::update_current_semaphore_index(uint32_t index) noexcept
     detail.current_swapchain_index = index;
     std::swap(detail.active_acquire_semaphores[index], detail.current_acquire_semaphore);
     detail.in_use[index] = true;
-    detail.current_submit_index = (detail.current_submit_index + 1) % FRAMES_IN_FLIGHT;
+    detail.current_submit_index = (detail.current_submit_index + 1) % detail.frames_in_flight;
     detail.idle_semaphores.insert(detail.idle_semaphores.end(),
         detail.expired_semaphores[detail.current_submit_index].begin(),
         detail.expired_semaphores[detail.current_submit_index].end());
@@ -393,7 +399,8 @@ Result<vkb::SwapchainManager> convert(Result<vkb::Swapchain> err)
     }
 }
 
-Result<SwapchainManager> SwapchainManager::create(Device const& device, SwapchainBuilder const& builder) noexcept
+Result<SwapchainManager> SwapchainManager::create(
+    Device const& device, SwapchainBuilder const& builder, uint32_t frames_in_flight) noexcept
 {
     auto swapchain_ret = builder.build();
     if (!swapchain_ret.has_value())
@@ -406,16 +413,20 @@ Result<SwapchainManager> SwapchainManager::create(Device const& device, Swapchai
     {
         return swapchain_resources_ret.error();
     }
-    return SwapchainManager(device, builder, swapchain_ret.value(), swapchain_resources_ret.value());
+    return SwapchainManager(
+        device, builder, swapchain_ret.value(), swapchain_resources_ret.value(), frames_in_flight);
 }
 
-SwapchainManager::SwapchainManager(
-    Device const& device, SwapchainBuilder const& builder, vkb::Swapchain swapchain, SwapchainResources resources) noexcept
+SwapchainManager::SwapchainManager(Device const& device,
+    SwapchainBuilder const& builder,
+    vkb::Swapchain swapchain,
+    SwapchainResources resources,
+    uint32_t frames_in_flight) noexcept
 : device(device.device),
   detail({ builder,
       swapchain,
       resources,
-      SemaphoreManager(device, swapchain.image_count),
+      SemaphoreManager(device, swapchain.image_count, frames_in_flight),
       DeletionQueue(device, swapchain.image_count) })
 {
 
@@ -478,6 +489,7 @@ Result<SwapchainResources> SwapchainManager::get_swapchain_resources() noexcept
 
 Result<SwapchainAcquireInfo> SwapchainManager::acquire_image() noexcept
 {
+    ORANGE_PROFILE_SCOPE("SwapchainManager::acquire_image");
     assert(detail.current_status != Status::destroyed && "SwapchainManager was destroyed!");
     if (detail.current_status == Status::expired)
     {
@@ -487,6 +499,7 @@ Result<SwapchainAcquireInfo> SwapchainManager::acquire_image() noexcept
     {
         // dont do anything
         SwapchainAcquireInfo out{};
+        out.image = detail.swapchain_resources.images[detail.current_image_index];
         out.image_view = detail.swapchain_resources.image_views[detail.current_image_index];
         out.image_index = detail.current_image_index;
         out.wait_semaphore = detail.semaphore_manager.get_acquire_semaphore();
@@ -525,6 +538,7 @@ Result<SwapchainAcquireInfo> SwapchainManager::acquire_image() noexcept
     detail.semaphore_manager.update_current_semaphore_index(detail.current_image_index);
     detail.current_status = Status::ready_to_present;
     SwapchainAcquireInfo out{};
+    out.image = detail.swapchain_resources.images[detail.current_image_index];
     out.image_view = detail.swapchain_resources.image_views[detail.current_image_index];
     out.image_index = detail.current_image_index;
     out.wait_semaphore = detail.semaphore_manager.get_acquire_semaphore();
@@ -534,6 +548,7 @@ Result<SwapchainAcquireInfo> SwapchainManager::acquire_image() noexcept
 
 Result<detail::E> SwapchainManager::present() noexcept
 {
+    ORANGE_PROFILE_SCOPE("SwapchainManager::present");
     assert(detail.current_status != Status::destroyed && "SwapchainManager was destroyed!");
     if (detail.current_status == Status::expired)
     {
@@ -635,11 +650,13 @@ Result<SwapchainResources> SwapchainManager::create_swapchain_resources(vkb::Swa
     SwapchainResources out{};
     out.swapchain = swapchain.swapchain;
     out.image_count = swapchain.image_count;
-    assert(out.image_count <= MAX_SWAPCHAIN_IMAGE_COUNT);
 
     VkResult result = vkGetSwapchainImagesKHR(swapchain.device, swapchain.swapchain, &out.image_count, nullptr);
     if (result != VK_SUCCESS)
         return { make_error_code(SwapchainManagerError::failed_get_swapchain_images), result };
+    // present modes like mailbox can get more images than asked for, which wouldn't fit the arrays
+    if (out.image_count > MAX_SWAPCHAIN_IMAGE_COUNT)
+        return { make_error_code(SwapchainManagerError::failed_get_swapchain_images) };
 
     result = vkGetSwapchainImagesKHR(
         swapchain.device, swapchain.swapchain, &out.image_count, out.images.data());
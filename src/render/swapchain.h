@@ -3,6 +3,7 @@
 #include <array>
 
 #include "VkBootstrap.h"
+#include "core/pool_allocator.h"
 
 namespace vkb
 {
@@ -26,8 +27,9 @@ std::error_code make_error_code(SwapchainManagerError swapchain_error);
 const char* to_string(SwapchainManagerError err);
 
 const uint32_t INDEX_MAX_VALUE = 65536;
-const int FRAMES_IN_FLIGHT = 2;
-const int MAX_SWAPCHAIN_IMAGE_COUNT = 8;
+// Upper bounds for the fixed size arrays below, the actual counts are chosen at runtime
+const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+const uint32_t MAX_SWAPCHAIN_IMAGE_COUNT = 8;
 
 // ImagelessFramebufferBuilder
 
@@ -109,10 +111,10 @@ class DeletionQueue
     private:
     struct DelaySets
     {
-        std::vector<VkImage> images;
-        std::vector<VkImageView> views;
-        std::vector<VkFramebuffer> framebuffers;
-        std::vector<VkSwapchainKHR> swapchains;
+        pool_vector<VkImage> images;
+        pool_vector<VkImageView> views;
+        pool_vector<VkFramebuffer> framebuffers;
+        pool_vector<VkSwapchainKHR> swapchains;
     };
     VkDevice device;
     uint32_t queue_depth = 0;
@@ -132,7 +134,11 @@ class SemaphoreManager
 {
     public:
     explicit SemaphoreManager() noexcept = default;
-    explicit SemaphoreManager(VkDevice device, uint32_t image_count) noexcept;
+    // frames_in_flight is how many submissions may be pending at once, semaphores retired by a
+    // recreate are only reused once that many images were acquired since. At most
+    // MAX_FRAMES_IN_FLIGHT.
+    explicit SemaphoreManager(
+        VkDevice device, uint32_t image_count, uint32_t frames_in_flight) noexcept;
     ~SemaphoreManager() noexcept;
     SemaphoreManager(SemaphoreManager const& other) = delete;
     SemaphoreManager& operator=(SemaphoreManager const& other) = delete;
@@ -151,13 +157,14 @@ class SemaphoreManager
     struct Details
     {
         uint32_t swapchain_image_count = 0;
+        uint32_t frames_in_flight = 0;
         uint32_t current_swapchain_index = INDEX_MAX_VALUE;
         std::array<bool, MAX_SWAPCHAIN_IMAGE_COUNT> in_use = {};
         std::array<VkSemaphore, MAX_SWAPCHAIN_IMAGE_COUNT> active_acquire_semaphores{};
         std::array<VkSemaphore, MAX_SWAPCHAIN_IMAGE_COUNT> active_submit_semaphores{};
         uint32_t current_submit_index = 0;
-        std::array<std::vector<VkSemaphore>, FRAMES_IN_FLIGHT> expired_semaphores;
-        std::vector<VkSemaphore> idle_semaphores;
+        std::array<pool_vector<VkSemaphore>, MAX_FRAMES_IN_FLIGHT> expired_semaphores;
+        pool_vector<VkSemaphore> idle_semaphores;
         VkSemaphore current_acquire_semaphore = VK_NULL_HANDLE;
     } detail;
     void destroy() noexcept;
@@ -190,7 +197,8 @@ struct SwapchainResources
 // Struct returned from SwapchainManager::acquire_image()
 struct SwapchainAcquireInfo
 {
-    // image view to use this frame
+    // image and image view to use this frame
+    VkImage image{};
     VkImageView image_view{};
     // index of the swapchain image to use this frame
     uint32_t image_index = INDEX_MAX_VALUE;
@@ -307,10 +315,15 @@ struct E
 class SwapchainManager
 {
     public:
-    explicit SwapchainManager(
-        Device const& device, SwapchainBuilder const& builder, Swapchain swapchain, SwapchainResources resources) noexcept;
-
-    static Result<SwapchainManager> create(Device const& device, SwapchainBuilder const& builder) noexcept;
+    explicit SwapchainManager(Device const& device,
+        SwapchainBuilder const& builder,
+        Swapchain swapchain,
+        SwapchainResources resources,
+        uint32_t frames_in_flight = 2) noexcept;
+
+    static Result<SwapchainManager> create(Device const& device,
+        SwapchainBuilder const& builder,
+        uint32_t frames_in_flight = 2) noexcept;
 
     explicit SwapchainManager() = default;
     ~SwapchainManager() noexcept;
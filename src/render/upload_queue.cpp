@@ -0,0 +1,570 @@
+#include "upload_queue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#include "core/profiler.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+// Allocations are rounded up to this, which keeps the head aligned for the usual 4, 8 and 16 byte
+// texel blocks. Other block sizes pad the start of their allocation, see upload_image().
+constexpr VkDeviceSize ring_alignment = 16;
+
+VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) noexcept
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VkImageSubresourceRange to_range(VkImageSubresourceLayers const& layers) noexcept
+{
+    return VkImageSubresourceRange{
+        layers.aspectMask, layers.mipLevel, 1, layers.baseArrayLayer, layers.layerCount };
+}
+
+bool same_subresource(
+    VkImageSubresourceLayers const& a, VkImageSubresourceLayers const& b) noexcept
+{
+    return a.aspectMask == b.aspectMask && a.mipLevel == b.mipLevel &&
+           a.baseArrayLayer == b.baseArrayLayer && a.layerCount == b.layerCount;
+}
+bool overlaps(uint32_t a_begin, uint32_t a_size, uint32_t b_begin, uint32_t b_size) noexcept
+{
+    return a_begin < b_begin + b_size && b_begin < a_begin + a_size;
+}
+
+bool overlaps(VkOffset3D a, VkExtent3D a_extent, VkOffset3D b, VkExtent3D b_extent) noexcept
+{
+    auto axis = [](int32_t a_begin, uint32_t a_size, int32_t b_begin, uint32_t b_size) {
+        return int64_t{ a_begin } < int64_t{ b_begin } + b_size &&
+               int64_t{ b_begin } < int64_t{ a_begin } + a_size;
+    };
+    return axis(a.x, a_extent.width, b.x, b_extent.width) &&
+           axis(a.y, a_extent.height, b.y, b_extent.height) &&
+           axis(a.z, a_extent.depth, b.z, b_extent.depth);
+}
+
+bool overlaps(VkBufferImageCopy const& a, VkBufferImageCopy const& b) noexcept
+{
+    auto const& a_layers = a.imageSubresource;
+    auto const& b_layers = b.imageSubresource;
+    return (a_layers.aspectMask & b_layers.aspectMask) != 0 &&
+           a_layers.mipLevel == b_layers.mipLevel &&
+           overlaps(a_layers.baseArrayLayer, a_layers.layerCount, b_layers.baseArrayLayer,
+               b_layers.layerCount) &&
+           overlaps(a.imageOffset, a.imageExtent, b.imageOffset, b.imageExtent);
+}
+} // namespace
+
+UploadQueue::UploadQueue(CreateDetails create_details)
+: device(create_details.device), allocator(create_details.allocator), memory(create_details.memory),
+  queue(create_details.queue), queue_family_index(create_details.queue_family_index),
+  graphics_queue_family_index(create_details.graphics_queue_family_index),
+  graphics_timeline(create_details.graphics_timeline),
+  upload_timeline(GpuTimeline::CreateDetails{ .device = create_details.device }),
+  ring_capacity(align_up(
+      create_details.bytes_per_frame * std::max(create_details.frame_count, 1u), ring_alignment))
+{
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = ring_capacity;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    // written once front to back with memcpy, which write combined memory handles well
+    VmaAllocationCreateInfo allocation_info{};
+    allocation_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+    allocation_info.flags =
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    VmaAllocationInfo allocation_result{};
+    VkResult result = vmaCreateBuffer(allocator,
+        &buffer_info,
+        &allocation_info,
+        &staging_buffer,
+        &staging_allocation,
+        &allocation_result);
+    if (result != VK_SUCCESS)
+        throw std::runtime_error("Failed to create upload queue: vmaCreateBuffer failed with "s +
+                                 std::to_string(result));
+    mapped = static_cast<uint8_t*>(allocation_result.pMappedData);
+    if (memory) memory->track(staging_allocation, MemoryCategory::staging);
+}
+
+UploadQueue::~UploadQueue() noexcept
+{
+    upload_timeline.wait(upload_timeline.last_submitted_value());
+    // destroying a pool frees its command buffer
+    for (auto const& submission : submissions)
+        vkDestroyCommandPool(device, submission.command_pool, nullptr);
+    if (memory) memory->untrack(staging_allocation);
+    vmaDestroyBuffer(allocator, staging_buffer, staging_allocation);
+}
+
+bool UploadQueue::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+    while (!regions.empty() && upload_timeline.is_complete(regions.front().value))
+    {
+        tail = regions.front().end;
+        used -= regions.front().bytes;
+        regions.pop_front();
+    }
+    if (used == 0) head = tail = 0;
+
+    // the bytes between head and an aligned start are skipped, like the end when wrapping around
+    VkDeviceSize start = align_up(head, alignment);
+    VkDeviceSize skipped = start - head;
+    if (used == 0 || head > tail)
+    {
+        // free space is [head, capacity) and [0, tail)
+        if (start <= ring_capacity && ring_capacity - start >= size)
+            offset = start;
+        else if (tail >= size)
+        {
+            skipped = ring_capacity - head;
+            offset = 0;
+        }
+        else
+            return false;
+    }
+    else if (start <= tail && tail - start >= size) // head < tail, or full when equal
+        offset = start;
+    else
+        return false;
+
+    head = offset + size;
+    used += skipped + size;
+    batch_bytes += skipped + size;
+    return true;
+}
+
+bool UploadQueue::upload_buffer(
+    VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size)
+{
+    if (size == 0) return true;
+    VkDeviceSize aligned_size = align_up(size, ring_alignment);
+    if (aligned_size > ring_capacity)
+        throw std::runtime_error("Failed to upload buffer: "s + std::to_string(size) +
+                                 " bytes are more than the staging ring holds");
+    // the copy happens under the lock, flush() must not submit a region that is still written
+    std::lock_guard lock(mutex);
+    VkDeviceSize staging_offset = 0;
+    if (!allocate(aligned_size, ring_alignment, staging_offset)) return false;
+    std::memcpy(mapped + staging_offset, data, size);
+    buffer_copies.push_back(
+        BufferCopy{ buffer, VkBufferCopy{ staging_offset, offset, size }, buffer_copies.size() });
+    return true;
+}
+
+bool UploadQueue::upload_image(VkImage image, VkImageSubresourceLayers subresource,
+    VkOffset3D offset, VkExtent3D extent, uint32_t texel_block_size, const void* data,
+    VkDeviceSize size, VkImageLayout final_layout)
+{
+    if (size == 0) return true;
+    if (texel_block_size == 0)
+        throw std::runtime_error("Failed to upload image: the texel block size is 0");
+    VkDeviceSize aligned_size = align_up(size, ring_alignment);
+    if (aligned_size > ring_capacity)
+        throw std::runtime_error("Failed to upload image: "s + std::to_string(size) +
+                                 " bytes are more than the staging ring holds");
+    // vkCmdCopyBufferToImage needs bufferOffset to be a multiple of the texel block size, and of
+    // 4 for depth and stencil
+    VkDeviceSize alignment = std::lcm(VkDeviceSize{ texel_block_size }, VkDeviceSize{ 4 });
+    std::lock_guard lock(mutex);
+    VkDeviceSize staging_offset = 0;
+    if (!allocate(aligned_size, alignment, staging_offset)) return false;
+    std::memcpy(mapped + staging_offset, data, size);
+    VkBufferImageCopy region{};
+    region.bufferOffset = staging_offset;
+    region.imageSubresource = subresource;
+    region.imageOffset = offset;
+    region.imageExtent = extent;
+    image_copies.push_back(ImageCopy{ image, region, final_layout });
+    return true;
+}
+
+uint64_t UploadQueue::flush()
+{
+    ORANGE_PROFILE_SCOPE("UploadQueue::flush");
+    uint64_t value = upload_timeline.next_value();
+    {
+        std::lock_guard lock(mutex);
+        if (buffer_copies.empty() && image_copies.empty()) return 0;
+        recording_buffer_copies.swap(buffer_copies);
+        recording_image_copies.swap(image_copies);
+        buffer_copies.clear();
+        image_copies.clear();
+        regions.push_back(Region{ head, batch_bytes, value });
+        ORANGE_PROFILE_COUNTER("Upload bytes", batch_bytes);
+        batch_bytes = 0;
+    }
+    // a no-op on host coherent memory
+    vmaFlushAllocation(allocator, staging_allocation, 0, VK_WHOLE_SIZE);
+
+    VkCommandBuffer command_buffer = begin_submission(value);
+    // Overwriting what an earlier batch wrote, or what earlier work on this queue still reads,
+    // waits for it. The image transitions below use the same source scope.
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+    record_buffer_copies(command_buffer);
+    record_image_copies(command_buffer);
+    vkEndCommandBuffer(command_buffer);
+
+    // a separate queue isn't ordered by the barrier, the frames reading the destinations may still
+    // run on the graphics queue
+    VkSemaphore wait_semaphore = VK_NULL_HANDLE;
+    VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    uint64_t wait_value = graphics_timeline ? graphics_timeline->last_submitted_value() : 0;
+    uint32_t wait_count = 0;
+    if (wait_value > 0)
+    {
+        wait_semaphore = graphics_timeline->semaphore();
+        wait_count = 1;
+    }
+    VkSemaphore signal_semaphore = upload_timeline.semaphore();
+    VkTimelineSemaphoreSubmitInfo timeline_info{};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.waitSemaphoreValueCount = wait_count;
+    timeline_info.pWaitSemaphoreValues = &wait_value;
+    timeline_info.signalSemaphoreValueCount = 1;
+    timeline_info.pSignalSemaphoreValues = &value;
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = &timeline_info;
+    submit_info.waitSemaphoreCount = wait_count;
+    submit_info.pWaitSemaphores = &wait_semaphore;
+    submit_info.pWaitDstStageMask = &wait_stage;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &signal_semaphore;
+    VkResult result = vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE);
+    if (result != VK_SUCCESS)
+        throw std::runtime_error(
+            "Failed to flush uploads: vkQueueSubmit failed with "s + std::to_string(result));
+    upload_timeline.submitted(value);
+    return value;
+}
+
+VkCommandBuffer UploadQueue::begin_submission(uint64_t value)
+{
+    // a few submissions are in flight at most, the oldest finished one is reused
+    auto it = std::find_if(submissions.begin(), submissions.end(),
+        [this](Submission const& submission) {
+            return upload_timeline.is_complete(submission.value);
+        });
+    if (it == submissions.end())
+    {
+        Submission submission{};
+        VkCommandPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        pool_info.queueFamilyIndex = queue_family_index;
+        VkResult result =
+            vkCreateCommandPool(device, &pool_info, nullptr, &submission.command_pool);
+        if (result != VK_SUCCESS)
+            throw std::runtime_error(
+                "Failed to flush uploads: vkCreateCommandPool failed with "s +
+                std::to_string(result));
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = submission.command_pool;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandBufferCount = 1;
+        result = vkAllocateCommandBuffers(device, &alloc_info, &submission.command_buffer);
+        if (result != VK_SUCCESS)
+        {
+            vkDestroyCommandPool(device, submission.command_pool, nullptr);
+            throw std::runtime_error(
+                "Failed to flush uploads: vkAllocateCommandBuffers failed with "s +
+                std::to_string(result));
+        }
+        submissions.push_back(submission);
+        it = submissions.end() - 1;
+    }
+    else
+        vkResetCommandPool(device, it->command_pool, 0);
+    it->value = value;
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(it->command_buffer, &begin_info);
+    return it->command_buffer;
+}
+
+void UploadQueue::record_buffer_copies(VkCommandBuffer command_buffer)
+{
+    auto& copies = recording_buffer_copies;
+    if (copies.empty()) return;
+    std::stable_sort(copies.begin(), copies.end(), [](BufferCopy const& a, BufferCopy const& b) {
+        if (a.buffer != b.buffer) return a.buffer < b.buffer;
+        return a.region.dstOffset < b.region.dstOffset;
+    });
+
+    auto add_region = [this](VkBufferCopy const& region) {
+        // uploads made one after another usually sit next to each other on both sides
+        if (!merged_regions.empty())
+        {
+            VkBufferCopy& previous = merged_regions.back();
+            if (previous.srcOffset + previous.size == region.srcOffset &&
+                previous.dstOffset + previous.size == region.dstOffset)
+            {
+                previous.size += region.size;
+                return;
+            }
+        }
+        merged_regions.push_back(region);
+    };
+    // Regions of one copy command must not overlap, and the latest upload has to win. Within a
+    // run of overlapping uploads every stretch between two region boundaries is copied from the
+    // latest upload covering it, what earlier uploads wrote there is dropped.
+    auto add_overlapping = [&](size_t begin, size_t end) {
+        boundaries.clear();
+        for (size_t i = begin; i < end; i++)
+        {
+            boundaries.push_back(copies[i].region.dstOffset);
+            boundaries.push_back(copies[i].region.dstOffset + copies[i].region.size);
+        }
+        std::sort(boundaries.begin(), boundaries.end());
+        boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+        for (size_t b = 0; b + 1 < boundaries.size(); b++)
+        {
+            const BufferCopy* latest = nullptr;
+            for (size_t i = begin; i < end; i++)
+            {
+                auto const& region = copies[i].region;
+                bool covers = region.dstOffset <= boundaries[b] &&
+                              region.dstOffset + region.size >= boundaries[b + 1];
+                if (covers && (latest == nullptr || copies[i].sequence > latest->sequence))
+                    latest = &copies[i];
+            }
+            if (latest == nullptr) continue;
+            VkDeviceSize skipped = boundaries[b] - latest->region.dstOffset;
+            add_region(VkBufferCopy{ latest->region.srcOffset + skipped,
+                boundaries[b],
+                boundaries[b + 1] - boundaries[b] });
+        }
+    };
+
+    buffer_barriers.clear();
+    size_t region_count = 0;
+    size_t first = 0;
+    while (first < copies.size())
+    {
+        VkBuffer buffer = copies[first].buffer;
+        merged_regions.clear();
+        size_t last = first;
+        while (last < copies.size() && copies[last].buffer == buffer)
+        {
+            // the run of uploads overlapping each other, sorted by offset they are adjacent
+            size_t end = last + 1;
+            VkDeviceSize run_end = copies[last].region.dstOffset + copies[last].region.size;
+            for (; end < copies.size() && copies[end].buffer == buffer &&
+                   copies[end].region.dstOffset < run_end;
+                 end++)
+                run_end = std::max(run_end, copies[end].region.dstOffset + copies[end].region.size);
+            if (end == last + 1)
+                add_region(copies[last].region);
+            else
+                add_overlapping(last, end);
+            last = end;
+        }
+        vkCmdCopyBuffer(command_buffer,
+            staging_buffer,
+            buffer,
+            static_cast<uint32_t>(merged_regions.size()),
+            merged_regions.data());
+        region_count += merged_regions.size();
+
+        if (transfers_ownership())
+            for (auto const& region : merged_regions)
+            {
+                VkBufferMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.srcQueueFamilyIndex = queue_family_index;
+                barrier.dstQueueFamilyIndex = graphics_queue_family_index;
+                barrier.buffer = buffer;
+                barrier.offset = region.dstOffset;
+                barrier.size = region.size;
+                buffer_barriers.push_back(barrier);
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+                buffer_acquires.push_back(barrier);
+            }
+        first = last;
+    }
+    copies.clear();
+    ORANGE_PROFILE_COUNTER("Upload buffer copies", region_count);
+
+    // releases to the graphics queue family. Within one family the semaphore the frame waits on
+    // makes the writes visible.
+    if (!buffer_barriers.empty())
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0,
+            nullptr,
+            static_cast<uint32_t>(buffer_barriers.size()),
+            buffer_barriers.data(),
+            0,
+            nullptr);
+}
+
+void UploadQueue::record_image_copies(VkCommandBuffer command_buffer)
+{
+    auto& copies = recording_image_copies;
+    if (copies.empty()) return;
+    // grouped by image, in upload order within an image
+    std::stable_sort(copies.begin(), copies.end(),
+        [](ImageCopy const& a, ImageCopy const& b) { return a.image < b.image; });
+
+    // one transition per written subresource, regions of the same subresource share it
+    image_barriers.clear();
+    final_layouts.clear();
+    for (size_t i = 0; i < copies.size(); i++)
+    {
+        auto const& subresource = copies[i].region.imageSubresource;
+        bool seen = false;
+        for (size_t j = i; j-- > 0 && copies[j].image == copies[i].image;)
+            seen = seen || same_subresource(copies[j].region.imageSubresource, subresource);
+        if (seen) continue;
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = copies[i].image;
+        barrier.subresourceRange = to_range(subresource);
+        image_barriers.push_back(barrier);
+        final_layouts.push_back(copies[i].final_layout);
+    }
+    // after earlier batches writing and earlier work on this queue reading the subresources
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        static_cast<uint32_t>(image_barriers.size()),
+        image_barriers.data());
+
+    auto copy_regions = [&](VkImage image) {
+        vkCmdCopyBufferToImage(command_buffer,
+            staging_buffer,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(image_regions.size()),
+            image_regions.data());
+        image_regions.clear();
+    };
+    size_t first = 0;
+    while (first < copies.size())
+    {
+        VkImage image = copies[first].image;
+        size_t last = first;
+        for (; last < copies.size() && copies[last].image == image; last++)
+        {
+            // Regions of one copy command must not overlap. A region rewriting texels of an
+            // earlier one starts a new copy, ordered after the previous so the later upload wins.
+            auto const& region = copies[last].region;
+            bool overlapping = std::any_of(image_regions.begin(), image_regions.end(),
+                [&region](VkBufferImageCopy const& other) { return overlaps(region, other); });
+            if (overlapping)
+            {
+                copy_regions(image);
+                VkMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                vkCmdPipelineBarrier(command_buffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0,
+                    1,
+                    &barrier,
+                    0,
+                    nullptr,
+                    0,
+                    nullptr);
+            }
+            image_regions.push_back(region);
+        }
+        copy_regions(image);
+        first = last;
+    }
+
+    // to the final layout, and to the graphics queue family when it differs. The acquire repeats
+    // the same layout transition, as ownership transfers require.
+    for (size_t i = 0; i < image_barriers.size(); i++)
+    {
+        auto& barrier = image_barriers[i];
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = final_layouts[i];
+        if (!transfers_ownership()) continue;
+        barrier.srcQueueFamilyIndex = queue_family_index;
+        barrier.dstQueueFamilyIndex = graphics_queue_family_index;
+        VkImageMemoryBarrier acquire = barrier;
+        acquire.srcAccessMask = 0;
+        acquire.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        image_acquires.push_back(acquire);
+    }
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        static_cast<uint32_t>(image_barriers.size()),
+        image_barriers.data());
+    ORANGE_PROFILE_COUNTER("Upload image copies", copies.size());
+    copies.clear();
+}
+
+void UploadQueue::record_acquires(VkCommandBuffer command_buffer)
+{
+    if (buffer_acquires.empty() && image_acquires.empty()) return;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        0,
+        nullptr,
+        static_cast<uint32_t>(buffer_acquires.size()),
+        buffer_acquires.data(),
+        static_cast<uint32_t>(image_acquires.size()),
+        image_acquires.data());
+}
+
+void UploadQueue::acquires_submitted() noexcept
+{
+    buffer_acquires.clear();
+    image_acquires.clear();
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+
+#include "gpu_memory.h"
+#include "gpu_timeline.h"
+
+// Streams buffer and image data to the GPU through a persistently mapped staging ring.
+//
+// Uploads are copied into the ring right away and batched until flush(), which records all of
+// them into one command buffer, merging copies that are contiguous in both the ring and the
+// destination, and submits it. With a transfer queue the copies run there, next to the graphics
+// work, and the destinations' ownership is handed over to the graphics queue family through
+// record_acquires(). Submissions signal the queue's own timeline, which the frame using the data
+// waits on.
+//
+// Each submission starts with a barrier ordering it after the previous one and after earlier work
+// on the same queue, so re-uploading data still read by a frame is safe. On a separate queue the
+// submission waits for everything submitted to the graphics timeline before it instead.
+//
+// Ring space is freed once the timeline passed the submission that read it. An upload that
+// doesn't fit right now returns false and should be retried after the next frame, the uploading
+// thread never blocks on the GPU.
+//
+//     if (!uploads.upload_buffer(vertex_buffer, 0, vertices.data(), vertices.size_bytes()))
+//         retry_next_frame();
+//     // on the submitting thread, once per frame
+//     uploads.flush();
+//     uploads.record_acquires(frame_command_buffer);
+//     // the frame's submission waits on timeline() at timeline().last_submitted_value()
+//     uploads.acquires_submitted();
+class UploadQueue
+{
+    public:
+    struct CreateDetails
+    {
+        VkDevice device = VK_NULL_HANDLE;
+        VmaAllocator allocator = VK_NULL_HANDLE;
+        // A transfer queue, or the graphics queue when the device has none
+        VkQueue queue = VK_NULL_HANDLE;
+        uint32_t queue_family_index = 0;
+        uint32_t graphics_queue_family_index = 0;
+        // The ring holds frame_count frames worth of uploads
+        VkDeviceSize bytes_per_frame = VkDeviceSize{ 32 } << 20;
+        uint32_t frame_count = 2;
+        // Optional, counts the ring as staging memory
+        GpuMemory* memory = nullptr;
+        // The graphics queue's timeline, only when `queue` is a different queue
+        GpuTimeline* graphics_timeline = nullptr;
+    };
+
+    UploadQueue(CreateDetails create_details);
+    // Waits for the uploads in flight
+    ~UploadQueue() noexcept;
+    UploadQueue(UploadQueue const&) = delete;
+    UploadQueue& operator=(UploadQueue const&) = delete;
+    UploadQueue(UploadQueue&& other) noexcept = delete;
+    UploadQueue& operator=(UploadQueue&& other) noexcept = delete;
+
+    // Copies `size` bytes of `data` into the ring, to be written to buffer at `offset` by the next
+    // flush(). Returns false when the ring is too full, throws when `size` can never fit. Safe to
+    // call from any thread.
+    bool upload_buffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+
+    // Like upload_buffer(), for tightly packed texels of one region of an image. The written
+    // subresources are transitioned from undefined, discarding their contents, and left in
+    // final_layout. texel_block_size is the size in bytes of a texel block of the copied aspect,
+    // 3 for R8G8B8 or 4 for the depth of D24_UNORM_S8_UINT.
+    bool upload_image(VkImage image, VkImageSubresourceLayers subresource, VkOffset3D offset,
+        VkExtent3D extent, uint32_t texel_block_size, const void* data, VkDeviceSize size,
+        VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    // Submits the uploads made so far, returns the timeline value signaled once they completed or
+    // 0 when there were none. Call only on the thread submitting to the graphics queue, which may
+    // be the queue used here.
+    uint64_t flush();
+
+    // Records the graphics queue taking ownership of everything flushed and not yet acquired, the
+    // data is usable in `command_buffer` afterwards. Does nothing without a separate transfer
+    // queue family. Call on the same thread as flush().
+    void record_acquires(VkCommandBuffer command_buffer);
+    // Call once the command buffer given to record_acquires() was submitted. Until then they are
+    // recorded again by the next call, in case the command buffer was dropped.
+    void acquires_submitted() noexcept;
+
+    [[nodiscard]] GpuTimeline& timeline() noexcept { return upload_timeline; }
+    [[nodiscard]] bool transfers_ownership() const noexcept
+    {
+        return queue_family_index != graphics_queue_family_index;
+    }
+    [[nodiscard]] VkDeviceSize capacity() const noexcept { return ring_capacity; }
+
+    private:
+    struct BufferCopy
+    {
+        VkBuffer buffer;
+        VkBufferCopy region;
+        // position in upload order, the later of two overlapping uploads wins
+        size_t sequence;
+    };
+    struct ImageCopy
+    {
+        VkImage image;
+        VkBufferImageCopy region;
+        VkImageLayout final_layout;
+    };
+    // Ring bytes read by one submission
+    struct Region
+    {
+        VkDeviceSize end;
+        VkDeviceSize bytes;
+        uint64_t value;
+    };
+    struct Submission
+    {
+        VkCommandPool command_pool = VK_NULL_HANDLE;
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        uint64_t value = 0;
+    };
+
+    // Ring offset for `size` bytes, a multiple of `alignment`, or false. Must hold the mutex.
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+    VkCommandBuffer begin_submission(uint64_t value);
+    void record_buffer_copies(VkCommandBuffer command_buffer);
+    void record_image_copies(VkCommandBuffer command_buffer);
+
+    VkDevice device = VK_NULL_HANDLE;
+    VmaAllocator allocator = VK_NULL_HANDLE;
+    GpuMemory* memory = nullptr;
+    VkQueue queue = VK_NULL_HANDLE;
+    uint32_t queue_family_index = 0;
+    uint32_t graphics_queue_family_index = 0;
+    GpuTimeline* graphics_timeline = nullptr;
+    GpuTimeline upload_timeline;
+
+    VkBuffer staging_buffer = VK_NULL_HANDLE;
+    VmaAllocation staging_allocation = VK_NULL_HANDLE;
+    uint8_t* mapped = nullptr;
+    VkDeviceSize ring_capacity = 0;
+
+    std::mutex mutex;
+    // next byte to write and oldest byte still in use, `used` tells a full ring from an empty one
+    VkDeviceSize head = 0;
+    VkDeviceSize tail = 0;
+    VkDeviceSize used = 0;
+    // bytes allocated since the last flush, including the ones skipped when wrapping around
+    VkDeviceSize batch_bytes = 0;
+    std::deque<Region> regions;
+    std::vector<BufferCopy> buffer_copies;
+    std::vector<ImageCopy> image_copies;
+
+    // only used by flush() and record_acquires()
+    std::vector<Submission> submissions;
+    std::vector<BufferCopy> recording_buffer_copies;
+    std::vector<ImageCopy> recording_image_copies;
+    std::vector<VkBufferCopy> merged_regions;
+    std::vector<VkDeviceSize> boundaries;
+    std::vector<VkBufferImageCopy> image_regions;
+    std::vector<VkImageMemoryBarrier> image_barriers;
+    std::vector<VkImageLayout> final_layouts;
+    std::vector<VkBufferMemoryBarrier> buffer_barriers;
+    std::vector<VkBufferMemoryBarrier> buffer_acquires;
+    std::vector<VkImageMemoryBarrier> image_acquires;
+};
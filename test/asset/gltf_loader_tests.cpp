@@ -0,0 +1,339 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "asset/gltf_loader.h"
+#include "core/job_system.h"
+
+namespace
+{
+// A triangle with positions, normals, normalized 16 bit texcoords and 16 bit indices, and two
+// translation keys
+std::vector<uint8_t> triangle_buffer()
+{
+    std::vector<uint8_t> buffer;
+    auto append = [&buffer](auto value) {
+        auto size = buffer.size();
+        buffer.resize(size + sizeof(value));
+        std::memcpy(buffer.data() + size, &value, sizeof(value));
+    };
+    for (float value : { 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 2.f, 0.f })
+        append(value);
+    for (int i = 0; i < 3; i++)
+        for (float value : { 0.f, 0.f, 1.f })
+            append(value);
+    for (int value : { 0, 0, 65535, 0, 0, 65535 })
+        append(static_cast<uint16_t>(value));
+    for (int value : { 0, 1, 2 })
+        append(static_cast<uint16_t>(value));
+    append(uint16_t{ 0 }); // align the floats after it
+    for (float value : { 0.f, 1.f })
+        append(value);
+    for (float value : { 0.f, 0.f, 0.f, 4.f, 5.f, 6.f })
+        append(value);
+    return buffer;
+}
+
+constexpr const char* triangle_primitive =
+    R"("attributes":{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2},"indices":3,"material":0)";
+
+// The child node comes first in the file, the loader puts the root first
+std::string triangle_json(std::string const& buffer_uri, size_t buffer_size,
+    std::string const& primitive = triangle_primitive)
+{
+    std::string uri = buffer_uri.empty() ? "" : R"("uri":")" + buffer_uri + R"(",)";
+    return R"({
+"asset":{"version":"2.0"},
+"buffers":[{)" + uri + R"("byteLength":)" + std::to_string(buffer_size) + R"(}],
+"bufferViews":[
+    {"buffer":0,"byteOffset":0,"byteLength":36},
+    {"buffer":0,"byteOffset":36,"byteLength":36},
+    {"buffer":0,"byteOffset":72,"byteLength":12},
+    {"buffer":0,"byteOffset":84,"byteLength":6},
+    {"buffer":0,"byteOffset":92,"byteLength":32}],
+"accessors":[
+    {"bufferView":0,"componentType":5126,"count":3,"type":"VEC3","min":[0,0,0],"max":[1,2,0]},
+    {"bufferView":1,"componentType":5126,"count":3,"type":"VEC3"},
+    {"bufferView":2,"componentType":5123,"normalized":true,"count":3,"type":"VEC2"},
+    {"bufferView":3,"componentType":5123,"count":3,"type":"SCALAR"},
+    {"bufferView":4,"componentType":5126,"count":2,"type":"SCALAR","min":[0],"max":[1]},
+    {"bufferView":4,"byteOffset":8,"componentType":5126,"count":2,"type":"VEC3"}],
+"materials":[{"name":"red","pbrMetallicRoughness":{"baseColorFactor":[1,0.5,0.25,1],
+    "metallicFactor":0,"roughnessFactor":0.5},"alphaMode":"MASK","alphaCutoff":0.25,
+    "doubleSided":true},
+    {"name":"bumpy","normalTexture":{"index":0}}],
+"images":[{"uri":"normal.png"}],
+"textures":[{"source":0}],
+"meshes":[{"name":"triangle","primitives":[{)" + primitive + R"(}]}],
+"nodes":[
+    {"name":"child","mesh":0,"translation":[1,2,3]},
+    {"name":"root","children":[0],"matrix":[2,0,0,0,0,2,0,0,0,0,2,0,5,6,7,1]}],
+"scenes":[{"nodes":[1]}],
+"scene":0,
+"animations":[{"name":"move","samplers":[{"input":4,"output":5}],
+    "channels":[{"sampler":0,"target":{"node":0,"path":"translation"}}]}]
+})";
+}
+
+std::string base64(std::vector<uint8_t> const& data)
+{
+    const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < data.size(); i += 3)
+    {
+        uint32_t bits = uint32_t{ data[i] } << 16;
+        if (i + 1 < data.size()) bits |= uint32_t{ data[i + 1] } << 8;
+        if (i + 2 < data.size()) bits |= data[i + 2];
+        out += alphabet[bits >> 18 & 63];
+        out += alphabet[bits >> 12 & 63];
+        out += i + 1 < data.size() ? alphabet[bits >> 6 & 63] : '=';
+        out += i + 2 < data.size() ? alphabet[bits & 63] : '=';
+    }
+    return out;
+}
+
+void write_file(std::filesystem::path const& path, std::string const& text)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+void write_file(std::filesystem::path const& path, std::vector<uint8_t> const& data)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(
+        reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+std::vector<uint8_t> glb(std::string json, std::vector<uint8_t> bin)
+{
+    // chunks are 4 byte aligned, JSON padded with spaces and binary data with zeros
+    json.resize((json.size() + 3) / 4 * 4, ' ');
+    bin.resize((bin.size() + 3) / 4 * 4, 0);
+    std::vector<uint8_t> out;
+    auto append = [&out](uint32_t value) {
+        for (int i = 0; i < 4; i++)
+            out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    };
+    append(0x46546C67); // glTF
+    append(2);
+    append(static_cast<uint32_t>(12 + 8 + json.size() + 8 + bin.size()));
+    append(static_cast<uint32_t>(json.size()));
+    append(0x4E4F534A); // JSON
+    out.insert(out.end(), json.begin(), json.end());
+    append(static_cast<uint32_t>(bin.size()));
+    append(0x004E4942); // BIN
+    out.insert(out.end(), bin.begin(), bin.end());
+    return out;
+}
+
+std::filesystem::path test_directory(const char* name)
+{
+    auto directory = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+
+void check_triangle(Model const& model, std::filesystem::path const& directory)
+{
+    REQUIRE(model.meshes.size() == 1);
+    REQUIRE(model.meshes[0].name == "triangle");
+    REQUIRE(model.meshes[0].primitives.size() == 1);
+    auto const& primitive = model.meshes[0].primitives[0];
+    REQUIRE(primitive.topology == Topology::triangles);
+    REQUIRE(primitive.vertex_count == 3);
+    REQUIRE(primitive.positions.size() == 3);
+    REQUIRE(primitive.positions.get(1) == math::vec3{ 1.f, 0.f, 0.f });
+    REQUIRE(primitive.positions.get(2) == math::vec3{ 0.f, 2.f, 0.f });
+    REQUIRE(primitive.normals.get(0) == math::vec3{ 0.f, 0.f, 1.f });
+    REQUIRE(primitive.texcoords0.get(1) == math::vec2{ 1.f, 0.f });
+    REQUIRE(primitive.texcoords0.get(2) == math::vec2{ 0.f, 1.f });
+    REQUIRE(primitive.tangents.empty());
+    REQUIRE(primitive.indices == std::vector<uint32_t>{ 0, 1, 2 });
+    REQUIRE(primitive.material == 0);
+    REQUIRE(primitive.bounds.max == math::vec3{ 1.f, 2.f, 0.f });
+
+    REQUIRE(model.materials.size() == 2);
+    auto const& material = model.materials[0];
+    REQUIRE(material.name == "red");
+    REQUIRE(material.base_color_factor == math::vec4{ 1.f, 0.5f, 0.25f, 1.f });
+    REQUIRE(material.metallic_factor == 0.f);
+    REQUIRE(material.roughness_factor == 0.5f);
+    REQUIRE(material.alpha_mode == AlphaMode::mask);
+    REQUIRE(material.alpha_cutoff == 0.25f);
+    REQUIRE(material.double_sided);
+    REQUIRE(material.base_color.texture == no_index);
+    REQUIRE(model.materials[1].normal.texture == 0);
+    REQUIRE(model.images[0].path == (directory / "normal.png").string());
+
+    REQUIRE(model.nodes.size() == 2);
+    REQUIRE(model.nodes[0].name == "root");
+    REQUIRE(model.nodes[1].name == "child");
+    REQUIRE(model.parents == std::vector<uint32_t>{ math::no_parent, 0 });
+    REQUIRE(model.scene_roots == std::vector<uint32_t>{ 0 });
+    REQUIRE(model.nodes[1].mesh == 0);
+    REQUIRE(model.nodes[1].local.translation == math::vec3{ 1.f, 2.f, 3.f });
+    auto const& root = model.nodes[0].local;
+    REQUIRE(root.translation == math::vec3{ 5.f, 6.f, 7.f });
+    REQUIRE(root.scale == math::vec3{ 2.f, 2.f, 2.f });
+    REQUIRE(root.rotation.w == Catch::Approx(1.f));
+
+    REQUIRE(model.animations.size() == 1);
+    auto const& animation = model.animations[0];
+    REQUIRE(animation.duration == 1.f);
+    REQUIRE(animation.channels.size() == 1);
+    REQUIRE(animation.channels[0].node == 1);
+    REQUIRE(animation.channels[0].path == AnimationPath::translation);
+    REQUIRE(animation.samplers[0].times == std::vector<float>{ 0.f, 1.f });
+    REQUIRE(animation.samplers[0].values == std::vector<float>{ 0.f, 0.f, 0.f, 4.f, 5.f, 6.f });
+}
+} // namespace
+
+TEST_CASE("GltfLoader reads a .gltf with an embedded buffer", "[asset]")
+{
+    auto directory = test_directory("orange_gltf_embedded");
+    auto buffer = triangle_buffer();
+    write_file(directory / "triangle.gltf",
+        triangle_json("data:application/octet-stream;base64," + base64(buffer), buffer.size()));
+    check_triangle(GltfLoader{ GltfLoader::CreateDetails{} }.load(directory / "triangle.gltf"),
+        directory);
+}
+
+TEST_CASE("GltfLoader maps external buffers", "[asset]")
+{
+    auto directory = test_directory("orange_gltf_external");
+    auto buffer = triangle_buffer();
+    write_file(directory / "triangle data.bin", buffer);
+    write_file(directory / "triangle.gltf", triangle_json("triangle%20data.bin", buffer.size()));
+    check_triangle(GltfLoader{ GltfLoader::CreateDetails{} }.load(directory / "triangle.gltf"),
+        directory);
+}
+
+TEST_CASE("GltfLoader reads .glb files", "[asset]")
+{
+    auto directory = test_directory("orange_gltf_binary");
+    auto buffer = triangle_buffer();
+    write_file(directory / "triangle.glb", glb(triangle_json("", buffer.size()), buffer));
+    check_triangle(GltfLoader{ GltfLoader::CreateDetails{} }.load(directory / "triangle.glb"),
+        directory);
+}
+
+TEST_CASE("GltfLoader packs vertices into a layout", "[asset]")
+{
+    auto directory = test_directory("orange_gltf_packed");
+    auto buffer = triangle_buffer();
+    write_file(directory / "triangle.glb", glb(triangle_json("", buffer.size()), buffer));
+    VertexLayout layout;
+    layout.add(VertexAttribute::position, VertexFormat::float32x3)
+        .add(VertexAttribute::normal, VertexFormat::snorm8x4)
+        .add(VertexAttribute::texcoord0, VertexFormat::unorm16x2)
+        .add(VertexAttribute::color0, VertexFormat::unorm8x4);
+    REQUIRE(layout.stride == 24);
+
+    Model model = GltfLoader{ GltfLoader::CreateDetails{ .vertex_layout = layout } }.load(
+        directory / "triangle.glb");
+    auto const& primitive = model.meshes[0].primitives[0];
+    REQUIRE(primitive.positions.empty());
+    REQUIRE(primitive.vertices.size() == 3 * 24);
+    auto vertex = [&](size_t index) { return primitive.vertices.data() + index * 24; };
+
+    float position[3];
+    std::memcpy(position, vertex(1), sizeof(position));
+    REQUIRE(position[0] == 1.f);
+    int8_t normal[4];
+    std::memcpy(normal, vertex(0) + 12, sizeof(normal));
+    // the missing w is 1
+    REQUIRE((normal[0] == 0 && normal[1] == 0 && normal[2] == 127 && normal[3] == 127));
+    uint16_t texcoord[2];
+    std::memcpy(texcoord, vertex(2) + 16, sizeof(texcoord));
+    REQUIRE((texcoord[0] == 0 && texcoord[1] == 65535));
+    // the file has no colors
+    uint8_t color[4];
+    std::memcpy(color, vertex(0) + 20, sizeof(color));
+    REQUIRE((color[0] == 0 && color[3] == 0));
+}
+
+TEST_CASE("GltfLoader generates missing normals and tangents", "[asset]")
+{
+    auto directory = test_directory("orange_gltf_generated");
+    auto buffer = triangle_buffer();
+    // no normals, and a material with a normal map
+    write_file(directory / "triangle.glb",
+        glb(triangle_json("", buffer.size(),
+                R"("attributes":{"POSITION":0,"TEXCOORD_0":2},"indices":3,"material":1)"),
+            buffer));
+    Model model = GltfLoader{ GltfLoader::CreateDetails{} }.load(directory / "triangle.glb");
+    auto const& primitive = model.meshes[0].primitives[0];
+    // flat normals give every corner a vertex of its own
+    REQUIRE(primitive.indices.empty());
+    REQUIRE(primitive.vertex_count == 3);
+    REQUIRE(primitive.positions.get(1) == math::vec3{ 1.f, 0.f, 0.f });
+    REQUIRE(primitive.texcoords0.get(2) == math::vec2{ 0.f, 1.f });
+    for (size_t i = 0; i < 3; i++)
+    {
+        REQUIRE(primitive.normals.get(i) == math::vec3{ 0.f, 0.f, 1.f });
+        REQUIRE(primitive.tangents.get(i) == math::vec4{ 1.f, 0.f, 0.f, 1.f });
+    }
+}
+
+TEST_CASE("GltfLoader output doesn't depend on the thread count", "[asset]")
+{
+    auto directory = test_directory("orange_gltf_threads");
+    auto buffer = triangle_buffer();
+    write_file(directory / "triangle.glb",
+        glb(triangle_json("", buffer.size(),
+                R"("attributes":{"POSITION":0,"TEXCOORD_0":2},"indices":3,"material":1)"),
+            buffer));
+    VertexLayout layout;
+    layout.add(VertexAttribute::position, VertexFormat::float32x3)
+        .add(VertexAttribute::normal, VertexFormat::snorm8x4)
+        .add(VertexAttribute::tangent, VertexFormat::snorm8x4)
+        .add(VertexAttribute::texcoord0, VertexFormat::float32x2);
+
+    Model serial = GltfLoader{ GltfLoader::CreateDetails{ .vertex_layout = layout } }.load(
+        directory / "triangle.glb");
+    JobSystem job_system{ JobSystem::CreateDetails{ .worker_count = 3 } };
+    GltfLoader loader{ GltfLoader::CreateDetails{
+        .job_system = &job_system, .vertex_layout = layout } };
+    Model parallel = loader.load(directory / "triangle.glb");
+    auto const& vertices = parallel.meshes[0].primitives[0].vertices;
+    REQUIRE(vertices == serial.meshes[0].primitives[0].vertices);
+    REQUIRE(vertices.size() == 3 * layout.stride);
+    int8_t normal[4];
+    int8_t tangent[4];
+    std::memcpy(normal, vertices.data() + 12, sizeof(normal));
+    std::memcpy(tangent, vertices.data() + 16, sizeof(tangent));
+    REQUIRE((normal[2] == 127 && normal[3] == 127));
+    REQUIRE((tangent[0] == 127 && tangent[3] == 127));
+    REQUIRE(parallel.animations[0].samplers[0].values == serial.animations[0].samplers[0].values);
+}
+
+TEST_CASE("GltfLoader throws on missing and invalid files", "[asset]")
+{
+    auto directory = test_directory("orange_gltf_invalid");
+    GltfLoader loader{ GltfLoader::CreateDetails{} };
+    REQUIRE_THROWS_AS(loader.load(directory / "missing.gltf"), std::runtime_error);
+    write_file(directory / "invalid.gltf", std::string("{ not json"));
+    REQUIRE_THROWS_AS(loader.load(directory / "invalid.gltf"), std::runtime_error);
+    write_file(directory / "missing_buffer.gltf", triangle_json("missing.bin", 124));
+    REQUIRE_THROWS_AS(loader.load(directory / "missing_buffer.gltf"), std::runtime_error);
+
+    // errors from the jobs reach the caller
+    JobSystem job_system{ JobSystem::CreateDetails{ .worker_count = 2 } };
+    auto buffer = triangle_buffer();
+    write_file(directory / "no_positions.glb",
+        glb(triangle_json("", buffer.size(), R"("attributes":{"NORMAL":1})"), buffer));
+    REQUIRE_THROWS_AS(
+        GltfLoader{ GltfLoader::CreateDetails{ .job_system = &job_system } }.load(
+            directory / "no_positions.glb"),
+        std::runtime_error);
+}
@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+
+#include "core/frame_allocator.h"
+
+namespace
+{
+// Counts allocations reaching the upstream resource
+struct counting_resource : std::pmr::memory_resource
+{
+    size_t allocations = 0;
+    size_t live_bytes = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        allocations++;
+        live_bytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override
+    {
+        live_bytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+} // namespace
+
+TEST_CASE("LinearArena hands out aligned, non overlapping memory", "[core]")
+{
+    LinearArena arena{ 1024 };
+    auto* a = static_cast<std::byte*>(arena.allocate(3, 1));
+    auto* b = static_cast<std::byte*>(arena.allocate(16, 16));
+    auto* c = static_cast<std::byte*>(arena.allocate(64, 64));
+    REQUIRE(reinterpret_cast<uintptr_t>(b) % 16 == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(c) % 64 == 0);
+    REQUIRE(b >= a + 3);
+    REQUIRE(c >= b + 16);
+    REQUIRE(arena.bytes_used() >= 3 + 16 + 64);
+
+    arena.reset();
+    REQUIRE(arena.bytes_used() == 0);
+    REQUIRE(arena.allocate(3, 1) == a);
+}
+
+TEST_CASE("LinearArena grows to fit a frame and then stops allocating", "[core]")
+{
+    counting_resource upstream;
+    {
+        LinearArena arena{ 256, &upstream };
+        REQUIRE(upstream.allocations == 1);
+
+        auto fill_frame = [&] {
+            frame_vector<uint64_t> values{ &arena };
+            for (uint64_t i = 0; i < 1000; i++)
+                values.push_back(i);
+            frame_string name{ "a string that is too long for the small string buffer", &arena };
+            REQUIRE(values[999] == 999);
+            REQUIRE(name.size() > 40);
+        };
+
+        fill_frame();
+        REQUIRE(upstream.allocations > 1);
+        arena.reset();
+        REQUIRE(arena.capacity() >= arena.high_water_mark());
+
+        size_t warm = upstream.allocations;
+        for (int frame = 0; frame < 10; frame++)
+        {
+            fill_frame();
+            arena.reset();
+        }
+        REQUIRE(upstream.allocations == warm);
+    }
+    REQUIRE(upstream.live_bytes == 0);
+}
+
+TEST_CASE("FrameArena keeps a frame's memory until its index comes around again", "[core]")
+{
+    FrameArena frames{ FrameArena::CreateDetails{ .frame_count = 3, .frame_size = 4096 } };
+    REQUIRE(frames.frame_count() == 3);
+
+    frames.begin_frame(0);
+    frame_vector<int> first{ frames.resource() };
+    first.assign(100, 7);
+
+    frames.begin_frame(1);
+    frame_vector<int> second{ frames.resource() };
+    second.assign(100, 9);
+    frames.begin_frame(2);
+
+    // frame 0 wasn't reset yet, its data is intact
+    for (int value : first)
+        REQUIRE(value == 7);
+    REQUIRE(frames.current_frame() == 2);
+    REQUIRE(frames.current().bytes_used() == 0);
+}
@@ -0,0 +1,46 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/frame_pacing.h"
+
+TEST_CASE("FramePacing reports even frames", "[core]")
+{
+    FramePacing pacing{ FramePacing::CreateDetails{ .window_frames = 10 } };
+    REQUIRE(pacing.report().frame_count == 0);
+
+    for (int i = 0; i < 10; i++)
+        pacing.record(FramePacing::Sample{
+            .frame_ns = 16'000'000, .fence_wait_ns = 4'000'000, .acquire_wait_ns = 0 });
+
+    auto report = pacing.report();
+    REQUIRE(report.frame_count == 10);
+    REQUIRE(report.average_ms == Catch::Approx(16.0));
+    REQUIRE(report.median_ms == Catch::Approx(16.0));
+    REQUIRE(report.max_ms == Catch::Approx(16.0));
+    REQUIRE(report.jitter_ms == Catch::Approx(0.0));
+    REQUIRE(report.average_fence_wait_ms == Catch::Approx(4.0));
+    REQUIRE(report.wait_fraction == Catch::Approx(0.25));
+    REQUIRE(report.hitch_count == 0);
+}
+
+TEST_CASE("FramePacing counts hitches and only keeps the window", "[core]")
+{
+    FramePacing pacing{ FramePacing::CreateDetails{ .window_frames = 8, .hitch_factor = 1.5 } };
+    // pushed out of the window by the frames after it
+    pacing.record(FramePacing::Sample{ .frame_ns = 500'000'000 });
+    for (int i = 0; i < 6; i++)
+        pacing.record(FramePacing::Sample{ .frame_ns = 10'000'000 });
+    pacing.record(FramePacing::Sample{ .frame_ns = 30'000'000 });
+    pacing.record(FramePacing::Sample{ .frame_ns = 10'000'000 });
+
+    auto report = pacing.report();
+    REQUIRE(report.frame_count == 8);
+    REQUIRE(report.max_ms == Catch::Approx(30.0));
+    REQUIRE(report.median_ms == Catch::Approx(10.0));
+    REQUIRE(report.average_ms == Catch::Approx(12.5));
+    REQUIRE(report.hitch_count == 1);
+    REQUIRE(report.jitter_ms > 0.0);
+
+    pacing.clear();
+    REQUIRE(pacing.report().frame_count == 0);
+}
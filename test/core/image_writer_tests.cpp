@@ -0,0 +1,203 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "core/image_writer.h"
+
+namespace
+{
+std::vector<uint8_t> read_file(std::filesystem::path const& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+uint32_t read_u32(std::vector<uint8_t> const& data, size_t offset)
+{
+    return uint32_t{ data[offset] } << 24 | uint32_t{ data[offset + 1] } << 16 |
+           uint32_t{ data[offset + 2] } << 8 | uint32_t{ data[offset + 3] };
+}
+
+uint32_t crc32(std::vector<uint8_t> const& data, size_t offset, size_t size)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = offset; i < offset + size; i++)
+    {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++)
+            crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+struct DecodedPng
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t color_type = 0;
+    std::vector<uint8_t> scanlines; // with the filter byte of each row
+};
+
+// Minimal reader for what write_png produces: checks every CRC, the stored deflate blocks and the
+// adler32 checksum
+DecodedPng decode_png(std::filesystem::path const& path)
+{
+    auto data = read_file(path);
+    REQUIRE(data.size() > 8);
+    REQUIRE(data[0] == 0x89);
+    REQUIRE(data[1] == 'P');
+
+    DecodedPng png;
+    std::vector<uint8_t> zlib;
+    size_t offset = 8;
+    bool ended = false;
+    while (!ended)
+    {
+        REQUIRE(offset + 12 <= data.size());
+        uint32_t length = read_u32(data, offset);
+        std::string type(data.begin() + static_cast<ptrdiff_t>(offset) + 4,
+            data.begin() + static_cast<ptrdiff_t>(offset) + 8);
+        REQUIRE(read_u32(data, offset + 8 + length) == crc32(data, offset + 4, length + 4));
+        size_t body = offset + 8;
+        if (type == "IHDR")
+        {
+            png.width = read_u32(data, body);
+            png.height = read_u32(data, body + 4);
+            png.color_type = data[body + 9];
+        }
+        else if (type == "IDAT")
+            zlib.insert(zlib.end(), data.begin() + static_cast<ptrdiff_t>(body),
+                data.begin() + static_cast<ptrdiff_t>(body + length));
+        else if (type == "IEND")
+            ended = true;
+        offset += 12 + length;
+    }
+
+    REQUIRE(zlib.size() >= 6);
+    REQUIRE((zlib[0] * 256 + zlib[1]) % 31 == 0);
+    size_t position = 2;
+    bool final_block = false;
+    while (!final_block)
+    {
+        final_block = zlib[position] & 1;
+        REQUIRE((zlib[position] & 6) == 0); // stored
+        uint16_t length = static_cast<uint16_t>(zlib[position + 1] | zlib[position + 2] << 8);
+        uint16_t inverse = static_cast<uint16_t>(zlib[position + 3] | zlib[position + 4] << 8);
+        REQUIRE(length == static_cast<uint16_t>(~inverse));
+        position += 5;
+        png.scanlines.insert(png.scanlines.end(), zlib.begin() + static_cast<ptrdiff_t>(position),
+            zlib.begin() + static_cast<ptrdiff_t>(position + length));
+        position += length;
+    }
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : png.scanlines)
+    {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    REQUIRE(read_u32(zlib, position) == (b << 16 | a));
+    return png;
+}
+
+std::vector<std::byte> gradient(uint32_t width, uint32_t height, uint32_t channels)
+{
+    std::vector<std::byte> pixels(size_t{ width } * height * channels);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = std::byte(i * 7 % 251);
+    return pixels;
+}
+
+std::filesystem::path test_directory(const char* name)
+{
+    auto directory = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+} // namespace
+
+TEST_CASE("write_png round trips through a stored deflate stream", "[core]")
+{
+    auto directory = test_directory("orange_image_writer_png");
+    // more than one 64KiB deflate block
+    ImageDescription image{ .width = 300, .height = 120, .channels = 4 };
+    auto pixels = gradient(image.width, image.height, image.channels);
+    REQUIRE(write_png(directory / "image.png", image, pixels));
+
+    auto png = decode_png(directory / "image.png");
+    REQUIRE(png.width == 300);
+    REQUIRE(png.height == 120);
+    REQUIRE(png.color_type == 6);
+    size_t row_size = size_t{ image.width } * 4;
+    REQUIRE(png.scanlines.size() == (row_size + 1) * image.height);
+    for (uint32_t y = 0; y < image.height; y++)
+    {
+        REQUIRE(png.scanlines[y * (row_size + 1)] == 0);
+        for (size_t x = 0; x < row_size; x++)
+            REQUIRE(png.scanlines[y * (row_size + 1) + 1 + x] ==
+                    static_cast<uint8_t>(pixels[y * row_size + x]));
+    }
+}
+
+TEST_CASE("write_png swaps blue and red of bgr images", "[core]")
+{
+    auto directory = test_directory("orange_image_writer_bgr");
+    ImageDescription image{ .width = 2, .height = 1, .channels = 4, .bgr_order = true };
+    std::vector<std::byte> pixels{ std::byte{ 1 }, std::byte{ 2 }, std::byte{ 3 }, std::byte{ 4 },
+        std::byte{ 5 }, std::byte{ 6 }, std::byte{ 7 }, std::byte{ 8 } };
+    REQUIRE(write_png(directory / "image.png", image, pixels));
+
+    auto png = decode_png(directory / "image.png");
+    std::vector<uint8_t> expected{ 0, 3, 2, 1, 4, 7, 6, 5, 8 };
+    REQUIRE(png.scanlines == expected);
+}
+
+TEST_CASE("ImageSequenceWriter writes every submitted frame", "[core]")
+{
+    auto directory = test_directory("orange_image_writer_sequence");
+    ImageDescription image{ .width = 16, .height = 8, .channels = 4 };
+    {
+        ImageSequenceWriter writer{ ImageSequenceWriter::CreateDetails{
+            .directory = directory, .format = ImageFileFormat::raw, .max_queued_frames = 2 } };
+        for (uint64_t frame = 0; frame < 20; frame++)
+        {
+            auto pixels = gradient(image.width, image.height, image.channels);
+            pixels[0] = std::byte(frame);
+            writer.submit(frame, image, pixels);
+        }
+        writer.flush();
+        REQUIRE(writer.frames_written() == 20);
+        REQUIRE(writer.frames_failed() == 0);
+        REQUIRE(writer.path_of(7) == directory / "frame_000007.raw");
+    }
+    for (uint64_t frame = 0; frame < 20; frame++)
+    {
+        auto data = read_file(directory / ("frame_0000" + std::to_string(frame / 10) +
+                                              std::to_string(frame % 10) + ".raw"));
+        REQUIRE(data.size() == image.byte_size());
+        REQUIRE(data[0] == frame);
+    }
+}
+
+TEST_CASE("ImageSequenceWriter finishes queued frames on destruction", "[core]")
+{
+    auto directory = test_directory("orange_image_writer_shutdown");
+    ImageDescription image{ .width = 64, .height = 64, .channels = 3 };
+    auto pixels = gradient(image.width, image.height, image.channels);
+    {
+        ImageSequenceWriter writer{ ImageSequenceWriter::CreateDetails{ .directory = directory } };
+        for (uint64_t frame = 0; frame < 8; frame++)
+            writer.submit(frame, image, pixels);
+    }
+    for (uint64_t frame = 0; frame < 8; frame++)
+    {
+        auto name = "frame_00000" + std::to_string(frame) + ".png";
+        REQUIRE(std::filesystem::exists(directory / name));
+    }
+}
@@ -0,0 +1,105 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/job_system.h"
+
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Job system runs submitted jobs", "[core]")
+{
+    JobSystem jobs{ JobSystem::CreateDetails{ .worker_count = 3 } };
+    REQUIRE(jobs.thread_count() == 4);
+    REQUIRE(jobs.current_thread_index() == 0);
+
+    std::atomic<uint32_t> sum = 0;
+    JobCounter counter;
+    for (uint32_t i = 1; i <= 1000; i++)
+        jobs.submit([&sum, i] { sum += i; }, counter);
+    jobs.wait(counter);
+    REQUIRE(counter.is_done());
+    REQUIRE(sum == 500500);
+}
+
+TEST_CASE("Job system continuations run after their dependency", "[core]")
+{
+    JobSystem jobs{ JobSystem::CreateDetails{ .worker_count = 3 } };
+    std::atomic<uint32_t> finished = 0;
+    std::atomic<bool> ran_early = false;
+    JobCounter first;
+    JobCounter second;
+    for (uint32_t i = 0; i < 64; i++)
+        jobs.submit(
+            [&finished] {
+                std::this_thread::yield();
+                finished++;
+            },
+            first);
+    jobs.submit_after(
+        first,
+        [&] {
+            if (finished != 64) ran_early = true;
+        },
+        &second);
+    jobs.wait(second);
+    REQUIRE(first.is_done());
+    REQUIRE_FALSE(ran_early);
+
+    // a dependency which is already done runs the continuation right away
+    std::atomic<bool> ran = false;
+    jobs.submit_after(first, [&ran] { ran = true; }, &second);
+    jobs.wait(second);
+    REQUIRE(ran);
+}
+
+TEST_CASE("Job system parallel_for covers the range exactly once", "[core]")
+{
+    JobSystem jobs{ JobSystem::CreateDetails{ .worker_count = 3 } };
+    for (size_t count : { size_t{ 0 }, size_t{ 1 }, size_t{ 7 }, size_t{ 1000 }, size_t{ 100003 } })
+    {
+        std::vector<std::atomic<uint32_t>> hits(count);
+        jobs.parallel_for(0, count, [&hits](size_t i) { hits[i]++; });
+        for (auto const& hit : hits)
+            REQUIRE(hit == 1);
+    }
+
+    std::vector<uint64_t> values(50000);
+    std::iota(values.begin(), values.end(), uint64_t{ 0 });
+    std::atomic<uint64_t> total = 0;
+    std::atomic<bool> small_chunk = false;
+    jobs.parallel_for(
+        0,
+        values.size(),
+        [&](size_t begin, size_t end) {
+            if (end - begin < 1000) small_chunk = true;
+            total += std::accumulate(values.begin() + static_cast<ptrdiff_t>(begin),
+                values.begin() + static_cast<ptrdiff_t>(end),
+                uint64_t{ 0 });
+        },
+        1000);
+    REQUIRE(total == uint64_t{ 49999 } * 50000 / 2);
+    REQUIRE_FALSE(small_chunk);
+}
+
+TEST_CASE("Job system handles nested waits and foreign threads", "[core]")
+{
+    JobSystem jobs{ JobSystem::CreateDetails{ .worker_count = 2, .queue_capacity = 16 } };
+    std::atomic<uint32_t> inner_jobs = 0;
+    // nested parallel_for waits inside jobs, overflowing the small queues
+    jobs.parallel_for(0, 32, [&](size_t) { jobs.parallel_for(0, 64, [&](size_t) { inner_jobs++; }); });
+    REQUIRE(inner_jobs == 32 * 64);
+
+    std::atomic<uint32_t> from_thread = 0;
+    uint32_t other_index = 0;
+    std::thread other([&] {
+        other_index = jobs.current_thread_index();
+        JobCounter counter;
+        for (uint32_t i = 0; i < 100; i++)
+            jobs.submit([&from_thread] { from_thread++; }, counter);
+        jobs.wait(counter);
+    });
+    other.join();
+    REQUIRE(other_index == jobs.thread_count());
+    REQUIRE(from_thread == 100);
+}
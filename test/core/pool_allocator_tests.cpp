@@ -0,0 +1,130 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "core/pool_allocator.h"
+
+TEST_CASE("PoolAllocator reuses freed blocks of the same size class", "[core]")
+{
+    PoolAllocator pool{ PoolAllocator::CreateDetails{} };
+    void* a = pool.allocate(24, 8);
+    void* b = pool.allocate(32, 8);
+    REQUIRE(a != b);
+    REQUIRE(pool.slab_count() == 1);
+
+    pool.deallocate(a, 24, 8);
+    REQUIRE(pool.allocate(30, 8) == a);
+
+    // different size classes come from different slabs
+    void* c = pool.allocate(100, 16);
+    REQUIRE(reinterpret_cast<uintptr_t>(c) % 16 == 0);
+    REQUIRE(pool.slab_count() == 2);
+
+    // too big or over aligned requests go upstream and don't take a slab
+    void* big = pool.allocate(PoolAllocator::max_pooled_size + 1, 8);
+    void* aligned = pool.allocate(16, 128);
+    REQUIRE(reinterpret_cast<uintptr_t>(aligned) % 128 == 0);
+    REQUIRE(pool.slab_count() == 2);
+
+    pool.deallocate(big, PoolAllocator::max_pooled_size + 1, 8);
+    pool.deallocate(aligned, 16, 128);
+    pool.deallocate(a, 30, 8);
+    pool.deallocate(b, 32, 8);
+    pool.deallocate(c, 100, 16);
+}
+
+TEST_CASE("PoolAllocator works as a pmr resource", "[core]")
+{
+    PoolAllocator pool{ PoolAllocator::CreateDetails{} };
+    std::pmr::vector<std::pmr::vector<int>> nested{ &pool };
+    for (int i = 0; i < 100; i++)
+    {
+        nested.emplace_back();
+        for (int j = 0; j <= i; j++)
+            nested.back().push_back(j);
+    }
+    REQUIRE(nested[99].size() == 100);
+    REQUIRE(nested[99].get_allocator().resource() == &pool);
+    REQUIRE(nested[50][50] == 50);
+}
+
+TEST_CASE("Blocks freed on another thread go back to their owner", "[core]")
+{
+    PoolAllocator pool{ PoolAllocator::CreateDetails{ .remote_batch_size = 8 } };
+    std::vector<void*> blocks;
+    for (int i = 0; i < 64; i++)
+        blocks.push_back(pool.allocate(64, 8));
+    size_t slabs = pool.slab_count();
+
+    std::thread other([&] {
+        // take a cache on this thread so its frees are batched
+        pool.deallocate(pool.allocate(64, 8), 64, 8);
+        for (void* block : blocks)
+            pool.deallocate(block, 64, 8);
+        pool.flush_remote_frees();
+    });
+    other.join();
+
+    // all of them are reused before a new slab is needed
+    for (int i = 0; i < 64; i++)
+        blocks[static_cast<size_t>(i)] = pool.allocate(64, 8);
+    REQUIRE(pool.slab_count() == slabs + 1); // the other thread's slab
+    for (void* block : blocks)
+        pool.deallocate(block, 64, 8);
+}
+
+TEST_CASE("PoolAllocator handles concurrent producers and consumers", "[core]")
+{
+    PoolAllocator pool{ PoolAllocator::CreateDetails{} };
+    constexpr int thread_count = 4;
+    constexpr int rounds = 2000;
+    std::vector<std::atomic<uint64_t*>> mailboxes(thread_count);
+    std::atomic<int> errors = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < rounds; i++)
+            {
+                auto* value = static_cast<uint64_t*>(pool.allocate(sizeof(uint64_t) * 4, 8));
+                value[0] = static_cast<uint64_t>(t);
+                // swap with a neighbour so blocks are freed by other threads
+                auto& mailbox = mailboxes[static_cast<size_t>((t + i) % thread_count)];
+                if (uint64_t* previous = mailbox.exchange(value))
+                {
+                    if (previous[0] >= thread_count) errors++;
+                    pool.deallocate(previous, sizeof(uint64_t) * 4, 8);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto& mailbox : mailboxes)
+        if (uint64_t* last = mailbox.load()) pool.deallocate(last, sizeof(uint64_t) * 4, 8);
+    REQUIRE(errors == 0);
+}
+
+TEST_CASE("A new thread takes over the cache of an exited thread", "[core]")
+{
+    PoolAllocator pool{ PoolAllocator::CreateDetails{} };
+    std::thread([&] { pool.deallocate(pool.allocate(512, 8), 512, 8); }).join();
+    size_t slabs = pool.slab_count();
+    std::thread([&] { pool.deallocate(pool.allocate(512, 8), 512, 8); }).join();
+    REQUIRE(pool.slab_count() == slabs);
+}
+
+TEST_CASE("pool_vector allocates from the default pool", "[core]")
+{
+    pool_vector<uint32_t> values;
+    for (uint32_t i = 0; i < 300; i++)
+        values.push_back(i);
+    pool_vector<uint32_t> copy = values;
+    REQUIRE(copy == values);
+    REQUIRE(default_pool_allocator().slab_count() > 0);
+}
@@ -0,0 +1,106 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "core/profiler.h"
+
+namespace
+{
+void profiled_work()
+{
+    ProfileScope scope{ "profiled_work" };
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+Profiler::ScopeStats find_stats(std::vector<Profiler::ScopeStats> const& stats, std::string name)
+{
+    auto it = std::find_if(
+        stats.begin(), stats.end(), [&](auto const& entry) { return entry.name == name; });
+    return it != stats.end() ? *it : Profiler::ScopeStats{};
+}
+} // namespace
+
+TEST_CASE("Profiler aggregates scopes over frames", "[core]")
+{
+    Profiler::clear();
+    for (int frame = 0; frame < 3; frame++)
+    {
+        profiled_work();
+        profiled_work();
+        Profiler::mark_frame();
+    }
+
+    auto stats = find_stats(Profiler::aggregate(3), "profiled_work");
+    REQUIRE(stats.count == 6);
+    REQUIRE(stats.min_ns >= 50'000);
+    REQUIRE(stats.max_ns >= stats.min_ns);
+    REQUIRE(stats.total_ns >= 6 * stats.min_ns);
+
+    REQUIRE(find_stats(Profiler::aggregate(1), "profiled_work").count == 2);
+}
+
+TEST_CASE("Profiler collects events from other threads", "[core]")
+{
+    Profiler::clear();
+    std::thread worker([] {
+        Profiler::set_thread_name("Profiler test worker");
+        for (int i = 0; i < 10; i++)
+        {
+            ProfileScope scope{ "worker_scope" };
+            Profiler::record_counter("worker_counter", i);
+        }
+    });
+    worker.join();
+    Profiler::mark_frame();
+    REQUIRE(find_stats(Profiler::aggregate(1), "worker_scope").count == 10);
+}
+
+TEST_CASE("Disabled profiler records nothing", "[core]")
+{
+    Profiler::clear();
+    Profiler::set_enabled(false);
+    profiled_work();
+    Profiler::set_enabled(true);
+    Profiler::mark_frame();
+    REQUIRE(find_stats(Profiler::aggregate(1), "profiled_work").count == 0);
+}
+
+TEST_CASE("Profiler writes a Chrome trace", "[core]")
+{
+    Profiler::clear();
+    profiled_work();
+    Profiler::record_counter("trace_counter", 42.0);
+    Profiler::mark_frame();
+
+    const char* path = "orange_profiler_test_trace.json";
+    REQUIRE(Profiler::write_chrome_trace(path));
+    std::ifstream file(path);
+    std::string contents{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    file.close();
+    std::remove(path);
+
+    REQUIRE(contents.find("\"traceEvents\"") != std::string::npos);
+    REQUIRE(contents.find("\"profiled_work\"") != std::string::npos);
+    REQUIRE(contents.find("\"trace_counter\"") != std::string::npos);
+    REQUIRE(contents.find("\"thread_name\"") != std::string::npos);
+}
+
+TEST_CASE("Scopes recorded on a track show up in the aggregate and the trace", "[core]")
+{
+    Profiler::clear();
+    Profiler::Track* gpu = Profiler::create_track("Test GPU queue");
+    REQUIRE(Profiler::create_track("Test GPU queue") == gpu);
+
+    int64_t now = Profiler::now_ns();
+    Profiler::record_scope(gpu, "track_scope", now, now + 1000);
+    Profiler::mark_frame();
+
+    auto stats = find_stats(Profiler::aggregate(1), "track_scope");
+    REQUIRE(stats.count == 1);
+    REQUIRE(stats.total_ns == 1000);
+}
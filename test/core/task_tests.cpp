@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/task.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+orange::task<int> add_on_worker(JobSystem& jobs, int left, int right)
+{
+    co_await orange::schedule_on(jobs);
+    co_return left + right;
+}
+
+orange::task<int> chained(JobSystem& jobs)
+{
+    int first = co_await add_on_worker(jobs, 1, 2);
+    int second = co_await add_on_worker(jobs, first, 4);
+    co_return second * 10;
+}
+
+orange::task<void> throws_on_worker(JobSystem& jobs)
+{
+    co_await orange::schedule_on(jobs);
+    throw std::runtime_error("task failed");
+}
+} // namespace
+
+TEST_CASE("Tasks chain through co_await", "[core]")
+{
+    JobSystem jobs{ JobSystem::CreateDetails{ .worker_count = 3 } };
+    REQUIRE(orange::sync_wait(jobs, chained(jobs)) == 70);
+    REQUIRE_THROWS_AS(orange::sync_wait(jobs, throws_on_worker(jobs)), std::runtime_error);
+}
+
+TEST_CASE("Tasks wait on counters, events and polled conditions", "[core]")
+{
+    JobSystem jobs{ JobSystem::CreateDetails{ .worker_count = 3 } };
+
+    SECTION("Counter")
+    {
+        std::atomic<uint32_t> finished = 0;
+        auto work = [&]() -> orange::task<uint32_t> {
+            JobCounter counter;
+            for (uint32_t i = 0; i < 100; i++)
+                jobs.submit([&finished] { finished++; }, counter);
+            co_await orange::wait_for(jobs, counter);
+            co_return finished.load();
+        };
+        REQUIRE(orange::sync_wait(jobs, work()) == 100);
+    }
+    SECTION("Event")
+    {
+        orange::async_event event{ jobs };
+        std::atomic<bool> resumed = false;
+        auto waiter = [&]() -> orange::task<void> {
+            co_await event;
+            resumed = true;
+        };
+        auto setter = [&]() -> orange::task<void> {
+            co_await orange::schedule_on(jobs);
+            event.set();
+            co_return;
+        };
+        std::vector<orange::task<void>> tasks;
+        tasks.push_back(waiter());
+        tasks.push_back(setter());
+        orange::sync_wait(jobs, orange::when_all(jobs, std::move(tasks)));
+        REQUIRE(resumed);
+        REQUIRE(event.is_set());
+    }
+    SECTION("Polled condition")
+    {
+        std::atomic<uint32_t> polls = 0;
+        auto work = [&]() -> orange::task<uint32_t> {
+            co_await orange::poll_until(jobs, [&polls] { return ++polls >= 10; });
+            co_return polls.load();
+        };
+        REQUIRE(orange::sync_wait(jobs, work()) == 10);
+    }
+    SECTION("Jobs run in between polls")
+    {
+        // the job is queued on the polling thread, the poll only finishes once some thread ran it
+        std::atomic<bool> ran = false;
+        auto work = [&]() -> orange::task<void> {
+            co_await orange::schedule_on(jobs);
+            jobs.submit([&ran] { ran = true; });
+            co_await orange::poll_until(jobs, [&ran] { return ran.load(); });
+        };
+        orange::sync_wait(jobs, work());
+        REQUIRE(ran);
+    }
+}
+
+TEST_CASE("when_all runs tasks in parallel and forwards exceptions", "[core]")
+{
+    JobSystem jobs{ JobSystem::CreateDetails{ .worker_count = 3 } };
+    std::atomic<int> sum = 0;
+    auto add = [&](int value) -> orange::task<void> {
+        sum += co_await add_on_worker(jobs, value, 0);
+    };
+    std::vector<orange::task<void>> tasks;
+    for (int i = 1; i <= 100; i++)
+        tasks.push_back(add(i));
+    orange::sync_wait(jobs, orange::when_all(jobs, std::move(tasks)));
+    REQUIRE(sum == 5050);
+
+    std::vector<orange::task<void>> failing;
+    failing.push_back(add(1));
+    failing.push_back(throws_on_worker(jobs));
+    REQUIRE_THROWS_AS(orange::sync_wait(jobs, orange::when_all(jobs, std::move(failing))),
+                      std::runtime_error);
+}
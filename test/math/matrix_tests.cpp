@@ -0,0 +1,141 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include "math/matrix.h"
+
+#include <vector>
+
+namespace
+{
+// Invertible matrix with no zero entries, so every path through the kernels is exercised
+constexpr math::matrix4 sample_matrix()
+{
+    return math::matrix4{ { 2.f, 1.f, 3.f, 0.5f, 1.f, 4.f, -1.f, 2.f, 0.5f, 2.f, 5.f, -3.f, 3.f, -2.f, 1.f, 6.f } };
+}
+constexpr math::matrix4 sample_affine()
+{
+    math::matrix4 m = math::translation(math::vec3{ 3.f, -2.f, 7.f }) * math::scaling(math::vec3{ 2.f, 0.5f, 4.f });
+    m(1, 0) = 0.75f;
+    m(2, 1) = -1.5f;
+    return m;
+}
+
+void require_approx(math::matrix4 const& left, math::matrix4 const& right)
+{
+    for (uint32_t i = 0; i < 16; i++)
+        REQUIRE(left.data[i] == Catch::Approx(right.data[i]).margin(1e-5));
+}
+} // namespace
+
+TEST_CASE("Matrix identity and access", "[math]")
+{
+    constexpr auto id = math::matrix4::identity();
+    static_assert(id(0, 0) == 1.f && id(3, 3) == 1.f && id(1, 0) == 0.f);
+
+    auto m = sample_matrix();
+    REQUIRE(m(1, 2) == m.data[6]);
+    REQUIRE(m.column(2) == math::vec4{ 0.5f, 2.f, 5.f, -3.f });
+    REQUIRE(m.row(1) == math::vec4{ 1.f, 4.f, 2.f, -2.f });
+    REQUIRE(m * math::matrix4::identity() == m);
+    REQUIRE(math::matrix4::identity() * m == m);
+}
+
+TEST_CASE("Matrix runtime evaluation matches compile time evaluation", "[math]")
+{
+    constexpr auto m = sample_matrix();
+    constexpr auto a = sample_affine();
+    constexpr auto product = m * a;
+    constexpr auto applied = m * math::vec4{ 1.f, -2.f, 3.f, 0.5f };
+    constexpr auto transposed = math::transpose(m);
+    constexpr auto inverted = math::inverse(m);
+    constexpr auto affine_inverted = math::affine_inverse(a);
+
+    auto runtime_m = m;
+    auto runtime_a = a;
+    require_approx(runtime_m * runtime_a, product);
+    auto runtime_applied = runtime_m * math::vec4{ 1.f, -2.f, 3.f, 0.5f };
+    for (size_t i = 0; i < 4; i++)
+        REQUIRE(runtime_applied[i] == Catch::Approx(applied[i]));
+    REQUIRE(math::transpose(runtime_m) == transposed);
+    require_approx(math::inverse(runtime_m), inverted);
+    require_approx(math::affine_inverse(runtime_a), affine_inverted);
+
+    auto accumulated = runtime_m;
+    accumulated *= runtime_a;
+    require_approx(accumulated, product);
+}
+
+TEST_CASE("Matrix inverse", "[math]")
+{
+    auto m = sample_matrix();
+    require_approx(math::inverse(m) * m, math::matrix4::identity());
+    require_approx(m * math::inverse(m), math::matrix4::identity());
+
+    auto a = sample_affine();
+    require_approx(math::affine_inverse(a) * a, math::matrix4::identity());
+    require_approx(math::affine_inverse(a), math::inverse(a));
+
+    math::matrix3 small{ { 2.f, 0.f, 1.f, 1.f, 3.f, 0.f, 0.f, 1.f, 4.f } };
+    auto small_identity = math::inverse(small) * small;
+    for (uint32_t c = 0; c < 3; c++)
+        for (uint32_t r = 0; r < 3; r++)
+            REQUIRE(small_identity(c, r) == Catch::Approx(c == r ? 1.f : 0.f).margin(1e-6));
+    REQUIRE(math::determinant(small) == Catch::Approx(25.f));
+}
+
+TEST_CASE("Matrix projection and view", "[math]")
+{
+    SECTION("Reversed Z perspective")
+    {
+        auto proj = math::perspective(1.2f, 16.f / 9.f, 0.1f, 100.f);
+        auto near_point = proj * math::vec4{ 0.f, 0.f, -0.1f, 1.f };
+        auto far_point = proj * math::vec4{ 0.f, 0.f, -100.f, 1.f };
+        REQUIRE(near_point.z / near_point.w == Catch::Approx(1.f));
+        REQUIRE(far_point.z / far_point.w == Catch::Approx(0.f).margin(1e-6));
+
+        auto up = proj * math::vec4{ 0.f, 1.f, -1.f, 1.f };
+        REQUIRE(up.y < 0.f);
+
+        auto infinite = math::perspective_infinite(1.2f, 16.f / 9.f, 0.1f);
+        auto infinite_near = infinite * math::vec4{ 0.f, 0.f, -0.1f, 1.f };
+        REQUIRE(infinite_near.z / infinite_near.w == Catch::Approx(1.f));
+    }
+    SECTION("Look at")
+    {
+        math::vec3 eye{ 1.f, 2.f, 3.f };
+        auto view = math::look_at(eye, math::vec3{ 1.f, 2.f, -5.f }, math::vec3{ 0.f, 1.f, 0.f });
+        auto origin = view * math::vec4{ eye.x, eye.y, eye.z, 1.f };
+        REQUIRE(origin.x == Catch::Approx(0.f).margin(1e-6));
+        REQUIRE(origin.y == Catch::Approx(0.f).margin(1e-6));
+        REQUIRE(origin.z == Catch::Approx(0.f).margin(1e-6));
+        auto ahead = view * math::vec4{ 1.f, 2.f, -1.f, 1.f };
+        REQUIRE(ahead.z == Catch::Approx(-4.f));
+    }
+}
+
+TEST_CASE("Matrix batch transforms", "[math]")
+{
+    auto a = sample_affine();
+    std::vector<math::vec3> points;
+    for (int i = 0; i < 37; i++)
+        points.push_back(math::vec3{ static_cast<float>(i), static_cast<float>(i % 5) - 2.f, 0.5f * static_cast<float>(i) });
+
+    std::vector<math::vec3> transformed(points.size());
+    math::transform_points(a, points, transformed);
+    std::vector<math::vec3> directions(points.size());
+    math::transform_vectors(a, points, directions);
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        auto point = a * math::vec4{ points[i].x, points[i].y, points[i].z, 1.f };
+        auto direction = a * math::vec4{ points[i].x, points[i].y, points[i].z, 0.f };
+        for (size_t c = 0; c < 3; c++)
+        {
+            REQUIRE(transformed[i][c] == Catch::Approx(point[c]));
+            REQUIRE(directions[i][c] == Catch::Approx(direction[c]).margin(1e-5));
+        }
+    }
+
+    // in place
+    math::transform_points(a, points, points);
+    REQUIRE(points == transformed);
+}
@@ -0,0 +1,127 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include "math/transform.h"
+
+#include <numbers>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+void require_approx(math::vec3 const& left, math::vec3 const& right)
+{
+    for (size_t i = 0; i < 3; i++)
+        REQUIRE(left[i] == Catch::Approx(right[i]).margin(1e-5));
+}
+void require_approx(math::matrix4 const& left, math::matrix4 const& right)
+{
+    for (uint32_t i = 0; i < 16; i++)
+        REQUIRE(left.data[i] == Catch::Approx(right.data[i]).margin(1e-5));
+}
+constexpr float half_pi = std::numbers::pi_v<float> / 2.f;
+} // namespace
+
+TEST_CASE("Quaternion rotation", "[math]")
+{
+    static_assert(math::quat::identity() * math::vec3{ 1.f, 2.f, 3.f } == math::vec3{ 1.f, 2.f, 3.f });
+
+    auto around_y = math::from_axis_angle(math::vec3{ 0.f, 1.f, 0.f }, half_pi);
+    require_approx(around_y * math::vec3{ 1.f, 0.f, 0.f }, math::vec3{ 0.f, 0.f, -1.f });
+
+    auto around_x = math::from_axis_angle(math::vec3{ 1.f, 0.f, 0.f }, half_pi);
+    auto combined = around_x * around_y;
+    math::vec3 v{ 0.3f, -1.f, 2.f };
+    require_approx(combined * v, around_x * (around_y * v));
+    require_approx(math::conjugate(combined) * (combined * v), v);
+
+    // the matrix applies the same rotation
+    auto m = math::to_matrix(combined);
+    auto rotated = m * math::vec4{ v.x, v.y, v.z, 1.f };
+    require_approx(math::vec3{ rotated.x, rotated.y, rotated.z }, combined * v);
+    REQUIRE(math::length(math::normalize(math::quat{ 1.f, 2.f, 3.f, 4.f })) == Catch::Approx(1.f));
+}
+
+TEST_CASE("Quaternion interpolation", "[math]")
+{
+    auto start = math::quat::identity();
+    auto end = math::from_axis_angle(math::vec3{ 0.f, 0.f, 1.f }, half_pi);
+    SECTION("Slerp")
+    {
+        require_approx(math::slerp(start, end, 0.f) * math::vec3{ 1.f, 0.f, 0.f }, math::vec3{ 1.f, 0.f, 0.f });
+        require_approx(math::slerp(start, end, 1.f) * math::vec3{ 1.f, 0.f, 0.f }, math::vec3{ 0.f, 1.f, 0.f });
+        auto half = math::slerp(start, end, 0.5f);
+        float diagonal = std::sqrt(0.5f);
+        require_approx(half * math::vec3{ 1.f, 0.f, 0.f }, math::vec3{ diagonal, diagonal, 0.f });
+        // q and -q are the same rotation, the shortest path must be taken for both
+        require_approx(math::slerp(start, -end, 0.5f) * math::vec3{ 1.f, 0.f, 0.f }, math::vec3{ diagonal, diagonal, 0.f });
+    }
+    SECTION("Nlerp")
+    {
+        auto half = math::nlerp(start, end, 0.5f);
+        REQUIRE(math::length(half) == Catch::Approx(1.f));
+        float diagonal = std::sqrt(0.5f);
+        require_approx(half * math::vec3{ 1.f, 0.f, 0.f }, math::vec3{ diagonal, diagonal, 0.f });
+        require_approx(math::nlerp(start, -end, 1.f) * math::vec3{ 1.f, 0.f, 0.f }, math::vec3{ 0.f, 1.f, 0.f });
+    }
+}
+
+TEST_CASE("Transform to matrix", "[math]")
+{
+    math::transform t{ math::vec3{ 1.f, 2.f, 3.f },
+        math::from_axis_angle(math::vec3{ 0.f, 1.f, 0.f }, 0.7f),
+        math::vec3{ 2.f, 3.f, 0.5f } };
+    require_approx(math::to_matrix(t),
+        math::translation(t.translation) * math::to_matrix(t.rotation) * math::scaling(t.scale));
+    REQUIRE(math::to_matrix(math::transform{}) == math::matrix4::identity());
+}
+
+TEST_CASE("Transform hierarchy propagation", "[math]")
+{
+    // 0 is the root, children are listed before their parents
+    std::vector<uint32_t> parents{ math::no_parent, 4, 0, 1, 2, math::no_parent, 5 };
+    std::vector<math::transform> local;
+    for (size_t i = 0; i < parents.size(); i++)
+    {
+        float f = static_cast<float>(i);
+        local.push_back(math::transform{ math::vec3{ f, 1.f, -f },
+            math::from_axis_angle(math::vec3{ 0.f, 0.f, 1.f }, 0.3f * f),
+            math::vec3{ 1.f + 0.1f * f, 1.f, 1.f } });
+    }
+    REQUIRE_FALSE(math::is_depth_sorted(parents));
+
+    auto order = math::depth_sorted_order(parents);
+    REQUIRE(order == std::vector<uint32_t>{ 0, 5, 2, 6, 4, 1, 3 });
+    auto sorted_parents = math::reorder_parents(parents, order);
+    REQUIRE(math::is_depth_sorted(sorted_parents));
+    auto sorted_local = math::reorder(std::span<math::transform const>(local), order);
+
+    std::vector<math::matrix4> world(local.size());
+    math::propagate_world_matrices(sorted_local, sorted_parents, world);
+
+    std::vector<math::matrix4> local_matrices(local.size());
+    math::to_matrices(sorted_local, local_matrices);
+    std::vector<math::matrix4> world_from_matrices(local.size());
+    math::propagate_world_matrices(local_matrices, sorted_parents, world_from_matrices);
+
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        // walk up the original hierarchy for the reference result
+        math::matrix4 expected = math::to_matrix(local[order[i]]);
+        for (uint32_t node = parents[order[i]]; node != math::no_parent; node = parents[node])
+            expected = math::to_matrix(local[node]) * expected;
+        require_approx(world[i], expected);
+        require_approx(world_from_matrices[i], expected);
+    }
+}
+
+TEST_CASE("Depth sorting rejects invalid hierarchies", "[math]")
+{
+    // 1 -> 2 -> 3 -> 1 never reaches a root
+    std::vector<uint32_t> cycle{ math::no_parent, 2, 3, 1 };
+    REQUIRE_THROWS_AS(math::depth_sorted_order(cycle), std::runtime_error);
+    std::vector<uint32_t> self_parent{ 0 };
+    REQUIRE_THROWS_AS(math::depth_sorted_order(self_parent), std::runtime_error);
+    std::vector<uint32_t> out_of_range{ math::no_parent, 7 };
+    REQUIRE_THROWS_AS(math::depth_sorted_order(out_of_range), std::runtime_error);
+}
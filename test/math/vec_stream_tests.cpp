@@ -0,0 +1,99 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include "math/vec_stream.h"
+
+namespace
+{
+math::vec3_stream make_stream(size_t count, float offset)
+{
+    math::vec3_stream out;
+    for (size_t i = 0; i < count; i++)
+    {
+        float f = static_cast<float>(i);
+        out.push_back(math::vec3{ f + offset, -f * 0.5f + offset, f * 0.25f - offset });
+    }
+    return out;
+}
+} // namespace
+
+TEST_CASE("Vector stream storage", "[math]")
+{
+    math::vec3_stream a;
+    REQUIRE(a.empty());
+    a.push_back(math::vec3{ 1.f, 2.f, 3.f });
+    a.push_back(math::vec3{ 4.f, 5.f, 6.f });
+    REQUIRE(a.size() == 2);
+    REQUIRE(a.capacity() % math::vec3_stream::lane_count == 0);
+    REQUIRE(a.get(1) == math::vec3{ 4.f, 5.f, 6.f });
+    REQUIRE(a.y()[0] == 2.f);
+    REQUIRE(reinterpret_cast<uintptr_t>(a.component(0)) % math::vec3_stream::alignment == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(a.component(2)) % math::vec3_stream::alignment == 0);
+
+    a.resize(100);
+    REQUIRE(a.get(0) == math::vec3{ 1.f, 2.f, 3.f });
+    REQUIRE(a.get(99) == math::vec3{});
+
+    math::vec3_stream b = a;
+    REQUIRE(b.size() == 100);
+    REQUIRE(b.get(1) == math::vec3{ 4.f, 5.f, 6.f });
+    math::vec3_stream c = std::move(b);
+    REQUIRE(c.get(1) == math::vec3{ 4.f, 5.f, 6.f });
+}
+
+TEST_CASE("Vector stream batch operations match vec", "[math]")
+{
+    // Odd sizes make sure the padding past size() is handled
+    for (size_t count : { size_t{ 1 }, size_t{ 17 }, size_t{ 100 } })
+    {
+        auto a = make_stream(count, 1.f);
+        auto b = make_stream(count, -3.f);
+        auto c = make_stream(count, 0.5f);
+        math::vec3_stream out;
+        math::float_stream scalars;
+
+        math::add(a, b, out);
+        for (size_t i = 0; i < count; i++)
+            REQUIRE(out.get(i) == a.get(i) + b.get(i));
+        math::sub(a, b, out);
+        for (size_t i = 0; i < count; i++)
+            REQUIRE(out.get(i) == a.get(i) - b.get(i));
+        math::mul(a, b, out);
+        for (size_t i = 0; i < count; i++)
+            REQUIRE(out.get(i) == a.get(i) * b.get(i));
+        math::mul(a, 2.f, out);
+        for (size_t i = 0; i < count; i++)
+            REQUIRE(out.get(i) == a.get(i) * 2.f);
+        math::min(a, b, out);
+        for (size_t i = 0; i < count; i++)
+            REQUIRE(out.get(i) == math::min(a.get(i), b.get(i)));
+        math::max(a, b, out);
+        for (size_t i = 0; i < count; i++)
+            REQUIRE(out.get(i) == math::max(a.get(i), b.get(i)));
+        math::clamp(a, -2.f, 5.f, out);
+        for (size_t i = 0; i < count; i++)
+            REQUIRE(out.get(i) == math::clamp(a.get(i), -2.f, 5.f));
+
+        math::fma(a, b, c, out);
+        for (size_t i = 0; i < count; i++)
+            for (size_t j = 0; j < 3; j++)
+                REQUIRE(out.get(i)[j] == Catch::Approx((a.get(i) * b.get(i) + c.get(i))[j]));
+        math::lerp(a, b, 0.25f, out);
+        for (size_t i = 0; i < count; i++)
+            for (size_t j = 0; j < 3; j++)
+                REQUIRE(out.get(i)[j] == Catch::Approx(math::lerp(a.get(i), b.get(i), 0.25f)[j]));
+        math::dot(a, b, scalars);
+        for (size_t i = 0; i < count; i++)
+            REQUIRE(scalars.get(i)[0] == Catch::Approx(math::dot(a.get(i), b.get(i))));
+        math::normalize(a, out);
+        for (size_t i = 0; i < count; i++)
+            for (size_t j = 0; j < 3; j++)
+                REQUIRE(out.get(i)[j] == Catch::Approx(math::normalize(a.get(i))[j]));
+
+        // in place
+        auto original = a;
+        math::add(a, a, a);
+        for (size_t i = 0; i < count; i++)
+            REQUIRE(a.get(i) == original.get(i) * 2.f);
+    }
+}
@@ -360,3 +360,84 @@ TEST_CASE("Vector functions", "[math]")
         REQUIRE(math::compare(math::vec2i{ 1, 4 }, math::vec2i{ 1, 2 }) == math::vec<bool, 2>{ true, false });
     }
 }
+
+TEST_CASE("Vector runtime evaluation matches compile time evaluation", "[math]")
+{
+    // The constexpr results are computed with the scalar loops, the runtime ones take the SIMD path
+    constexpr math::vec4 a{ 1.5f, -2.f, 3.25f, -4.f };
+    constexpr math::vec4 b{ -0.5f, 8.f, 2.f, 0.25f };
+    constexpr math::vec3 c{ 1.5f, -2.f, 3.25f };
+    constexpr math::vec3 d{ -0.5f, 8.f, 2.f };
+    constexpr math::vec4i e{ 3, -7, 12, -1 };
+    constexpr math::vec4i f{ -4, 5, 2, 9 };
+    SECTION("vec4")
+    {
+        constexpr auto sum = a + b;
+        constexpr auto difference = a - b;
+        constexpr auto product = a * b;
+        constexpr auto quotient = a / b;
+        constexpr auto scaled = a * 3.f;
+        constexpr auto negated = -a;
+        constexpr auto dot = math::dot(a, b);
+        constexpr auto minimum = math::min(a, b);
+        constexpr auto maximum = math::max(a, b);
+        constexpr auto absolute = math::abs(a);
+        constexpr auto clamped = math::clamp(a, -1.f, 2.f);
+        REQUIRE(a + b == sum);
+        REQUIRE(a - b == difference);
+        REQUIRE(a * b == product);
+        REQUIRE(a / b == quotient);
+        REQUIRE(a * 3.f == scaled);
+        REQUIRE(-a == negated);
+        REQUIRE(math::dot(a, b) == dot);
+        REQUIRE(math::min(a, b) == minimum);
+        REQUIRE(math::max(a, b) == maximum);
+        REQUIRE(math::abs(a) == absolute);
+        REQUIRE(math::clamp(a, -1.f, 2.f) == clamped);
+        math::vec4 g = a;
+        g += b;
+        REQUIRE(g == sum);
+        g /= 2.f;
+        REQUIRE(g == sum / 2.f);
+    }
+    SECTION("vec3")
+    {
+        constexpr auto sum = c + d;
+        constexpr auto difference = c - d;
+        constexpr auto product = c * d;
+        constexpr auto quotient = c / d;
+        constexpr auto inverse = 1.f / c;
+        constexpr auto dot = math::dot(c, d);
+        constexpr auto minimum = math::min(c, d);
+        constexpr auto maximum = math::max(c, d);
+        constexpr auto clamped = math::clamp(c, -1.f, 2.f);
+        REQUIRE(c + d == sum);
+        REQUIRE(c - d == difference);
+        REQUIRE(c * d == product);
+        REQUIRE(c / d == quotient);
+        REQUIRE(1.f / c == inverse);
+        REQUIRE(math::dot(c, d) == dot);
+        REQUIRE(math::min(c, d) == minimum);
+        REQUIRE(math::max(c, d) == maximum);
+        REQUIRE(math::clamp(c, -1.f, 2.f) == clamped);
+    }
+    SECTION("vec4i")
+    {
+        constexpr auto sum = e + f;
+        constexpr auto difference = e - f;
+        constexpr auto product = e * f;
+        constexpr auto quotient = e / f;
+        constexpr auto minimum = math::min(e, f);
+        constexpr auto maximum = math::max(e, f);
+        constexpr auto absolute = math::abs(e);
+        constexpr auto clamped = math::clamp(e, -2, 4);
+        REQUIRE(e + f == sum);
+        REQUIRE(e - f == difference);
+        REQUIRE(e * f == product);
+        REQUIRE(e / f == quotient);
+        REQUIRE(math::min(e, f) == minimum);
+        REQUIRE(math::max(e, f) == maximum);
+        REQUIRE(math::abs(e) == absolute);
+        REQUIRE(math::clamp(e, -2, 4) == clamped);
+    }
+}
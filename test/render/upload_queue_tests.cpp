@@ -0,0 +1,148 @@
+// the renderer leaves VMA's implementation to the executable
+#define VMA_IMPLEMENTATION
+#include <vk_mem_alloc.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+#include <memory>
+#include <vector>
+
+#include <VkBootstrap.h>
+
+#include "render/gpu_timeline.h"
+#include "render/upload_queue.h"
+
+namespace
+{
+// A headless device with timeline semaphores, null when there is no Vulkan driver to run on
+struct TestDevice
+{
+    vkb::Instance instance;
+    vkb::Device device;
+    VmaAllocator allocator = VK_NULL_HANDLE;
+
+    ~TestDevice()
+    {
+        if (allocator != VK_NULL_HANDLE) vmaDestroyAllocator(allocator);
+        if (device.device != VK_NULL_HANDLE) vkb::destroy_device(device);
+        vkb::destroy_instance(instance);
+    }
+};
+
+std::unique_ptr<TestDevice> create_device()
+{
+    auto inst_ret = vkb::InstanceBuilder{}.set_headless().require_api_version(1, 2).build();
+    if (!inst_ret) return nullptr;
+    auto test_device = std::make_unique<TestDevice>();
+    test_device->instance = inst_ret.value();
+
+    VkPhysicalDeviceVulkan12Features features_12{};
+    features_12.timelineSemaphore = VK_TRUE;
+    vkb::PhysicalDeviceSelector selector{ test_device->instance };
+    auto phys_dev_ret = selector.set_required_features_12(features_12).select();
+    if (!phys_dev_ret) return nullptr;
+    auto dev_ret = vkb::DeviceBuilder{ phys_dev_ret.value() }.build();
+    if (!dev_ret) return nullptr;
+    test_device->device = dev_ret.value();
+
+    VmaAllocatorCreateInfo allocator_info{};
+    allocator_info.vulkanApiVersion = VK_API_VERSION_1_2;
+    allocator_info.physicalDevice = test_device->device.physical_device.physical_device;
+    allocator_info.device = test_device->device.device;
+    allocator_info.instance = test_device->instance.instance;
+    if (vmaCreateAllocator(&allocator_info, &test_device->allocator) != VK_SUCCESS) return nullptr;
+    return test_device;
+}
+
+// Uploads `first` and then `second` to the same range in two flushes, returns what the buffer
+// holds once both completed
+std::vector<uint32_t> upload_twice(TestDevice& test_device, UploadQueue::CreateDetails details,
+    std::vector<uint32_t> const& first, std::vector<uint32_t> const& second)
+{
+    VkDeviceSize size = first.size() * sizeof(uint32_t);
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VmaAllocationCreateInfo allocation_info{};
+    allocation_info.usage = VMA_MEMORY_USAGE_AUTO;
+    allocation_info.flags =
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VmaAllocation allocation = VK_NULL_HANDLE;
+    VmaAllocationInfo allocation_result{};
+    REQUIRE(vmaCreateBuffer(test_device.allocator, &buffer_info, &allocation_info, &buffer,
+                &allocation, &allocation_result) == VK_SUCCESS);
+
+    std::vector<uint32_t> contents(first.size());
+    {
+        UploadQueue uploads{ details };
+        REQUIRE(uploads.upload_buffer(buffer, 0, first.data(), size));
+        REQUIRE(uploads.flush() != 0);
+        REQUIRE(uploads.upload_buffer(buffer, 0, second.data(), size));
+        uint64_t value = uploads.flush();
+        REQUIRE(value != 0);
+        uploads.timeline().wait(value);
+    }
+    vmaInvalidateAllocation(test_device.allocator, allocation, 0, VK_WHOLE_SIZE);
+    std::memcpy(contents.data(), allocation_result.pMappedData, size);
+    vmaDestroyBuffer(test_device.allocator, buffer, allocation);
+    return contents;
+}
+} // namespace
+
+TEST_CASE("Uploading a range again in the next flush keeps the later data")
+{
+    auto test_device = create_device();
+    if (!test_device)
+    {
+        WARN("No Vulkan 1.2 device, skipping");
+        return;
+    }
+    auto& device = test_device->device;
+    uint32_t graphics_index = device.get_queue_index(vkb::QueueType::graphics).value();
+    UploadQueue::CreateDetails details{ .device = device.device,
+        .allocator = test_device->allocator,
+        .queue = device.get_queue(vkb::QueueType::graphics).value(),
+        .queue_family_index = graphics_index,
+        .graphics_queue_family_index = graphics_index,
+        .bytes_per_frame = 1 << 20 };
+    // large enough for the copies to take a while, so a missing dependency shows
+    std::vector<uint32_t> first(1 << 17, 1);
+    std::vector<uint32_t> second(1 << 17, 2);
+
+    SECTION("On the graphics queue")
+    {
+        REQUIRE(upload_twice(*test_device, details, first, second) == second);
+    }
+    SECTION("On a transfer queue waiting for graphics work")
+    {
+        auto transfer_queue = device.get_queue(vkb::QueueType::transfer);
+        if (!transfer_queue) return;
+        // an empty submission, which the uploads wait for
+        GpuTimeline graphics_timeline{ GpuTimeline::CreateDetails{ .device = device.device } };
+        uint64_t graphics_value = graphics_timeline.next_value();
+        VkSemaphore semaphore = graphics_timeline.semaphore();
+        VkTimelineSemaphoreSubmitInfo timeline_info{};
+        timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timeline_info.signalSemaphoreValueCount = 1;
+        timeline_info.pSignalSemaphoreValues = &graphics_value;
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.pNext = &timeline_info;
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = &semaphore;
+        REQUIRE(vkQueueSubmit(details.queue, 1, &submit_info, VK_NULL_HANDLE) == VK_SUCCESS);
+        graphics_timeline.submitted(graphics_value);
+
+        details.queue = transfer_queue.value();
+        details.queue_family_index = device.get_queue_index(vkb::QueueType::transfer).value();
+        details.graphics_timeline = &graphics_timeline;
+        REQUIRE(upload_twice(*test_device, details, first, second) == second);
+        graphics_timeline.wait(graphics_value);
+    }
+}